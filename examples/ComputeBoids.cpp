@@ -268,7 +268,7 @@ void initCommandBuffers() {
                 .SetPipeline(updatePipeline)
                 .TransitionBufferUsage(bufferSrc, nxt::BufferUsageBit::Storage)
                 .TransitionBufferUsage(bufferDst, nxt::BufferUsageBit::Storage)
-                .SetBindGroup(0, updateBGs[i])
+                .SetBindGroup(0, updateBGs[i], 0, nullptr)
                 .Dispatch(kNumParticles, 1, 1)
             .EndComputePass()
 
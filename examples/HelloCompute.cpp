@@ -129,7 +129,7 @@ void frame() {
         .BeginComputePass()
             .SetPipeline(computePipeline)
             .TransitionBufferUsage(buffer, nxt::BufferUsageBit::Storage)
-            .SetBindGroup(0, computeBindGroup)
+            .SetBindGroup(0, computeBindGroup, 0, nullptr)
             .Dispatch(1, 1, 1)
         .EndComputePass()
 
@@ -137,7 +137,7 @@ void frame() {
         .BeginRenderSubpass()
             .SetPipeline(renderPipeline)
             .TransitionBufferUsage(buffer, nxt::BufferUsageBit::Uniform)
-            .SetBindGroup(0, renderBindGroup)
+            .SetBindGroup(0, renderBindGroup, 0, nullptr)
             .DrawArrays(3, 1, 0, 0)
         .EndRenderSubpass()
         .EndRenderPass()
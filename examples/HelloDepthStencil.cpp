@@ -275,7 +275,7 @@ void frame() {
         .BeginRenderSubpass()
             .SetPipeline(pipeline)
             .TransitionBufferUsage(cameraBuffer, nxt::BufferUsageBit::Uniform)
-            .SetBindGroup(0, bindGroup[0])
+            .SetBindGroup(0, bindGroup[0], 0, nullptr)
             .SetVertexBuffers(0, 1, &vertexBuffer, vertexBufferOffsets)
             .SetIndexBuffer(indexBuffer, 0, nxt::IndexFormat::Uint32)
             .DrawElements(36, 1, 0, 0)
@@ -287,7 +287,7 @@ void frame() {
 
             .SetPipeline(reflectionPipeline)
             .SetVertexBuffers(0, 1, &vertexBuffer, vertexBufferOffsets)
-            .SetBindGroup(0, bindGroup[1])
+            .SetBindGroup(0, bindGroup[1], 0, nullptr)
             .DrawElements(36, 1, 0, 0)
         .EndRenderSubpass()
         .EndRenderPass()
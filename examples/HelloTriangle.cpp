@@ -146,7 +146,7 @@ void frame() {
         .BeginRenderPass(renderpass, framebuffer)
         .BeginRenderSubpass()
             .SetPipeline(pipeline)
-            .SetBindGroup(0, bindGroup)
+            .SetBindGroup(0, bindGroup, 0, nullptr)
             .SetVertexBuffers(0, 1, &vertexBuffer, vertexBufferOffsets)
             .SetIndexBuffer(indexBuffer, 0, nxt::IndexFormat::Uint32)
             .DrawElements(3, 1, 0, 0)
@@ -97,7 +97,7 @@ void frame() {
         .BeginRenderSubpass()
             .SetPipeline(pipeline)
             .TransitionBufferUsage(buffer, nxt::BufferUsageBit::Uniform)
-            .SetBindGroup(0, bindGroup)
+            .SetBindGroup(0, bindGroup, 0, nullptr)
             .DrawArrays(3, 1, 0, 0)
         .EndRenderSubpass()
         .EndRenderPass()
@@ -196,7 +196,7 @@ void frame() {
                 .SetPipeline(pipelinePost)
                 .SetVertexBuffers(0, 1, &vertexBufferQuad, vertexBufferOffsets)
                 .TransitionTextureUsage(renderTarget, nxt::TextureUsageBit::Sampled)
-                .SetBindGroup(0, bindGroup)
+                .SetBindGroup(0, bindGroup, 0, nullptr)
                 .DrawArrays(6, 1, 0, 0)
             .EndRenderSubpass()
         .EndRenderPass()
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "utils/BackendBinding.h"
+#include "utils/ProfilingProcTable.h"
 #include "../src/wire/TerribleCommandBuffer.h"
 
 #include <nxt/nxt.h>
@@ -47,6 +48,7 @@ static utils::BackendType backendType = utils::BackendType::OpenGL;
 #endif
 
 static CmdBufType cmdBufType = CmdBufType::Terrible;
+static bool profileProcs = false;
 static utils::BackendBinding* binding = nullptr;
 
 static GLFWwindow* window = nullptr;
@@ -105,6 +107,13 @@ nxt::Device CreateCppNXTDevice() {
             break;
     }
 
+    // Profiles the procs called by the sample, which are the wire client's when using a command
+    // buffer.
+    if (profileProcs) {
+        procs = utils::GetProfilingProcs(procs);
+        utils::DumpProcProfilesAtExit();
+    }
+
     nxtSetProcs(&procs);
     procs.deviceSetErrorCallback(cDevice, PrintDeviceError, 0);
     return nxt::Device::Acquire(cDevice);
@@ -150,10 +159,15 @@ bool InitSample(int argc, const char** argv) {
             fprintf(stderr, "--command-buffer expects a command buffer name (none, terrible)\n");
             return false;
         }
+        if (std::string("-p") == argv[i] || std::string("--profile-procs") == argv[i]) {
+            profileProcs = true;
+            continue;
+        }
         if (std::string("-h") == argv[i] || std::string("--help") == argv[i]) {
-            printf("Usage: %s [-b BACKEND] [-c COMMAND_BUFFER]\n", argv[0]);
+            printf("Usage: %s [-b BACKEND] [-c COMMAND_BUFFER] [-p]\n", argv[0]);
             printf("  BACKEND is one of: d3d12, metal, null, opengl, vulkan\n");
             printf("  COMMAND_BUFFER is one of: none, terrible\n");
+            printf("  -p, --profile-procs prints the call count and time of each API entry point at exit\n");
             return false;
         }
     }
@@ -498,7 +498,7 @@ namespace {
             cmd.BeginRenderSubpass();
             cmd.SetPipeline(material.pipeline);
             cmd.TransitionBufferUsage(material.uniformBuffer, nxt::BufferUsageBit::Uniform);
-            cmd.SetBindGroup(0, material.bindGroup0);
+            cmd.SetBindGroup(0, material.bindGroup0, 0, nullptr);
 
             uint32_t vertexCount = 0;
             for (const auto& s : slotSemantics) {
@@ -85,6 +85,16 @@ class MethodArgument:
         self.annotation = annotation
         self.length = None
 
+class StructureMember:
+    def __init__(self, name, typ):
+        self.name = name
+        self.type = typ
+
+class StructureType(Type):
+    def __init__(self, name, record):
+        Type.__init__(self, name, record)
+        self.members = []
+
 Method = namedtuple('Method', ['name', 'return_type', 'arguments'])
 class ObjectType(Type):
     def __init__(self, name, record):
@@ -112,6 +122,11 @@ def link_object(obj, types):
             arguments_by_name[arg.name.canonical_case()] = arg
 
         for (arg, a) in zip(arguments, record.get('args', [])):
+            # Structures are passed by pointer to a single element.
+            if arg.type.category == 'structure':
+                assert(arg.annotation == 'const*' and not 'length' in a)
+                continue
+
             assert(arg.annotation == 'value' or 'length' in a)
             if arg.annotation != 'value':
                 if a['length'] == 'strlen':
@@ -133,6 +148,13 @@ def link_object(obj, types):
                 break
         assert(obj.built_type != None)
 
+def link_structure(struct, types):
+    for m in struct.record['members']:
+        member = StructureMember(Name(m['name']), types[m['type']])
+        # Structures are copied as is through the wire so they can't contain objects or pointers.
+        assert(member.type.category in ['bitmask', 'enum', 'native'])
+        struct.members.append(member)
+
 def parse_json(json):
     category_to_parser = {
         'bitmask': BitmaskType,
@@ -140,6 +162,7 @@ def parse_json(json):
         'native': NativeType,
         'natively defined': NativelyDefined,
         'object': ObjectType,
+        'structure': StructureType,
     }
 
     types = {}
@@ -159,6 +182,9 @@ def parse_json(json):
     for obj in by_category['object']:
         link_object(obj, types)
 
+    for struct in by_category['structure']:
+        link_structure(struct, types)
+
     for category in by_category.keys():
         by_category[category] = sorted(by_category[category], key=lambda typ: typ.name.canonical_case())
 
@@ -325,6 +351,9 @@ def as_backendType(typ):
     else:
         return as_cType(typ.name)
 
+def has_structure_arguments(method):
+    return any([arg.type.category == 'structure' for arg in method.arguments])
+
 def cpp_native_methods(types, typ):
     methods = typ.methods + typ.native_methods
 
@@ -347,7 +376,7 @@ def debug(text):
     print(text)
 
 def main():
-    targets = ['nxt', 'nxtcpp', 'mock_nxt', 'opengl', 'metal', 'd3d12', 'null', 'wire', 'blink']
+    targets = ['nxt', 'nxtcpp', 'mock_nxt', 'opengl', 'metal', 'd3d12', 'null', 'wire', 'profiling', 'blink']
 
     parser = argparse.ArgumentParser(
         description = 'Generates code for various target for NXT.',
@@ -451,14 +480,20 @@ def main():
         renders.append(FileRender('wire/WireClient.cpp', 'wire/WireClient.cpp', base_backend_params))
         renders.append(FileRender('wire/WireServer.cpp', 'wire/WireServer.cpp', base_backend_params))
 
+    if 'profiling' in targets:
+        renders.append(FileRender('ProfilingProcTable.cpp', 'profiling/ProfilingProcTable.cpp', [base_params, api_params, c_params]))
+
     if 'blink' in targets:
+        # TODO(agent@local): expose the descriptor methods with IDL dictionaries.
+        blink_params = {'blink_methods': lambda typ: [method for method in typ.methods if not has_structure_arguments(method)]}
+
         renders.append(FileRender('blink/autogen.gni', 'autogen.gni', [base_params, api_params]))
-        renders.append(FileRender('blink/Objects.cpp', 'NXT.cpp', [base_params, api_params]))
+        renders.append(FileRender('blink/Objects.cpp', 'NXT.cpp', [base_params, api_params, blink_params]))
         renders.append(FileRender('blink/Forward.h', 'Forward.h', [base_params, api_params]))
 
         for typ in api_params['by_category']['object']:
             file_prefix = 'NXT' + typ.name.CamelCase()
-            params = [base_params, api_params, {'type': typ}]
+            params = [base_params, api_params, blink_params, {'type': typ}]
 
             renders.append(FileRender('blink/Object.h', file_prefix + '.h', params))
             renders.append(FileRender('blink/Object.idl', file_prefix + '.idl', params))
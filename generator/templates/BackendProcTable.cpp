@@ -49,6 +49,7 @@ namespace {{namespace}} {
         {% set methodsWithExtraValidation = (
             "CommandBufferBuilderGetResult",
             "QueueSubmit",
+            "RenderBundleBuilderGetResult",
         ) %}
 
         {% for type in by_category["object"] %}
@@ -70,6 +71,8 @@ namespace {{namespace}} {
                             {%- if not loop.first %}, {% endif -%}
                             {%- if arg.type.category in ["enum", "bitmask"] -%}
                                 static_cast<nxt::{{as_cppType(arg.type.name)}}>({{as_varName(arg.name)}})
+                            {%- elif arg.type.category == "structure" -%}
+                                reinterpret_cast<const nxt::{{as_cppType(arg.type.name)}}*>({{as_varName(arg.name)}})
                             {%- else -%}
                                 {{as_varName(arg.name)}}
                             {%- endif -%}
@@ -81,7 +84,7 @@ namespace {{namespace}} {
                 }
 
                 //* Autogenerated part of the entry point validation
-                //*  - Check that enum and bitmaks are in the correct range
+                //*  - Check that enum and bitmaks are in the correct range, including in structures
                 //*  - Check that builders have not been consumed already
                 //*  - Others TODO
                 bool ValidateBase{{suffix}}(
@@ -104,6 +107,19 @@ namespace {{namespace}} {
                             if (!CheckEnum{{as_cType(arg.type.name)}}({{as_varName(arg.name)}})) error = true;;
                         {% elif arg.type.category == "bitmask" %}
                             if (!CheckBitmask{{as_cType(arg.type.name)}}({{as_varName(arg.name)}})) error = true;
+                        {% elif arg.type.category == "structure" %}
+                            if ({{as_varName(arg.name)}} == nullptr) {
+                                error = true;
+                            } else {
+                                {% for member in arg.type.members %}
+                                    {% set value = as_varName(arg.name) + "->" + as_varName(member.name) %}
+                                    {% if member.type.category == "enum" %}
+                                        if (!CheckEnum{{as_cType(member.type.name)}}({{value}})) error = true;
+                                    {% elif member.type.category == "bitmask" %}
+                                        if (!CheckBitmask{{as_cType(member.type.name)}}({{value}})) error = true;
+                                    {% endif %}
+                                {% endfor %}
+                            }
                         {% else %}
                             (void) {{as_varName(arg.name)}};
                         {% endif %}
@@ -169,6 +185,8 @@ namespace {{namespace}} {
                             {%- if not loop.first %}, {% endif -%}
                             {%- if arg.type.category in ["enum", "bitmask"] -%}
                                 static_cast<nxt::{{as_cppType(arg.type.name)}}>({{as_varName(arg.name)}})
+                            {%- elif arg.type.category == "structure" -%}
+                                reinterpret_cast<const nxt::{{as_cppType(arg.type.name)}}*>({{as_varName(arg.name)}})
                             {%- else -%}
                                 {{as_varName(arg.name)}}
                             {%- endif -%}
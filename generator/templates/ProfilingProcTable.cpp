@@ -0,0 +1,154 @@
+//* Copyright 2017 The NXT Authors
+//*
+//* Licensed under the Apache License, Version 2.0 (the "License");
+//* you may not use this file except in compliance with the License.
+//* You may obtain a copy of the License at
+//*
+//*     http://www.apache.org/licenses/LICENSE-2.0
+//*
+//* Unless required by applicable law or agreed to in writing, software
+//* distributed under the License is distributed on an "AS IS" BASIS,
+//* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//* See the License for the specific language governing permissions and
+//* limitations under the License.
+
+#include "utils/ProfilingProcTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+namespace utils {
+
+    namespace {
+
+        enum ProcIndex {
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    Proc{{as_MethodSuffix(type.name, method.name)}},
+                {% endfor %}
+            {% endfor %}
+            ProcCount,
+        };
+
+        const char* procNames[ProcCount] = {
+            {% for type in by_category["object"] %}
+                {% for method in native_methods(type) %}
+                    "{{as_cMethod(type.name, method.name)}}",
+                {% endfor %}
+            {% endfor %}
+        };
+
+        //* Atomics so that entry points called from several threads are all counted
+        struct ProcCounters {
+            std::atomic<uint64_t> callCount;
+            std::atomic<uint64_t> totalNanoseconds;
+        };
+        ProcCounters procCounters[ProcCount];
+
+        nxtProcTable profiledProcs;
+
+        class ScopedProcTimer {
+            public:
+                ScopedProcTimer(ProcIndex index)
+                    : index(index), begin(std::chrono::steady_clock::now()) {
+                }
+
+                ~ScopedProcTimer() {
+                    auto duration = std::chrono::steady_clock::now() - begin;
+                    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+                    procCounters[index].callCount.fetch_add(1, std::memory_order_relaxed);
+                    procCounters[index].totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+                }
+
+            private:
+                ProcIndex index;
+                std::chrono::steady_clock::time_point begin;
+        };
+
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                {% set suffix = as_MethodSuffix(type.name, method.name) %}
+                {{as_cType(method.return_type.name)}} Profiling{{suffix}}(
+                    {{-as_cType(type.name)}} self
+                    {%- for arg in method.arguments -%}
+                        , {{as_annotated_cType(arg)}}
+                    {%- endfor -%}
+                ) {
+                    ScopedProcTimer timer(Proc{{suffix}});
+                    return profiledProcs.{{as_varName(type.name, method.name)}}(self
+                        {%- for arg in method.arguments -%}
+                            , {{as_varName(arg.name)}}
+                        {%- endfor -%}
+                    );
+                }
+            {% endfor %}
+
+        {% endfor %}
+
+        void DumpProcProfilesToStderr() {
+            DumpProcProfiles(stderr);
+        }
+    }
+
+    nxtProcTable GetProfilingProcs(const nxtProcTable& procs) {
+        profiledProcs = procs;
+
+        nxtProcTable table;
+        {% for type in by_category["object"] %}
+            {% for method in native_methods(type) %}
+                table.{{as_varName(type.name, method.name)}} = Profiling{{as_MethodSuffix(type.name, method.name)}};
+            {% endfor %}
+        {% endfor %}
+        return table;
+    }
+
+    std::vector<ProcProfile> GetProcProfiles() {
+        std::vector<ProcProfile> profiles;
+        for (size_t i = 0; i < ProcCount; ++i) {
+            uint64_t callCount = procCounters[i].callCount.load(std::memory_order_relaxed);
+            if (callCount == 0) {
+                continue;
+            }
+
+            ProcProfile profile;
+            profile.name = procNames[i];
+            profile.callCount = callCount;
+            profile.totalNanoseconds = procCounters[i].totalNanoseconds.load(std::memory_order_relaxed);
+            profiles.push_back(profile);
+        }
+
+        std::stable_sort(profiles.begin(), profiles.end(), [](const ProcProfile& a, const ProcProfile& b) {
+            return a.totalNanoseconds > b.totalNanoseconds;
+        });
+        return profiles;
+    }
+
+    void ResetProcProfiles() {
+        for (ProcCounters& counters : procCounters) {
+            counters.callCount.store(0, std::memory_order_relaxed);
+            counters.totalNanoseconds.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void DumpProcProfiles(FILE* file) {
+        fprintf(file, "%12s %12s %12s  %s\n", "calls", "total ms", "ns/call", "entry point");
+        for (const ProcProfile& profile : GetProcProfiles()) {
+            fprintf(file, "%12llu %12.3f %12.1f  %s\n",
+                    static_cast<unsigned long long>(profile.callCount),
+                    profile.totalNanoseconds / 1e6,
+                    static_cast<double>(profile.totalNanoseconds) / profile.callCount,
+                    profile.name);
+        }
+    }
+
+    void DumpProcProfilesAtExit() {
+        static bool registered = false;
+        if (!registered) {
+            registered = true;
+            atexit(DumpProcProfilesToStderr);
+        }
+    }
+}
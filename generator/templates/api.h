@@ -33,6 +33,14 @@
 
 {% endfor %}
 
+{% for type in by_category["structure"] %}
+    typedef struct {{as_cType(type.name)}} {
+        {% for member in type.members %}
+            {{as_cType(member.type.name)}} {{as_varName(member.name)}};
+        {% endfor %}
+    } {{as_cType(type.name)}};
+
+{% endfor %}
 // Custom types depending on the target language
 typedef uint64_t nxtCallbackUserdata;
 typedef void (*nxtDeviceErrorCallback)(const char* message, nxtCallbackUserdata userdata);
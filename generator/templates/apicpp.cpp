@@ -14,6 +14,8 @@
 
 #include "nxtcpp.h"
 
+#include <cstddef>
+
 namespace nxt {
 
     {% for type in by_category["enum"] + by_category["bitmask"] %}
@@ -29,6 +31,19 @@ namespace nxt {
 
     {% endfor %}
 
+    {% for type in by_category["structure"] %}
+        {% set CppType = as_cppType(type.name) %}
+        {% set CType = as_cType(type.name) %}
+
+        static_assert(sizeof({{CppType}}) == sizeof({{CType}}), "sizeof mismatch for {{CppType}}");
+        static_assert(alignof({{CppType}}) == alignof({{CType}}), "alignof mismatch for {{CppType}}");
+
+        {% for member in type.members %}
+            {% set memberName = as_varName(member.name) %}
+            static_assert(offsetof({{CppType}}, {{memberName}}) == offsetof({{CType}}, {{memberName}}), "offsetof mismatch for {{CppType}}::{{memberName}}");
+        {% endfor %}
+
+    {% endfor %}
 
     {% for type in by_category["object"] %}
         {% set CppType = as_cppType(type.name) %}
@@ -51,6 +51,15 @@ namespace nxt {
         using {{as_cppType(type.name)}} = {{as_cType(type.name)}};
     {% endfor %}
 
+    {% for type in by_category["structure"] %}
+        struct {{as_cppType(type.name)}} {
+            {% for member in type.members %}
+                {{as_cppType(member.type.name)}} {{as_varName(member.name)}};
+            {% endfor %}
+        };
+
+    {% endfor %}
+
     {% for type in by_category["object"] %}
         class {{as_cppType(type.name)}};
     {% endfor %}
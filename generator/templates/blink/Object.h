@@ -54,7 +54,7 @@ class {{Class}} final :
         {{Class}}({{as_cType(type.name)}} self, Member<NXTState> state);
         void Dispose();
 
-        {% for method in type.methods %}
+        {% for method in blink_methods(type) %}
             {% if method.return_type.name.concatcase() == "void" %}
                 {{Class}}*
             {%- else %}
@@ -42,7 +42,7 @@ namespace blink {
             {% endif %}
         }
 
-        {% for method in type.methods %}
+        {% for method in blink_methods(type) %}
             {% if method.return_type.name.concatcase() == "void" %}
                 {{Class}}*
             {%- else %}
@@ -16,6 +16,8 @@
 #include "wire/WireCmd.h"
 
 #include "common/Assert.h"
+#include "common/StackVector.h"
+#include "common/Tracing.h"
 
 #include <cstring>
 #include <vector>
@@ -26,6 +28,9 @@ namespace wire {
     namespace server {
         class Server;
 
+        //* Arrays of objects up to this size are unpacked on the stack.
+        static constexpr size_t kMaxInlineObjects = 16;
+
         struct MapReadUserdata {
             Server* server;
             uint32_t bufferId;
@@ -206,6 +211,7 @@ namespace wire {
                 }
 
                 const uint8_t* HandleCommands(const uint8_t* commands, size_t size) override {
+                    NXT_TRACE_EVENT("wire", "Server::HandleCommands");
                     procs.deviceTick(knownDevice.Get(1)->handle);
 
                     while (size > sizeof(WireCmd)) {
@@ -335,8 +341,8 @@ namespace wire {
                                     }
                                 {% elif arg.type.category == "object" %}
                                     //* Unpack arrays of objects.
-                                    //* TODO(cwallez@chromium.org) do not allocate when there are few objects.
-                                    std::vector<{{as_cType(arg.type.name)}}> {{argName}}Storage(cmd->{{as_varName(arg.length.name)}});
+                                    //* Only commands with many objects allocate to unpack them.
+                                    StackVector<{{as_cType(arg.type.name)}}, kMaxInlineObjects> {{argName}}Storage(cmd->{{as_varName(arg.length.name)}});
                                     auto {{argName}}Ids = reinterpret_cast<const uint32_t*>(cmd->GetPtr_{{argName}}());
                                     for (size_t i = 0; i < cmd->{{as_varName(arg.length.name)}}; i++) {
                                         {% set Type = arg.type.name.CamelCase() %}
@@ -349,7 +355,7 @@ namespace wire {
                                     }
                                     arg_{{argName}} = {{argName}}Storage.data();
                                 {% else %}
-                                    //* For anything else, just get the pointer.
+                                    //* For anything else, including structures, just get the pointer.
                                     arg_{{argName}} = reinterpret_cast<const {{as_cType(arg.type.name)}}*>(cmd->GetPtr_{{argName}}());
                                 {% endif %}
                             {% endfor %}
@@ -19,13 +19,69 @@
 #include "backend/Device.h"
 #include "backend/Texture.h"
 #include "common/Assert.h"
+#include "common/HashUtils.h"
+
+#include <algorithm>
 
 namespace backend {
 
     // BindGroup
 
-    BindGroupBase::BindGroupBase(BindGroupBuilder* builder)
-        : layout(std::move(builder->layout)), usage(builder->usage), bindings(std::move(builder->bindings)) {
+    BindGroupBase::BindGroupBase(BindGroupBuilder* builder, bool blueprint)
+        : device(builder->device), layout(builder->layout), usage(builder->usage), bindings(builder->bindings), blueprint(blueprint) {
+        const auto& layoutInfo = layout->GetBindingInfo();
+        uint32_t dynamicIndex = 0;
+        for (size_t i = 0; i < kMaxBindingsPerGroup; ++i) {
+            if (!layoutInfo.mask[i]) {
+                continue;
+            }
+
+            switch (layoutInfo.types[i]) {
+                case nxt::BindingType::UniformBuffer:
+                case nxt::BindingType::DynamicUniformBuffer:
+                case nxt::BindingType::StorageBuffer:
+                    {
+                        BufferViewBase* view = GetBindingAsBufferView(i);
+
+                        nxt::BufferUsageBit requiredUsage = nxt::BufferUsageBit::Uniform;
+                        if (layoutInfo.types[i] == nxt::BindingType::StorageBuffer) {
+                            requiredUsage = nxt::BufferUsageBit::Storage;
+                            hasStorageBuffers = true;
+                        }
+
+                        if (layoutInfo.types[i] == nxt::BindingType::DynamicUniformBuffer) {
+                            maxDynamicOffsets[dynamicIndex++] = view->GetBuffer()->GetSize() - view->GetOffset() - view->GetSize();
+                        }
+
+                        BufferUsage required(view->GetBuffer(), requiredUsage);
+                        if (std::find(requiredBufferUsages.begin(), requiredBufferUsages.end(), required) == requiredBufferUsages.end()) {
+                            requiredBufferUsages.push_back(required);
+                            requiredUsagesFrozen = requiredUsagesFrozen && required.first->HasFrozenUsage(required.second);
+                        }
+                    }
+                    break;
+
+                case nxt::BindingType::SampledTexture:
+                    {
+                        TextureUsage required(GetBindingAsTextureView(i)->GetTexture(), nxt::TextureUsageBit::Sampled);
+                        if (std::find(requiredTextureUsages.begin(), requiredTextureUsages.end(), required) == requiredTextureUsages.end()) {
+                            requiredTextureUsages.push_back(required);
+                            requiredUsagesFrozen = requiredUsagesFrozen && required.first->HasFrozenUsage(required.second);
+                        }
+                    }
+                    break;
+
+                case nxt::BindingType::Sampler:
+                    break;
+            }
+        }
+    }
+
+    BindGroupBase::~BindGroupBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheBindGroup(this);
+        }
     }
 
     const BindGroupLayoutBase* BindGroupBase::GetLayout() const {
@@ -36,10 +92,32 @@ namespace backend {
         return usage;
     }
 
+    const std::vector<BindGroupBase::BufferUsage>& BindGroupBase::GetRequiredBufferUsages() const {
+        return requiredBufferUsages;
+    }
+
+    const std::vector<BindGroupBase::TextureUsage>& BindGroupBase::GetRequiredTextureUsages() const {
+        return requiredTextureUsages;
+    }
+
+    bool BindGroupBase::AreRequiredUsagesFrozen() const {
+        return requiredUsagesFrozen;
+    }
+
+    bool BindGroupBase::HasStorageBuffers() const {
+        return hasStorageBuffers;
+    }
+
+    uint32_t BindGroupBase::GetMaxDynamicOffset(uint32_t dynamicIndex) const {
+        ASSERT(dynamicIndex < layout->GetDynamicBufferCount());
+        return maxDynamicOffsets[dynamicIndex];
+    }
+
     BufferViewBase* BindGroupBase::GetBindingAsBufferView(size_t binding) {
         ASSERT(binding < kMaxBindingsPerGroup);
         ASSERT(layout->GetBindingInfo().mask[binding]);
         ASSERT(layout->GetBindingInfo().types[binding] == nxt::BindingType::UniformBuffer ||
+              layout->GetBindingInfo().types[binding] == nxt::BindingType::DynamicUniformBuffer ||
               layout->GetBindingInfo().types[binding] == nxt::BindingType::StorageBuffer);
         return reinterpret_cast<BufferViewBase*>(bindings[binding].Get());
     }
@@ -80,7 +158,13 @@ namespace backend {
             return nullptr;
         }
 
-        return device->CreateBindGroup(this);
+        // Dynamic bind groups can be modified so they can't be shared.
+        if (usage == nxt::BindGroupUsage::Dynamic) {
+            return device->CreateBindGroup(this);
+        }
+
+        BindGroupBase blueprint(this, true);
+        return device->GetOrCreateBindGroup(&blueprint, this);
     }
 
     void BindGroupBuilder::SetLayout(BindGroupLayoutBase* layout) {
@@ -113,6 +197,7 @@ namespace backend {
             nxt::BufferUsageBit requiredBit;
             switch (layoutInfo.types[i]) {
                 case nxt::BindingType::UniformBuffer:
+                case nxt::BindingType::DynamicUniformBuffer:
                     requiredBit = nxt::BufferUsageBit::Uniform;
                     break;
 
@@ -205,4 +290,27 @@ namespace backend {
 
         return true;
     }
+    // BindGroupCacheFuncs
+
+    size_t BindGroupCacheFuncs::operator() (const BindGroupBase* group) const {
+        size_t hash = Hash(group->layout.Get());
+        CombineHashes(&hash, Hash(group->usage));
+        for (const auto& binding : group->bindings) {
+            CombineHashes(&hash, Hash(binding.Get()));
+        }
+        return hash;
+    }
+
+    bool BindGroupCacheFuncs::operator() (const BindGroupBase* a, const BindGroupBase* b) const {
+        if (a->layout.Get() != b->layout.Get() || a->usage != b->usage) {
+            return false;
+        }
+        for (size_t binding = 0; binding < kMaxBindingsPerGroup; ++binding) {
+            if (a->bindings[binding].Get() != b->bindings[binding].Get()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
 }
@@ -25,12 +25,15 @@
 #include <array>
 #include <bitset>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace backend {
 
     class BindGroupBase : public RefCounted {
         public:
-            BindGroupBase(BindGroupBuilder* builder);
+            BindGroupBase(BindGroupBuilder* builder, bool blueprint = false);
+            ~BindGroupBase() override;
 
             const BindGroupLayoutBase* GetLayout() const;
             nxt::BindGroupUsage GetUsage() const;
@@ -38,10 +41,39 @@ namespace backend {
             SamplerBase* GetBindingAsSampler(size_t binding);
             TextureViewBase* GetBindingAsTextureView(size_t binding);
 
+            // The usages the resources of the group need to have when it is set, without
+            // duplicates, computed when the group is created so that setting it doesn't have to
+            // look at each binding.
+            using BufferUsage = std::pair<BufferBase*, nxt::BufferUsageBit>;
+            using TextureUsage = std::pair<TextureBase*, nxt::TextureUsageBit>;
+            const std::vector<BufferUsage>& GetRequiredBufferUsages() const;
+            const std::vector<TextureUsage>& GetRequiredTextureUsages() const;
+
+            // True if all the required usages were frozen when the group was created. Frozen
+            // usages can't change so the usages don't need to be checked when setting the group.
+            bool AreRequiredUsagesFrozen() const;
+
+            // True if the GPU can write to buffers of the group.
+            bool HasStorageBuffers() const;
+
+            // The largest offset that can be added to the view of the dynamic uniform buffer at
+            // dynamicIndex without going out of its buffer.
+            uint32_t GetMaxDynamicOffset(uint32_t dynamicIndex) const;
+
         private:
+            friend struct BindGroupCacheFuncs;
+
+            DeviceBase* device;
             Ref<BindGroupLayoutBase> layout;
             nxt::BindGroupUsage usage;
             std::array<Ref<RefCounted>, kMaxBindingsPerGroup> bindings;
+            bool blueprint = false;
+
+            std::vector<BufferUsage> requiredBufferUsages;
+            std::vector<TextureUsage> requiredTextureUsages;
+            bool requiredUsagesFrozen = true;
+            bool hasStorageBuffers = false;
+            std::array<uint32_t, kMaxBindingsPerGroup> maxDynamicOffsets;
     };
 
     class BindGroupBuilder : public Builder<BindGroupBase> {
@@ -88,6 +120,15 @@ namespace backend {
             std::array<Ref<RefCounted>, kMaxBindingsPerGroup> bindings;
     };
 
+    // Implements the functors necessary for the unordered_set<BindGroup*>-based cache.
+    struct BindGroupCacheFuncs {
+        // The hash function
+        size_t operator() (const BindGroupBase* group) const;
+
+        // The equality predicate
+        bool operator() (const BindGroupBase* a, const BindGroupBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_BINDGROUP_H_
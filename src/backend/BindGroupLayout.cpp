@@ -15,33 +15,12 @@
 #include "backend/BindGroupLayout.h"
 
 #include "backend/Device.h"
-
-#include <functional>
+#include "common/HashUtils.h"
 
 namespace backend {
 
     namespace {
 
-        // Workaround for Chrome's stdlib having a broken std::hash for enums and bitsets
-        template<typename T>
-        typename std::enable_if<std::is_enum<T>::value, size_t>::type Hash(T value) {
-            using Integral = typename nxt::UnderlyingType<T>::type;
-            return std::hash<Integral>()(static_cast<Integral>(value));
-        }
-
-        template<size_t N>
-        size_t Hash(const std::bitset<N>& value) {
-            static_assert(N <= sizeof(unsigned long long) * 8, "");
-            return std::hash<unsigned long long>()(value.to_ullong());
-        }
-
-
-        // TODO(cwallez@chromium.org): see if we can use boost's hash combined or some equivalent
-        // this currently assumes that size_t is 64 bits
-        void CombineHashes(size_t* h1, size_t h2) {
-            *h1 ^= (h2 << 7) + (h2 >> (64 - 7)) + 0x304975;
-        }
-
         size_t HashBindingInfo(const BindGroupLayoutBase::LayoutBindingInfo& info) {
             size_t hash = Hash(info.mask);
 
@@ -79,6 +58,11 @@ namespace backend {
 
     BindGroupLayoutBase::BindGroupLayoutBase(BindGroupLayoutBuilder* builder, bool blueprint)
         : device(builder->device), bindingInfo(builder->bindingInfo), blueprint(blueprint) {
+        for (size_t binding = 0; binding < kMaxBindingsPerGroup; ++binding) {
+            if (bindingInfo.mask[binding] && bindingInfo.types[binding] == nxt::BindingType::DynamicUniformBuffer) {
+                dynamicBufferCount++;
+            }
+        }
     }
 
     BindGroupLayoutBase::~BindGroupLayoutBase() {
@@ -92,6 +76,10 @@ namespace backend {
         return bindingInfo;
     }
 
+    uint32_t BindGroupLayoutBase::GetDynamicBufferCount() const {
+        return dynamicBufferCount;
+    }
+
     // BindGroupLayoutBuilder
 
     BindGroupLayoutBuilder::BindGroupLayoutBuilder(DeviceBase* device) : Builder(device) {
@@ -104,9 +92,7 @@ namespace backend {
     BindGroupLayoutBase* BindGroupLayoutBuilder::GetResultImpl() {
         BindGroupLayoutBase blueprint(this, true);
 
-        auto* result = device->GetOrCreateBindGroupLayout(&blueprint, this);
-        result->Reference();
-        return result;
+        return device->GetOrCreateBindGroupLayout(&blueprint, this);
     }
 
     void BindGroupLayoutBuilder::SetBindingsType(nxt::ShaderStageBit visibility, nxt::BindingType bindingType, uint32_t start, uint32_t count) {
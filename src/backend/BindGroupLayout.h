@@ -39,9 +39,14 @@ namespace backend {
             };
             const LayoutBindingInfo& GetBindingInfo() const;
 
+            // The number of dynamic offsets SetBindGroup takes for groups of this layout, one per
+            // dynamic uniform buffer in increasing binding order.
+            uint32_t GetDynamicBufferCount() const;
+
         private:
             DeviceBase* device;
             LayoutBindingInfo bindingInfo;
+            uint32_t dynamicBufferCount = 0;
             bool blueprint = false;
     };
 
@@ -15,17 +15,84 @@
 #include "backend/Buffer.h"
 
 #include "backend/Device.h"
+#include "backend/InputState.h"
 #include "common/Assert.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 #include <cstdio>
 
 namespace backend {
 
+    namespace {
+
+        // The usages with which the GPU can write to the buffer.
+        const nxt::BufferUsageBit kWritableUsages =
+            nxt::BufferUsageBit::TransferDst |
+            nxt::BufferUsageBit::Storage;
+
+        // A plain reduction that the compiler can vectorize. The indices are read with memcpy
+        // because the offsets of index buffers don't have to be aligned.
+        template<typename T>
+        uint32_t ScanMaxIndex(const uint8_t* data, uint32_t count) {
+            T result = 0;
+            for (uint32_t i = 0; i < count; ++i) {
+                T index;
+                memcpy(&index, data + i * sizeof(T), sizeof(T));
+                result = index > result ? index : result;
+            }
+            return result;
+        }
+
+        constexpr uint32_t kShadowPageSize = 4096;
+
+        // Returns true if all the 4-byte words overlapping [begin, end) were written.
+        bool AreContentsKnown(const std::vector<uint64_t>& knownWords, uint32_t begin, uint32_t end) {
+            if (knownWords.empty()) {
+                return false;
+            }
+            for (uint32_t word = begin / sizeof(uint32_t); word < (end + sizeof(uint32_t) - 1) / sizeof(uint32_t); ++word) {
+                if ((knownWords[word / 64] & (uint64_t(1) << (word % 64))) == 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Scans the indices page by page. An index that straddles two pages is gathered first.
+        template<typename T>
+        uint32_t ScanShadowMaxIndex(const std::vector<std::unique_ptr<uint8_t[]>>& pages,
+                                    uint32_t byteOffset, uint32_t indexCount) {
+            uint32_t result = 0;
+            uint32_t offset = byteOffset;
+            uint32_t end = byteOffset + indexCount * sizeof(T);
+            while (offset < end) {
+                uint32_t inPage = offset % kShadowPageSize;
+                uint32_t count = std::min(kShadowPageSize - inPage, end - offset) / sizeof(T);
+                if (count > 0) {
+                    const uint8_t* data = pages[offset / kShadowPageSize].get() + inPage;
+                    result = std::max(result, ScanMaxIndex<T>(data, count));
+                    offset += count * sizeof(T);
+                } else {
+                    uint8_t data[sizeof(T)];
+                    for (uint32_t i = 0; i < sizeof(T); ++i) {
+                        data[i] = pages[(offset + i) / kShadowPageSize][(offset + i) % kShadowPageSize];
+                    }
+                    result = std::max(result, ScanMaxIndex<T>(data, 1));
+                    offset += sizeof(T);
+                }
+            }
+            return result;
+        }
+
+    }
+
     // Buffer
 
     BufferBase::BufferBase(BufferBuilder* builder)
         : device(builder->device),
+          denseIndex(device->GetBufferIndexAllocator()->Allocate()),
           size(builder->size),
           allowedUsage(builder->allowedUsage),
           currentUsage(builder->currentUsage) {
@@ -35,6 +102,7 @@ namespace backend {
         if (mapped) {
             CallMapReadCallback(mapReadSerial, NXT_BUFFER_MAP_READ_STATUS_UNKNOWN, nullptr);
         }
+        device->GetBufferIndexAllocator()->Free(denseIndex);
     }
 
     BufferViewBuilder* BufferBase::CreateBufferViewBuilder() {
@@ -76,6 +144,122 @@ namespace backend {
         }
 
         SetSubDataImpl(start, count, data);
+
+        if (allowedUsage & nxt::BufferUsageBit::Index) {
+            uint32_t begin = start * sizeof(uint32_t);
+            uint32_t end = (start + count) * sizeof(uint32_t);
+
+            std::lock_guard<std::mutex> lock(contentsMutex);
+            if (knownWords.empty()) {
+                shadowPages.resize((size + kShadowPageSize - 1) / kShadowPageSize);
+                knownWords.assign((size / sizeof(uint32_t) + 63) / 64, 0);
+            }
+
+            const uint8_t* source = reinterpret_cast<const uint8_t*>(data);
+            for (uint32_t offset = begin; offset < end;) {
+                uint32_t page = offset / kShadowPageSize;
+                uint32_t inPage = offset % kShadowPageSize;
+                uint32_t copySize = std::min(kShadowPageSize - inPage, end - offset);
+                if (shadowPages[page] == nullptr) {
+                    shadowPages[page].reset(new uint8_t[kShadowPageSize]);
+                }
+                memcpy(shadowPages[page].get() + inPage, source + (offset - begin), copySize);
+                offset += copySize;
+            }
+            for (uint32_t word = start; word < start + count; ++word) {
+                knownWords[word / 64] |= uint64_t(1) << (word % 64);
+            }
+
+            ClearMaxIndexCache();
+            contentsGeneration++;
+        }
+    }
+
+    uint32_t BufferBase::GetContentsGeneration() const {
+        return contentsGeneration.load(std::memory_order_acquire);
+    }
+
+    void BufferBase::InvalidateContents() {
+        if (!(allowedUsage & nxt::BufferUsageBit::Index)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(contentsMutex);
+        shadowPages.clear();
+        knownWords.clear();
+        ClearMaxIndexCache();
+        contentsGeneration++;
+    }
+
+    void BufferBase::ClearMaxIndexCache() {
+        largestMaxIndexRange = MaxIndexCacheEntry();
+        recentMaxIndexRangeCount = 0;
+    }
+
+    bool BufferBase::GetMaxIndex(uint32_t byteOffset, uint32_t indexCount, nxt::IndexFormat format, uint32_t* maxIndex) {
+        size_t indexSize = IndexFormatSize(format);
+        ASSERT(uint64_t(byteOffset) + uint64_t(indexCount) * indexSize <= size);
+
+        std::lock_guard<std::mutex> lock(contentsMutex);
+
+        auto IsRange = [&](const MaxIndexCacheEntry& entry) {
+            return entry.byteOffset == byteOffset && entry.indexCount == indexCount &&
+                entry.format == format;
+        };
+
+        if (indexCount == 0) {
+            *maxIndex = 0;
+            return true;
+        }
+        if (IsRange(largestMaxIndexRange)) {
+            *maxIndex = largestMaxIndexRange.maxIndex;
+            return true;
+        }
+        for (size_t i = 0; i < recentMaxIndexRangeCount; ++i) {
+            if (IsRange(recentMaxIndexRanges[i])) {
+                *maxIndex = recentMaxIndexRanges[i].maxIndex;
+                std::rotate(recentMaxIndexRanges.begin(), recentMaxIndexRanges.begin() + i,
+                            recentMaxIndexRanges.begin() + i + 1);
+                return true;
+            }
+        }
+
+        // Ranges are only cached when their contents are known so this is checked after the
+        // cache lookup.
+        if (!AreContentsKnown(knownWords, byteOffset, byteOffset + indexCount * indexSize)) {
+            return false;
+        }
+
+        switch (format) {
+            case nxt::IndexFormat::Uint16:
+                *maxIndex = ScanShadowMaxIndex<uint16_t>(shadowPages, byteOffset, indexCount);
+                break;
+            case nxt::IndexFormat::Uint32:
+                *maxIndex = ScanShadowMaxIndex<uint32_t>(shadowPages, byteOffset, indexCount);
+                break;
+        }
+
+        MaxIndexCacheEntry entry;
+        entry.byteOffset = byteOffset;
+        entry.indexCount = indexCount;
+        entry.format = format;
+        entry.maxIndex = *maxIndex;
+
+        // A range replacing the largest one is moved to the recently used ranges instead of
+        // being dropped.
+        if (indexCount * indexSize > largestMaxIndexRange.indexCount * IndexFormatSize(largestMaxIndexRange.format)) {
+            std::swap(entry, largestMaxIndexRange);
+            if (entry.indexCount == 0) {
+                return true;
+            }
+        }
+        if (recentMaxIndexRangeCount < kMaxIndexCacheSize) {
+            recentMaxIndexRangeCount++;
+        }
+        std::rotate(recentMaxIndexRanges.begin(), recentMaxIndexRanges.begin() + recentMaxIndexRangeCount - 1,
+                    recentMaxIndexRanges.begin() + recentMaxIndexRangeCount);
+        recentMaxIndexRanges[0] = entry;
+        return true;
     }
 
     void BufferBase::MapReadAsync(uint32_t start, uint32_t size, nxtBufferMapReadCallback callback, nxtCallbackUserdata userdata) {
@@ -122,8 +306,16 @@ namespace backend {
         return frozen;
     }
 
+    bool BufferBase::IsMapped() const {
+        return mapped;
+    }
+
     bool BufferBase::HasFrozenUsage(nxt::BufferUsageBit usage) const {
-        return frozen && (usage & allowedUsage);
+        return GetUsageState().HasFrozenUsage(usage);
+    }
+
+    BufferUsageState BufferBase::GetUsageState() const {
+        return {allowedUsage, frozen, mapped};
     }
 
     bool BufferBase::IsUsagePossible(nxt::BufferUsageBit allowedUsage, nxt::BufferUsageBit usage) {
@@ -140,22 +332,29 @@ namespace backend {
     }
 
     bool BufferBase::IsTransitionPossible(nxt::BufferUsageBit usage) const {
-        if (frozen || mapped) {
-            return false;
-        }
-        return IsUsagePossible(allowedUsage, usage);
+        return GetUsageState().IsTransitionPossible(usage);
     }
 
     void BufferBase::UpdateUsageInternal(nxt::BufferUsageBit usage) {
         ASSERT(IsTransitionPossible(usage));
+        if (usage & kWritableUsages) {
+            InvalidateContents();
+        }
         currentUsage = usage;
     }
 
+    uint32_t BufferBase::GetDenseIndex() const {
+        return denseIndex;
+    }
+
     void BufferBase::TransitionUsage(nxt::BufferUsageBit usage) {
         if (!IsTransitionPossible(usage)) {
             device->HandleError("Buffer frozen or usage not allowed");
             return;
         }
+        if (usage & kWritableUsages) {
+            InvalidateContents();
+        }
         TransitionUsageImpl(currentUsage, usage);
         currentUsage = usage;
     }
@@ -165,12 +364,45 @@ namespace backend {
             device->HandleError("Buffer frozen or usage not allowed");
             return;
         }
+        if (usage & kWritableUsages) {
+            InvalidateContents();
+        }
         allowedUsage = usage;
         TransitionUsageImpl(currentUsage, usage);
         currentUsage = usage;
         frozen = true;
     }
 
+    // BufferUsageState
+
+    bool BufferUsageState::HasFrozenUsage(nxt::BufferUsageBit usage) const {
+        return frozen && (usage & allowedUsage);
+    }
+
+    bool BufferUsageState::IsTransitionPossible(nxt::BufferUsageBit usage) const {
+        if (frozen || mapped) {
+            return false;
+        }
+        return BufferBase::IsUsagePossible(allowedUsage, usage);
+    }
+
+    bool RevalidateIndexRange(IndexRangeCheck* check) {
+        // The generation is read before the contents so that a concurrent change is seen by the
+        // next check.
+        uint32_t generation = check->buffer->GetContentsGeneration();
+        if (generation == check->contentsGeneration) {
+            return true;
+        }
+
+        uint32_t maxIndex;
+        if (check->buffer->GetMaxIndex(check->byteOffset, check->indexCount, check->format, &maxIndex) &&
+            maxIndex >= check->maxVertexCount) {
+            return false;
+        }
+        check->contentsGeneration = generation;
+        return true;
+    }
+
     // BufferBuilder
 
     enum BufferSetProperties {
@@ -21,8 +21,25 @@
 
 #include "nxt/nxtcpp.h"
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace backend {
 
+    // The part of the state of a buffer that decides the usages command buffers can give it.
+    // Command buffers validated on another thread use a copy captured when they are created.
+    struct BufferUsageState {
+        nxt::BufferUsageBit allowedUsage;
+        bool frozen;
+        bool mapped;
+
+        bool HasFrozenUsage(nxt::BufferUsageBit usage) const;
+        bool IsTransitionPossible(nxt::BufferUsageBit usage) const;
+    };
+
     class BufferBase : public RefCounted {
         public:
             BufferBase(BufferBuilder* builder);
@@ -34,9 +51,28 @@ namespace backend {
             static bool IsUsagePossible(nxt::BufferUsageBit allowedUsage, nxt::BufferUsageBit usage);
             bool IsTransitionPossible(nxt::BufferUsageBit usage) const;
             bool IsFrozen() const;
+            bool IsMapped() const;
             bool HasFrozenUsage(nxt::BufferUsageBit usage) const;
+            BufferUsageState GetUsageState() const;
             void UpdateUsageInternal(nxt::BufferUsageBit usage);
 
+            // Unique among the live buffers of the device, see DenseIndexAllocator.
+            uint32_t GetDenseIndex() const;
+
+            // Buffers that allow the index usage keep a copy of the contents written with
+            // SetSubData so that the indices used by DrawElements can be validated. Only the parts
+            // of the buffer that are written are copied. What the GPU
+            // writes isn't known, so the contents are invalidated when the buffer is transitioned
+            // to a usage the GPU can write, and when a command buffer writing it is submitted.
+            // Each change of the contents increments the contents generation.
+            uint32_t GetContentsGeneration() const;
+            void InvalidateContents();
+
+            // Gets the largest of indexCount indices of the given format, starting at byteOffset.
+            // The results for the largest range and for a few recently used ones are cached until
+            // the contents change. Returns false if the contents of the range aren't known.
+            bool GetMaxIndex(uint32_t byteOffset, uint32_t indexCount, nxt::IndexFormat format, uint32_t* maxIndex);
+
             DeviceBase* GetDevice();
 
             // NXT API
@@ -57,6 +93,7 @@ namespace backend {
             virtual void TransitionUsageImpl(nxt::BufferUsageBit currentUsage, nxt::BufferUsageBit targetUsage) = 0;
 
             DeviceBase* device;
+            uint32_t denseIndex;
             uint32_t size;
             nxt::BufferUsageBit allowedUsage = nxt::BufferUsageBit::None;
             nxt::BufferUsageBit currentUsage = nxt::BufferUsageBit::None;
@@ -67,8 +104,48 @@ namespace backend {
 
             bool frozen = false;
             bool mapped = false;
+
+            struct MaxIndexCacheEntry {
+                uint32_t byteOffset = 0;
+                uint32_t indexCount = 0;
+                nxt::IndexFormat format = nxt::IndexFormat::Uint16;
+                uint32_t maxIndex = 0;
+            };
+            static constexpr size_t kMaxIndexCacheSize = 8;
+
+            void ClearMaxIndexCache();
+
+            // Validation can happen on several threads so the contents are protected by a mutex.
+            // The copy of the contents is split in pages that are allocated when they are first
+            // written, and a bit per 4-byte word of the buffer tells if the word was written.
+            std::mutex contentsMutex;
+            std::vector<std::unique_ptr<uint8_t[]>> shadowPages;
+            std::vector<uint64_t> knownWords;
+            // The largest range is usually the whole range bound by SetIndexBuffer and is kept
+            // apart so that it isn't evicted by the ranges of individual draws. The recent ranges
+            // are sorted from the most to the least recently used.
+            MaxIndexCacheEntry largestMaxIndexRange;
+            std::array<MaxIndexCacheEntry, kMaxIndexCacheSize> recentMaxIndexRanges;
+            size_t recentMaxIndexRangeCount = 0;
+            std::atomic<uint32_t> contentsGeneration{0};
     };
 
+    // A range of indices used by DrawElements that was checked against the number of vertices
+    // available in the vertex buffers, when the contents of the index buffer had the given
+    // generation.
+    struct IndexRangeCheck {
+        BufferBase* buffer;
+        uint32_t byteOffset;
+        uint32_t indexCount;
+        nxt::IndexFormat format;
+        uint32_t maxVertexCount;
+        uint32_t contentsGeneration;
+    };
+
+    // Checks the range again if the contents of the buffer changed since the last check. Contents
+    // that aren't known are considered valid.
+    bool RevalidateIndexRange(IndexRangeCheck* check);
+
     class BufferBuilder : public Builder<BufferBase> {
         public:
             BufferBuilder(DeviceBase* device);
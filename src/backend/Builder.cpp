@@ -28,9 +28,48 @@ namespace backend {
     }
 
     void BuilderBase::HandleError(const char* message) {
+        if (latchingErrors) {
+            if (!hasLatchedError) {
+                hasLatchedError = true;
+                latchedMessage = message;
+            }
+            return;
+        }
         SetStatus(nxt::BuilderErrorStatus::Error, message);
     }
 
+    void BuilderBase::StartLatchingErrors() {
+        latchingErrors = true;
+    }
+
+    void BuilderBase::StopLatchingErrors() {
+        if (!latchingErrors) {
+            return;
+        }
+        latchingErrors = false;
+
+        if (hasLatchedError) {
+            SetStatus(nxt::BuilderErrorStatus::Error, latchedMessage.c_str());
+        }
+    }
+
+    bool BuilderBase::HasLatchedError() const {
+        return hasLatchedError;
+    }
+
+    void BuilderBase::DeferResult() {
+        resultDeferred = true;
+    }
+
+    void BuilderBase::ResolveDeferredResult() {
+        ASSERT(resultDeferred && consumed);
+        resultDeferred = false;
+
+        if (callback) {
+            callback(static_cast<nxtBuilderErrorStatus>(storedStatus), storedMessage.c_str(), userdata1, userdata2);
+        }
+    }
+
     void BuilderBase::SetErrorCallback(nxt::BuilderErrorCallback callback,
                                    nxt::CallbackUserdata userdata1,
                                    nxt::CallbackUserdata userdata2) {
@@ -63,6 +102,12 @@ namespace backend {
         ASSERT(!consumed);
         consumed = true;
 
+        // The status isn't known yet, it will be given by ResolveDeferredResult.
+        if (resultDeferred) {
+            ASSERT(result != nullptr);
+            return true;
+        }
+
         // result == nullptr implies there was an error which implies we should have a status set.
         ASSERT(result != nullptr || gotStatus);
 
@@ -47,6 +47,19 @@ namespace backend {
             // Set the status of the builder to an error.
             void HandleError(const char* message);
 
+            // Builders that validate while recording latch their errors, so that they can still
+            // be used until GetResult like builders that validate in GetResult. Only the first
+            // error is kept, it becomes the status of the builder when latching stops.
+            void StartLatchingErrors();
+            void StopLatchingErrors();
+            bool HasLatchedError() const;
+
+            // Builders that validate their result in the background defer the callback: after
+            // DeferResult, HandleResult returns the result without calling the callback, and
+            // ResolveDeferredResult calls it with the status set by the validation.
+            void DeferResult();
+            void ResolveDeferredResult();
+
             // Internal API, to be used by builder and BackendProcTable only.
             // rReturns true for success cases, and calls the callback with appropriate status.
             bool HandleResult(RefCounted* result);
@@ -73,6 +86,11 @@ namespace backend {
             nxt::BuilderErrorStatus storedStatus = nxt::BuilderErrorStatus::Success;
             std::string storedMessage;
 
+            bool latchingErrors = false;
+            bool hasLatchedError = false;
+            std::string latchedMessage;
+
+            bool resultDeferred = false;
             bool consumed = false;
     };
 
@@ -18,13 +18,262 @@
 #include "common/Math.h"
 
 #include <algorithm>
-#include <climits>
 #include <cstdlib>
+#include <cstring>
 
 namespace backend {
 
-    constexpr uint32_t EndOfBlock = UINT_MAX;//std::numeric_limits<uint32_t>::max();
-    constexpr uint32_t AdditionalData = UINT_MAX - 1;//std::numeric_limits<uint32_t>::max();
+    // Layout of the 8bit ids in the command stream: the low bits are the command id and the top
+    // two bits are the packing width of the command (0 for commands that aren't packed). Ids
+    // with all the bits of the width set are reserved for the allocator.
+    constexpr uint8_t EndOfBlock = 0xFF;
+    constexpr uint8_t AdditionalData = 0xFE;
+    constexpr uint8_t kCommandIdMask = 0x3F;
+    constexpr uint8_t kPackedWidthShift = 6;
+    constexpr uint8_t kPacked8 = 1;
+    constexpr uint8_t kPacked16 = 2;
+    static_assert(kMaxCommandId < AdditionalData && kMaxCommandId <= kCommandIdMask, "");
+
+    // CommandBlockPool
+
+    namespace {
+        size_t SizeClassIndex(size_t size) {
+            ASSERT(size <= CommandBlockPool::kMaxPooledBlockSize);
+            size_t index = 0;
+            while ((CommandBlockPool::kMinPooledBlockSize << index) < size) {
+                index++;
+            }
+            return index;
+        }
+
+        std::atomic<uint64_t> nextPoolSerial(1);
+
+        // The pools that still exist, so that exiting threads only give their cached blocks back
+        // to those. Never deleted so that threads can exit during static destruction.
+        struct LivePools {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, CommandBlockPool*> pools;
+        };
+        LivePools* GetLivePools() {
+            static LivePools* livePools = new LivePools;
+            return livePools;
+        }
+
+        // Each thread remembers the cache it used last so that finding it again doesn't need to
+        // lock the pool, unless the thread alternates between the pools of several devices. It
+        // also remembers all the pools it has a cache in, to release them when it exits.
+        struct ThreadCacheSlots {
+            ~ThreadCacheSlots() {
+                // ReleaseThreadCache removes the pools from poolSerials.
+                std::vector<uint64_t> serials = std::move(poolSerials);
+
+                LivePools* livePools = GetLivePools();
+                std::lock_guard<std::mutex> lock(livePools->mutex);
+                for (uint64_t poolSerial : serials) {
+                    auto it = livePools->pools.find(poolSerial);
+                    if (it != livePools->pools.end()) {
+                        it->second->ReleaseThreadCache();
+                    }
+                }
+            }
+
+            uint64_t currentPoolSerial = 0;
+            CommandBlockThreadCache* currentCache = nullptr;
+            std::vector<uint64_t> poolSerials;
+        };
+        thread_local ThreadCacheSlots threadCacheSlots;
+    }
+
+    struct CommandBlockThreadCache {
+        std::array<std::vector<uint8_t*>, CommandBlockPool::kNumSizeClasses> freeBlocks;
+    };
+
+    constexpr size_t CommandBlockPool::kMinPooledBlockSize;
+    constexpr size_t CommandBlockPool::kMaxPooledBlockSize;
+    constexpr size_t CommandBlockPool::kMaxThreadCachedBlocks;
+    constexpr size_t CommandBlockPool::kNumSizeClasses;
+
+    CommandBlockPool::CommandBlockPool()
+        : serial(nextPoolSerial.fetch_add(1, std::memory_order_relaxed)) {
+        LivePools* livePools = GetLivePools();
+        std::lock_guard<std::mutex> lock(livePools->mutex);
+        livePools->pools[serial] = this;
+    }
+
+    CommandBlockPool::~CommandBlockPool() {
+        {
+            LivePools* livePools = GetLivePools();
+            std::lock_guard<std::mutex> lock(livePools->mutex);
+            livePools->pools.erase(serial);
+        }
+
+        for (auto& it : threadCaches) {
+            FlushThreadCache(it.second.get());
+        }
+
+        for (auto& sizeClass : sizeClasses) {
+            ASSERT(sizeClass.blocksInUse == 0);
+            for (uint8_t* block : sizeClass.freeBlocks) {
+                free(block);
+            }
+        }
+    }
+
+    uint8_t* CommandBlockPool::AllocateBlock(size_t minimumSize, size_t* size) {
+        if (minimumSize > kMaxPooledBlockSize) {
+            stats.oversizeAllocations++;
+            *size = minimumSize;
+            return reinterpret_cast<uint8_t*>(malloc(minimumSize));
+        }
+
+        size_t index = SizeClassIndex(minimumSize);
+        size_t blockSize = kMinPooledBlockSize << index;
+        *size = blockSize;
+
+        // Fast path: take a block from the thread's cache, without locking.
+        std::vector<uint8_t*>& threadFreeBlocks = GetThreadCache()->freeBlocks[index];
+        if (!threadFreeBlocks.empty()) {
+            uint8_t* block = threadFreeBlocks.back();
+            threadFreeBlocks.pop_back();
+            stats.hits++;
+            stats.bytesCached -= blockSize;
+            stats.bytesInUse += blockSize;
+            return block;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        SizeClass& sizeClass = sizeClasses[index];
+
+        uint8_t* block = nullptr;
+        if (!sizeClass.freeBlocks.empty()) {
+            block = sizeClass.freeBlocks.back();
+            sizeClass.freeBlocks.pop_back();
+            stats.hits++;
+            stats.bytesCached -= blockSize;
+        } else {
+            block = reinterpret_cast<uint8_t*>(malloc(blockSize));
+            if (block == nullptr) {
+                return nullptr;
+            }
+            stats.misses++;
+        }
+
+        sizeClass.blocksInUse++;
+        sizeClass.highWaterMark = std::max(sizeClass.highWaterMark, sizeClass.blocksInUse);
+        stats.bytesInUse += blockSize;
+
+        return block;
+    }
+
+    void CommandBlockPool::DeallocateBlock(uint8_t* block, size_t size) {
+        if (size > kMaxPooledBlockSize) {
+            free(block);
+            return;
+        }
+
+        size_t index = SizeClassIndex(size);
+        ASSERT((kMinPooledBlockSize << index) == size);
+        stats.bytesInUse -= size;
+        stats.bytesCached += size;
+
+        // Fast path: keep the block in the thread's cache, without locking.
+        std::vector<uint8_t*>& threadFreeBlocks = GetThreadCache()->freeBlocks[index];
+        if (threadFreeBlocks.size() < kMaxThreadCachedBlocks) {
+            threadFreeBlocks.push_back(block);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        SizeClass& sizeClass = sizeClasses[index];
+
+        ASSERT(sizeClass.blocksInUse > 0);
+        sizeClass.blocksInUse--;
+        sizeClass.freeBlocks.push_back(block);
+    }
+
+    void CommandBlockPool::Trim() {
+        CommandBlockThreadCache* threadCache = GetThreadCache();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        FlushThreadCache(threadCache);
+
+        for (size_t i = 0; i < kNumSizeClasses; ++i) {
+            SizeClass& sizeClass = sizeClasses[i];
+            size_t blockSize = kMinPooledBlockSize << i;
+
+            // Only keep enough cached blocks to reach the high-water mark again.
+            ASSERT(sizeClass.highWaterMark >= sizeClass.blocksInUse);
+            size_t blocksToKeep = sizeClass.highWaterMark - sizeClass.blocksInUse;
+            while (sizeClass.freeBlocks.size() > blocksToKeep) {
+                free(sizeClass.freeBlocks.back());
+                sizeClass.freeBlocks.pop_back();
+                stats.trimmedBlocks++;
+                stats.bytesCached -= blockSize;
+            }
+
+            sizeClass.highWaterMark = sizeClass.blocksInUse;
+        }
+    }
+
+    void CommandBlockPool::ReleaseThreadCache() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = threadCaches.find(std::this_thread::get_id());
+        if (it == threadCaches.end()) {
+            return;
+        }
+
+        FlushThreadCache(it->second.get());
+        threadCaches.erase(it);
+
+        if (threadCacheSlots.currentPoolSerial == serial) {
+            threadCacheSlots.currentPoolSerial = 0;
+            threadCacheSlots.currentCache = nullptr;
+        }
+        auto& poolSerials = threadCacheSlots.poolSerials;
+        poolSerials.erase(std::remove(poolSerials.begin(), poolSerials.end(), serial), poolSerials.end());
+    }
+
+    CommandBlockPoolStats CommandBlockPool::GetStats() const {
+        CommandBlockPoolStats result;
+        result.hits = stats.hits.load(std::memory_order_relaxed);
+        result.misses = stats.misses.load(std::memory_order_relaxed);
+        result.oversizeAllocations = stats.oversizeAllocations.load(std::memory_order_relaxed);
+        result.trimmedBlocks = stats.trimmedBlocks.load(std::memory_order_relaxed);
+        result.bytesInUse = stats.bytesInUse.load(std::memory_order_relaxed);
+        result.bytesCached = stats.bytesCached.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    CommandBlockThreadCache* CommandBlockPool::GetThreadCache() {
+        if (threadCacheSlots.currentPoolSerial == serial) {
+            return threadCacheSlots.currentCache;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<CommandBlockThreadCache>& cache = threadCaches[std::this_thread::get_id()];
+        if (cache == nullptr) {
+            cache = std::make_unique<CommandBlockThreadCache>();
+            threadCacheSlots.poolSerials.push_back(serial);
+        }
+
+        threadCacheSlots.currentPoolSerial = serial;
+        threadCacheSlots.currentCache = cache.get();
+        return cache.get();
+    }
+
+    void CommandBlockPool::FlushThreadCache(CommandBlockThreadCache* cache) {
+        for (size_t i = 0; i < kNumSizeClasses; ++i) {
+            SizeClass& sizeClass = sizeClasses[i];
+            std::vector<uint8_t*>& threadFreeBlocks = cache->freeBlocks[i];
+
+            ASSERT(sizeClass.blocksInUse >= threadFreeBlocks.size());
+            sizeClass.blocksInUse -= threadFreeBlocks.size();
+            sizeClass.freeBlocks.insert(sizeClass.freeBlocks.end(), threadFreeBlocks.begin(), threadFreeBlocks.end());
+            threadFreeBlocks.clear();
+        }
+    }
+
+    // CommandIterator
 
     // TODO(cwallez@chromium.org): figure out a way to have more type safety for the iterator
 
@@ -35,18 +284,15 @@ namespace backend {
 
     CommandIterator::~CommandIterator() {
         ASSERT(dataWasDestroyed);
-
-        if (!IsEmpty()) {
-            for (auto& block : blocks) {
-                free(block.block);
-            }
-        }
+        ReleaseBlocks();
     }
 
     CommandIterator::CommandIterator(CommandIterator&& other)
         : endOfBlock(EndOfBlock) {
         if (!other.IsEmpty()) {
             blocks = std::move(other.blocks);
+            pool = other.pool;
+            ownsBlocks = other.ownsBlocks;
             other.Reset();
         }
         other.DataWasDestroyed();
@@ -54,11 +300,15 @@ namespace backend {
     }
 
     CommandIterator& CommandIterator::operator=(CommandIterator&& other) {
+        ReleaseBlocks();
         if (!other.IsEmpty()) {
             blocks = std::move(other.blocks);
+            pool = other.pool;
+            ownsBlocks = other.ownsBlocks;
             other.Reset();
         } else {
             blocks.clear();
+            ownsBlocks = true;
         }
         other.DataWasDestroyed();
         Reset();
@@ -66,16 +316,29 @@ namespace backend {
     }
 
     CommandIterator::CommandIterator(CommandAllocator&& allocator)
-        : blocks(allocator.AcquireBlocks()), endOfBlock(EndOfBlock) {
+        : blocks(allocator.AcquireBlocks()), pool(allocator.pool), endOfBlock(EndOfBlock) {
         Reset();
     }
 
     CommandIterator& CommandIterator::operator=(CommandAllocator&& allocator) {
+        ReleaseBlocks();
         blocks = allocator.AcquireBlocks();
+        pool = allocator.pool;
+        ownsBlocks = true;
         Reset();
         return *this;
     }
 
+    CommandIterator CommandIterator::CreateView() const {
+        CommandIterator view;
+        if (!IsEmpty()) {
+            view.blocks = blocks;
+            view.ownsBlocks = false;
+            view.Reset();
+        }
+        return view;
+    }
+
     void CommandIterator::Reset() {
         currentBlock = 0;
 
@@ -88,8 +351,21 @@ namespace backend {
             blocks[0].size = sizeof(endOfBlock);
             blocks[0].block = currentPtr;
         } else {
-            currentPtr = Align(blocks[0].block, alignof(uint32_t));
+            currentPtr = blocks[0].block;
+        }
+    }
+
+    void CommandIterator::ReleaseBlocks() {
+        if (ownsBlocks && !IsEmpty()) {
+            for (auto& block : blocks) {
+                if (pool != nullptr) {
+                    pool->DeallocateBlock(block.block, block.size);
+                } else {
+                    free(block.block);
+                }
+            }
         }
+        blocks.clear();
     }
 
     void CommandIterator::DataWasDestroyed() {
@@ -101,10 +377,9 @@ namespace backend {
     }
 
     bool CommandIterator::NextCommandId(uint32_t* commandId) {
-        uint8_t* idPtr = Align(currentPtr, alignof(uint32_t));
-        ASSERT(idPtr + sizeof(uint32_t) <= blocks[currentBlock].block + blocks[currentBlock].size);
+        ASSERT(currentPtr + sizeof(uint8_t) <= blocks[currentBlock].block + blocks[currentBlock].size);
 
-        uint32_t id = *reinterpret_cast<uint32_t*>(idPtr);
+        uint8_t id = *currentPtr;
 
         if (id == EndOfBlock) {
             currentBlock++;
@@ -112,21 +387,53 @@ namespace backend {
                 Reset();
                 return false;
             }
-            currentPtr = Align(blocks[currentBlock].block, alignof(uint32_t));
+            currentPtr = blocks[currentBlock].block;
             return NextCommandId(commandId);
         }
 
-        currentPtr = idPtr + sizeof(uint32_t);
-        *commandId = id;
+        currentPtr++;
+        if (id == AdditionalData) {
+            currentPackedWidth = 0;
+            *commandId = id;
+        } else {
+            uint8_t width = id >> kPackedWidthShift;
+            currentPackedWidth = width == 0 ? 0 : size_t(1) << (width - 1);
+            *commandId = id & kCommandIdMask;
+        }
         return true;
     }
 
     void* CommandIterator::NextCommand(size_t commandSize, size_t commandAlignment) {
-        uint8_t* commandPtr = Align(currentPtr, commandAlignment);
-        ASSERT(commandPtr + sizeof(commandSize) <= blocks[currentBlock].block + blocks[currentBlock].size);
+        if (currentPackedWidth == 0) {
+            uint8_t* commandPtr = Align(currentPtr, commandAlignment);
+            ASSERT(commandPtr + commandSize <= blocks[currentBlock].block + blocks[currentBlock].size);
+
+            currentPtr = commandPtr + commandSize;
+            return commandPtr;
+        }
+
+        ASSERT(commandAlignment == alignof(uint32_t));
+        ASSERT(commandSize % sizeof(uint32_t) == 0);
+        size_t wordCount = commandSize / sizeof(uint32_t);
+        ASSERT(wordCount <= kMaxPackedCommandWords);
+
+        uint8_t* packedPtr = Align(currentPtr, currentPackedWidth);
+        ASSERT(packedPtr + wordCount * currentPackedWidth <= blocks[currentBlock].block + blocks[currentBlock].size);
+
+        if (currentPackedWidth == sizeof(uint8_t)) {
+            for (size_t i = 0; i < wordCount; ++i) {
+                unpackedCommand[i] = packedPtr[i];
+            }
+        } else {
+            ASSERT(currentPackedWidth == sizeof(uint16_t));
+            const uint16_t* packedWords = reinterpret_cast<const uint16_t*>(packedPtr);
+            for (size_t i = 0; i < wordCount; ++i) {
+                unpackedCommand[i] = packedWords[i];
+            }
+        }
 
-        currentPtr = commandPtr + commandSize;
-        return commandPtr;
+        currentPtr = packedPtr + wordCount * currentPackedWidth;
+        return unpackedCommand;
     }
 
     void* CommandIterator::NextData(size_t dataSize, size_t dataAlignment) {
@@ -144,8 +451,10 @@ namespace backend {
     //  - Be able to optimize allocation to one block, for command buffers expected to live long to avoid cache misses
     //  - Better block allocation, maybe have NXT API to say command buffer is going to have size close to another
 
-    CommandAllocator::CommandAllocator()
-        : currentPtr(reinterpret_cast<uint8_t*>(&dummyEnum[0])), endPtr(reinterpret_cast<uint8_t*>(&dummyEnum[1])) {
+    // CommandAllocator
+
+    CommandAllocator::CommandAllocator(CommandBlockPool* pool)
+        : pool(pool), currentPtr(reinterpret_cast<uint8_t*>(&dummyEnum[0])), endPtr(reinterpret_cast<uint8_t*>(&dummyEnum[1])) {
     }
 
     CommandAllocator::~CommandAllocator() {
@@ -154,9 +463,8 @@ namespace backend {
 
     CommandBlocks&& CommandAllocator::AcquireBlocks() {
         ASSERT(currentPtr != nullptr && endPtr != nullptr);
-        ASSERT(IsAligned(currentPtr, alignof(uint32_t)));
-        ASSERT(currentPtr + sizeof(uint32_t) <= endPtr);
-        *reinterpret_cast<uint32_t*>(currentPtr) = EndOfBlock;
+        ASSERT(currentPtr + sizeof(uint8_t) <= endPtr);
+        *currentPtr = EndOfBlock;
 
         currentPtr = nullptr;
         endPtr = nullptr;
@@ -164,54 +472,90 @@ namespace backend {
     }
 
     uint8_t* CommandAllocator::Allocate(uint32_t commandId, size_t commandSize, size_t commandAlignment) {
+        ASSERT(commandId <= kMaxCommandId);
+        return AllocateRaw(static_cast<uint8_t>(commandId), commandSize, commandAlignment);
+    }
+
+    uint8_t* CommandAllocator::AllocateData(size_t commandSize, size_t commandAlignment) {
+        return AllocateRaw(AdditionalData, commandSize, commandAlignment);
+    }
+
+    void CommandAllocator::AllocatePacked(uint32_t commandId, const uint32_t* words, size_t wordCount) {
+        ASSERT(commandId <= kMaxCommandId);
+        ASSERT(wordCount <= kMaxPackedCommandWords);
+
+        uint32_t allBits = 0;
+        for (size_t i = 0; i < wordCount; ++i) {
+            allBits |= words[i];
+        }
+
+        if (allBits <= UINT8_MAX) {
+            uint8_t id = static_cast<uint8_t>(commandId | (kPacked8 << kPackedWidthShift));
+            uint8_t* packed = AllocateRaw(id, wordCount * sizeof(uint8_t), alignof(uint8_t));
+            for (size_t i = 0; i < wordCount; ++i) {
+                packed[i] = static_cast<uint8_t>(words[i]);
+            }
+        } else if (allBits <= UINT16_MAX) {
+            uint8_t id = static_cast<uint8_t>(commandId | (kPacked16 << kPackedWidthShift));
+            uint16_t* packed = reinterpret_cast<uint16_t*>(AllocateRaw(id, wordCount * sizeof(uint16_t), alignof(uint16_t)));
+            for (size_t i = 0; i < wordCount; ++i) {
+                packed[i] = static_cast<uint16_t>(words[i]);
+            }
+        } else {
+            uint8_t* command = AllocateRaw(static_cast<uint8_t>(commandId), wordCount * sizeof(uint32_t), alignof(uint32_t));
+            memcpy(command, words, wordCount * sizeof(uint32_t));
+        }
+    }
+
+    uint8_t* CommandAllocator::AllocateRaw(uint8_t id, size_t size, size_t alignment) {
         ASSERT(currentPtr != nullptr);
         ASSERT(endPtr != nullptr);
-        ASSERT(commandId != EndOfBlock);
+        ASSERT(id != EndOfBlock);
 
         // It should always be possible to allocate one id, for EndOfBlock tagging,
-        ASSERT(IsAligned(currentPtr, alignof(uint32_t)));
-        ASSERT(currentPtr + sizeof(uint32_t) <= endPtr);
-        uint32_t* idAlloc = reinterpret_cast<uint32_t*>(currentPtr);
+        ASSERT(currentPtr + sizeof(uint8_t) <= endPtr);
+        uint8_t* idAlloc = currentPtr;
 
-        uint8_t* commandAlloc = Align(currentPtr + sizeof(uint32_t), commandAlignment);
-        uint8_t* nextPtr = Align(commandAlloc + commandSize, alignof(uint32_t));
+        uint8_t* commandAlloc = Align(currentPtr + sizeof(uint8_t), alignment);
+        uint8_t* nextPtr = commandAlloc + size;
 
         // When there is not enough space, we signal the EndOfBlock, so that the iterator nows to
         // move to the next one. EndOfBlock on the last block means the end of the commands.
-        if (nextPtr + sizeof(uint32_t) > endPtr) {
+        if (nextPtr + sizeof(uint8_t) > endPtr) {
 
             // Even if we are not able to get another block, the list of commands will be well-formed
             // and iterable as this block will be that last one.
             *idAlloc = EndOfBlock;
 
             // Make sure we have space for current allocation, plus end of block and alignment padding
-            // for the first id.
-            if (!GetNewBlock(nextPtr - currentPtr + sizeof(uint32_t) + alignof(uint32_t))) {
+            // after the id.
+            if (!GetNewBlock(sizeof(uint8_t) + alignment + size + sizeof(uint8_t))) {
                 return nullptr;
             }
-            return Allocate(commandId, commandSize, commandAlignment);
+            return AllocateRaw(id, size, alignment);
         }
 
-        *idAlloc = commandId;
+        *idAlloc = id;
         currentPtr = nextPtr;
         return commandAlloc;
     }
 
-    uint8_t* CommandAllocator::AllocateData(size_t commandSize, size_t commandAlignment) {
-        return Allocate(AdditionalData, commandSize, commandAlignment);
-    }
-
     bool CommandAllocator::GetNewBlock(size_t minimumSize) {
         // Allocate blocks doubling sizes each time, to a maximum of 16k (or at least minimumSize).
         lastAllocationSize = std::max(minimumSize, std::min(lastAllocationSize * 2, size_t(16384)));
 
-        uint8_t* block = reinterpret_cast<uint8_t*>(malloc(lastAllocationSize));
+        uint8_t* block = nullptr;
+        if (pool != nullptr) {
+            block = pool->AllocateBlock(lastAllocationSize, &lastAllocationSize);
+        } else {
+            block = reinterpret_cast<uint8_t*>(malloc(lastAllocationSize));
+        }
         if (block == nullptr) {
             return false;
         }
 
         blocks.push_back({lastAllocationSize, block});
-        currentPtr = Align(block, alignof(uint32_t));
+        currentPtr = block;
         endPtr = block + lastAllocationSize;
         return true;
     }
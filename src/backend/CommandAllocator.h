@@ -15,16 +15,30 @@
 #ifndef BACKEND_COMMAND_ALLOCATOR_H_
 #define BACKEND_COMMAND_ALLOCATOR_H_
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace backend {
 
     // Allocation for command buffers should be fast. To avoid doing an allocation per command
     // or to avoid copying commands when reallocing, we use a linear allocator in a growing set
-    // of large memory blocks. We also use this to have the format to be (u32 commandId, command),
+    // of large memory blocks. We also use this to have the format to be (u8 commandId, command),
     // so that iteration over the commands is easy.
+    //
+    // Commands that are only made of 32bit words and don't need to be destroyed (draws, dispatches,
+    // push constant headers...) can be allocated with AllocatePacked instead. Their words are then
+    // stored with the smallest of 8, 16 or 32 bits that fits all of them, and the width is encoded
+    // in the top bits of the command id. The iterator unpacks them transparently, but the pointer
+    // returned by NextCommand for a packed command is only valid until the next call to
+    // NextCommand.
 
     // Usage of the allocator and iterator:
     //     CommandAllocator allocator;
@@ -57,8 +71,103 @@ namespace backend {
     };
     using CommandBlocks = std::vector<BlockDef>;
 
+    // Command buffers are created and destroyed at a high rate so instead of going through
+    // malloc and free for each of their blocks, blocks can be recycled through a pool that is
+    // owned by the device. Blocks are sorted in power-of-two size classes between
+    // kMinPooledBlockSize and kMaxPooledBlockSize; larger blocks are only needed for huge
+    // commands and go straight to malloc / free.
+    //
+    // To avoid holding on to memory after a spike of command recording, the pool remembers the
+    // highest number of blocks of each size class that were in use at the same time. Trim()
+    // frees the cached blocks that weren't needed to reach that high-water mark and starts
+    // tracking a new one.
+    //
+    // Command buffers can be recorded on several threads at once, so each thread has a small
+    // cache of free blocks that is used without taking a lock, and the rest of the pool is shared
+    // and protected by a mutex. The blocks in a thread's cache count as in use for the shared
+    // pool, and Trim() only gives the calling thread's cached blocks back to the shared pool.
+    // Threads give their cached blocks back when they exit so that they can be trimmed.
+    struct CommandBlockPoolStats {
+        // Number of blocks that were served from the cache, or had to be malloced.
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Number of blocks too large to be pooled.
+        uint64_t oversizeAllocations = 0;
+        // Number of cached blocks freed by Trim().
+        uint64_t trimmedBlocks = 0;
+        // Current number of bytes in blocks that are handed out and cached.
+        size_t bytesInUse = 0;
+        size_t bytesCached = 0;
+    };
+
+    struct CommandBlockThreadCache;
+
+    class CommandBlockPool {
+        public:
+            static constexpr size_t kMinPooledBlockSize = 2048;
+            static constexpr size_t kMaxPooledBlockSize = 16384;
+            // The number of free blocks of each size class a thread can keep for itself.
+            static constexpr size_t kMaxThreadCachedBlocks = 4;
+
+            CommandBlockPool();
+            ~CommandBlockPool();
+
+            // Returns a block of at least minimumSize bytes and writes its actual size in size.
+            uint8_t* AllocateBlock(size_t minimumSize, size_t* size);
+            // The size must be the one that was returned by AllocateBlock.
+            void DeallocateBlock(uint8_t* block, size_t size);
+
+            void Trim();
+
+            // Gives the blocks cached by the calling thread back to the shared pool and forgets
+            // its cache. Called when the thread exits.
+            void ReleaseThreadCache();
+
+            // Returns a snapshot of the statistics, the counters are updated atomically.
+            CommandBlockPoolStats GetStats() const;
+
+            static constexpr size_t kNumSizeClasses = 4;
+            static_assert(kMinPooledBlockSize << (kNumSizeClasses - 1) == kMaxPooledBlockSize, "");
+
+        private:
+            CommandBlockThreadCache* GetThreadCache();
+            // Gives the blocks of a thread cache back to the shared pool, mutex must be locked.
+            void FlushThreadCache(CommandBlockThreadCache* cache);
+
+            // Identifies the pool in the threads' pointer to their cache, unlike the address of
+            // the pool it is never reused.
+            const uint64_t serial;
+
+            std::mutex mutex;
+
+            // Protected by the mutex.
+            struct SizeClass {
+                std::vector<uint8_t*> freeBlocks;
+                size_t blocksInUse = 0;
+                size_t highWaterMark = 0;
+            };
+            std::array<SizeClass, kNumSizeClasses> sizeClasses;
+            std::unordered_map<std::thread::id, std::unique_ptr<CommandBlockThreadCache>> threadCaches;
+
+            struct AtomicStats {
+                std::atomic<uint64_t> hits{0};
+                std::atomic<uint64_t> misses{0};
+                std::atomic<uint64_t> oversizeAllocations{0};
+                std::atomic<uint64_t> trimmedBlocks{0};
+                std::atomic<size_t> bytesInUse{0};
+                std::atomic<size_t> bytesCached{0};
+            };
+            AtomicStats stats;
+    };
+
     class CommandAllocator;
 
+    // Command ids are stored on 8 bits, the top two being reserved for the packing width of the
+    // command, and the last values being reserved by the allocator.
+    static constexpr uint32_t kMaxCommandId = 62;
+    // The largest command, in 32bit words, that can be allocated with AllocatePacked.
+    static constexpr size_t kMaxPackedCommandWords = 4;
+
     // TODO(cwallez@chromium.org): prevent copy for both iterator and allocator
     class CommandIterator {
         public:
@@ -71,9 +180,18 @@ namespace backend {
             CommandIterator(CommandAllocator&& allocator);
             CommandIterator& operator=(CommandAllocator&& allocator);
 
+            // Returns an iterator over the same commands that doesn't own them, the commands
+            // must outlive it and destroying it doesn't free them.
+            CommandIterator CreateView() const;
+
             template<typename E>
             bool NextCommandId(E* commandId) {
-                return NextCommandId(reinterpret_cast<uint32_t*>(commandId));
+                uint32_t id;
+                if (!NextCommandId(&id)) {
+                    return false;
+                }
+                *commandId = static_cast<E>(id);
+                return true;
             }
             template<typename T>
             T* NextCommand() {
@@ -91,31 +209,51 @@ namespace backend {
 
         private:
             bool IsEmpty() const;
+            // Gives the blocks back to the pool (or frees them), the commands must have been
+            // destroyed already.
+            void ReleaseBlocks();
 
             bool NextCommandId(uint32_t* commandId);
             void* NextCommand(size_t commandSize, size_t commandAlignment);
             void* NextData(size_t dataSize, size_t dataAlignment);
 
             CommandBlocks blocks;
+            CommandBlockPool* pool = nullptr;
             uint8_t* currentPtr = nullptr;
             size_t currentBlock = 0;
+            // The width in bytes of the words of the current command if it is packed, 0 otherwise.
+            size_t currentPackedWidth = 0;
+            // Storage the current packed command is unpacked to.
+            uint32_t unpackedCommand[kMaxPackedCommandWords];
             // Used to avoid a special case for empty iterators.
-            uint32_t endOfBlock;
+            uint8_t endOfBlock;
             bool dataWasDestroyed = false;
+            bool ownsBlocks = true;
     };
 
     class CommandAllocator {
         public:
-            CommandAllocator();
+            // When a pool is given, blocks are taken from it and the CommandIterator the
+            // commands are moved to will give them back to the pool on destruction.
+            explicit CommandAllocator(CommandBlockPool* pool = nullptr);
             ~CommandAllocator();
 
             template<typename T, typename E>
             T* Allocate(E commandId) {
-                static_assert(sizeof(E) == sizeof(uint32_t), "");
-                static_assert(alignof(E) == alignof(uint32_t), "");
                 return reinterpret_cast<T*>(Allocate(static_cast<uint32_t>(commandId), sizeof(T), alignof(T)));
             }
 
+            // Copies the command in the allocator with the narrowest encoding that fits its values.
+            template<typename T, typename E>
+            void AllocatePacked(E commandId, const T& command) {
+                static_assert(std::is_trivially_copyable<T>::value, "Packed commands must be trivially copyable");
+                static_assert(alignof(T) == alignof(uint32_t), "Packed commands must be made of 32bit words");
+                static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Packed commands must be made of 32bit words");
+                static_assert(sizeof(T) <= kMaxPackedCommandWords * sizeof(uint32_t), "Packed command too large");
+                AllocatePacked(static_cast<uint32_t>(commandId), reinterpret_cast<const uint32_t*>(&command),
+                               sizeof(T) / sizeof(uint32_t));
+            }
+
             template<typename T>
             T* AllocateData(size_t count) {
                 return reinterpret_cast<T*>(AllocateData(sizeof(T) * count, alignof(T)));
@@ -127,13 +265,16 @@ namespace backend {
 
             uint8_t* Allocate(uint32_t commandId, size_t commandSize, size_t commandAlignment);
             uint8_t* AllocateData(size_t dataSize, size_t dataAlignment);
+            void AllocatePacked(uint32_t commandId, const uint32_t* words, size_t wordCount);
+            uint8_t* AllocateRaw(uint8_t id, size_t size, size_t alignment);
             bool GetNewBlock(size_t minimumSize);
 
             CommandBlocks blocks;
+            CommandBlockPool* pool = nullptr;
             size_t lastAllocationSize = 2048;
 
             // Pointers to the current range of allocation in the block. Guaranteed to allow
-            // for at least one uint32_t is not nullptr, so that the special EndOfBlock command id
+            // for at least one uint8_t is not nullptr, so that the special EndOfBlock command id
             // can always be written.
             // Nullptr iff the blocks were moved out.
             uint8_t* currentPtr = nullptr;
@@ -142,7 +283,7 @@ namespace backend {
             // Data used for the block range at initialization so that the first call to Allocate
             // sees there is not enough space and calls GetNewBlock. This avoids having to special
             // case the initialization in Allocate.
-            uint32_t dummyEnum[1] = {0};
+            uint8_t dummyEnum[1] = {0};
     };
 
 }
@@ -23,7 +23,12 @@
 #include "backend/Pipeline.h"
 #include "backend/PipelineLayout.h"
 #include "backend/Texture.h"
+#include "backend/WorkerThread.h"
+#include "common/Constants.h"
+#include "common/Tracing.h"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <map>
 
@@ -32,7 +37,7 @@ namespace backend {
     namespace {
 
         bool ValidateCopyLocationFitsInTexture(CommandBufferBuilder* builder, const TextureCopyLocation& location) {
-            const TextureBase* texture = location.texture.Get();
+            const TextureBase* texture = location.texture;
             if (location.level >= texture->GetNumMipLevels()) {
                 builder->HandleError("Copy mip-level out of range");
                 return false;
@@ -61,7 +66,7 @@ namespace backend {
         }
 
         bool ValidateCopySizeFitsInBuffer(CommandBufferBuilder* builder, const BufferCopyLocation& location, uint32_t dataSize) {
-            if (!FitsInBuffer(location.buffer.Get(), location.offset, dataSize)) {
+            if (!FitsInBuffer(location.buffer, location.offset, dataSize)) {
                 builder->HandleError("Copy would overflow the buffer");
                 return false;
             }
@@ -77,12 +82,177 @@ namespace backend {
             return true;
         }
 
+        template<typename T>
+        void CopyCommand(CommandIterator* source, CommandAllocator* destination, Command type) {
+            T* cmd = source->NextCommand<T>();
+            new(destination->Allocate<T>(type)) T(*cmd);
+        }
+
+        template<typename T>
+        void CopyPackedCommand(CommandIterator* source, CommandAllocator* destination, Command type) {
+            destination->AllocatePacked(type, *source->NextCommand<T>());
+        }
+
     }
 
+    // Finds the state-setting commands that don't change anything. Each Set* method returns
+    // true when the command is redundant and records the new state otherwise. The tracking
+    // is conservative: it is reset at pass and subpass boundaries, and changing the pipeline
+    // forgets the bind groups and vertex buffers because backends derive their bindings from
+    // the pipeline layout and input state. Raw pointers are fine because the residency set of
+    // the builder holds references to all the objects.
+    class RedundantStateTracker {
+        public:
+            RedundantStateTracker() {
+                Reset();
+            }
+
+            void Reset() {
+                pipeline = nullptr;
+                indexBuffer = nullptr;
+                ResetPipelineDependentState(0);
+            }
+
+            bool SetPipeline(PipelineBase* newPipeline) {
+                if (newPipeline == pipeline) {
+                    return true;
+                }
+
+                // Backends keep the bind groups of the groups inherited from the last layout.
+                PipelineLayoutBase* lastLayout = pipeline ? pipeline->GetLayout() : nullptr;
+                uint32_t inheritedGroups = newPipeline->GetLayout()->GroupsInheritedFrom(lastLayout);
+                pipeline = newPipeline;
+                ResetPipelineDependentState(inheritedGroups);
+                return false;
+            }
+
+            bool SetBindGroup(uint32_t index, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
+                ASSERT(index < kMaxBindGroups);
+                if (dynamicOffsetCount > kMaxBindingsPerGroup) {
+                    return false;
+                }
+
+                bool sameOffsets = dynamicOffsetCount == 0 ||
+                    memcmp(bindGroupDynamicOffsets[index].data(), dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t)) == 0;
+                if (bindGroups[index] == group && sameOffsets) {
+                    return true;
+                }
+                bindGroups[index] = group;
+                memcpy(bindGroupDynamicOffsets[index].data(), dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t));
+                return false;
+            }
+
+            bool SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format) {
+                if (indexBuffer == buffer && indexBufferOffset == offset && indexFormat == format) {
+                    return true;
+                }
+                indexBuffer = buffer;
+                indexBufferOffset = offset;
+                indexFormat = format;
+                return false;
+            }
+
+            bool SetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, const uint32_t* offsets) {
+                if (startSlot > kMaxVertexInputs || count > kMaxVertexInputs - startSlot) {
+                    return false;
+                }
+
+                bool redundant = true;
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint32_t slot = startSlot + i;
+                    if (vertexBuffers[slot] != buffers[i] || vertexBufferOffsets[slot] != offsets[i]) {
+                        vertexBuffers[slot] = buffers[i];
+                        vertexBufferOffsets[slot] = offsets[i];
+                        redundant = false;
+                    }
+                }
+                return redundant;
+            }
+
+        private:
+            void ResetPipelineDependentState(uint32_t inheritedGroups) {
+                for (uint32_t i = inheritedGroups; i < kMaxBindGroups; ++i) {
+                    bindGroups[i] = nullptr;
+                }
+                vertexBuffers.fill(nullptr);
+                vertexBufferOffsets.fill(0);
+            }
+
+            PipelineBase* pipeline = nullptr;
+            std::array<BindGroupBase*, kMaxBindGroups> bindGroups;
+            std::array<std::array<uint32_t, kMaxBindingsPerGroup>, kMaxBindGroups> bindGroupDynamicOffsets;
+
+            BufferBase* indexBuffer = nullptr;
+            uint32_t indexBufferOffset = 0;
+            nxt::IndexFormat indexFormat = nxt::IndexFormat::Uint16;
+
+            std::array<BufferBase*, kMaxVertexInputs> vertexBuffers;
+            std::array<uint32_t, kMaxVertexInputs> vertexBufferOffsets;
+    };
+
     CommandBufferBase::CommandBufferBase(CommandBufferBuilder* builder)
         : device(builder->device),
-          buffersTransitioned(std::move(builder->state->buffersTransitioned)),
-          texturesTransitioned(std::move(builder->state->texturesTransitioned)) {
+          residency(std::move(builder->residency)),
+          redundantStateCommandsRemoved(builder->redundantStateCommandsRemoved) {
+        // With background validation the transitions are only known once it is finished.
+        if (!builder->validatingInBackground) {
+            TakeValidationResults(builder);
+        }
+    }
+
+    CommandBufferBase::~CommandBufferBase() {
+        // The validation thread might still be using the commands that the builder owns.
+        WaitForValidation();
+    }
+
+    bool CommandBufferBase::WaitForValidation() {
+        if (validationBuilder.Get() == nullptr) {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(validationMutex);
+        validationCondition.wait(lock, [this]() { return validationFinished; });
+
+        if (!validationResolved) {
+            validationResolved = true;
+            if (validationSucceeded) {
+                TakeValidationResults(validationBuilder.Get());
+            }
+            validationBuilder->ResolveDeferredResult();
+        }
+
+        return validationSucceeded;
+    }
+
+    void CommandBufferBase::TakeValidationResults(CommandBufferBuilder* builder) {
+        buffersTransitioned = std::move(builder->state->buffersTransitioned);
+        texturesTransitioned = std::move(builder->state->texturesTransitioned);
+        std::sort(buffersTransitioned.begin(), buffersTransitioned.end());
+        std::sort(texturesTransitioned.begin(), texturesTransitioned.end());
+        buffersWritten = std::move(builder->state->buffersWritten);
+        indexRangeChecks = std::move(builder->state->indexRangeChecks);
+    }
+
+    void CommandBufferBase::ValidateInBackground(CommandBufferBuilder* builder) {
+        validationBuilder = builder;
+
+        device->GetValidationThread()->PostTask([this]() {
+            // The commands are already in the backend's command buffer, so the redundant state
+            // commands can't be removed anymore.
+            uint32_t redundantStateCommands = 0;
+            bool valid = validationBuilder->ValidateCommands(&redundantStateCommands);
+
+            // Notify while the lock is held as the command buffer can be destroyed as soon as
+            // it is released.
+            std::lock_guard<std::mutex> lock(validationMutex);
+            validationSucceeded = valid;
+            validationFinished = true;
+            validationCondition.notify_all();
+        });
+    }
+
+    uint32_t CommandBufferBase::GetRedundantStateCommandsRemoved() const {
+        return redundantStateCommandsRemoved;
     }
 
     bool CommandBufferBase::ValidateResourceUsagesImmediate() {
@@ -91,6 +261,10 @@ namespace backend {
                 device->HandleError("Command buffer: cannot transition buffer with frozen usage");
                 return false;
             }
+            if (buffer->IsMapped()) {
+                device->HandleError("Command buffer: cannot transition mapped buffer");
+                return false;
+            }
         }
         for (auto texture : texturesTransitioned) {
             if (texture->IsFrozen()) {
@@ -98,141 +272,22 @@ namespace backend {
                 return false;
             }
         }
+        for (auto& check : indexRangeChecks) {
+            if (!RevalidateIndexRange(&check)) {
+                device->HandleError("Command buffer: index out of the range of the vertex buffers");
+                return false;
+            }
+        }
         return true;
     }
 
-    void FreeCommands(CommandIterator* commands) {
-        Command type;
-        while(commands->NextCommandId(&type)) {
-            switch (type) {
-                case Command::BeginComputePass:
-                    {
-                        BeginComputePassCmd* begin = commands->NextCommand<BeginComputePassCmd>();
-                        begin->~BeginComputePassCmd();
-                    }
-                    break;
-                case Command::BeginRenderPass:
-                    {
-                        BeginRenderPassCmd* begin = commands->NextCommand<BeginRenderPassCmd>();
-                        begin->~BeginRenderPassCmd();
-                    }
-                    break;
-                case Command::BeginRenderSubpass:
-                    {
-                        BeginRenderSubpassCmd* begin = commands->NextCommand<BeginRenderSubpassCmd>();
-                        begin->~BeginRenderSubpassCmd();
-                    }
-                    break;
-                case Command::CopyBufferToBuffer:
-                    {
-                        CopyBufferToBufferCmd* copy = commands->NextCommand<CopyBufferToBufferCmd>();
-                        copy->~CopyBufferToBufferCmd();
-                    }
-                    break;
-                case Command::CopyBufferToTexture:
-                    {
-                        CopyBufferToTextureCmd* copy = commands->NextCommand<CopyBufferToTextureCmd>();
-                        copy->~CopyBufferToTextureCmd();
-                    }
-                    break;
-                case Command::CopyTextureToBuffer:
-                    {
-                        CopyTextureToBufferCmd* copy = commands->NextCommand<CopyTextureToBufferCmd>();
-                        copy->~CopyTextureToBufferCmd();
-                    }
-                    break;
-                case Command::Dispatch:
-                    {
-                        DispatchCmd* dispatch = commands->NextCommand<DispatchCmd>();
-                        dispatch->~DispatchCmd();
-                    }
-                    break;
-                case Command::DrawArrays:
-                    {
-                        DrawArraysCmd* draw = commands->NextCommand<DrawArraysCmd>();
-                        draw->~DrawArraysCmd();
-                    }
-                    break;
-                case Command::DrawElements:
-                    {
-                        DrawElementsCmd* draw = commands->NextCommand<DrawElementsCmd>();
-                        draw->~DrawElementsCmd();
-                    }
-                    break;
-                case Command::EndComputePass:
-                    {
-                        EndComputePassCmd* cmd = commands->NextCommand<EndComputePassCmd>();
-                        cmd->~EndComputePassCmd();
-                    }
-                    break;
-                case Command::EndRenderPass:
-                    {
-                        EndRenderPassCmd* cmd = commands->NextCommand<EndRenderPassCmd>();
-                        cmd->~EndRenderPassCmd();
-                    }
-                    break;
-                case Command::EndRenderSubpass:
-                    {
-                        EndRenderSubpassCmd* cmd = commands->NextCommand<EndRenderSubpassCmd>();
-                        cmd->~EndRenderSubpassCmd();
-                    }
-                    break;
-                case Command::SetPipeline:
-                    {
-                        SetPipelineCmd* cmd = commands->NextCommand<SetPipelineCmd>();
-                        cmd->~SetPipelineCmd();
-                    }
-                    break;
-                case Command::SetPushConstants:
-                    {
-                        SetPushConstantsCmd* cmd = commands->NextCommand<SetPushConstantsCmd>();
-                        commands->NextData<uint32_t>(cmd->count);
-                        cmd->~SetPushConstantsCmd();
-                    }
-                    break;
-                case Command::SetStencilReference:
-                    {
-                        SetStencilReferenceCmd* cmd = commands->NextCommand<SetStencilReferenceCmd>();
-                        cmd->~SetStencilReferenceCmd();
-                    }
-                    break;
-                case Command::SetBindGroup:
-                    {
-                        SetBindGroupCmd* cmd = commands->NextCommand<SetBindGroupCmd>();
-                        cmd->~SetBindGroupCmd();
-                    }
-                    break;
-                case Command::SetIndexBuffer:
-                    {
-                        SetIndexBufferCmd* cmd = commands->NextCommand<SetIndexBufferCmd>();
-                        cmd->~SetIndexBufferCmd();
-                    }
-                    break;
-                case Command::SetVertexBuffers:
-                    {
-                        SetVertexBuffersCmd* cmd = commands->NextCommand<SetVertexBuffersCmd>();
-                        auto buffers = commands->NextData<Ref<BufferBase>>(cmd->count);
-                        for (size_t i = 0; i < cmd->count; ++i) {
-                            (&buffers[i])->~Ref<BufferBase>();
-                        }
-                        commands->NextData<uint32_t>(cmd->count);
-                        cmd->~SetVertexBuffersCmd();
-                    }
-                    break;
-                case Command::TransitionBufferUsage:
-                    {
-                        TransitionBufferUsageCmd* cmd = commands->NextCommand<TransitionBufferUsageCmd>();
-                        cmd->~TransitionBufferUsageCmd();
-                    }
-                    break;
-                case Command::TransitionTextureUsage:
-                    {
-                        TransitionTextureUsageCmd* cmd = commands->NextCommand<TransitionTextureUsageCmd>();
-                        cmd->~TransitionTextureUsageCmd();
-                    }
-                    break;
-            }
+    void CommandBufferBase::InvalidateContentsWritten() {
+        for (auto buffer : buffersWritten) {
+            buffer->InvalidateContents();
         }
+    }
+
+    void FreeCommands(CommandIterator* commands) {
         commands->DataWasDestroyed();
     }
 
@@ -286,6 +341,10 @@ namespace backend {
                 commands->NextCommand<EndRenderSubpassCmd>();
                 break;
 
+            case Command::ExecuteBundle:
+                commands->NextCommand<ExecuteBundleCmd>();
+                break;
+
             case Command::SetPipeline:
                 commands->NextCommand<SetPipelineCmd>();
                 break;
@@ -302,7 +361,10 @@ namespace backend {
                 break;
 
             case Command::SetBindGroup:
-                commands->NextCommand<SetBindGroupCmd>();
+                {
+                    auto* cmd = commands->NextCommand<SetBindGroupCmd>();
+                    commands->NextData<uint32_t>(cmd->dynamicOffsetCount);
+                }
                 break;
 
             case Command::SetIndexBuffer:
@@ -312,7 +374,7 @@ namespace backend {
             case Command::SetVertexBuffers:
                 {
                     auto* cmd = commands->NextCommand<SetVertexBuffersCmd>();
-                    commands->NextData<Ref<BufferBase>>(cmd->count);
+                    commands->NextData<BufferBase*>(cmd->count);
                     commands->NextData<uint32_t>(cmd->count);
                 }
                 break;
@@ -327,7 +389,44 @@ namespace backend {
         }
     }
 
-    CommandBufferBuilder::CommandBufferBuilder(DeviceBase* device) : Builder(device), state(std::make_unique<CommandBufferStateTracker>(this)) {
+    BundleReplayIterator::BundleReplayIterator(CommandIterator* commands)
+        : commands(commands), current(commands) {
+    }
+
+    bool BundleReplayIterator::NextCommandId(Command* commandId) {
+        while (true) {
+            if (!current->NextCommandId(commandId)) {
+                // The end of a bundle, continue with the commands after the ExecuteBundle.
+                if (current != commands) {
+                    current = commands;
+                    continue;
+                }
+                return false;
+            }
+
+            if (*commandId != Command::ExecuteBundle) {
+                return true;
+            }
+
+            ASSERT(current == commands);
+            ExecuteBundleCmd* cmd = current->NextCommand<ExecuteBundleCmd>();
+            current = cmd->bundle->GetCommands();
+        }
+    }
+
+    void BundleReplayIterator::SkipCommand(Command type) {
+        backend::SkipCommand(current, type);
+    }
+
+    CommandBufferBuilder::CommandBufferBuilder(DeviceBase* device)
+        : Builder(device), state(std::make_unique<CommandBufferStateTracker>(this)),
+          redundantState(std::make_unique<RedundantStateTracker>()),
+          allocator(device->GetCommandBlockPool()),
+          streamingValidation(device->IsStreamingValidationEnabled()),
+          backgroundValidation(device->IsBackgroundValidationEnabled()) {
+        if (streamingValidation) {
+            StartLatchingErrors();
+        }
     }
 
     CommandBufferBuilder::~CommandBufferBuilder() {
@@ -338,154 +437,403 @@ namespace backend {
     }
 
     bool CommandBufferBuilder::ValidateGetResult() {
+        NXT_TRACE_EVENT("frontend", "CommandBufferBuilder::ValidateGetResult");
         MoveToIterator();
 
+        // With streaming validation the commands were validated as they were recorded and the
+        // redundant state commands were not recorded at all.
+        if (streamingValidation) {
+            StopLatchingErrors();
+            if (HasLatchedError()) {
+                return false;
+            }
+            return state->ValidateEndCommandBuffer();
+        }
+
+        // The commands are validated on the device's validation thread once the command buffer
+        // is created, see GetResultImpl.
+        if (backgroundValidation) {
+            validatingInBackground = true;
+            DeferResult();
+            return true;
+        }
+
+        uint32_t redundantStateCommands = 0;
+        if (!ValidateCommands(&redundantStateCommands)) {
+            return false;
+        }
+
+        if (redundantStateCommands > 0 && device->IsRedundantStateEliminationEnabled()) {
+            EliminateRedundantState();
+            redundantStateCommandsRemoved = redundantStateCommands;
+        }
+
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateCommands(uint32_t* redundantStateCommands) {
         Command type;
         while (iterator.NextCommandId(&type)) {
+            bool isRedundant = false;
+            bool valid = false;
+
             switch (type) {
                 case Command::BeginComputePass:
-                    {
-                        iterator.NextCommand<BeginComputePassCmd>();
-                        if (!state->BeginComputePass()) {
-                            return false;
-                        }
-                    }
+                    iterator.NextCommand<BeginComputePassCmd>();
+                    valid = ValidateBeginComputePass();
                     break;
 
                 case Command::BeginRenderPass:
                     {
                         BeginRenderPassCmd* cmd = iterator.NextCommand<BeginRenderPassCmd>();
-                        auto* renderPass = cmd->renderPass.Get();
-                        auto* framebuffer = cmd->framebuffer.Get();
-                        // TODO(kainino@chromium.org): null checks should not be necessary
-                        if (renderPass == nullptr) {
-                            HandleError("Render pass is invalid");
-                            return false;
-                        }
-                        if (framebuffer == nullptr) {
-                            HandleError("Framebuffer is invalid");
-                            return false;
-                        }
-                        if (!state->BeginRenderPass(renderPass, framebuffer)) {
-                            return false;
-                        }
+                        valid = ValidateBeginRenderPass(cmd->renderPass, cmd->framebuffer);
                     }
                     break;
 
                 case Command::BeginRenderSubpass:
-                    {
-                        iterator.NextCommand<BeginRenderSubpassCmd>();
-                        if (!state->BeginSubpass()) {
-                            return false;
-                        }
-                    }
+                    iterator.NextCommand<BeginRenderSubpassCmd>();
+                    valid = ValidateBeginRenderSubpass();
                     break;
 
                 case Command::CopyBufferToBuffer:
-                    {
-                        CopyBufferToBufferCmd* copy = iterator.NextCommand<CopyBufferToBufferCmd>();
-                        if (!ValidateCopySizeFitsInBuffer(this, copy->source, copy->size) ||
-                            !ValidateCopySizeFitsInBuffer(this, copy->destination, copy->size) ||
-                            !state->ValidateCanCopy() ||
-                            !state->ValidateCanUseBufferAs(copy->source.buffer.Get(), nxt::BufferUsageBit::TransferSrc) ||
-                            !state->ValidateCanUseBufferAs(copy->destination.buffer.Get(), nxt::BufferUsageBit::TransferDst)) {
-                            return false;
-                        }
-                    }
+                    valid = ValidateCopyBufferToBuffer(*iterator.NextCommand<CopyBufferToBufferCmd>());
                     break;
 
                 case Command::CopyBufferToTexture:
-                    {
-                        CopyBufferToTextureCmd* copy = iterator.NextCommand<CopyBufferToTextureCmd>();
-
-                        uint32_t bufferCopySize = 0;
-                        if (!ComputeTextureCopyBufferSize(this, copy->destination, &bufferCopySize) ||
-                            !ValidateCopyLocationFitsInTexture(this, copy->destination) ||
-                            !ValidateCopySizeFitsInBuffer(this, copy->source, bufferCopySize) ||
-                            !state->ValidateCanCopy() ||
-                            !state->ValidateCanUseBufferAs(copy->source.buffer.Get(), nxt::BufferUsageBit::TransferSrc) ||
-                            !state->ValidateCanUseTextureAs(copy->destination.texture.Get(), nxt::TextureUsageBit::TransferDst)) {
-                            return false;
-                        }
-                    }
+                    valid = ValidateCopyBufferToTexture(*iterator.NextCommand<CopyBufferToTextureCmd>());
                     break;
 
                 case Command::CopyTextureToBuffer:
-                    {
-                        CopyTextureToBufferCmd* copy = iterator.NextCommand<CopyTextureToBufferCmd>();
-
-                        uint32_t bufferCopySize = 0;
-                        if (!ComputeTextureCopyBufferSize(this, copy->source, &bufferCopySize) ||
-                            !ValidateCopyLocationFitsInTexture(this, copy->source) ||
-                            !ValidateCopySizeFitsInBuffer(this, copy->destination, bufferCopySize) ||
-                            !state->ValidateCanCopy() ||
-                            !state->ValidateCanUseTextureAs(copy->source.texture.Get(), nxt::TextureUsageBit::TransferSrc) ||
-                            !state->ValidateCanUseBufferAs(copy->destination.buffer.Get(), nxt::BufferUsageBit::TransferDst)) {
-                            return false;
-                        }
-                    }
+                    valid = ValidateCopyTextureToBuffer(*iterator.NextCommand<CopyTextureToBufferCmd>());
                     break;
 
                 case Command::Dispatch:
+                    iterator.NextCommand<DispatchCmd>();
+                    valid = ValidateDispatch();
+                    break;
+
+                case Command::DrawArrays:
+                    valid = ValidateDrawArrays(*iterator.NextCommand<DrawArraysCmd>());
+                    break;
+
+                case Command::DrawElements:
+                    valid = ValidateDrawElements(*iterator.NextCommand<DrawElementsCmd>());
+                    break;
+
+                case Command::EndComputePass:
+                    iterator.NextCommand<EndComputePassCmd>();
+                    valid = ValidateEndComputePass();
+                    break;
+
+                case Command::EndRenderPass:
+                    iterator.NextCommand<EndRenderPassCmd>();
+                    valid = ValidateEndRenderPass();
+                    break;
+
+                case Command::EndRenderSubpass:
+                    iterator.NextCommand<EndRenderSubpassCmd>();
+                    valid = ValidateEndRenderSubpass();
+                    break;
+
+                case Command::ExecuteBundle:
+                    valid = ValidateExecuteBundle(iterator.NextCommand<ExecuteBundleCmd>()->bundle);
+                    break;
+
+                case Command::SetPipeline:
+                    valid = ValidateSetPipeline(iterator.NextCommand<SetPipelineCmd>()->pipeline, &isRedundant);
+                    break;
+
+                case Command::SetPushConstants:
                     {
-                        iterator.NextCommand<DispatchCmd>();
-                        if (!state->ValidateCanDispatch()) {
-                            return false;
-                        }
+                        SetPushConstantsCmd* cmd = iterator.NextCommand<SetPushConstantsCmd>();
+                        iterator.NextData<uint32_t>(cmd->count);
+                        valid = ValidateSetPushConstants(cmd->offset, cmd->count);
                     }
                     break;
 
-                case Command::DrawArrays:
+                case Command::SetStencilReference:
+                    iterator.NextCommand<SetStencilReferenceCmd>();
+                    valid = ValidateSetStencilReference();
+                    break;
+
+                case Command::SetBindGroup:
                     {
-                        iterator.NextCommand<DrawArraysCmd>();
-                        if (!state->ValidateCanDrawArrays()) {
-                            return false;
-                        }
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        uint32_t* dynamicOffsets = iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        valid = ValidateSetBindGroup(cmd->index, cmd->group, cmd->dynamicOffsetCount, dynamicOffsets, &isRedundant);
                     }
                     break;
 
-                case Command::DrawElements:
+                case Command::SetIndexBuffer:
                     {
-                        iterator.NextCommand<DrawElementsCmd>();
-                        if (!state->ValidateCanDrawElements()) {
-                            return false;
-                        }
+                        SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
+                        valid = ValidateSetIndexBuffer(cmd->buffer, cmd->offset, cmd->format, &isRedundant);
                     }
                     break;
 
-                case Command::EndComputePass:
+                case Command::SetVertexBuffers:
                     {
-                        iterator.NextCommand<EndComputePassCmd>();
-                        if (!state->EndComputePass()) {
-                            return false;
-                        }
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
+                        valid = ValidateSetVertexBuffers(cmd->startSlot, cmd->count, buffers, offsets, &isRedundant);
                     }
                     break;
 
-                case Command::EndRenderPass:
+                case Command::TransitionBufferUsage:
                     {
-                        iterator.NextCommand<EndRenderPassCmd>();
-                        if (!state->EndRenderPass()) {
-                            return false;
-                        }
+                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
+                        valid = ValidateTransitionBufferUsage(cmd->buffer, cmd->usage);
                     }
                     break;
 
-                case Command::EndRenderSubpass:
+                case Command::TransitionTextureUsage:
                     {
-                        iterator.NextCommand<EndRenderSubpassCmd>();
-                        if (!state->EndSubpass()) {
-                            return false;
-                        }
+                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
+                        valid = ValidateTransitionTextureUsage(cmd->texture, cmd->usage);
                     }
                     break;
+            }
+
+            if (!valid) {
+                return false;
+            }
+            if (isRedundant) {
+                (*redundantStateCommands)++;
+            }
+        }
+
+        return state->ValidateEndCommandBuffer();
+    }
+
+    bool CommandBufferBuilder::ValidateBeginComputePass() {
+        redundantState->Reset();
+        return state->BeginComputePass();
+    }
+
+    bool CommandBufferBuilder::ValidateBeginRenderPass(RenderPassBase* renderPass, FramebufferBase* framebuffer) {
+        // TODO(kainino@chromium.org): null checks should not be necessary
+        if (renderPass == nullptr) {
+            HandleError("Render pass is invalid");
+            return false;
+        }
+        if (framebuffer == nullptr) {
+            HandleError("Framebuffer is invalid");
+            return false;
+        }
+        redundantState->Reset();
+        return state->BeginRenderPass(renderPass, framebuffer);
+    }
+
+    bool CommandBufferBuilder::ValidateBeginRenderSubpass() {
+        redundantState->Reset();
+        return state->BeginSubpass();
+    }
+
+    bool CommandBufferBuilder::ValidateCopyBufferToBuffer(const CopyBufferToBufferCmd& copy) {
+        return ValidateCopySizeFitsInBuffer(this, copy.source, copy.size) &&
+               ValidateCopySizeFitsInBuffer(this, copy.destination, copy.size) &&
+               state->ValidateCanCopy() &&
+               state->ValidateCanUseBufferAs(copy.source.buffer, nxt::BufferUsageBit::TransferSrc) &&
+               state->ValidateCanUseBufferAs(copy.destination.buffer, nxt::BufferUsageBit::TransferDst);
+    }
+
+    bool CommandBufferBuilder::ValidateCopyBufferToTexture(const CopyBufferToTextureCmd& copy) {
+        uint32_t bufferCopySize = 0;
+        return ComputeTextureCopyBufferSize(this, copy.destination, &bufferCopySize) &&
+               ValidateCopyLocationFitsInTexture(this, copy.destination) &&
+               ValidateCopySizeFitsInBuffer(this, copy.source, bufferCopySize) &&
+               state->ValidateCanCopy() &&
+               state->ValidateCanUseBufferAs(copy.source.buffer, nxt::BufferUsageBit::TransferSrc) &&
+               state->ValidateCanUseTextureAs(copy.destination.texture, nxt::TextureUsageBit::TransferDst);
+    }
+
+    bool CommandBufferBuilder::ValidateCopyTextureToBuffer(const CopyTextureToBufferCmd& copy) {
+        uint32_t bufferCopySize = 0;
+        return ComputeTextureCopyBufferSize(this, copy.source, &bufferCopySize) &&
+               ValidateCopyLocationFitsInTexture(this, copy.source) &&
+               ValidateCopySizeFitsInBuffer(this, copy.destination, bufferCopySize) &&
+               state->ValidateCanCopy() &&
+               state->ValidateCanUseTextureAs(copy.source.texture, nxt::TextureUsageBit::TransferSrc) &&
+               state->ValidateCanUseBufferAs(copy.destination.buffer, nxt::BufferUsageBit::TransferDst);
+    }
+
+    bool CommandBufferBuilder::ValidateDispatch() {
+        return state->ValidateCanDispatch();
+    }
+
+    bool CommandBufferBuilder::ValidateDrawArrays(const DrawArraysCmd& draw) {
+        return state->ValidateCanDrawArrays(draw.vertexCount, draw.instanceCount, draw.firstVertex, draw.firstInstance);
+    }
+
+    bool CommandBufferBuilder::ValidateDrawElements(const DrawElementsCmd& draw) {
+        return state->ValidateCanDrawElements(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.firstInstance);
+    }
+
+    bool CommandBufferBuilder::ValidateEndComputePass() {
+        redundantState->Reset();
+        return state->EndComputePass();
+    }
+
+    bool CommandBufferBuilder::ValidateEndRenderPass() {
+        redundantState->Reset();
+        return state->EndRenderPass();
+    }
+
+    bool CommandBufferBuilder::ValidateEndRenderSubpass() {
+        redundantState->Reset();
+        return state->EndSubpass();
+    }
+
+    bool CommandBufferBuilder::ValidateExecuteBundle(RenderBundleBase* bundle) {
+        if (bundle == nullptr) {
+            HandleError("Render bundle is invalid");
+            return false;
+        }
+        redundantState->Reset();
+        return state->ExecuteBundle(bundle);
+    }
+
+    bool CommandBufferBuilder::ValidateSetPipeline(PipelineBase* pipeline, bool* isRedundant) {
+        if (!state->SetPipeline(pipeline)) {
+            return false;
+        }
+        *isRedundant = redundantState->SetPipeline(pipeline);
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateSetPushConstants(uint32_t offset, uint32_t count) {
+        if (count + offset > kMaxPushConstants) {
+            HandleError("Setting pushconstants past the limit");
+            return false;
+        }
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateSetStencilReference() {
+        if (!state->HaveRenderPass()) {
+            HandleError("Can't set stencil reference without an active render pass");
+            return false;
+        }
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateSetBindGroup(uint32_t index, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets, bool* isRedundant) {
+        if (!state->SetBindGroup(index, group, dynamicOffsetCount, dynamicOffsets)) {
+            return false;
+        }
+        *isRedundant = redundantState->SetBindGroup(index, group, dynamicOffsetCount, dynamicOffsets);
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateSetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format, bool* isRedundant) {
+        if (!state->SetIndexBuffer(buffer, offset, format)) {
+            return false;
+        }
+        *isRedundant = redundantState->SetIndexBuffer(buffer, offset, format);
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateSetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, const uint32_t* offsets, bool* isRedundant) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!state->SetVertexBuffer(startSlot + i, buffers[i], offsets[i])) {
+                return false;
+            }
+        }
+        *isRedundant = redundantState->SetVertexBuffers(startSlot, count, buffers, offsets);
+        return true;
+    }
+
+    bool CommandBufferBuilder::ValidateTransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage) {
+        return state->TransitionBufferUsage(buffer, usage);
+    }
+
+    bool CommandBufferBuilder::ValidateTransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage) {
+        return state->TransitionTextureUsage(texture, usage);
+    }
+
+    bool CommandBufferBuilder::SkipRedundantCommand(bool isRedundant) {
+        if (isRedundant && device->IsRedundantStateEliminationEnabled()) {
+            redundantStateCommandsRemoved++;
+            return true;
+        }
+        return false;
+    }
+
+    void CommandBufferBuilder::EliminateRedundantState() {
+        // The stream was fully validated so it can be rewritten without the redundant commands
+        // into a new allocator. Commands that are kept are copied. The objects used only by the
+        // removed commands stay in the residency set until the command buffer is destroyed.
+        CommandAllocator compacted(device->GetCommandBlockPool());
+        RedundantStateTracker redundantState;
+
+        Command type;
+        while (iterator.NextCommandId(&type)) {
+            switch (type) {
+                case Command::BeginComputePass:
+                    CopyCommand<BeginComputePassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::BeginRenderPass:
+                    CopyCommand<BeginRenderPassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::BeginRenderSubpass:
+                    CopyCommand<BeginRenderSubpassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::CopyBufferToBuffer:
+                    CopyCommand<CopyBufferToBufferCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::CopyBufferToTexture:
+                    CopyCommand<CopyBufferToTextureCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::CopyTextureToBuffer:
+                    CopyCommand<CopyTextureToBufferCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::Dispatch:
+                    CopyPackedCommand<DispatchCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::DrawArrays:
+                    CopyPackedCommand<DrawArraysCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::DrawElements:
+                    CopyPackedCommand<DrawElementsCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::EndComputePass:
+                    CopyCommand<EndComputePassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::EndRenderPass:
+                    CopyCommand<EndRenderPassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::EndRenderSubpass:
+                    CopyCommand<EndRenderSubpassCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
+
+                case Command::ExecuteBundle:
+                    CopyCommand<ExecuteBundleCmd>(&iterator, &compacted, type);
+                    redundantState.Reset();
+                    break;
 
                 case Command::SetPipeline:
                     {
                         SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
-                        PipelineBase* pipeline = cmd->pipeline.Get();
-                        if (!state->SetPipeline(pipeline)) {
-                            return false;
+                        if (!redundantState.SetPipeline(cmd->pipeline)) {
+                            new(compacted.Allocate<SetPipelineCmd>(type)) SetPipelineCmd(*cmd);
                         }
                     }
                     break;
@@ -493,29 +841,28 @@ namespace backend {
                 case Command::SetPushConstants:
                     {
                         SetPushConstantsCmd* cmd = iterator.NextCommand<SetPushConstantsCmd>();
-                        iterator.NextData<uint32_t>(cmd->count);
-                        if (cmd->count + cmd->offset > kMaxPushConstants) {
-                            HandleError("Setting pushconstants past the limit");
-                            return false;
-                        }
+                        uint32_t* values = iterator.NextData<uint32_t>(cmd->count);
+
+                        compacted.AllocatePacked(type, *cmd);
+                        uint32_t* newValues = compacted.AllocateData<uint32_t>(cmd->count);
+                        memcpy(newValues, values, cmd->count * sizeof(uint32_t));
                     }
                     break;
 
                 case Command::SetStencilReference:
-                    {
-                        iterator.NextCommand<SetStencilReferenceCmd>();
-                        if (!state->HaveRenderPass()) {
-                            HandleError("Can't set stencil reference without an active render pass");
-                            return false;
-                        }
-                    }
+                    CopyPackedCommand<SetStencilReferenceCmd>(&iterator, &compacted, type);
                     break;
 
                 case Command::SetBindGroup:
                     {
                         SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
-                        if (!state->SetBindGroup(cmd->index, cmd->group.Get())) {
-                            return false;
+                        uint32_t* dynamicOffsets = iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+
+                        if (!redundantState.SetBindGroup(cmd->index, cmd->group, cmd->dynamicOffsetCount, dynamicOffsets)) {
+                            new(compacted.Allocate<SetBindGroupCmd>(type)) SetBindGroupCmd(*cmd);
+
+                            uint32_t* newDynamicOffsets = compacted.AllocateData<uint32_t>(cmd->dynamicOffsetCount);
+                            memcpy(newDynamicOffsets, dynamicOffsets, cmd->dynamicOffsetCount * sizeof(uint32_t));
                         }
                     }
                     break;
@@ -523,8 +870,8 @@ namespace backend {
                 case Command::SetIndexBuffer:
                     {
                         SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
-                        if (!state->SetIndexBuffer(cmd->buffer.Get())) {
-                            return false;
+                        if (!redundantState.SetIndexBuffer(cmd->buffer, cmd->offset, cmd->format)) {
+                            new(compacted.Allocate<SetIndexBufferCmd>(type)) SetIndexBufferCmd(*cmd);
                         }
                     }
                     break;
@@ -532,155 +879,323 @@ namespace backend {
                 case Command::SetVertexBuffers:
                     {
                         SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
-                        auto buffers = iterator.NextData<Ref<BufferBase>>(cmd->count);
-                        iterator.NextData<uint32_t>(cmd->count);
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
 
-                        for (uint32_t i = 0; i < cmd->count; ++i) {
-                            state->SetVertexBuffer(cmd->startSlot + i, buffers[i].Get());
+                        if (!redundantState.SetVertexBuffers(cmd->startSlot, cmd->count, buffers, offsets)) {
+                            new(compacted.Allocate<SetVertexBuffersCmd>(type)) SetVertexBuffersCmd(*cmd);
+
+                            BufferBase** newBuffers = compacted.AllocateData<BufferBase*>(cmd->count);
+                            memcpy(newBuffers, buffers, cmd->count * sizeof(BufferBase*));
+
+                            uint32_t* newOffsets = compacted.AllocateData<uint32_t>(cmd->count);
+                            memcpy(newOffsets, offsets, cmd->count * sizeof(uint32_t));
                         }
                     }
                     break;
 
                 case Command::TransitionBufferUsage:
+                    CopyCommand<TransitionBufferUsageCmd>(&iterator, &compacted, type);
+                    break;
+
+                case Command::TransitionTextureUsage:
+                    CopyCommand<TransitionTextureUsageCmd>(&iterator, &compacted, type);
+                    break;
+            }
+        }
+
+        FreeCommands(&iterator);
+        iterator = std::move(compacted);
+    }
+
+    void CommandBufferBuilder::CaptureUsageStates() {
+        Command type;
+        while (iterator.NextCommandId(&type)) {
+            switch (type) {
+                case Command::BeginRenderPass:
+                    state->CaptureUsageStates(iterator.NextCommand<BeginRenderPassCmd>()->framebuffer);
+                    break;
+
+                case Command::CopyBufferToBuffer:
                     {
-                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
-                        if (!state->TransitionBufferUsage(cmd->buffer.Get(), cmd->usage)) {
-                            return false;
-                        }
+                        CopyBufferToBufferCmd* cmd = iterator.NextCommand<CopyBufferToBufferCmd>();
+                        state->CaptureUsageState(cmd->source.buffer);
+                        state->CaptureUsageState(cmd->destination.buffer);
                     }
                     break;
 
-                case Command::TransitionTextureUsage:
+                case Command::CopyBufferToTexture:
                     {
-                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
-                        if (!state->TransitionTextureUsage(cmd->texture.Get(), cmd->usage)) {
-                            return false;
-                        }
+                        CopyBufferToTextureCmd* cmd = iterator.NextCommand<CopyBufferToTextureCmd>();
+                        state->CaptureUsageState(cmd->source.buffer);
+                        state->CaptureUsageState(cmd->destination.texture);
+                    }
+                    break;
 
+                case Command::CopyTextureToBuffer:
+                    {
+                        CopyTextureToBufferCmd* cmd = iterator.NextCommand<CopyTextureToBufferCmd>();
+                        state->CaptureUsageState(cmd->source.texture);
+                        state->CaptureUsageState(cmd->destination.buffer);
                     }
                     break;
-            }
-        }
 
-        if (!state->ValidateEndCommandBuffer()) {
-            return false;
-        }
+                case Command::ExecuteBundle:
+                    state->CaptureUsageStates(iterator.NextCommand<ExecuteBundleCmd>()->bundle);
+                    break;
 
-        return true;
+                case Command::SetBindGroup:
+                    {
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        state->CaptureUsageStates(cmd->group);
+                    }
+                    break;
+
+                case Command::SetIndexBuffer:
+                    state->CaptureUsageState(iterator.NextCommand<SetIndexBufferCmd>()->buffer);
+                    break;
+
+                case Command::SetVertexBuffers:
+                    {
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        iterator.NextData<uint32_t>(cmd->count);
+                        for (uint32_t i = 0; i < cmd->count; ++i) {
+                            state->CaptureUsageState(buffers[i]);
+                        }
+                    }
+                    break;
+
+                case Command::TransitionBufferUsage:
+                    state->CaptureUsageState(iterator.NextCommand<TransitionBufferUsageCmd>()->buffer);
+                    break;
+
+                case Command::TransitionTextureUsage:
+                    state->CaptureUsageState(iterator.NextCommand<TransitionTextureUsageCmd>()->texture);
+                    break;
+
+                default:
+                    SkipCommand(&iterator, type);
+                    break;
+            }
+        }
+        iterator.Reset();
     }
 
     CommandIterator CommandBufferBuilder::AcquireCommands() {
+        // The builder keeps the commands while they are validated in the background, and the
+        // command buffer keeps the builder alive.
+        if (validatingInBackground) {
+            return iterator.CreateView();
+        }
+
         ASSERT(!commandsAcquired);
         commandsAcquired = true;
         return std::move(iterator);
     }
 
     CommandBufferBase* CommandBufferBuilder::GetResultImpl() {
+        NXT_TRACE_EVENT("frontend", "CommandBufferBuilder::GetResult");
         MoveToIterator();
-        return device->CreateCommandBuffer(this);
+
+        // Through the non-validating procs ValidateGetResult isn't called, but the errors
+        // latched while recording must still be reported.
+        StopLatchingErrors();
+        if (HasLatchedError()) {
+            return nullptr;
+        }
+
+        if (validatingInBackground) {
+            CaptureUsageStates();
+        }
+
+        CommandBufferBase* result = device->CreateCommandBuffer(this);
+        if (validatingInBackground) {
+            result->ValidateInBackground(this);
+        }
+        return result;
     }
 
     void CommandBufferBuilder::BeginComputePass() {
+        if (streamingValidation && (HasLatchedError() || !ValidateBeginComputePass())) {
+            return;
+        }
+
         allocator.Allocate<BeginComputePassCmd>(Command::BeginComputePass);
     }
 
     void CommandBufferBuilder::BeginRenderPass(RenderPassBase* renderPass, FramebufferBase* framebuffer) {
+        if (streamingValidation && (HasLatchedError() || !ValidateBeginRenderPass(renderPass, framebuffer))) {
+            return;
+        }
+
         BeginRenderPassCmd* cmd = allocator.Allocate<BeginRenderPassCmd>(Command::BeginRenderPass);
         new(cmd) BeginRenderPassCmd;
         cmd->renderPass = renderPass;
         cmd->framebuffer = framebuffer;
+        residency.Add(renderPass);
+        residency.Add(framebuffer);
     }
 
     void CommandBufferBuilder::BeginRenderSubpass() {
+        if (streamingValidation && (HasLatchedError() || !ValidateBeginRenderSubpass())) {
+            return;
+        }
+
         allocator.Allocate<BeginRenderSubpassCmd>(Command::BeginRenderSubpass);
     }
 
     void CommandBufferBuilder::CopyBufferToBuffer(BufferBase* source, uint32_t sourceOffset, BufferBase* destination, uint32_t destinationOffset, uint32_t size) {
-        CopyBufferToBufferCmd* copy = allocator.Allocate<CopyBufferToBufferCmd>(Command::CopyBufferToBuffer);
-        new(copy) CopyBufferToBufferCmd;
-        copy->source.buffer = source;
-        copy->source.offset = sourceOffset;
-        copy->destination.buffer = destination;
-        copy->destination.offset = destinationOffset;
-        copy->size = size;
+        CopyBufferToBufferCmd copy;
+        copy.source.buffer = source;
+        copy.source.offset = sourceOffset;
+        copy.destination.buffer = destination;
+        copy.destination.offset = destinationOffset;
+        copy.size = size;
+
+        if (streamingValidation && (HasLatchedError() || !ValidateCopyBufferToBuffer(copy))) {
+            return;
+        }
+
+        new(allocator.Allocate<CopyBufferToBufferCmd>(Command::CopyBufferToBuffer)) CopyBufferToBufferCmd(copy);
+        residency.Add(source);
+        residency.Add(destination);
     }
 
     void CommandBufferBuilder::CopyBufferToTexture(BufferBase* buffer, uint32_t bufferOffset,
                                                    TextureBase* texture, uint32_t x, uint32_t y, uint32_t z,
                                                    uint32_t width, uint32_t height, uint32_t depth, uint32_t level) {
-        CopyBufferToTextureCmd* copy = allocator.Allocate<CopyBufferToTextureCmd>(Command::CopyBufferToTexture);
-        new(copy) CopyBufferToTextureCmd;
-        copy->source.buffer = buffer;
-        copy->source.offset = bufferOffset;
-        copy->destination.texture = texture;
-        copy->destination.x = x;
-        copy->destination.y = y;
-        copy->destination.z = z;
-        copy->destination.width = width;
-        copy->destination.height = height;
-        copy->destination.depth = depth;
-        copy->destination.level = level;
+        CopyBufferToTextureCmd copy;
+        copy.source.buffer = buffer;
+        copy.source.offset = bufferOffset;
+        copy.destination.texture = texture;
+        copy.destination.x = x;
+        copy.destination.y = y;
+        copy.destination.z = z;
+        copy.destination.width = width;
+        copy.destination.height = height;
+        copy.destination.depth = depth;
+        copy.destination.level = level;
+
+        if (streamingValidation && (HasLatchedError() || !ValidateCopyBufferToTexture(copy))) {
+            return;
+        }
+
+        new(allocator.Allocate<CopyBufferToTextureCmd>(Command::CopyBufferToTexture)) CopyBufferToTextureCmd(copy);
+        residency.Add(buffer);
+        residency.Add(texture);
     }
 
     void CommandBufferBuilder::CopyTextureToBuffer(TextureBase* texture, uint32_t x, uint32_t y, uint32_t z,
                                                   uint32_t width, uint32_t height, uint32_t depth, uint32_t level,
                                                   BufferBase* buffer, uint32_t bufferOffset) {
-        CopyTextureToBufferCmd* copy = allocator.Allocate<CopyTextureToBufferCmd>(Command::CopyTextureToBuffer);
-        new(copy) CopyTextureToBufferCmd;
-        copy->source.texture = texture;
-        copy->source.x = x;
-        copy->source.y = y;
-        copy->source.z = z;
-        copy->source.width = width;
-        copy->source.height = height;
-        copy->source.depth = depth;
-        copy->source.level = level;
-        copy->destination.buffer = buffer;
-        copy->destination.offset = bufferOffset;
+        CopyTextureToBufferCmd copy;
+        copy.source.texture = texture;
+        copy.source.x = x;
+        copy.source.y = y;
+        copy.source.z = z;
+        copy.source.width = width;
+        copy.source.height = height;
+        copy.source.depth = depth;
+        copy.source.level = level;
+        copy.destination.buffer = buffer;
+        copy.destination.offset = bufferOffset;
+
+        if (streamingValidation && (HasLatchedError() || !ValidateCopyTextureToBuffer(copy))) {
+            return;
+        }
+
+        new(allocator.Allocate<CopyTextureToBufferCmd>(Command::CopyTextureToBuffer)) CopyTextureToBufferCmd(copy);
+        residency.Add(texture);
+        residency.Add(buffer);
     }
 
     void CommandBufferBuilder::Dispatch(uint32_t x, uint32_t y, uint32_t z) {
-        DispatchCmd* dispatch = allocator.Allocate<DispatchCmd>(Command::Dispatch);
-        new(dispatch) DispatchCmd;
-        dispatch->x = x;
-        dispatch->y = y;
-        dispatch->z = z;
+        if (streamingValidation && (HasLatchedError() || !ValidateDispatch())) {
+            return;
+        }
+
+        DispatchCmd dispatch;
+        dispatch.x = x;
+        dispatch.y = y;
+        dispatch.z = z;
+        allocator.AllocatePacked(Command::Dispatch, dispatch);
     }
 
     void CommandBufferBuilder::DrawArrays(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
-        DrawArraysCmd* draw = allocator.Allocate<DrawArraysCmd>(Command::DrawArrays);
-        new(draw) DrawArraysCmd;
-        draw->vertexCount = vertexCount;
-        draw->instanceCount = instanceCount;
-        draw->firstVertex = firstVertex;
-        draw->firstInstance = firstInstance;
+        DrawArraysCmd draw;
+        draw.vertexCount = vertexCount;
+        draw.instanceCount = instanceCount;
+        draw.firstVertex = firstVertex;
+        draw.firstInstance = firstInstance;
+        if (streamingValidation && (HasLatchedError() || !ValidateDrawArrays(draw))) {
+            return;
+        }
+
+        allocator.AllocatePacked(Command::DrawArrays, draw);
     }
 
     void CommandBufferBuilder::DrawElements(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance) {
-        DrawElementsCmd* draw = allocator.Allocate<DrawElementsCmd>(Command::DrawElements);
-        new(draw) DrawElementsCmd;
-        draw->indexCount = indexCount;
-        draw->instanceCount = instanceCount;
-        draw->firstIndex = firstIndex;
-        draw->firstInstance = firstInstance;
+        DrawElementsCmd draw;
+        draw.indexCount = indexCount;
+        draw.instanceCount = instanceCount;
+        draw.firstIndex = firstIndex;
+        draw.firstInstance = firstInstance;
+        if (streamingValidation && (HasLatchedError() || !ValidateDrawElements(draw))) {
+            return;
+        }
+
+        allocator.AllocatePacked(Command::DrawElements, draw);
     }
 
     void CommandBufferBuilder::EndComputePass() {
+        if (streamingValidation && (HasLatchedError() || !ValidateEndComputePass())) {
+            return;
+        }
+
         allocator.Allocate<EndComputePassCmd>(Command::EndComputePass);
     }
 
     void CommandBufferBuilder::EndRenderPass() {
+        if (streamingValidation && (HasLatchedError() || !ValidateEndRenderPass())) {
+            return;
+        }
+
         allocator.Allocate<EndRenderPassCmd>(Command::EndRenderPass);
     }
 
     void CommandBufferBuilder::EndRenderSubpass() {
+        if (streamingValidation && (HasLatchedError() || !ValidateEndRenderSubpass())) {
+            return;
+        }
+
         allocator.Allocate<EndRenderSubpassCmd>(Command::EndRenderSubpass);
     }
 
+    void CommandBufferBuilder::ExecuteBundle(RenderBundleBase* bundle) {
+        if (streamingValidation && (HasLatchedError() || !ValidateExecuteBundle(bundle))) {
+            return;
+        }
+
+        ExecuteBundleCmd* cmd = allocator.Allocate<ExecuteBundleCmd>(Command::ExecuteBundle);
+        new(cmd) ExecuteBundleCmd;
+        cmd->bundle = bundle;
+        residency.Add(bundle);
+    }
+
     void CommandBufferBuilder::SetPipeline(PipelineBase* pipeline) {
+        if (streamingValidation) {
+            bool isRedundant = false;
+            if (HasLatchedError() || !ValidateSetPipeline(pipeline, &isRedundant) || SkipRedundantCommand(isRedundant)) {
+                return;
+            }
+        }
+
         SetPipelineCmd* cmd = allocator.Allocate<SetPipelineCmd>(Command::SetPipeline);
         new(cmd) SetPipelineCmd;
         cmd->pipeline = pipeline;
+        residency.Add(pipeline);
     }
 
     void CommandBufferBuilder::SetPushConstants(nxt::ShaderStageBit stage, uint32_t offset, uint32_t count, const void* data) {
@@ -688,56 +1203,88 @@ namespace backend {
             HandleError("Setting too many push constants");
             return;
         }
+        if (streamingValidation && (HasLatchedError() || !ValidateSetPushConstants(offset, count))) {
+            return;
+        }
 
-        SetPushConstantsCmd* cmd = allocator.Allocate<SetPushConstantsCmd>(Command::SetPushConstants);
-        new(cmd) SetPushConstantsCmd;
-        cmd->stage = stage;
-        cmd->offset = offset;
-        cmd->count = count;
+        SetPushConstantsCmd cmd;
+        cmd.stage = stage;
+        cmd.offset = offset;
+        cmd.count = count;
+        allocator.AllocatePacked(Command::SetPushConstants, cmd);
 
         uint32_t* values = allocator.AllocateData<uint32_t>(count);
         memcpy(values, data, count * sizeof(uint32_t));
     }
 
     void CommandBufferBuilder::SetStencilReference(uint32_t reference) {
-        SetStencilReferenceCmd* cmd = allocator.Allocate<SetStencilReferenceCmd>(Command::SetStencilReference);
-        new(cmd) SetStencilReferenceCmd;
-        cmd->reference = reference;
+        if (streamingValidation && (HasLatchedError() || !ValidateSetStencilReference())) {
+            return;
+        }
+
+        SetStencilReferenceCmd cmd;
+        cmd.reference = reference;
+        allocator.AllocatePacked(Command::SetStencilReference, cmd);
     }
 
-    void CommandBufferBuilder::SetBindGroup(uint32_t groupIndex, BindGroupBase* group) {
+    void CommandBufferBuilder::SetBindGroup(uint32_t groupIndex, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
         if (groupIndex >= kMaxBindGroups) {
             HandleError("Setting bind group over the max");
             return;
         }
+        if (streamingValidation) {
+            bool isRedundant = false;
+            if (HasLatchedError() || !ValidateSetBindGroup(groupIndex, group, dynamicOffsetCount, dynamicOffsets, &isRedundant) || SkipRedundantCommand(isRedundant)) {
+                return;
+            }
+        }
 
         SetBindGroupCmd* cmd = allocator.Allocate<SetBindGroupCmd>(Command::SetBindGroup);
         new(cmd) SetBindGroupCmd;
         cmd->index = groupIndex;
         cmd->group = group;
+        cmd->dynamicOffsetCount = dynamicOffsetCount;
+        residency.Add(group);
+
+        uint32_t* cmdDynamicOffsets = allocator.AllocateData<uint32_t>(dynamicOffsetCount);
+        memcpy(cmdDynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t));
     }
 
     void CommandBufferBuilder::SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format) {
         // TODO(kainino@chromium.org): validation
+        if (streamingValidation) {
+            bool isRedundant = false;
+            if (HasLatchedError() || !ValidateSetIndexBuffer(buffer, offset, format, &isRedundant) || SkipRedundantCommand(isRedundant)) {
+                return;
+            }
+        }
 
         SetIndexBufferCmd* cmd = allocator.Allocate<SetIndexBufferCmd>(Command::SetIndexBuffer);
         new(cmd) SetIndexBufferCmd;
         cmd->buffer = buffer;
         cmd->offset = offset;
         cmd->format = format;
+        residency.Add(buffer);
     }
 
     void CommandBufferBuilder::SetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, uint32_t const* offsets){
         // TODO(kainino@chromium.org): validation
+        if (streamingValidation) {
+            bool isRedundant = false;
+            if (HasLatchedError() || !ValidateSetVertexBuffers(startSlot, count, buffers, offsets, &isRedundant) || SkipRedundantCommand(isRedundant)) {
+                return;
+            }
+        }
 
         SetVertexBuffersCmd* cmd = allocator.Allocate<SetVertexBuffersCmd>(Command::SetVertexBuffers);
         new(cmd) SetVertexBuffersCmd;
         cmd->startSlot = startSlot;
         cmd->count = count;
 
-        Ref<BufferBase>* cmdBuffers = allocator.AllocateData<Ref<BufferBase>>(count);
+        BufferBase** cmdBuffers = allocator.AllocateData<BufferBase*>(count);
         for (size_t i = 0; i < count; ++i) {
-            new(&cmdBuffers[i]) Ref<BufferBase>(buffers[i]);
+            cmdBuffers[i] = buffers[i];
+            residency.Add(buffers[i]);
         }
 
         uint32_t* cmdOffsets = allocator.AllocateData<uint32_t>(count);
@@ -745,17 +1292,27 @@ namespace backend {
     }
 
     void CommandBufferBuilder::TransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage) {
+        if (streamingValidation && (HasLatchedError() || !ValidateTransitionBufferUsage(buffer, usage))) {
+            return;
+        }
+
         TransitionBufferUsageCmd* cmd = allocator.Allocate<TransitionBufferUsageCmd>(Command::TransitionBufferUsage);
         new(cmd) TransitionBufferUsageCmd;
         cmd->buffer = buffer;
         cmd->usage = usage;
+        residency.Add(buffer);
     }
 
     void CommandBufferBuilder::TransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage) {
+        if (streamingValidation && (HasLatchedError() || !ValidateTransitionTextureUsage(texture, usage))) {
+            return;
+        }
+
         TransitionTextureUsageCmd* cmd = allocator.Allocate<TransitionTextureUsageCmd>(Command::TransitionTextureUsage);
         new(cmd) TransitionTextureUsageCmd;
         cmd->texture = texture;
         cmd->usage = usage;
+        residency.Add(texture);
     }
 
     void CommandBufferBuilder::MoveToIterator() {
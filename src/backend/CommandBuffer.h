@@ -17,36 +17,88 @@
 
 #include "nxt/nxtcpp.h"
 
+#include "backend/Buffer.h"
 #include "backend/CommandAllocator.h"
 #include "backend/Builder.h"
 #include "backend/RefCounted.h"
+#include "backend/ResidencySet.h"
 
+#include <condition_variable>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 namespace backend {
 
     class BindGroupBase;
     class BufferBase;
     class CommandBufferStateTracker;
+    class RedundantStateTracker;
     class FramebufferBase;
     class DeviceBase;
     class PipelineBase;
+    class RenderBundleBase;
     class RenderPassBase;
     class TextureBase;
 
     class CommandBufferBuilder;
 
+    struct CopyBufferToBufferCmd;
+    struct CopyBufferToTextureCmd;
+    struct CopyTextureToBufferCmd;
+    struct DrawArraysCmd;
+    struct DrawElementsCmd;
+
+    // Command buffers can be submitted any number of times. The commands are validated once in
+    // CommandBufferBuilder::GetResult, relative to the frozen usages and the transitions in the
+    // command buffer, so on each submission only the state that could have changed since is
+    // checked by ValidateResourceUsagesImmediate: resources that got frozen or mapped, and the
+    // contents of index buffers that changed.
+    //
+    // With background validation (see DeviceBase::SetBackgroundValidationEnabled) the commands
+    // are validated on the device's validation thread instead. The command buffer then keeps the
+    // builder alive, as it owns the commands and the state of the validation.
     class CommandBufferBase : public RefCounted {
         public:
             CommandBufferBase(CommandBufferBuilder* builder);
+            ~CommandBufferBase();
             bool ValidateResourceUsagesImmediate();
 
+            // Waits for the background validation if there is one, and calls the builder's
+            // callback the first time. Returns whether the commands are valid.
+            bool WaitForValidation();
+
+            // The contents of the buffers written by the command buffer are no longer known once
+            // it is submitted.
+            void InvalidateContentsWritten();
+
+            // The number of redundant state commands that were removed from the command stream
+            // when the command buffer was built.
+            uint32_t GetRedundantStateCommandsRemoved() const;
+
         private:
+            friend class CommandBufferBuilder;
+
+            void TakeValidationResults(CommandBufferBuilder* builder);
+            void ValidateInBackground(CommandBufferBuilder* builder);
+
             DeviceBase* device;
-            std::set<BufferBase*> buffersTransitioned;
-            std::set<TextureBase*> texturesTransitioned;
+            // Sorted and without duplicates.
+            std::vector<BufferBase*> buffersTransitioned;
+            std::vector<TextureBase*> texturesTransitioned;
+            std::vector<BufferBase*> buffersWritten;
+            std::vector<IndexRangeCheck> indexRangeChecks;
+            ResidencySet residency;
+            uint32_t redundantStateCommandsRemoved = 0;
+
+            Ref<CommandBufferBuilder> validationBuilder;
+            std::mutex validationMutex;
+            std::condition_variable validationCondition;
+            // Protected by the mutex.
+            bool validationFinished = false;
+            bool validationSucceeded = false;
+            bool validationResolved = false;
     };
 
     class CommandBufferBuilder : public Builder<CommandBufferBase> {
@@ -75,10 +127,11 @@ namespace backend {
             void EndComputePass();
             void EndRenderPass();
             void EndRenderSubpass();
+            void ExecuteBundle(RenderBundleBase* bundle);
             void SetPushConstants(nxt::ShaderStageBit stage, uint32_t offset, uint32_t count, const void* data);
             void SetPipeline(PipelineBase* pipeline);
             void SetStencilReference(uint32_t reference);
-            void SetBindGroup(uint32_t groupIndex, BindGroupBase* group);
+            void SetBindGroup(uint32_t groupIndex, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets);
             void SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format);
 
             template<typename T>
@@ -96,12 +149,52 @@ namespace backend {
 
             CommandBufferBase* GetResultImpl() override;
             void MoveToIterator();
+            void EliminateRedundantState();
+            bool ValidateCommands(uint32_t* redundantStateCommands);
+
+            // Validation of each command, shared by ValidateGetResult and streaming validation
+            // in the recording methods. The Set* validators also tell if the command is redundant.
+            bool ValidateBeginComputePass();
+            bool ValidateBeginRenderPass(RenderPassBase* renderPass, FramebufferBase* framebuffer);
+            bool ValidateBeginRenderSubpass();
+            bool ValidateCopyBufferToBuffer(const CopyBufferToBufferCmd& copy);
+            bool ValidateCopyBufferToTexture(const CopyBufferToTextureCmd& copy);
+            bool ValidateCopyTextureToBuffer(const CopyTextureToBufferCmd& copy);
+            bool ValidateDispatch();
+            bool ValidateDrawArrays(const DrawArraysCmd& draw);
+            bool ValidateDrawElements(const DrawElementsCmd& draw);
+            bool ValidateEndComputePass();
+            bool ValidateEndRenderPass();
+            bool ValidateEndRenderSubpass();
+            bool ValidateExecuteBundle(RenderBundleBase* bundle);
+            bool ValidateSetPipeline(PipelineBase* pipeline, bool* isRedundant);
+            bool ValidateSetPushConstants(uint32_t offset, uint32_t count);
+            bool ValidateSetStencilReference();
+            bool ValidateSetBindGroup(uint32_t index, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets, bool* isRedundant);
+            bool ValidateSetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format, bool* isRedundant);
+            bool ValidateSetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, const uint32_t* offsets, bool* isRedundant);
+            bool ValidateTransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage);
+            bool ValidateTransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
+
+            // Captures the usage state of the resources used by the commands, before they are
+            // validated in the background.
+            void CaptureUsageStates();
+
+            // Returns true when a redundant command shouldn't be recorded in streaming validation.
+            bool SkipRedundantCommand(bool isRedundant);
 
             std::unique_ptr<CommandBufferStateTracker> state;
+            std::unique_ptr<RedundantStateTracker> redundantState;
             CommandAllocator allocator;
             CommandIterator iterator;
             bool movedToIterator = false;
             bool commandsAcquired = false;
+            uint32_t redundantStateCommandsRemoved = 0;
+            // Holds the references to the objects used by the commands, see Commands.h
+            ResidencySet residency;
+            bool streamingValidation = false;
+            bool backgroundValidation = false;
+            bool validatingInBackground = false;
     };
 
 }
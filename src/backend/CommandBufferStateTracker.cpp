@@ -18,18 +18,72 @@
 #include "backend/BindGroup.h"
 #include "backend/BindGroupLayout.h"
 #include "backend/Buffer.h"
+#include "backend/Device.h"
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/Pipeline.h"
 #include "backend/PipelineLayout.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/Texture.h"
 #include "common/Assert.h"
 #include "common/BitSetIterator.h"
 
+#include <algorithm>
+
 namespace backend {
-    CommandBufferStateTracker::CommandBufferStateTracker(CommandBufferBuilder* builder)
-        : builder(builder) {
+    void UsageTrackingTables::Clear() {
+        mostRecentBufferUsages.Clear();
+        mostRecentTextureUsages.Clear();
+        texturesAttached.Clear();
+        buffersWritten.Clear();
+    }
+
+    CommandBufferStateTracker::CommandBufferStateTracker(BuilderBase* builder)
+        : builder(builder), tables(builder->GetDevice()->AcquireUsageTrackingTables()) {
+    }
+
+    CommandBufferStateTracker::~CommandBufferStateTracker() {
+        builder->GetDevice()->ReleaseUsageTrackingTables(tables);
+    }
+
+    void CommandBufferStateTracker::CaptureUsageState(BufferBase* buffer) {
+        usageStatesCaptured = true;
+        capturedBufferStates.Set(buffer->GetDenseIndex(), buffer->GetUsageState());
+    }
+
+    void CommandBufferStateTracker::CaptureUsageState(TextureBase* texture) {
+        usageStatesCaptured = true;
+        capturedTextureStates.Set(texture->GetDenseIndex(), texture->GetUsageState());
+    }
+
+    void CommandBufferStateTracker::CaptureUsageStates(BindGroupBase* group) {
+        for (const auto& usage : group->GetRequiredBufferUsages()) {
+            CaptureUsageState(usage.first);
+        }
+        for (const auto& usage : group->GetRequiredTextureUsages()) {
+            CaptureUsageState(usage.first);
+        }
+    }
+
+    void CommandBufferStateTracker::CaptureUsageStates(FramebufferBase* framebuffer) {
+        uint32_t attachmentCount = framebuffer->GetRenderPass()->GetAttachmentCount();
+        for (uint32_t i = 0; i < attachmentCount; ++i) {
+            // The texture view is null for the backbuffer, see BeginSubpass.
+            TextureViewBase* view = framebuffer->GetTextureView(i);
+            if (view != nullptr) {
+                CaptureUsageState(view->GetTexture());
+            }
+        }
+    }
+
+    void CommandBufferStateTracker::CaptureUsageStates(RenderBundleBase* bundle) {
+        for (const auto& usage : bundle->GetRequiredBufferUsages()) {
+            CaptureUsageState(usage.first);
+        }
+        for (const auto& usage : bundle->GetRequiredTextureUsages()) {
+            CaptureUsageState(usage.first);
+        }
     }
 
     bool CommandBufferStateTracker::HaveRenderPass() const {
@@ -44,15 +98,18 @@ namespace backend {
         return true;
     }
 
-    bool CommandBufferStateTracker::ValidateCanUseBufferAs(BufferBase* buffer, nxt::BufferUsageBit usage) const {
+    bool CommandBufferStateTracker::ValidateCanUseBufferAs(BufferBase* buffer, nxt::BufferUsageBit usage) {
         if (!BufferHasGuaranteedUsageBit(buffer, usage)) {
             builder->HandleError("Buffer is not in the necessary usage");
             return false;
         }
+        if (usage & (nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Storage)) {
+            MarkBufferWritten(buffer);
+        }
         return true;
     }
 
-    bool CommandBufferStateTracker::ValidateCanUseTextureAs(TextureBase* texture, nxt::TextureUsageBit usage) const {
+    bool CommandBufferStateTracker::ValidateCanUseTextureAs(TextureBase* texture, nxt::TextureUsageBit usage) {
         if (!TextureHasGuaranteedUsageBit(texture, usage)) {
             builder->HandleError("Texture is not in the necessary usage");
             return false;
@@ -81,37 +138,42 @@ namespace backend {
         return true;
     }
 
-    bool CommandBufferStateTracker::ValidateCanDrawArrays() {
+    bool CommandBufferStateTracker::ValidateCanDrawArrays(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
         // TODO(kainino@chromium.org): Check for a current render pass
         constexpr ValidationAspects requiredAspects =
             1 << VALIDATION_ASPECT_RENDER_PIPELINE | // implicitly requires RENDER_SUBPASS
             1 << VALIDATION_ASPECT_BIND_GROUPS |
             1 << VALIDATION_ASPECT_VERTEX_BUFFERS;
+        uint64_t vertexEnd = uint64_t(firstVertex) + vertexCount;
+        uint64_t instanceEnd = uint64_t(firstInstance) + instanceCount;
         if ((requiredAspects & ~aspects).none()) {
-            // Fast return-true path if everything is good
-            return true;
+            // Fast path if everything is good, only the fetched ranges need to be checked
+            return ValidateFetchRanges(vertexEnd, instanceEnd);
         }
 
-        return RevalidateCanDraw();
+        return RevalidateCanDraw() && ValidateFetchRanges(vertexEnd, instanceEnd);
     }
 
-    bool CommandBufferStateTracker::ValidateCanDrawElements() {
+    bool CommandBufferStateTracker::ValidateCanDrawElements(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance) {
         // TODO(kainino@chromium.org): Check for a current render pass
         constexpr ValidationAspects requiredAspects =
             1 << VALIDATION_ASPECT_RENDER_PIPELINE |
             1 << VALIDATION_ASPECT_BIND_GROUPS |
             1 << VALIDATION_ASPECT_VERTEX_BUFFERS |
             1 << VALIDATION_ASPECT_INDEX_BUFFER;
+        // The vertices fetched are checked with the indices
+        uint64_t instanceEnd = uint64_t(firstInstance) + instanceCount;
         if ((requiredAspects & ~aspects).none()) {
-            // Fast return-true path if everything is good
-            return true;
+            // Fast path if everything is good, only the fetched ranges need to be checked
+            return ValidateFetchRanges(0, instanceEnd) && ValidateIndexRange(indexCount, firstIndex);
         }
 
         if (!aspects[VALIDATION_ASPECT_INDEX_BUFFER]) {
             builder->HandleError("Cannot DrawElements without index buffer set");
             return false;
         }
-        return RevalidateCanDraw();
+        return RevalidateCanDraw() && ValidateFetchRanges(0, instanceEnd) &&
+            ValidateIndexRange(indexCount, firstIndex);
     }
 
     bool CommandBufferStateTracker::ValidateEndCommandBuffer() const {
@@ -176,7 +238,7 @@ namespace backend {
                 builder->HandleError("Unable to ensure texture has OutputAttachment usage");
                 return false;
             }
-            texturesAttached.insert(texture);
+            tables->texturesAttached.Set(texture->GetDenseIndex(), true);
         }
 
         aspects.set(VALIDATION_ASPECT_RENDER_SUBPASS);
@@ -190,25 +252,8 @@ namespace backend {
         }
         ASSERT(currentRenderPass != nullptr);
 
-        auto& subpassInfo = currentRenderPass->GetSubpassInfo(currentSubpass);
-        for (auto location : IterateBitSet(subpassInfo.colorAttachmentsSet)) {
-            auto attachmentSlot = subpassInfo.colorAttachments[location];
-            auto* tv = currentFramebuffer->GetTextureView(attachmentSlot);
-            // TODO(kainino@chromium.org): the TextureView can only be null
-            // because of the null=backbuffer hack (null representing the
-            // backbuffer). Once that hack is removed (once we have WSI)
-            // this check isn't needed.
-            if (tv == nullptr) {
-                continue;
-            }
-
-            auto* texture = tv->GetTexture();
-            if (texture->IsFrozen()) {
-                continue;
-            }
-        }
         // Everything in texturesAttached should be for the current render subpass.
-        texturesAttached.clear();
+        tables->texturesAttached.Clear();
 
         currentSubpass += 1;
         aspects.reset(VALIDATION_ASPECT_RENDER_SUBPASS);
@@ -257,6 +302,51 @@ namespace backend {
         return true;
     }
 
+    bool CommandBufferStateTracker::ExecuteBundle(RenderBundleBase* bundle) {
+        if (!aspects[VALIDATION_ASPECT_RENDER_SUBPASS]) {
+            builder->HandleError("A render subpass must be active to execute a render bundle");
+            return false;
+        }
+        if (!bundle->IsCompatibleWith(currentRenderPass, currentSubpass)) {
+            builder->HandleError("Render bundle is incompatible with this subpass");
+            return false;
+        }
+        for (const auto& usage : bundle->GetRequiredBufferUsages()) {
+            if (!BufferHasGuaranteedUsageBit(usage.first, usage.second)) {
+                builder->HandleError("Can't guarantee buffer usage needed by render bundle");
+                return false;
+            }
+        }
+        for (const auto& usage : bundle->GetRequiredTextureUsages()) {
+            if (!TextureHasGuaranteedUsageBit(usage.first, usage.second)) {
+                builder->HandleError("Can't guarantee texture usage needed by render bundle");
+                return false;
+            }
+        }
+        for (BufferBase* buffer : bundle->GetBuffersWritten()) {
+            MarkBufferWritten(buffer);
+        }
+        // The index ranges of the bundle were checked when it was built, they only need to be
+        // checked again if the contents of the index buffers changed since.
+        for (IndexRangeCheck check : bundle->GetIndexRangeChecks()) {
+            if (IsBufferWritten(check.buffer)) {
+                continue;
+            }
+            if (!RevalidateIndexRange(&check)) {
+                builder->HandleError("Render bundle uses indices out of the range of its vertex buffers");
+                return false;
+            }
+            indexRangeChecks.push_back(check);
+        }
+
+        // The bundle changes the pipeline, bind groups and vertex and index buffers so they need
+        // to be set again after it.
+        UnsetPipeline();
+        inputsSet.reset();
+        vertexBuffers.fill(nullptr);
+        return true;
+    }
+
     bool CommandBufferStateTracker::SetPipeline(PipelineBase* pipeline) {
         PipelineLayoutBase* layout = pipeline->GetLayout();
 
@@ -281,26 +371,39 @@ namespace backend {
             }
             aspects.set(VALIDATION_ASPECT_RENDER_PIPELINE);
         }
-        aspects.reset(VALIDATION_ASPECT_BIND_GROUPS);
-        bindgroupsSet = ~layout->GetBindGroupsLayoutMask();
-
         // Only bindgroups that were not the same layout in the last pipeline need to be set again.
-        if (lastPipeline) {
-            PipelineLayoutBase* lastLayout = lastPipeline->GetLayout();
-            for (uint32_t i = 0; i < kMaxBindGroups; ++i) {
-                if (lastLayout->GetBindGroupLayout(i) == layout->GetBindGroupLayout(i)) {
-                    bindgroupsSet |= uint64_t(1) << i;
-                } else {
-                    break;
-                }
-            }
+        // When all of them are inherited the bind group state stays valid.
+        PipelineLayoutBase* lastLayout = lastPipeline ? lastPipeline->GetLayout() : nullptr;
+        std::bitset<kMaxBindGroups> inheritedGroups = layout->InheritedGroupsMask(lastLayout);
+        if (!inheritedGroups.all()) {
+            aspects.reset(VALIDATION_ASPECT_BIND_GROUPS);
+        }
+        for (uint32_t i : IterateBitSet(~inheritedGroups)) {
+            bindgroups[i] = nullptr;
         }
+        bindgroupsSet = ~layout->GetBindGroupsLayoutMask() | (inheritedGroups & bindgroupsSet);
 
         lastPipeline = pipeline;
+        fetchLimitsDirty = true;
         return true;
     }
 
-    bool CommandBufferStateTracker::SetBindGroup(uint32_t index, BindGroupBase* bindgroup) {
+    bool CommandBufferStateTracker::SetBindGroup(uint32_t index, BindGroupBase* bindgroup, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
+        if (dynamicOffsetCount != bindgroup->GetLayout()->GetDynamicBufferCount()) {
+            builder->HandleError("Dynamic offset count doesn't match the dynamic buffers of the bind group");
+            return false;
+        }
+        for (uint32_t i = 0; i < dynamicOffsetCount; ++i) {
+            if (dynamicOffsets[i] % kDynamicBufferOffsetAlignment != 0) {
+                builder->HandleError("Dynamic offset isn't aligned");
+                return false;
+            }
+            if (dynamicOffsets[i] > bindgroup->GetMaxDynamicOffset(i)) {
+                builder->HandleError("Dynamic offset puts the buffer view out of its buffer");
+                return false;
+            }
+        }
+
         if (!ValidateBindGroupUsages(bindgroup)) {
             return false;
         }
@@ -310,7 +413,7 @@ namespace backend {
         return true;
     }
 
-    bool CommandBufferStateTracker::SetIndexBuffer(BufferBase* buffer) {
+    bool CommandBufferStateTracker::SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format) {
         if (!HavePipeline()) {
             builder->HandleError("Can't set the index buffer without a pipeline");
             return false;
@@ -321,12 +424,22 @@ namespace backend {
             builder->HandleError("Buffer needs the index usage bit to be guaranteed");
             return false;
         }
+        if (offset > buffer->GetSize()) {
+            builder->HandleError("Index buffer offset out of the buffer");
+            return false;
+        }
+
+        indexBuffer = buffer;
+        indexBufferOffset = offset;
+        indexBufferCount = (buffer->GetSize() - offset) / IndexFormatSize(format);
+        indexFormat = format;
+        boundIndicesState = BoundIndicesState::Unknown;
 
         aspects.set(VALIDATION_ASPECT_INDEX_BUFFER);
         return true;
     }
 
-    bool CommandBufferStateTracker::SetVertexBuffer(uint32_t index, BufferBase* buffer) {
+    bool CommandBufferStateTracker::SetVertexBuffer(uint32_t index, BufferBase* buffer, uint32_t offset) {
         if (!HavePipeline()) {
             builder->HandleError("Can't set vertex buffers without a pipeline");
             return false;
@@ -339,14 +452,18 @@ namespace backend {
         }
 
         inputsSet.set(index);
+        vertexBuffers[index] = buffer;
+        vertexBufferOffsets[index] = offset;
+        fetchLimitsDirty = true;
         return true;
     }
 
     bool CommandBufferStateTracker::TransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage) {
-        if (!buffer->IsTransitionPossible(usage)) {
-            if (buffer->IsFrozen()) {
+        BufferUsageState usageState = GetUsageState(buffer);
+        if (!usageState.IsTransitionPossible(usage)) {
+            if (usageState.frozen) {
                 builder->HandleError("Buffer transition not possible (usage is frozen)");
-            } else if (!BufferBase::IsUsagePossible(buffer->GetAllowedUsage(), usage)) {
+            } else if (!BufferBase::IsUsagePossible(usageState.allowedUsage, usage)) {
                 builder->HandleError("Buffer transition not possible (usage not allowed)");
             } else {
                 builder->HandleError("Buffer transition not possible");
@@ -354,18 +471,18 @@ namespace backend {
             return false;
         }
 
-        mostRecentBufferUsages[buffer] = usage;
-        buffersTransitioned.insert(buffer);
+        SetMostRecentBufferUsage(buffer, usage);
         return true;
     }
 
     bool CommandBufferStateTracker::TransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage) {
         if (!IsExplicitTextureTransitionPossible(texture, usage)) {
-            if (texture->IsFrozen()) {
+            TextureUsageState usageState = GetUsageState(texture);
+            if (usageState.frozen) {
                 builder->HandleError("Texture transition not possible (usage is frozen)");
-            } else if (!TextureBase::IsUsagePossible(texture->GetAllowedUsage(), usage)) {
+            } else if (!TextureBase::IsUsagePossible(usageState.allowedUsage, usage)) {
                 builder->HandleError("Texture transition not possible (usage not allowed)");
-            } else if (texturesAttached.find(texture) != texturesAttached.end()) {
+            } else if (IsTextureAttached(texture)) {
                 builder->HandleError("Texture transition not possible (texture is in use as a framebuffer attachment)");
             } else {
                 builder->HandleError("Texture transition not possible");
@@ -373,47 +490,61 @@ namespace backend {
             return false;
         }
 
-        mostRecentTextureUsages[texture] = usage;
-        texturesTransitioned.insert(texture);
+        SetMostRecentTextureUsage(texture, usage);
         return true;
     }
 
     bool CommandBufferStateTracker::EnsureTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage) {
-        if (texture->HasFrozenUsage(nxt::TextureUsageBit::OutputAttachment)) {
+        if (GetUsageState(texture).HasFrozenUsage(nxt::TextureUsageBit::OutputAttachment)) {
             return true;
         }
         if (!IsInternalTextureTransitionPossible(texture, usage)) {
             return false;
         }
-        mostRecentTextureUsages[texture] = usage;
-        texturesTransitioned.insert(texture);
+        SetMostRecentTextureUsage(texture, usage);
         return true;
     }
 
-    bool CommandBufferStateTracker::BufferHasGuaranteedUsageBit(BufferBase* buffer, nxt::BufferUsageBit usage) const {
+    void CommandBufferStateTracker::BeginRenderBundle(RenderPassBase* renderPass, uint32_t subpass) {
+        ASSERT(currentRenderPass == nullptr);
+        currentRenderPass = renderPass;
+        currentSubpass = subpass;
+        aspects.set(VALIDATION_ASPECT_RENDER_SUBPASS);
+        recordingRenderBundle = true;
+    }
+
+    bool CommandBufferStateTracker::BufferHasGuaranteedUsageBit(BufferBase* buffer, nxt::BufferUsageBit usage) {
         ASSERT(usage != nxt::BufferUsageBit::None && nxt::HasZeroOrOneBits(usage));
-        if (buffer->HasFrozenUsage(usage)) {
+        if (GetUsageState(buffer).HasFrozenUsage(usage)) {
+            return true;
+        }
+        if (recordingRenderBundle) {
+            requiredBufferUsages.insert(std::make_pair(buffer, usage));
             return true;
         }
-        auto it = mostRecentBufferUsages.find(buffer);
-        return it != mostRecentBufferUsages.end() && (it->second & usage);
+        const nxt::BufferUsageBit* mostRecentUsage = tables->mostRecentBufferUsages.Get(buffer->GetDenseIndex());
+        return mostRecentUsage != nullptr && (*mostRecentUsage & usage);
     };
 
-    bool CommandBufferStateTracker::TextureHasGuaranteedUsageBit(TextureBase* texture, nxt::TextureUsageBit usage) const {
+    bool CommandBufferStateTracker::TextureHasGuaranteedUsageBit(TextureBase* texture, nxt::TextureUsageBit usage) {
         ASSERT(usage != nxt::TextureUsageBit::None && nxt::HasZeroOrOneBits(usage));
-        if (texture->HasFrozenUsage(usage)) {
+        if (GetUsageState(texture).HasFrozenUsage(usage)) {
             return true;
         }
-        auto it = mostRecentTextureUsages.find(texture);
-        return it != mostRecentTextureUsages.end() && (it->second & usage);
+        if (recordingRenderBundle) {
+            requiredTextureUsages.insert(std::make_pair(texture, usage));
+            return true;
+        }
+        const nxt::TextureUsageBit* mostRecentUsage = tables->mostRecentTextureUsages.Get(texture->GetDenseIndex());
+        return mostRecentUsage != nullptr && (*mostRecentUsage & usage);
     };
 
     bool CommandBufferStateTracker::IsInternalTextureTransitionPossible(TextureBase* texture, nxt::TextureUsageBit usage) const {
         ASSERT(usage != nxt::TextureUsageBit::None && nxt::HasZeroOrOneBits(usage));
-        if (texturesAttached.find(texture) != texturesAttached.end()) {
+        if (IsTextureAttached(texture)) {
             return false;
         }
-        return texture->IsTransitionPossible(usage);
+        return GetUsageState(texture).IsTransitionPossible(usage);
     };
 
     bool CommandBufferStateTracker::IsExplicitTextureTransitionPossible(TextureBase* texture, nxt::TextureUsageBit usage) const {
@@ -425,6 +556,40 @@ namespace backend {
         return IsInternalTextureTransitionPossible(texture, usage);
     }
 
+    BufferUsageState CommandBufferStateTracker::GetUsageState(BufferBase* buffer) const {
+        if (!usageStatesCaptured) {
+            return buffer->GetUsageState();
+        }
+        const BufferUsageState* state = capturedBufferStates.Get(buffer->GetDenseIndex());
+        ASSERT(state != nullptr);
+        return *state;
+    }
+
+    TextureUsageState CommandBufferStateTracker::GetUsageState(TextureBase* texture) const {
+        if (!usageStatesCaptured) {
+            return texture->GetUsageState();
+        }
+        const TextureUsageState* state = capturedTextureStates.Get(texture->GetDenseIndex());
+        ASSERT(state != nullptr);
+        return *state;
+    }
+
+    void CommandBufferStateTracker::SetMostRecentBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage) {
+        if (tables->mostRecentBufferUsages.Set(buffer->GetDenseIndex(), usage)) {
+            buffersTransitioned.push_back(buffer);
+        }
+    }
+
+    void CommandBufferStateTracker::SetMostRecentTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage) {
+        if (tables->mostRecentTextureUsages.Set(texture->GetDenseIndex(), usage)) {
+            texturesTransitioned.push_back(texture);
+        }
+    }
+
+    bool CommandBufferStateTracker::IsTextureAttached(TextureBase* texture) const {
+        return tables->texturesAttached.Contains(texture->GetDenseIndex());
+    }
+
     bool CommandBufferStateTracker::RecomputeHaveAspectBindGroups() {
         if (aspects[VALIDATION_ASPECT_BIND_GROUPS]) {
             return true;
@@ -465,53 +630,28 @@ namespace backend {
         return (aspects & pipelineAspects).any();
     }
 
-    bool CommandBufferStateTracker::ValidateBindGroupUsages(BindGroupBase* group) const {
-        const auto& layoutInfo = group->GetLayout()->GetBindingInfo();
-        for (size_t i = 0; i < kMaxBindingsPerGroup; ++i) {
-            if (!layoutInfo.mask[i]) {
-                continue;
+    bool CommandBufferStateTracker::ValidateBindGroupUsages(BindGroupBase* group) {
+        if (group->HasStorageBuffers()) {
+            for (const auto& usage : group->GetRequiredBufferUsages()) {
+                if (usage.second == nxt::BufferUsageBit::Storage) {
+                    MarkBufferWritten(usage.first);
+                }
             }
+        }
+        if (group->AreRequiredUsagesFrozen()) {
+            return true;
+        }
 
-            nxt::BindingType type = layoutInfo.types[i];
-            switch (type) {
-                case nxt::BindingType::UniformBuffer:
-                case nxt::BindingType::StorageBuffer:
-                    {
-                        nxt::BufferUsageBit requiredUsage;
-                        switch (type) {
-                            case nxt::BindingType::UniformBuffer:
-                                requiredUsage = nxt::BufferUsageBit::Uniform;
-                                break;
-
-                            case nxt::BindingType::StorageBuffer:
-                                requiredUsage = nxt::BufferUsageBit::Storage;
-                                break;
-
-                            default:
-                                ASSERT(false);
-                                return false;
-                        }
-
-                        auto buffer = group->GetBindingAsBufferView(i)->GetBuffer();
-                        if (!BufferHasGuaranteedUsageBit(buffer, requiredUsage)) {
-                            builder->HandleError("Can't guarantee buffer usage needed by bind group");
-                            return false;
-                        }
-                    }
-                    break;
-                case nxt::BindingType::SampledTexture:
-                    {
-                        auto requiredUsage = nxt::TextureUsageBit::Sampled;
-
-                        auto texture = group->GetBindingAsTextureView(i)->GetTexture();
-                        if (!TextureHasGuaranteedUsageBit(texture, requiredUsage)) {
-                            builder->HandleError("Can't guarantee texture usage needed by bind group");
-                            return false;
-                        }
-                    }
-                    break;
-                case nxt::BindingType::Sampler:
-                    continue;
+        for (const auto& usage : group->GetRequiredBufferUsages()) {
+            if (!BufferHasGuaranteedUsageBit(usage.first, usage.second)) {
+                builder->HandleError("Can't guarantee buffer usage needed by bind group");
+                return false;
+            }
+        }
+        for (const auto& usage : group->GetRequiredTextureUsages()) {
+            if (!TextureHasGuaranteedUsageBit(usage.first, usage.second)) {
+                builder->HandleError("Can't guarantee texture usage needed by bind group");
+                return false;
             }
         }
         return true;
@@ -534,6 +674,127 @@ namespace backend {
         return true;
     }
 
+    void CommandBufferStateTracker::MarkBufferWritten(BufferBase* buffer) {
+        if (tables->buffersWritten.Set(buffer->GetDenseIndex(), true)) {
+            buffersWritten.push_back(buffer);
+        }
+        // The contents of the index buffer are no longer known for the next draws.
+        if (buffer == indexBuffer) {
+            boundIndicesState = BoundIndicesState::Unknown;
+        }
+    }
+
+    bool CommandBufferStateTracker::IsBufferWritten(BufferBase* buffer) const {
+        return tables->buffersWritten.Contains(buffer->GetDenseIndex());
+    }
+
+    void CommandBufferStateTracker::RecomputeFetchLimits() {
+        // Assumes we have a pipeline already
+        InputStateBase* inputState = lastPipeline->GetInputState();
+        maxVertexCount = kUnlimitedFetchCount;
+        maxInstanceCount = kUnlimitedFetchCount;
+        for (uint32_t slot : IterateBitSet(inputState->GetInputsSetMask())) {
+            uint64_t fetchSize = inputState->GetInputFetchSize(slot);
+            BufferBase* buffer = vertexBuffers[slot];
+            if (fetchSize == 0 || buffer == nullptr) {
+                continue;
+            }
+
+            const auto& input = inputState->GetInput(slot);
+            uint64_t& maxCount = input.stepMode == nxt::InputStepMode::Vertex ? maxVertexCount : maxInstanceCount;
+
+            uint64_t available = 0;
+            if (vertexBufferOffsets[slot] < buffer->GetSize()) {
+                available = buffer->GetSize() - vertexBufferOffsets[slot];
+            }
+            if (available < fetchSize) {
+                maxCount = 0;
+            } else if (input.stride != 0) {
+                maxCount = std::min(maxCount, (available - fetchSize) / input.stride + 1);
+            }
+        }
+
+        fetchLimitsDirty = false;
+    }
+
+    bool CommandBufferStateTracker::ValidateFetchRanges(uint64_t vertexEnd, uint64_t instanceEnd) {
+        if (fetchLimitsDirty) {
+            RecomputeFetchLimits();
+        }
+        if (vertexEnd > maxVertexCount) {
+            builder->HandleError("Vertex range out of the vertex buffers");
+            return false;
+        }
+        if (instanceEnd > maxInstanceCount) {
+            builder->HandleError("Instance range out of the vertex buffers");
+            return false;
+        }
+        return true;
+    }
+
+    bool CommandBufferStateTracker::ValidateIndexRange(uint32_t indexCount, uint32_t firstIndex) {
+        if (uint64_t(firstIndex) + indexCount > indexBufferCount) {
+            builder->HandleError("Index range out of the index buffer");
+            return false;
+        }
+
+        if (maxVertexCount == kUnlimitedFetchCount) {
+            return true;
+        }
+        // Vertex buffers are smaller than 4GB so this fits in 32 bits.
+        uint32_t vertexCount = static_cast<uint32_t>(maxVertexCount);
+
+        // The contents of a buffer written earlier in the command buffer can't be known.
+        if (IsBufferWritten(indexBuffer)) {
+            return true;
+        }
+
+        uint32_t generation = indexBuffer->GetContentsGeneration();
+        if (boundIndicesGeneration != generation || boundIndicesMaxVertexCount != vertexCount) {
+            boundIndicesState = BoundIndicesState::Unknown;
+        }
+
+        IndexRangeCheck check;
+        check.buffer = indexBuffer;
+        check.format = indexFormat;
+        check.maxVertexCount = vertexCount;
+        check.contentsGeneration = generation;
+
+        // Fast path: check all the indices of the bound range once for this generation of the
+        // contents, then draws using a subrange don't need to look at the indices.
+        if (boundIndicesState == BoundIndicesState::Unknown) {
+            boundIndicesState = BoundIndicesState::NotInBounds;
+            boundIndicesGeneration = generation;
+            boundIndicesMaxVertexCount = vertexCount;
+
+            uint32_t maxIndex;
+            if (indexBuffer->GetMaxIndex(indexBufferOffset, indexBufferCount, indexFormat, &maxIndex) &&
+                maxIndex < vertexCount) {
+                boundIndicesState = BoundIndicesState::InBounds;
+                check.byteOffset = indexBufferOffset;
+                check.indexCount = indexBufferCount;
+                indexRangeChecks.push_back(check);
+            }
+        }
+        if (boundIndicesState == BoundIndicesState::InBounds) {
+            return true;
+        }
+
+        // Otherwise only the indices used by the draw are checked.
+        check.byteOffset = indexBufferOffset + firstIndex * IndexFormatSize(indexFormat);
+        check.indexCount = indexCount;
+        uint32_t maxIndex;
+        if (!indexBuffer->GetMaxIndex(check.byteOffset, check.indexCount, check.format, &maxIndex)) {
+            return true;
+        }
+        if (maxIndex >= vertexCount) {
+            builder->HandleError("Index out of the range of the vertex buffers");
+            return false;
+        }
+        indexRangeChecks.push_back(check);
+        return true;
+    }
+
     void CommandBufferStateTracker::UnsetPipeline() {
         constexpr ValidationAspects pipelineDependentAspectsInverse =
             ~(1 << VALIDATION_ASPECT_RENDER_PIPELINE |
@@ -543,5 +804,7 @@ namespace backend {
               1 << VALIDATION_ASPECT_INDEX_BUFFER);
         aspects &= pipelineDependentAspectsInverse;
         bindgroups.fill(nullptr);
+        bindgroupsSet.reset();
+        lastPipeline = nullptr;
     }
 }
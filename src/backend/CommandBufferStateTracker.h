@@ -15,27 +15,47 @@
 #ifndef BACKEND_COMMANDBUFFERSTATETRACKER_H
 #define BACKEND_COMMANDBUFFERSTATETRACKER_H
 
+#include "backend/Buffer.h"
 #include "backend/CommandBuffer.h"
+#include "backend/DenseIndex.h"
+#include "backend/RenderBundle.h"
+#include "backend/Texture.h"
 #include "common/Constants.h"
 
 #include <array>
 #include <bitset>
-#include <map>
 #include <set>
+#include <vector>
 
 namespace backend {
+
+    // The tables of the state tracker, indexed by the dense index of buffers and textures. They
+    // are recycled by the device between command buffers.
+    struct UsageTrackingTables {
+        // Only contain the resources that were transitioned in the command buffer.
+        DenseSlotTable<nxt::BufferUsageBit> mostRecentBufferUsages;
+        DenseSlotTable<nxt::TextureUsageBit> mostRecentTextureUsages;
+        // The textures attached in the current subpass.
+        DenseSlotTable<bool> texturesAttached;
+        // The buffers the GPU writes in the command buffer.
+        DenseSlotTable<bool> buffersWritten;
+
+        void Clear();
+    };
+
     class CommandBufferStateTracker {
         public:
-            explicit CommandBufferStateTracker(CommandBufferBuilder* builder);
+            explicit CommandBufferStateTracker(BuilderBase* builder);
+            ~CommandBufferStateTracker();
 
             // Non-state-modifying validation functions
             bool HaveRenderPass() const;
             bool ValidateCanCopy() const;
-            bool ValidateCanUseBufferAs(BufferBase* buffer, nxt::BufferUsageBit usage) const;
-            bool ValidateCanUseTextureAs(TextureBase* texture, nxt::TextureUsageBit usage) const;
+            bool ValidateCanUseBufferAs(BufferBase* buffer, nxt::BufferUsageBit usage);
+            bool ValidateCanUseTextureAs(TextureBase* texture, nxt::TextureUsageBit usage);
             bool ValidateCanDispatch();
-            bool ValidateCanDrawArrays();
-            bool ValidateCanDrawElements();
+            bool ValidateCanDrawArrays(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+            bool ValidateCanDrawElements(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance);
             bool ValidateEndCommandBuffer() const;
 
             // State-modifying methods
@@ -45,20 +65,44 @@ namespace backend {
             bool EndSubpass();
             bool BeginRenderPass(RenderPassBase* renderPass, FramebufferBase* framebuffer);
             bool EndRenderPass();
+            bool ExecuteBundle(RenderBundleBase* bundle);
             bool SetPipeline(PipelineBase* pipeline);
-            bool SetBindGroup(uint32_t index, BindGroupBase* bindgroup);
-            bool SetIndexBuffer(BufferBase* buffer);
-            bool SetVertexBuffer(uint32_t index, BufferBase* buffer);
+            bool SetBindGroup(uint32_t index, BindGroupBase* bindgroup, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets);
+            bool SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format);
+            bool SetVertexBuffer(uint32_t index, BufferBase* buffer, uint32_t offset);
             bool TransitionBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage);
             bool TransitionTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
             bool EnsureTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
 
-            // These collections are copied to the CommandBuffer at build time.
-            // These pointers will remain valid since they are referenced by
-            // the bind groups which are referenced by this command buffer.
-            std::set<BufferBase*> buffersTransitioned;
-            std::set<TextureBase*> texturesTransitioned;
-            std::set<TextureBase*> texturesAttached;
+            // Command buffers validated on another thread capture the usage state of all the
+            // resources their commands use on the recording thread. The validation then sees the
+            // resources as they were at that time instead of reading state that the application
+            // can change concurrently.
+            void CaptureUsageState(BufferBase* buffer);
+            void CaptureUsageState(TextureBase* texture);
+            void CaptureUsageStates(BindGroupBase* group);
+            void CaptureUsageStates(FramebufferBase* framebuffer);
+            void CaptureUsageStates(RenderBundleBase* bundle);
+
+            // Validates the commands of a render bundle as if they were in the given subpass.
+            // Usages that are not frozen are not known yet: they are added to the required
+            // usages instead, to be checked when the bundle is executed.
+            void BeginRenderBundle(RenderPassBase* renderPass, uint32_t subpass);
+
+            // These collections are moved to the CommandBuffer at build time. They don't contain
+            // duplicates. These pointers will remain valid since they are referenced by the
+            // residency set of the command buffer.
+            std::vector<BufferBase*> buffersTransitioned;
+            std::vector<TextureBase*> texturesTransitioned;
+            std::vector<BufferBase*> buffersWritten;
+
+            // The index ranges of DrawElements with known contents, checked again at submit time
+            // in case the contents of the index buffers changed.
+            std::vector<IndexRangeCheck> indexRangeChecks;
+
+            // These collections are copied to the RenderBundle at build time.
+            std::set<RenderBundleBase::BufferUsage> requiredBufferUsages;
+            std::set<RenderBundleBase::TextureUsage> requiredTextureUsages;
 
         private:
             enum ValidationAspect {
@@ -75,8 +119,8 @@ namespace backend {
             using ValidationAspects = std::bitset<VALIDATION_ASPECT_COUNT>;
 
             // Usage helper functions
-            bool BufferHasGuaranteedUsageBit(BufferBase* buffer, nxt::BufferUsageBit usage) const;
-            bool TextureHasGuaranteedUsageBit(TextureBase* texture, nxt::TextureUsageBit usage) const;
+            bool BufferHasGuaranteedUsageBit(BufferBase* buffer, nxt::BufferUsageBit usage);
+            bool TextureHasGuaranteedUsageBit(TextureBase* texture, nxt::TextureUsageBit usage);
             bool IsInternalTextureTransitionPossible(TextureBase* texture, nxt::TextureUsageBit usage) const;
             bool IsExplicitTextureTransitionPossible(TextureBase* texture, nxt::TextureUsageBit usage) const;
 
@@ -85,26 +129,71 @@ namespace backend {
             bool RecomputeHaveAspectVertexBuffers();
 
             bool HavePipeline() const;
-            bool ValidateBindGroupUsages(BindGroupBase* group) const;
+            bool ValidateBindGroupUsages(BindGroupBase* group);
             bool RevalidateCanDraw();
 
+            // Index range validation helpers
+            void MarkBufferWritten(BufferBase* buffer);
+            bool IsBufferWritten(BufferBase* buffer) const;
+            void RecomputeFetchLimits();
+            bool ValidateFetchRanges(uint64_t vertexEnd, uint64_t instanceEnd);
+            bool ValidateIndexRange(uint32_t indexCount, uint32_t firstIndex);
+
             void UnsetPipeline();
 
-            CommandBufferBuilder* builder;
+            BuilderBase* builder;
 
             ValidationAspects aspects;
 
             std::bitset<kMaxBindGroups> bindgroupsSet;
             std::array<BindGroupBase*, kMaxBindGroups> bindgroups = {};
             std::bitset<kMaxVertexInputs> inputsSet;
+            std::array<BufferBase*, kMaxVertexInputs> vertexBuffers = {};
+            std::array<uint32_t, kMaxVertexInputs> vertexBufferOffsets = {};
             PipelineBase* lastPipeline = nullptr;
 
-            std::map<BufferBase*, nxt::BufferUsageBit> mostRecentBufferUsages;
-            std::map<TextureBase*, nxt::TextureUsageBit> mostRecentTextureUsages;
+            // The number of vertices and instances that can be fetched from the vertex buffers
+            // by the current pipeline, computed on the first draw after the pipeline or vertex
+            // buffers change.
+            static constexpr uint64_t kUnlimitedFetchCount = UINT64_MAX;
+            uint64_t maxVertexCount = kUnlimitedFetchCount;
+            uint64_t maxInstanceCount = kUnlimitedFetchCount;
+            bool fetchLimitsDirty = true;
+
+            BufferBase* indexBuffer = nullptr;
+            uint32_t indexBufferOffset = 0;
+            uint32_t indexBufferCount = 0;
+            nxt::IndexFormat indexFormat = nxt::IndexFormat::Uint32;
+
+            // Most draws use the whole index buffer, so the result of checking all the indices
+            // of the bound range is remembered for a contents generation and vertex count.
+            enum class BoundIndicesState {
+                Unknown,
+                InBounds,
+                NotInBounds,
+            };
+            BoundIndicesState boundIndicesState = BoundIndicesState::Unknown;
+            uint32_t boundIndicesGeneration = 0;
+            uint32_t boundIndicesMaxVertexCount = 0;
+
+            // Returns the captured usage state of the resource if there is one, and its current
+            // state otherwise.
+            BufferUsageState GetUsageState(BufferBase* buffer) const;
+            TextureUsageState GetUsageState(TextureBase* texture) const;
+            bool usageStatesCaptured = false;
+            DenseSlotTable<BufferUsageState> capturedBufferStates;
+            DenseSlotTable<TextureUsageState> capturedTextureStates;
+
+            void SetMostRecentBufferUsage(BufferBase* buffer, nxt::BufferUsageBit usage);
+            void SetMostRecentTextureUsage(TextureBase* texture, nxt::TextureUsageBit usage);
+            bool IsTextureAttached(TextureBase* texture) const;
+
+            UsageTrackingTables* tables;
 
             RenderPassBase* currentRenderPass = nullptr;
             FramebufferBase* currentFramebuffer = nullptr;
             uint32_t currentSubpass = 0;
+            bool recordingRenderBundle = false;
     };
 }
 
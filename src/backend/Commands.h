@@ -16,16 +16,27 @@
 #define BACKEND_COMMANDS_H_
 
 #include "backend/Framebuffer.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/Texture.h"
 
 #include "nxt/nxtcpp.h"
 
+#include <type_traits>
+
 namespace backend {
 
     // Definition of the commands that are present in the CommandIterator given by the
     // CommandBufferBuilder. There are not defined in CommandBuffer.h to break some header
-    // dependencies: Ref<Object> needs Object to be defined.
+    // dependencies.
+    //
+    // Commands only store raw pointers to the objects they use, the objects are kept alive by the
+    // ResidencySet of the command buffer or render bundle that contains them. All the commands
+    // are trivially destructible so the command stream can be freed without iterating over it.
+    //
+    // Commands made only of 32bit values (draws, dispatches...) are recorded with
+    // CommandAllocator::AllocatePacked so their values take 8 or 16 bits in the command stream
+    // when they fit.
 
     enum class Command {
         BeginComputePass,
@@ -40,6 +51,7 @@ namespace backend {
         EndComputePass,
         EndRenderPass,
         EndRenderSubpass,
+        ExecuteBundle,
         SetPipeline,
         SetPushConstants,
         SetStencilReference,
@@ -54,20 +66,20 @@ namespace backend {
     };
 
     struct BeginRenderPassCmd {
-        Ref<RenderPassBase> renderPass;
-        Ref<FramebufferBase> framebuffer;
+        RenderPassBase* renderPass;
+        FramebufferBase* framebuffer;
     };
 
     struct BeginRenderSubpassCmd {
     };
 
     struct BufferCopyLocation {
-        Ref<BufferBase> buffer;
+        BufferBase* buffer;
         uint32_t offset;
     };
 
     struct TextureCopyLocation {
-        Ref<TextureBase> texture;
+        TextureBase* texture;
         uint32_t x, y, z;
         uint32_t width, height, depth;
         uint32_t level;
@@ -118,8 +130,12 @@ namespace backend {
     struct EndRenderSubpassCmd {
     };
 
+    struct ExecuteBundleCmd {
+        RenderBundleBase* bundle;
+    };
+
     struct SetPipelineCmd {
-        Ref<PipelineBase> pipeline;
+        PipelineBase* pipeline;
     };
 
     struct SetPushConstantsCmd {
@@ -134,11 +150,12 @@ namespace backend {
 
     struct SetBindGroupCmd {
         uint32_t index;
-        Ref<BindGroupBase> group;
+        BindGroupBase* group;
+        uint32_t dynamicOffsetCount;
     };
 
     struct SetIndexBufferCmd {
-        Ref<BufferBase> buffer;
+        BufferBase* buffer;
         uint32_t offset;
         nxt::IndexFormat format;
     };
@@ -149,22 +166,60 @@ namespace backend {
     };
 
     struct TransitionBufferUsageCmd {
-        Ref<BufferBase> buffer;
+        BufferBase* buffer;
         nxt::BufferUsageBit usage;
     };
 
     struct TransitionTextureUsageCmd {
-        Ref<TextureBase> texture;
+        TextureBase* texture;
         uint32_t startLevel;
         uint32_t levelCount;
         nxt::TextureUsageBit usage;
     };
 
-    // This needs to be called before the CommandIterator is freed so that the Ref<> present in
-    // the commands have a chance to run their destructor and remove internal references.
+    static_assert(std::is_trivially_destructible<BeginRenderPassCmd>::value &&
+                  std::is_trivially_destructible<CopyBufferToBufferCmd>::value &&
+                  std::is_trivially_destructible<CopyBufferToTextureCmd>::value &&
+                  std::is_trivially_destructible<CopyTextureToBufferCmd>::value &&
+                  std::is_trivially_destructible<ExecuteBundleCmd>::value &&
+                  std::is_trivially_destructible<SetPipelineCmd>::value &&
+                  std::is_trivially_destructible<SetBindGroupCmd>::value &&
+                  std::is_trivially_destructible<SetIndexBufferCmd>::value &&
+                  std::is_trivially_destructible<SetVertexBuffersCmd>::value &&
+                  std::is_trivially_destructible<TransitionBufferUsageCmd>::value &&
+                  std::is_trivially_destructible<TransitionTextureUsageCmd>::value,
+                  "FreeCommands doesn't run the destructors of the commands");
+
+    // This needs to be called before the CommandIterator is freed. It doesn't need to look at the
+    // commands since they are all trivially destructible.
     void FreeCommands(CommandIterator* commands);
     void SkipCommand(CommandIterator* commands, Command type);
 
+    // Iterates over the commands of a command buffer for the backends, with the commands of render
+    // bundles replayed in place of the ExecuteBundle commands. Bundles cannot contain ExecuteBundle
+    // commands so the replay never needs to go more than one level deep.
+    class BundleReplayIterator {
+        public:
+            BundleReplayIterator(CommandIterator* commands);
+
+            bool NextCommandId(Command* commandId);
+            void SkipCommand(Command type);
+
+            template<typename T>
+            T* NextCommand() {
+                return current->NextCommand<T>();
+            }
+
+            template<typename T>
+            T* NextData(size_t count) {
+                return current->NextData<T>(count);
+            }
+
+        private:
+            CommandIterator* commands;
+            CommandIterator* current;
+    };
+
 }
 
 #endif // BACKEND_COMMANDS_H_
@@ -0,0 +1,35 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/DenseIndex.h"
+
+namespace backend {
+
+    uint32_t DenseIndexAllocator::Allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeIndices.empty()) {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return index;
+        }
+        return nextIndex++;
+    }
+
+    void DenseIndexAllocator::Free(uint32_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT(index < nextIndex);
+        freeIndices.push_back(index);
+    }
+
+}
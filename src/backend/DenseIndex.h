@@ -0,0 +1,99 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_DENSEINDEX_H_
+#define BACKEND_DENSEINDEX_H_
+
+#include "common/Assert.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace backend {
+
+    // Gives objects a small index that is unique among the live objects using the same
+    // allocator. Indices of destroyed objects are reused, so the indices stay close to the number
+    // of live objects and can be used to index flat tables. Objects can be created and destroyed
+    // from multiple threads so the allocator is protected by a mutex.
+    class DenseIndexAllocator {
+        public:
+            uint32_t Allocate();
+            void Free(uint32_t index);
+
+        private:
+            std::mutex mutex;
+            std::vector<uint32_t> freeIndices;
+            uint32_t nextIndex = 0;
+    };
+
+    // A table from dense indices to values of type T. Instead of being erased the values are
+    // tagged with the generation of the table they were set in, so Clear is O(1) and the memory
+    // of the table can be reused without touching all its slots.
+    template<typename T>
+    class DenseSlotTable {
+        public:
+            // Returns nullptr if no value was set for the index since the last Clear.
+            T* Get(uint32_t index) {
+                if (index >= slots.size() || slots[index].generation != generation) {
+                    return nullptr;
+                }
+                return &slots[index].value;
+            }
+
+            const T* Get(uint32_t index) const {
+                return const_cast<DenseSlotTable*>(this)->Get(index);
+            }
+
+            bool Contains(uint32_t index) const {
+                return Get(index) != nullptr;
+            }
+
+            // Returns true if there was no value for the index.
+            bool Set(uint32_t index, T value) {
+                if (index >= slots.size()) {
+                    slots.resize(index + 1);
+                }
+
+                Slot& slot = slots[index];
+                bool inserted = slot.generation != generation;
+                slot.generation = generation;
+                slot.value = value;
+                return inserted;
+            }
+
+            void Clear() {
+                generation++;
+                // On wrap-around the old slots could appear to be in the new generation.
+                if (generation == 0) {
+                    for (Slot& slot : slots) {
+                        slot.generation = 0;
+                    }
+                    generation = 1;
+                }
+            }
+
+        private:
+            struct Slot {
+                uint32_t generation = 0;
+                T value = {};
+            };
+
+            std::vector<Slot> slots;
+            uint32_t generation = 1;
+    };
+
+}
+
+#endif // BACKEND_DENSEINDEX_H_
@@ -15,13 +15,21 @@
 #include "backend/DepthStencilState.h"
 
 #include "backend/Device.h"
+#include "common/HashUtils.h"
 
 namespace backend {
 
     // DepthStencilStateBase
 
-    DepthStencilStateBase::DepthStencilStateBase(DepthStencilStateBuilder* builder)
-        : depthInfo(builder->depthInfo), stencilInfo(builder->stencilInfo) {
+    DepthStencilStateBase::DepthStencilStateBase(DepthStencilStateBuilder* builder, bool blueprint)
+        : device(builder->device), depthInfo(builder->depthInfo), stencilInfo(builder->stencilInfo), blueprint(blueprint) {
+    }
+
+    DepthStencilStateBase::~DepthStencilStateBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheDepthStencilState(this);
+        }
     }
 
     bool DepthStencilStateBase::DepthTestEnabled() const {
@@ -61,7 +69,8 @@ namespace backend {
     }
 
     DepthStencilStateBase* DepthStencilStateBuilder::GetResultImpl() {
-        return device->CreateDepthStencilState(this);
+        DepthStencilStateBase blueprint(this, true);
+        return device->GetOrCreateDepthStencilState(&blueprint, this);
     }
 
     void DepthStencilStateBuilder::SetDepthCompareFunction(nxt::CompareFunction depthCompareFunction) {
@@ -132,4 +141,44 @@ namespace backend {
         stencilInfo.writeMask = writeMask;
     }
 
+    // DepthStencilStateCacheFuncs
+
+    namespace {
+        void HashStencilFace(size_t* hash, const DepthStencilStateBase::StencilFaceInfo& face) {
+            CombineHashes(hash, Hash(face.compareFunction));
+            CombineHashes(hash, Hash(face.stencilFail));
+            CombineHashes(hash, Hash(face.depthFail));
+            CombineHashes(hash, Hash(face.depthStencilPass));
+        }
+
+        bool operator== (const DepthStencilStateBase::StencilFaceInfo& a, const DepthStencilStateBase::StencilFaceInfo& b) {
+            return a.compareFunction == b.compareFunction && a.stencilFail == b.stencilFail &&
+                a.depthFail == b.depthFail && a.depthStencilPass == b.depthStencilPass;
+        }
+    }
+
+    size_t DepthStencilStateCacheFuncs::operator() (const DepthStencilStateBase* state) const {
+        const auto& depth = state->GetDepth();
+        const auto& stencil = state->GetStencil();
+
+        size_t hash = Hash(depth.compareFunction);
+        CombineHashes(&hash, Hash(depth.depthWriteEnabled));
+        HashStencilFace(&hash, stencil.back);
+        HashStencilFace(&hash, stencil.front);
+        CombineHashes(&hash, Hash(stencil.readMask));
+        CombineHashes(&hash, Hash(stencil.writeMask));
+        return hash;
+    }
+
+    bool DepthStencilStateCacheFuncs::operator() (const DepthStencilStateBase* a, const DepthStencilStateBase* b) const {
+        const auto& depthA = a->GetDepth();
+        const auto& depthB = b->GetDepth();
+        const auto& stencilA = a->GetStencil();
+        const auto& stencilB = b->GetStencil();
+
+        return depthA.compareFunction == depthB.compareFunction &&
+            depthA.depthWriteEnabled == depthB.depthWriteEnabled &&
+            stencilA.back == stencilB.back && stencilA.front == stencilB.front &&
+            stencilA.readMask == stencilB.readMask && stencilA.writeMask == stencilB.writeMask;
+    }
 }
@@ -23,10 +23,10 @@
 
 namespace backend {
 
-
     class DepthStencilStateBase : public RefCounted {
         public:
-            DepthStencilStateBase(DepthStencilStateBuilder* builder);
+            DepthStencilStateBase(DepthStencilStateBuilder* builder, bool blueprint = false);
+            ~DepthStencilStateBase() override;
 
             struct DepthInfo {
                 nxt::CompareFunction compareFunction = nxt::CompareFunction::Always;
@@ -53,8 +53,10 @@ namespace backend {
             const StencilInfo& GetStencil() const;
 
         private:
+            DeviceBase* device;
             DepthInfo depthInfo;
             StencilInfo stencilInfo;
+            bool blueprint = false;
     };
 
     class DepthStencilStateBuilder : public Builder<DepthStencilStateBase> {
@@ -79,6 +81,15 @@ namespace backend {
             DepthStencilStateBase::StencilInfo stencilInfo;
     };
 
+    // Implements the functors necessary for the unordered_set<DepthStencilState*>-based cache.
+    struct DepthStencilStateCacheFuncs {
+        // The hash function
+        size_t operator() (const DepthStencilStateBase* state) const;
+
+        // The equality predicate
+        bool operator() (const DepthStencilStateBase* a, const DepthStencilStateBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_DEPTHSTENCILSTATE_H_
@@ -18,29 +18,89 @@
 #include "backend/BindGroupLayout.h"
 #include "backend/Buffer.h"
 #include "backend/CommandBuffer.h"
+#include "backend/CommandBufferStateTracker.h"
 #include "backend/DepthStencilState.h"
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/Pipeline.h"
 #include "backend/PipelineLayout.h"
 #include "backend/Queue.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/Sampler.h"
 #include "backend/ShaderModule.h"
 #include "backend/Texture.h"
+#include "backend/WorkerThread.h"
+#include "common/Tracing.h"
 
+#include <limits>
+#include <mutex>
 #include <unordered_set>
 
 namespace backend {
 
     // DeviceBase::Caches
 
-    // The caches are unordered_sets of pointers with special hash and compare functions
-    // to compare the value of the objects, instead of the pointers.
-    using BindGroupLayoutCache = std::unordered_set<BindGroupLayoutBase*, BindGroupLayoutCacheFuncs, BindGroupLayoutCacheFuncs>;
+    namespace {
+
+        // The caches are unordered_sets of pointers with special hash and compare functions
+        // to compare the value of the objects, instead of the pointers.
+        // Objects can be created from multiple threads so each cache is protected by a mutex.
+        // Each cache has its own mutex so that creating an object can create objects of
+        // other types.
+        template<typename T, typename CacheFuncs>
+        struct ObjectCache {
+            std::mutex mutex;
+            std::unordered_set<T*, CacheFuncs, CacheFuncs> objects;
+        };
+
+        template<typename T, typename CacheFuncs, typename Create>
+        T* GetOrCreate(ObjectCache<T, CacheFuncs>* cache, const T* blueprint, Create create) {
+            // The blueprint is only used to search in the cache and is not modified. However cached
+            // objects can be modified, and unordered_set cannot search for a const pointer in a non
+            // const pointer set. That's why we do a const_cast here, but the blueprint won't be
+            // modified.
+            // The returned object is referenced while the cache is locked so that another thread
+            // can't release it in between.
+            std::lock_guard<std::mutex> lock(cache->mutex);
+
+            auto iter = cache->objects.find(const_cast<T*>(blueprint));
+            if (iter != cache->objects.end()) {
+                if ((*iter)->TryReference()) {
+                    return *iter;
+                }
+                // The object is being deleted by another thread, replace it. Its Uncache will
+                // see it was replaced and leave the new object in the cache.
+                cache->objects.erase(iter);
+            }
+
+            T* backendObj = create();
+            cache->objects.insert(backendObj);
+            return backendObj;
+        }
+
+        template<typename T, typename CacheFuncs>
+        void Uncache(ObjectCache<T, CacheFuncs>* cache, T* obj) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+
+            // Only remove the object itself and not an equivalent object that replaced it.
+            auto iter = cache->objects.find(obj);
+            if (iter != cache->objects.end() && *iter == obj) {
+                cache->objects.erase(iter);
+            }
+        }
+
+    }
 
     struct DeviceBase::Caches {
-        BindGroupLayoutCache bindGroupLayouts;
+        ObjectCache<BindGroupBase, BindGroupCacheFuncs> bindGroups;
+        ObjectCache<BindGroupLayoutBase, BindGroupLayoutCacheFuncs> bindGroupLayouts;
+        ObjectCache<DepthStencilStateBase, DepthStencilStateCacheFuncs> depthStencilStates;
+        ObjectCache<InputStateBase, InputStateCacheFuncs> inputStates;
+        ObjectCache<PipelineLayoutBase, PipelineLayoutCacheFuncs> pipelineLayouts;
+        ObjectCache<RenderPassBase, RenderPassCacheFuncs> renderPasses;
+        ObjectCache<SamplerBase, SamplerCacheFuncs> samplers;
+        ObjectCache<ShaderModuleBase, ShaderModuleCacheFuncs> shaderModules;
     };
 
     // DeviceBase
@@ -50,16 +110,30 @@ namespace backend {
     }
 
     DeviceBase::~DeviceBase() {
+        // Finish the pending validations before destroying what they use.
+        validationThread = nullptr;
+
+        // The objects still kept alive may need to be removed from the caches.
+        ReleaseAllKeptAliveObjects();
+
         delete caches;
+
+        for (UsageTrackingTables* tables : freeUsageTrackingTables) {
+            delete tables;
+        }
     }
 
     void DeviceBase::HandleError(const char* message) {
+        // Errors can be produced by several threads at once, the callback is called for one
+        // error at a time so that the application doesn't have to synchronize it.
+        std::lock_guard<std::recursive_mutex> lock(errorMutex);
         if (errorCallback) {
             errorCallback(message, errorUserdata);
         }
     }
 
     void DeviceBase::SetErrorCallback(nxt::DeviceErrorCallback callback, nxt::CallbackUserdata userdata) {
+        std::lock_guard<std::recursive_mutex> lock(errorMutex);
         this->errorCallback = callback;
         this->errorUserdata = userdata;
     }
@@ -68,23 +142,163 @@ namespace backend {
         return this;
     }
 
+    BindGroupBase* DeviceBase::GetOrCreateBindGroup(const BindGroupBase* blueprint, BindGroupBuilder* builder) {
+        return GetOrCreate(&caches->bindGroups, blueprint, [&]() {
+            return CreateBindGroup(builder);
+        });
+    }
+
+    void DeviceBase::UncacheBindGroup(BindGroupBase* obj) {
+        Uncache(&caches->bindGroups, obj);
+    }
+
     BindGroupLayoutBase* DeviceBase::GetOrCreateBindGroupLayout(const BindGroupLayoutBase* blueprint, BindGroupLayoutBuilder* builder) {
-        // The blueprint is only used to search in the cache and is not modified. However cached
-        // objects can be modified, and unordered_set cannot search for a const pointer in a non
-        // const pointer set. That's why we do a const_cast here, but the blueprint won't be
-        // modified.
-        auto iter = caches->bindGroupLayouts.find(const_cast<BindGroupLayoutBase*>(blueprint));
-        if (iter != caches->bindGroupLayouts.end()) {
-            return *iter;
+        return GetOrCreate(&caches->bindGroupLayouts, blueprint, [&]() {
+            return CreateBindGroupLayout(builder);
+        });
+    }
+
+    void DeviceBase::UncacheBindGroupLayout(BindGroupLayoutBase* obj) {
+        Uncache(&caches->bindGroupLayouts, obj);
+    }
+
+    DepthStencilStateBase* DeviceBase::GetOrCreateDepthStencilState(const DepthStencilStateBase* blueprint, DepthStencilStateBuilder* builder) {
+        return GetOrCreate(&caches->depthStencilStates, blueprint, [&]() {
+            return CreateDepthStencilState(builder);
+        });
+    }
+
+    void DeviceBase::UncacheDepthStencilState(DepthStencilStateBase* obj) {
+        Uncache(&caches->depthStencilStates, obj);
+    }
+
+    InputStateBase* DeviceBase::GetOrCreateInputState(const InputStateBase* blueprint, InputStateBuilder* builder) {
+        return GetOrCreate(&caches->inputStates, blueprint, [&]() {
+            return CreateInputState(builder);
+        });
+    }
+
+    void DeviceBase::UncacheInputState(InputStateBase* obj) {
+        Uncache(&caches->inputStates, obj);
+    }
+
+    PipelineLayoutBase* DeviceBase::GetOrCreatePipelineLayout(const PipelineLayoutBase* blueprint, PipelineLayoutBuilder* builder) {
+        return GetOrCreate(&caches->pipelineLayouts, blueprint, [&]() {
+            return CreatePipelineLayout(builder);
+        });
+    }
+
+    void DeviceBase::UncachePipelineLayout(PipelineLayoutBase* obj) {
+        Uncache(&caches->pipelineLayouts, obj);
+    }
+
+    RenderPassBase* DeviceBase::GetOrCreateRenderPass(const RenderPassBase* blueprint, RenderPassBuilder* builder) {
+        return GetOrCreate(&caches->renderPasses, blueprint, [&]() {
+            return CreateRenderPass(builder);
+        });
+    }
+
+    void DeviceBase::UncacheRenderPass(RenderPassBase* obj) {
+        Uncache(&caches->renderPasses, obj);
+    }
+
+    SamplerBase* DeviceBase::GetOrCreateSampler(const SamplerBase* blueprint, SamplerBuilder* builder) {
+        return GetOrCreate(&caches->samplers, blueprint, [&]() {
+            return CreateSampler(builder);
+        });
+    }
+
+    void DeviceBase::UncacheSampler(SamplerBase* obj) {
+        Uncache(&caches->samplers, obj);
+    }
+
+    ShaderModuleBase* DeviceBase::GetOrCreateShaderModule(const ShaderModuleBase* blueprint, ShaderModuleBuilder* builder) {
+        return GetOrCreate(&caches->shaderModules, blueprint, [&]() {
+            return CreateShaderModule(builder);
+        });
+    }
+
+    void DeviceBase::UncacheShaderModule(ShaderModuleBase* obj) {
+        Uncache(&caches->shaderModules, obj);
+    }
+
+    CommandBlockPool* DeviceBase::GetCommandBlockPool() {
+        return &commandBlockPool;
+    }
+
+    DenseIndexAllocator* DeviceBase::GetBufferIndexAllocator() {
+        return &bufferIndices;
+    }
+
+    DenseIndexAllocator* DeviceBase::GetTextureIndexAllocator() {
+        return &textureIndices;
+    }
+
+    UsageTrackingTables* DeviceBase::AcquireUsageTrackingTables() {
+        std::lock_guard<std::mutex> lock(usageTrackingTablesMutex);
+        if (freeUsageTrackingTables.empty()) {
+            return new UsageTrackingTables;
         }
 
-        BindGroupLayoutBase* backendObj = CreateBindGroupLayout(builder);
-        caches->bindGroupLayouts.insert(backendObj);
-        return backendObj;
+        UsageTrackingTables* tables = freeUsageTrackingTables.back();
+        freeUsageTrackingTables.pop_back();
+        return tables;
     }
 
-    void DeviceBase::UncacheBindGroupLayout(BindGroupLayoutBase* obj) {
-        caches->bindGroupLayouts.erase(obj);
+    void DeviceBase::ReleaseUsageTrackingTables(UsageTrackingTables* tables) {
+        tables->Clear();
+
+        std::lock_guard<std::mutex> lock(usageTrackingTablesMutex);
+        freeUsageTrackingTables.push_back(tables);
+    }
+
+    void DeviceBase::SetRedundantStateEliminationEnabled(bool enabled) {
+        redundantStateEliminationEnabled = enabled;
+    }
+
+    bool DeviceBase::IsRedundantStateEliminationEnabled() const {
+        return redundantStateEliminationEnabled;
+    }
+
+    void DeviceBase::SetStreamingValidationEnabled(bool enabled) {
+        streamingValidationEnabled = enabled;
+    }
+
+    bool DeviceBase::IsStreamingValidationEnabled() const {
+        return streamingValidationEnabled;
+    }
+
+    void DeviceBase::SetBackgroundValidationEnabled(bool enabled) {
+        backgroundValidationEnabled = enabled;
+        if (enabled && validationThread == nullptr) {
+            validationThread = std::make_unique<WorkerThread>();
+        }
+    }
+
+    bool DeviceBase::IsBackgroundValidationEnabled() const {
+        return backgroundValidationEnabled;
+    }
+
+    WorkerThread* DeviceBase::GetValidationThread() {
+        ASSERT(validationThread != nullptr);
+        return validationThread.get();
+    }
+
+    namespace {
+        // Errors of the builders used to create objects from descriptors are device errors.
+        void ForwardBuilderErrorToDevice(nxtBuilderErrorStatus status, const char* message,
+                                         nxtCallbackUserdata userdata1, nxtCallbackUserdata) {
+            if (status == NXT_BUILDER_ERROR_STATUS_ERROR) {
+                reinterpret_cast<DeviceBase*>(static_cast<uintptr_t>(userdata1))->HandleError(message);
+            }
+        }
+
+        // Objects created from a descriptor are validated like with their builder, but the
+        // builder lives on the stack and is never seen by the application.
+        template<typename BuilderType>
+        void PrepareDescriptorBuilder(DeviceBase* device, BuilderType* builder) {
+            builder->SetErrorCallback(ForwardBuilderErrorToDevice, static_cast<nxt::CallbackUserdata>(reinterpret_cast<uintptr_t>(device)), 0);
+        }
     }
 
     BindGroupBuilder* DeviceBase::CreateBindGroupBuilder() {
@@ -93,6 +307,14 @@ namespace backend {
     BindGroupLayoutBuilder* DeviceBase::CreateBindGroupLayoutBuilder() {
         return new BindGroupLayoutBuilder(this);
     }
+    BufferBase* DeviceBase::CreateBuffer(const nxt::BufferDescriptor* descriptor) {
+        BufferBuilder builder(this);
+        PrepareDescriptorBuilder(this, &builder);
+        builder.SetAllowedUsage(descriptor->allowedUsage);
+        builder.SetInitialUsage(descriptor->initialUsage);
+        builder.SetSize(descriptor->size);
+        return builder.GetResult();
+    }
     BufferBuilder* DeviceBase::CreateBufferBuilder() {
         return new BufferBuilder(this);
     }
@@ -117,21 +339,60 @@ namespace backend {
     QueueBuilder* DeviceBase::CreateQueueBuilder() {
         return new QueueBuilder(this);
     }
+    RenderBundleBuilder* DeviceBase::CreateRenderBundleBuilder() {
+        return new RenderBundleBuilder(this);
+    }
     RenderPassBuilder* DeviceBase::CreateRenderPassBuilder() {
         return new RenderPassBuilder(this);
     }
+    SamplerBase* DeviceBase::CreateSampler(const nxt::SamplerDescriptor* descriptor) {
+        SamplerBuilder builder(this);
+        PrepareDescriptorBuilder(this, &builder);
+        builder.SetFilterMode(descriptor->magFilter, descriptor->minFilter, descriptor->mipmapFilter);
+        return builder.GetResult();
+    }
     SamplerBuilder* DeviceBase::CreateSamplerBuilder() {
         return new SamplerBuilder(this);
     }
     ShaderModuleBuilder* DeviceBase::CreateShaderModuleBuilder() {
         return new ShaderModuleBuilder(this);
     }
+    TextureBase* DeviceBase::CreateTexture(const nxt::TextureDescriptor* descriptor) {
+        TextureBuilder builder(this);
+        PrepareDescriptorBuilder(this, &builder);
+        builder.SetDimension(descriptor->dimension);
+        builder.SetExtent(descriptor->width, descriptor->height, descriptor->depth);
+        builder.SetFormat(descriptor->format);
+        builder.SetMipLevels(descriptor->mipLevels);
+        builder.SetAllowedUsage(descriptor->allowedUsage);
+        builder.SetInitialUsage(descriptor->initialUsage);
+        return builder.GetResult();
+    }
     TextureBuilder* DeviceBase::CreateTextureBuilder() {
         return new TextureBuilder(this);
     }
 
     void DeviceBase::Tick() {
+        NXT_TRACE_EVENT("frontend", "Device::Tick");
         TickImpl();
+        ReleaseKeptAliveObjectsUpTo(GetCompletedCommandSerial());
+        commandBlockPool.Trim();
+    }
+
+    void DeviceBase::KeepAliveUntilSerial(RefCounted* object, Serial serial) {
+        object->ReferenceInternal();
+        keptAliveObjects.Enqueue(object, serial);
+    }
+
+    void DeviceBase::ReleaseAllKeptAliveObjects() {
+        ReleaseKeptAliveObjectsUpTo(std::numeric_limits<Serial>::max());
+    }
+
+    void DeviceBase::ReleaseKeptAliveObjectsUpTo(Serial serial) {
+        for (RefCounted* object : keptAliveObjects.IterateUpTo(serial)) {
+            object->ReleaseInternal();
+        }
+        keptAliveObjects.ClearUpTo(serial);
     }
 
     void DeviceBase::Reference() {
@@ -15,15 +15,26 @@
 #ifndef BACKEND_DEVICEBASE_H_
 #define BACKEND_DEVICEBASE_H_
 
+#include "backend/CommandAllocator.h"
+#include "backend/DenseIndex.h"
 #include "backend/Forward.h"
 #include "backend/RefCounted.h"
+#include "common/Serial.h"
+#include "common/SerialQueue.h"
 
 #include "nxt/nxtcpp.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace backend {
 
     using ErrorCallback = void (*)(const char* errorMessage, void* userData);
 
+    struct UsageTrackingTables;
+    class WorkerThread;
+
     class DeviceBase {
         public:
             DeviceBase();
@@ -45,6 +56,7 @@ namespace backend {
             virtual PipelineBase* CreatePipeline(PipelineBuilder* builder) = 0;
             virtual PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) = 0;
             virtual QueueBase* CreateQueue(QueueBuilder* builder) = 0;
+            virtual RenderBundleBase* CreateRenderBundle(RenderBundleBuilder* builder) = 0;
             virtual RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) = 0;
             virtual SamplerBase* CreateSampler(SamplerBuilder* builder) = 0;
             virtual ShaderModuleBase* CreateShaderModule(ShaderModuleBuilder* builder) = 0;
@@ -53,6 +65,17 @@ namespace backend {
 
             virtual void TickImpl() = 0;
 
+            // Objects used by submitted commands must stay alive until the GPU is done with them,
+            // even if the application releases its last reference before that. When submitting,
+            // backends give each command buffer to KeepAliveUntilSerial with the serial of the
+            // submission: the device holds an internal reference to it, and through its residency
+            // set to every object it uses. The references are dropped in batches in Tick once
+            // GetCompletedCommandSerial reaches their serial, so the objects whose last reference
+            // was dropped in the meantime are destroyed there instead of in the middle of the
+            // application's frame.
+            void KeepAliveUntilSerial(RefCounted* object, Serial serial);
+            virtual Serial GetCompletedCommandSerial() = 0;
+
             // Many NXT objects are completely immutable once created which means that if two
             // builders are given the same arguments, they can return the same object. Reusing
             // objects will help make comparisons between objects by a single pointer comparison.
@@ -66,13 +89,74 @@ namespace backend {
             // When trying to create an object, we give both the builder and an example of what
             // the built object will be, the "blueprint". The blueprint is just a FooBase object
             // instead of a backend Foo object. If the blueprint doesn't match an object in the
-            // cache, then the builder is used to make a new object.
+            // cache, then the builder is used to make a new object. The returned object has an
+            // external reference for the caller.
+            //
+            // Shader modules are looked up by a hash of their SPIR-V so that identical modules
+            // are only reflected once. Only frozen bind groups are cached as dynamic ones can be
+            // modified.
+            //
+            // The caches can be used from multiple threads at the same time.
+            BindGroupBase* GetOrCreateBindGroup(const BindGroupBase* blueprint, BindGroupBuilder* builder);
+            void UncacheBindGroup(BindGroupBase* obj);
             BindGroupLayoutBase* GetOrCreateBindGroupLayout(const BindGroupLayoutBase* blueprint, BindGroupLayoutBuilder* builder);
             void UncacheBindGroupLayout(BindGroupLayoutBase* obj);
+            DepthStencilStateBase* GetOrCreateDepthStencilState(const DepthStencilStateBase* blueprint, DepthStencilStateBuilder* builder);
+            void UncacheDepthStencilState(DepthStencilStateBase* obj);
+            InputStateBase* GetOrCreateInputState(const InputStateBase* blueprint, InputStateBuilder* builder);
+            void UncacheInputState(InputStateBase* obj);
+            PipelineLayoutBase* GetOrCreatePipelineLayout(const PipelineLayoutBase* blueprint, PipelineLayoutBuilder* builder);
+            void UncachePipelineLayout(PipelineLayoutBase* obj);
+            RenderPassBase* GetOrCreateRenderPass(const RenderPassBase* blueprint, RenderPassBuilder* builder);
+            void UncacheRenderPass(RenderPassBase* obj);
+            SamplerBase* GetOrCreateSampler(const SamplerBase* blueprint, SamplerBuilder* builder);
+            void UncacheSampler(SamplerBase* obj);
+            ShaderModuleBase* GetOrCreateShaderModule(const ShaderModuleBase* blueprint, ShaderModuleBuilder* builder);
+            void UncacheShaderModule(ShaderModuleBase* obj);
+
+            // Blocks of the CommandAllocators of command buffers are recycled through this pool,
+            // it is trimmed on every Tick.
+            CommandBlockPool* GetCommandBlockPool();
+
+            // Buffers and textures get a dense index from the device so that the command buffer
+            // state tracker can use flat tables instead of maps.
+            DenseIndexAllocator* GetBufferIndexAllocator();
+            DenseIndexAllocator* GetTextureIndexAllocator();
+
+            // The tables of the command buffer state trackers are recycled so that their memory
+            // is reused and they can be cleared in O(1).
+            UsageTrackingTables* AcquireUsageTrackingTables();
+            void ReleaseUsageTrackingTables(UsageTrackingTables* tables);
+
+            // When enabled (the default), CommandBufferBuilder::ValidateGetResult removes the
+            // SetPipeline, SetBindGroup, SetIndexBuffer and SetVertexBuffers commands that don't
+            // change the state, so that backends iterate over shorter command streams.
+            void SetRedundantStateEliminationEnabled(bool enabled);
+            bool IsRedundantStateEliminationEnabled() const;
+
+            // When enabled, CommandBufferBuilders created afterwards validate each command as it
+            // is recorded instead of walking the command stream again in ValidateGetResult. The
+            // errors are latched and reported by GetResult. This happens even when the builder
+            // is used through the non-validating procs. Disabled by default.
+            void SetStreamingValidationEnabled(bool enabled);
+            bool IsStreamingValidationEnabled() const;
+
+            // When enabled, the command buffers built afterwards through the validating procs are
+            // returned by GetResult right away and their commands are validated on a validation
+            // thread owned by the device. Queue::Submit waits for that validation to finish and
+            // rejects invalid command buffers. The commands are validated against the usage state
+            // the resources had when GetResult was called; freezing or mapping them afterwards is
+            // caught by the checks done on submit. The builder's error callback is only called
+            // when the command buffer is submitted or destroyed, whichever happens first, and not
+            // when the validation thread is done with it. Disabled by default.
+            void SetBackgroundValidationEnabled(bool enabled);
+            bool IsBackgroundValidationEnabled() const;
+            WorkerThread* GetValidationThread();
 
             // NXT API
             BindGroupBuilder* CreateBindGroupBuilder();
             BindGroupLayoutBuilder* CreateBindGroupLayoutBuilder();
+            BufferBase* CreateBuffer(const nxt::BufferDescriptor* descriptor);
             BufferBuilder* CreateBufferBuilder();
             BufferViewBuilder* CreateBufferViewBuilder();
             CommandBufferBuilder* CreateCommandBufferBuilder();
@@ -82,9 +166,12 @@ namespace backend {
             PipelineBuilder* CreatePipelineBuilder();
             PipelineLayoutBuilder* CreatePipelineLayoutBuilder();
             QueueBuilder* CreateQueueBuilder();
+            RenderBundleBuilder* CreateRenderBundleBuilder();
             RenderPassBuilder* CreateRenderPassBuilder();
+            SamplerBase* CreateSampler(const nxt::SamplerDescriptor* descriptor);
             SamplerBuilder* CreateSamplerBuilder();
             ShaderModuleBuilder* CreateShaderModuleBuilder();
+            TextureBase* CreateTexture(const nxt::TextureDescriptor* descriptor);
             TextureBuilder* CreateTextureBuilder();
 
             void Tick();
@@ -93,12 +180,33 @@ namespace backend {
             void Reference();
             void Release();
 
+        protected:
+            // Drops all the references held for submitted commands. The device destructor does
+            // it too, but backends whose objects use the backend device when they are destroyed
+            // must call it in their destructor, after waiting for the GPU to be idle.
+            void ReleaseAllKeptAliveObjects();
+
         private:
+            void ReleaseKeptAliveObjectsUpTo(Serial serial);
+
             // The object caches aren't exposed in the header as they would require a lot of
             // additional includes.
             struct Caches;
             Caches* caches = nullptr;
 
+            CommandBlockPool commandBlockPool;
+            DenseIndexAllocator bufferIndices;
+            DenseIndexAllocator textureIndices;
+            SerialQueue<RefCounted*> keptAliveObjects;
+
+            std::mutex usageTrackingTablesMutex;
+            std::vector<UsageTrackingTables*> freeUsageTrackingTables;
+            bool redundantStateEliminationEnabled = true;
+            bool streamingValidationEnabled = false;
+            bool backgroundValidationEnabled = false;
+            std::unique_ptr<WorkerThread> validationThread;
+
+            std::recursive_mutex errorMutex;
             nxt::DeviceErrorCallback errorCallback = nullptr;
             nxt::CallbackUserdata errorUserdata = 0;
             uint32_t refCount = 1;
@@ -41,6 +41,8 @@ namespace backend {
     class PipelineLayoutBuilder;
     class QueueBase;
     class QueueBuilder;
+    class RenderBundleBase;
+    class RenderBundleBuilder;
     class RenderPassBase;
     class RenderPassBuilder;
     class SamplerBase;
@@ -18,11 +18,12 @@
 #include "backend/Builder.h"
 #include "backend/Forward.h"
 #include "backend/RefCounted.h"
+#include "common/Constants.h"
+#include "common/StackVector.h"
 
 #include "nxt/nxtcpp.h"
 
 #include <type_traits>
-#include <vector>
 
 namespace backend {
 
@@ -39,7 +40,7 @@ namespace backend {
             Ref<RenderPassBase> renderPass;
             uint32_t width = 0;
             uint32_t height = 0;
-            std::vector<Ref<TextureViewBase>> textureViews;
+            StackVector<Ref<TextureViewBase>, kMaxColorAttachments> textureViews;
     };
 
     class FramebufferBuilder : public Builder<FramebufferBase> {
@@ -60,7 +61,7 @@ namespace backend {
             Ref<RenderPassBase> renderPass;
             uint32_t width = 0;
             uint32_t height = 0;
-            std::vector<Ref<TextureViewBase>> textureViews;
+            StackVector<Ref<TextureViewBase>, kMaxColorAttachments> textureViews;
             int propertiesSet = 0;
     };
 
@@ -16,6 +16,10 @@
 
 #include "backend/Device.h"
 #include "common/Assert.h"
+#include "common/BitSetIterator.h"
+#include "common/HashUtils.h"
+
+#include <algorithm>
 
 namespace backend {
 
@@ -55,11 +59,25 @@ namespace backend {
 
     // InputStateBase
 
-    InputStateBase::InputStateBase(InputStateBuilder* builder) {
+    InputStateBase::InputStateBase(InputStateBuilder* builder, bool blueprint)
+        : device(builder->device), blueprint(blueprint) {
         attributesSetMask = builder->attributesSetMask;
         attributeInfos = builder->attributeInfos;
         inputsSetMask = builder->inputsSetMask;
         inputInfos = builder->inputInfos;
+
+        for (uint32_t location : IterateBitSet(attributesSetMask)) {
+            const auto& attribute = attributeInfos[location];
+            uint64_t fetchSize = uint64_t(attribute.offset) + VertexFormatSize(attribute.format);
+            inputFetchSizes[attribute.bindingSlot] = std::max(inputFetchSizes[attribute.bindingSlot], fetchSize);
+        }
+    }
+
+    InputStateBase::~InputStateBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheInputState(this);
+        }
     }
 
     const std::bitset<kMaxVertexAttributes>& InputStateBase::GetAttributesSetMask() const {
@@ -80,6 +98,11 @@ namespace backend {
         return inputInfos[slot];
     }
 
+    uint64_t InputStateBase::GetInputFetchSize(uint32_t slot) const {
+        ASSERT(inputsSetMask[slot]);
+        return inputFetchSizes[slot];
+    }
+
     // InputStateBuilder
 
     InputStateBuilder::InputStateBuilder(DeviceBase* device) : Builder(device) {
@@ -94,7 +117,8 @@ namespace backend {
             }
         }
 
-        return device->CreateInputState(this);
+        InputStateBase blueprint(this, true);
+        return device->GetOrCreateInputState(&blueprint, this);
     }
 
     void InputStateBuilder::SetAttribute(uint32_t shaderLocation,
@@ -136,4 +160,50 @@ namespace backend {
         info.stepMode = stepMode;
     }
 
+    // InputStateCacheFuncs
+
+    size_t InputStateCacheFuncs::operator() (const InputStateBase* inputState) const {
+        size_t hash = Hash(inputState->GetAttributesSetMask());
+        for (uint32_t location : IterateBitSet(inputState->GetAttributesSetMask())) {
+            const auto& attribute = inputState->GetAttribute(location);
+            CombineHashes(&hash, Hash(attribute.bindingSlot));
+            CombineHashes(&hash, Hash(attribute.format));
+            CombineHashes(&hash, Hash(attribute.offset));
+        }
+
+        CombineHashes(&hash, Hash(inputState->GetInputsSetMask()));
+        for (uint32_t slot : IterateBitSet(inputState->GetInputsSetMask())) {
+            const auto& input = inputState->GetInput(slot);
+            CombineHashes(&hash, Hash(input.stride));
+            CombineHashes(&hash, Hash(input.stepMode));
+        }
+
+        return hash;
+    }
+
+    bool InputStateCacheFuncs::operator() (const InputStateBase* a, const InputStateBase* b) const {
+        if (a->GetAttributesSetMask() != b->GetAttributesSetMask() ||
+                a->GetInputsSetMask() != b->GetInputsSetMask()) {
+            return false;
+        }
+
+        for (uint32_t location : IterateBitSet(a->GetAttributesSetMask())) {
+            const auto& attributeA = a->GetAttribute(location);
+            const auto& attributeB = b->GetAttribute(location);
+            if (attributeA.bindingSlot != attributeB.bindingSlot || attributeA.format != attributeB.format ||
+                    attributeA.offset != attributeB.offset) {
+                return false;
+            }
+        }
+
+        for (uint32_t slot : IterateBitSet(a->GetInputsSetMask())) {
+            const auto& inputA = a->GetInput(slot);
+            const auto& inputB = b->GetInput(slot);
+            if (inputA.stride != inputB.stride || inputA.stepMode != inputB.stepMode) {
+                return false;
+            }
+        }
+
+        return true;
+    }
 }
@@ -33,7 +33,8 @@ namespace backend {
 
     class InputStateBase : public RefCounted {
         public:
-            InputStateBase(InputStateBuilder* builder);
+            InputStateBase(InputStateBuilder* builder, bool blueprint = false);
+            ~InputStateBase() override;
 
             struct AttributeInfo {
                 uint32_t bindingSlot;
@@ -51,11 +52,19 @@ namespace backend {
             const std::bitset<kMaxVertexInputs>& GetInputsSetMask() const;
             const InputInfo& GetInput(uint32_t slot) const;
 
+            // The number of bytes the attributes of an input read in each element, precomputed
+            // so that the vertex and instance counts available in vertex buffers can be found
+            // without looking at each attribute. It is 0 for inputs without attributes.
+            uint64_t GetInputFetchSize(uint32_t slot) const;
+
         private:
+            DeviceBase* device;
             std::bitset<kMaxVertexAttributes> attributesSetMask;
             std::array<AttributeInfo, kMaxVertexAttributes> attributeInfos;
             std::bitset<kMaxVertexInputs> inputsSetMask;
             std::array<InputInfo, kMaxVertexInputs> inputInfos;
+            std::array<uint64_t, kMaxVertexInputs> inputFetchSizes = {};
+            bool blueprint = false;
     };
 
     class InputStateBuilder : public Builder<InputStateBase> {
@@ -79,6 +88,15 @@ namespace backend {
             std::array<InputStateBase::InputInfo, kMaxVertexInputs> inputInfos;
     };
 
+    // Implements the functors necessary for the unordered_set<InputState*>-based cache.
+    struct InputStateCacheFuncs {
+        // The hash function
+        size_t operator() (const InputStateBase* inputState) const;
+
+        // The equality predicate
+        bool operator() (const InputStateBase* a, const InputStateBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_INPUTSTATE_H_
@@ -17,13 +17,28 @@
 #include "backend/BindGroupLayout.h"
 #include "backend/Device.h"
 #include "common/Assert.h"
+#include "common/HashUtils.h"
+
+#include <functional>
 
 namespace backend {
 
     // PipelineLayoutBase
 
-    PipelineLayoutBase::PipelineLayoutBase(PipelineLayoutBuilder* builder)
-        : bindGroupLayouts(std::move(builder->bindGroupLayouts)), mask(builder->mask) {
+    PipelineLayoutBase::PipelineLayoutBase(PipelineLayoutBuilder* builder, bool blueprint)
+        : device(builder->device), bindGroupLayouts(builder->bindGroupLayouts), mask(builder->mask), blueprint(blueprint) {
+        size_t hash = 0;
+        for (uint32_t group = 0; group < kMaxBindGroups; ++group) {
+            CombineHashes(&hash, std::hash<const BindGroupLayoutBase*>()(bindGroupLayouts[group].Get()));
+            prefixHashes[group] = hash;
+        }
+    }
+
+    PipelineLayoutBase::~PipelineLayoutBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncachePipelineLayout(this);
+        }
     }
 
     const BindGroupLayoutBase* PipelineLayoutBase::GetBindGroupLayout(size_t group) const {
@@ -35,6 +50,34 @@ namespace backend {
         return mask;
     }
 
+    size_t PipelineLayoutBase::GetPrefixHash(uint32_t group) const {
+        ASSERT(group < kMaxBindGroups);
+        return prefixHashes[group];
+    }
+
+    uint32_t PipelineLayoutBase::GroupsInheritedFrom(const PipelineLayoutBase* other) const {
+        if (other == this) {
+            return kMaxBindGroups;
+        }
+        if (other == nullptr) {
+            return 0;
+        }
+
+        uint32_t groups = 0;
+        while (groups < kMaxBindGroups && prefixHashes[groups] == other->prefixHashes[groups]) {
+            // Equal hashes can be collisions, compare the layouts too.
+            if (bindGroupLayouts[groups].Get() != other->bindGroupLayouts[groups].Get()) {
+                break;
+            }
+            groups++;
+        }
+        return groups;
+    }
+
+    std::bitset<kMaxBindGroups> PipelineLayoutBase::InheritedGroupsMask(const PipelineLayoutBase* other) const {
+        return (uint64_t(1) << GroupsInheritedFrom(other)) - 1;
+    }
+
     // PipelineLayoutBuilder
 
     PipelineLayoutBuilder::PipelineLayoutBuilder(DeviceBase* device) : Builder(device) {
@@ -49,7 +92,8 @@ namespace backend {
             }
         }
 
-        return device->CreatePipelineLayout(this);
+        PipelineLayoutBase blueprint(this, true);
+        return device->GetOrCreatePipelineLayout(&blueprint, this);
     }
 
     void PipelineLayoutBuilder::SetBindGroupLayout(uint32_t groupIndex, BindGroupLayoutBase* layout) {
@@ -66,4 +110,17 @@ namespace backend {
         mask.set(groupIndex);
     }
 
+    // PipelineLayoutCacheFuncs
+
+    size_t PipelineLayoutCacheFuncs::operator() (const PipelineLayoutBase* layout) const {
+        // Bind group layouts are cached so they can be hashed and compared by pointer.
+        size_t hash = Hash(layout->GetBindGroupsLayoutMask());
+        CombineHashes(&hash, layout->GetPrefixHash(kMaxBindGroups - 1));
+        return hash;
+    }
+
+    bool PipelineLayoutCacheFuncs::operator() (const PipelineLayoutBase* a, const PipelineLayoutBase* b) const {
+        return a->GetBindGroupsLayoutMask() == b->GetBindGroupsLayoutMask() &&
+            b->GroupsInheritedFrom(a) == kMaxBindGroups;
+    }
 }
@@ -31,14 +31,29 @@ namespace backend {
 
     class PipelineLayoutBase : public RefCounted {
         public:
-            PipelineLayoutBase(PipelineLayoutBuilder* builder);
+            PipelineLayoutBase(PipelineLayoutBuilder* builder, bool blueprint = false);
+            ~PipelineLayoutBase() override;
 
             const BindGroupLayoutBase* GetBindGroupLayout(size_t group) const;
             const std::bitset<kMaxBindGroups> GetBindGroupsLayoutMask() const;
 
+            // Bind group layouts are deduplicated by the device so layouts are compatible up to
+            // a group if they have the same bind group layout objects up to it. The hash of the
+            // layouts of groups 0..group is precomputed for each group to compare them quickly.
+            size_t GetPrefixHash(uint32_t group) const;
+
+            // The number of leading groups that are compatible with another layout. The bind
+            // groups set for these groups stay valid when switching from a pipeline with the
+            // other layout to a pipeline with this one.
+            uint32_t GroupsInheritedFrom(const PipelineLayoutBase* other) const;
+            std::bitset<kMaxBindGroups> InheritedGroupsMask(const PipelineLayoutBase* other) const;
+
         protected:
+            DeviceBase* device;
             BindGroupLayoutArray bindGroupLayouts;
             std::bitset<kMaxBindGroups> mask;
+            std::array<size_t, kMaxBindGroups> prefixHashes;
+            bool blueprint = false;
     };
 
     class PipelineLayoutBuilder : public Builder<PipelineLayoutBase> {
@@ -57,6 +72,15 @@ namespace backend {
             std::bitset<kMaxBindGroups> mask;
     };
 
+    // Implements the functors necessary for the unordered_set<PipelineLayout*>-based cache.
+    struct PipelineLayoutCacheFuncs {
+        // The hash function
+        size_t operator() (const PipelineLayoutBase* layout) const;
+
+        // The equality predicate
+        bool operator() (const PipelineLayoutBase* a, const PipelineLayoutBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_PIPELINELAYOUT_H_
@@ -29,7 +29,15 @@ namespace backend {
     }
 
     bool QueueBase::ValidateSubmitCommand(CommandBufferBase* command) {
-        return command->ValidateResourceUsagesImmediate();
+        if (!command->WaitForValidation()) {
+            device->HandleError("Command buffer failed validation");
+            return false;
+        }
+        if (!command->ValidateResourceUsagesImmediate()) {
+            return false;
+        }
+        command->InvalidateContentsWritten();
+        return true;
     }
 
     // QueueBuilder
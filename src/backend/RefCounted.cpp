@@ -15,49 +15,138 @@
 #include "backend/RefCounted.h"
 
 #include "common/Assert.h"
+#include "common/SlabAllocator.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <new>
 
 namespace backend {
 
-    RefCounted::RefCounted() {
+    namespace {
+        // Objects are sorted in size classes kObjectSizeGranularity bytes apart, objects larger
+        // than kMaxSlabAllocatedSize are rare and use the global allocator. Each size class has
+        // its own lock so that objects of different types rarely contend.
+        constexpr size_t kObjectSizeGranularity = 16;
+        constexpr size_t kMaxSlabAllocatedSize = 2048;
+        constexpr size_t kSlabSize = 16384;
+        constexpr size_t kNumSizeClasses = kMaxSlabAllocatedSize / kObjectSizeGranularity;
+
+        struct ObjectSlabs {
+            struct SizeClass {
+                std::mutex mutex;
+                std::unique_ptr<SlabAllocator> allocator;
+            };
+            std::array<SizeClass, kNumSizeClasses> sizeClasses;
+        };
+
+        size_t SizeClassIndex(size_t size) {
+            ASSERT(size > 0 && size <= kMaxSlabAllocatedSize);
+            return (size - 1) / kObjectSizeGranularity;
+        }
+
+        ObjectSlabs::SizeClass* GetSizeClass(size_t index) {
+            // Never deleted so that objects can still be released during static destruction.
+            static ObjectSlabs* slabs = new ObjectSlabs;
+            return &slabs->sizeClasses[index];
+        }
+    }
+
+    RefCounted::RefCounted() : externalRefs(1), internalRefs(1) {
     }
 
     RefCounted::~RefCounted() {
     }
 
     void RefCounted::ReferenceInternal() {
-        ASSERT(internalRefs != 0);
+        // A new reference can only be made from an existing one so no ordering is needed.
         // TODO(cwallez@chromium.org): what to do on overflow?
-        internalRefs ++;
+        uint32_t previousRefs = internalRefs.fetch_add(1, std::memory_order_relaxed);
+        ASSERT(previousRefs != 0);
     }
 
     void RefCounted::ReleaseInternal() {
-        ASSERT(internalRefs != 0);
-        internalRefs --;
-        if (internalRefs == 0) {
+        // The release must be ordered with the other threads' uses of the object before it is
+        // deleted by the thread dropping the last reference.
+        uint32_t previousRefs = internalRefs.fetch_sub(1, std::memory_order_acq_rel);
+        ASSERT(previousRefs != 0);
+        if (previousRefs == 1) {
             ASSERT(externalRefs == 0);
-            // TODO(cwallez@chromium.org): would this work with custom allocators?
             delete this;
         }
     }
 
     uint32_t RefCounted::GetExternalRefs() const {
-        return externalRefs;
+        return externalRefs.load(std::memory_order_relaxed);
     }
 
     uint32_t RefCounted::GetInternalRefs() const {
-        return internalRefs;
+        return internalRefs.load(std::memory_order_relaxed);
+    }
+
+    bool RefCounted::TryReference() {
+        // Take an internal reference first so that the object can't be deleted in between.
+        uint32_t refs = internalRefs.load(std::memory_order_relaxed);
+        do {
+            if (refs == 0) {
+                return false;
+            }
+        } while (!internalRefs.compare_exchange_weak(refs, refs + 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+        // The external references share a single internal reference: keep ours only if we
+        // revived the external references.
+        uint32_t previousRefs = externalRefs.fetch_add(1, std::memory_order_relaxed);
+        if (previousRefs != 0) {
+            ReleaseInternal();
+        }
+        return true;
     }
 
     void RefCounted::Reference() {
-        ASSERT(externalRefs != 0);
         // TODO(cwallez@chromium.org): what to do on overflow?
-        externalRefs ++;
+        uint32_t previousRefs = externalRefs.fetch_add(1, std::memory_order_relaxed);
+        ASSERT(previousRefs != 0);
+    }
+
+    void* RefCounted::operator new(size_t size) {
+        if (size > kMaxSlabAllocatedSize) {
+            return ::operator new(size);
+        }
+
+        size_t index = SizeClassIndex(size);
+        ObjectSlabs::SizeClass* sizeClass = GetSizeClass(index);
+        void* ptr = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(sizeClass->mutex);
+            if (sizeClass->allocator == nullptr) {
+                size_t blockSize = (index + 1) * kObjectSizeGranularity;
+                sizeClass->allocator = std::make_unique<SlabAllocator>(blockSize, kSlabSize / blockSize);
+            }
+            ptr = sizeClass->allocator->Allocate();
+        }
+
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void RefCounted::operator delete(void* ptr, size_t size) {
+        if (size > kMaxSlabAllocatedSize) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        ObjectSlabs::SizeClass* sizeClass = GetSizeClass(SizeClassIndex(size));
+        std::lock_guard<std::mutex> lock(sizeClass->mutex);
+        sizeClass->allocator->Deallocate(ptr);
     }
 
     void RefCounted::Release() {
-        ASSERT(externalRefs != 0);
-        externalRefs --;
-        if (externalRefs == 0) {
+        uint32_t previousRefs = externalRefs.fetch_sub(1, std::memory_order_acq_rel);
+        ASSERT(previousRefs != 0);
+        if (previousRefs == 1) {
             ReleaseInternal();
         }
     }
@@ -15,10 +15,14 @@
 #ifndef BACKEND_REFCOUNTED_H_
 #define BACKEND_REFCOUNTED_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
 namespace backend {
 
+    // The reference counts are atomic so that objects can be referenced and released from
+    // multiple threads at the same time, for example when recording command buffers in parallel.
     class RefCounted {
         public:
             RefCounted();
@@ -30,13 +34,25 @@ namespace backend {
             uint32_t GetExternalRefs() const;
             uint32_t GetInternalRefs() const;
 
+            // Adds an external reference unless the object is being deleted by another thread.
+            // Used by the device caches that can find objects that are only kept alive by
+            // internal references, or whose last reference was just dropped.
+            bool TryReference();
+
             // NXT API
             void Reference();
             void Release();
 
+            // Objects are created and destroyed at a high rate so they are allocated in slabs
+            // sorted by size, and the memory of deleted objects is reused for the next objects of
+            // the same size. The size given to operator delete is the one of the most derived
+            // class thanks to the virtual destructor.
+            static void* operator new(size_t size);
+            static void operator delete(void* ptr, size_t size);
+
         protected:
-            uint32_t externalRefs = 1;
-            uint32_t internalRefs = 1;
+            std::atomic<uint32_t> externalRefs;
+            std::atomic<uint32_t> internalRefs;
     };
 
     template<typename T>
@@ -0,0 +1,270 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/RenderBundle.h"
+
+#include "backend/BindGroup.h"
+#include "backend/Buffer.h"
+#include "backend/CommandBufferStateTracker.h"
+#include "backend/Commands.h"
+#include "backend/Device.h"
+#include "backend/Pipeline.h"
+#include "backend/RenderPass.h"
+#include "common/Assert.h"
+#include "common/Constants.h"
+
+#include <cstring>
+
+namespace backend {
+
+    // RenderBundle
+
+    RenderBundleBase::RenderBundleBase(RenderBundleBuilder* builder)
+        : renderPass(builder->renderPass), subpass(builder->subpass),
+          requiredBufferUsages(std::move(builder->state->requiredBufferUsages)),
+          requiredTextureUsages(std::move(builder->state->requiredTextureUsages)),
+          buffersWritten(std::move(builder->state->buffersWritten)),
+          indexRangeChecks(std::move(builder->state->indexRangeChecks)),
+          residency(std::move(builder->residency)) {
+        ASSERT(!builder->commandsAcquired);
+        commands = std::move(builder->iterator);
+        builder->commandsAcquired = true;
+    }
+
+    RenderBundleBase::~RenderBundleBase() {
+        FreeCommands(&commands);
+    }
+
+    RenderPassBase* RenderBundleBase::GetRenderPass() {
+        return renderPass.Get();
+    }
+
+    uint32_t RenderBundleBase::GetSubpass() const {
+        return subpass;
+    }
+
+    bool RenderBundleBase::IsCompatibleWith(const RenderPassBase* renderPass, uint32_t subpass) const {
+        return this->renderPass->IsCompatibleWith(renderPass) && this->subpass == subpass;
+    }
+
+    const std::set<RenderBundleBase::BufferUsage>& RenderBundleBase::GetRequiredBufferUsages() const {
+        return requiredBufferUsages;
+    }
+
+    const std::set<RenderBundleBase::TextureUsage>& RenderBundleBase::GetRequiredTextureUsages() const {
+        return requiredTextureUsages;
+    }
+
+    const std::vector<BufferBase*>& RenderBundleBase::GetBuffersWritten() const {
+        return buffersWritten;
+    }
+
+    const std::vector<IndexRangeCheck>& RenderBundleBase::GetIndexRangeChecks() const {
+        return indexRangeChecks;
+    }
+
+    CommandIterator* RenderBundleBase::GetCommands() {
+        return &commands;
+    }
+
+    // RenderBundleBuilder
+
+    RenderBundleBuilder::RenderBundleBuilder(DeviceBase* device)
+        : Builder(device), state(std::make_unique<CommandBufferStateTracker>(this)),
+          allocator(device->GetCommandBlockPool()) {
+    }
+
+    RenderBundleBuilder::~RenderBundleBuilder() {
+        if (!commandsAcquired) {
+            MoveToIterator();
+            FreeCommands(&iterator);
+        }
+    }
+
+    bool RenderBundleBuilder::ValidateGetResult() {
+        MoveToIterator();
+
+        if (renderPass.Get() == nullptr) {
+            HandleError("Render bundle subpass not set");
+            return false;
+        }
+        if (subpass >= renderPass->GetSubpassCount()) {
+            HandleError("Render bundle subpass out of bounds");
+            return false;
+        }
+        state->BeginRenderBundle(renderPass.Get(), subpass);
+
+        Command type;
+        while (iterator.NextCommandId(&type)) {
+            switch (type) {
+                case Command::DrawArrays:
+                    {
+                        DrawArraysCmd* cmd = iterator.NextCommand<DrawArraysCmd>();
+                        if (!state->ValidateCanDrawArrays(cmd->vertexCount, cmd->instanceCount, cmd->firstVertex, cmd->firstInstance)) {
+                            return false;
+                        }
+                    }
+                    break;
+
+                case Command::DrawElements:
+                    {
+                        DrawElementsCmd* cmd = iterator.NextCommand<DrawElementsCmd>();
+                        if (!state->ValidateCanDrawElements(cmd->indexCount, cmd->instanceCount, cmd->firstIndex, cmd->firstInstance)) {
+                            return false;
+                        }
+                    }
+                    break;
+
+                case Command::SetBindGroup:
+                    {
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        uint32_t* dynamicOffsets = iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        if (!state->SetBindGroup(cmd->index, cmd->group, cmd->dynamicOffsetCount, dynamicOffsets)) {
+                            return false;
+                        }
+                    }
+                    break;
+
+                case Command::SetIndexBuffer:
+                    {
+                        SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
+                        if (!state->SetIndexBuffer(cmd->buffer, cmd->offset, cmd->format)) {
+                            return false;
+                        }
+                    }
+                    break;
+
+                case Command::SetPipeline:
+                    {
+                        SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
+                        if (!state->SetPipeline(cmd->pipeline)) {
+                            return false;
+                        }
+                    }
+                    break;
+
+                case Command::SetVertexBuffers:
+                    {
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
+
+                        for (uint32_t i = 0; i < cmd->count; ++i) {
+                            if (!state->SetVertexBuffer(cmd->startSlot + i, buffers[i], offsets[i])) {
+                                return false;
+                            }
+                        }
+                    }
+                    break;
+
+                default:
+                    // The builder only records the commands above.
+                    ASSERT(false);
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    RenderBundleBase* RenderBundleBuilder::GetResultImpl() {
+        MoveToIterator();
+        return device->CreateRenderBundle(this);
+    }
+
+    void RenderBundleBuilder::DrawArrays(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+        DrawArraysCmd draw;
+        draw.vertexCount = vertexCount;
+        draw.instanceCount = instanceCount;
+        draw.firstVertex = firstVertex;
+        draw.firstInstance = firstInstance;
+        allocator.AllocatePacked(Command::DrawArrays, draw);
+    }
+
+    void RenderBundleBuilder::DrawElements(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance) {
+        DrawElementsCmd draw;
+        draw.indexCount = indexCount;
+        draw.instanceCount = instanceCount;
+        draw.firstIndex = firstIndex;
+        draw.firstInstance = firstInstance;
+        allocator.AllocatePacked(Command::DrawElements, draw);
+    }
+
+    void RenderBundleBuilder::SetBindGroup(uint32_t groupIndex, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
+        if (groupIndex >= kMaxBindGroups) {
+            HandleError("Setting bind group over the max");
+            return;
+        }
+
+        SetBindGroupCmd* cmd = allocator.Allocate<SetBindGroupCmd>(Command::SetBindGroup);
+        new(cmd) SetBindGroupCmd;
+        cmd->index = groupIndex;
+        cmd->group = group;
+        cmd->dynamicOffsetCount = dynamicOffsetCount;
+        residency.Add(group);
+
+        uint32_t* cmdDynamicOffsets = allocator.AllocateData<uint32_t>(dynamicOffsetCount);
+        memcpy(cmdDynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t));
+    }
+
+    void RenderBundleBuilder::SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format) {
+        SetIndexBufferCmd* cmd = allocator.Allocate<SetIndexBufferCmd>(Command::SetIndexBuffer);
+        new(cmd) SetIndexBufferCmd;
+        cmd->buffer = buffer;
+        cmd->offset = offset;
+        cmd->format = format;
+        residency.Add(buffer);
+    }
+
+    void RenderBundleBuilder::SetPipeline(PipelineBase* pipeline) {
+        SetPipelineCmd* cmd = allocator.Allocate<SetPipelineCmd>(Command::SetPipeline);
+        new(cmd) SetPipelineCmd;
+        cmd->pipeline = pipeline;
+        residency.Add(pipeline);
+    }
+
+    void RenderBundleBuilder::SetSubpass(RenderPassBase* renderPass, uint32_t subpass) {
+        if (this->renderPass.Get() != nullptr) {
+            HandleError("Render bundle subpass set multiple times");
+            return;
+        }
+
+        this->renderPass = renderPass;
+        this->subpass = subpass;
+    }
+
+    void RenderBundleBuilder::SetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, uint32_t const* offsets) {
+        SetVertexBuffersCmd* cmd = allocator.Allocate<SetVertexBuffersCmd>(Command::SetVertexBuffers);
+        new(cmd) SetVertexBuffersCmd;
+        cmd->startSlot = startSlot;
+        cmd->count = count;
+
+        BufferBase** cmdBuffers = allocator.AllocateData<BufferBase*>(count);
+        for (size_t i = 0; i < count; ++i) {
+            cmdBuffers[i] = buffers[i];
+            residency.Add(buffers[i]);
+        }
+
+        uint32_t* cmdOffsets = allocator.AllocateData<uint32_t>(count);
+        memcpy(cmdOffsets, offsets, count * sizeof(uint32_t));
+    }
+
+    void RenderBundleBuilder::MoveToIterator() {
+        if (!movedToIterator) {
+            iterator = std::move(allocator);
+            movedToIterator = true;
+        }
+    }
+
+}
@@ -0,0 +1,116 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_RENDERBUNDLE_H_
+#define BACKEND_RENDERBUNDLE_H_
+
+#include "backend/Buffer.h"
+#include "backend/Builder.h"
+#include "backend/CommandAllocator.h"
+#include "backend/Forward.h"
+#include "backend/RefCounted.h"
+#include "backend/ResidencySet.h"
+
+#include "nxt/nxtcpp.h"
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace backend {
+
+    class CommandBufferStateTracker;
+
+    // Render bundles are sequences of SetPipeline, SetBindGroup, SetIndexBuffer,
+    // SetVertexBuffers and Draw* commands recorded once against a subpass of a render pass.
+    // They are validated in GetResult and then executed with CommandBufferBuilder::ExecuteBundle
+    // in that subpass of any compatible render pass. The usages of resources can only be known
+    // when a bundle is executed, so the usages that are not frozen are stored in the bundle and
+    // checked by each command buffer that executes it.
+    class RenderBundleBase : public RefCounted {
+        public:
+            RenderBundleBase(RenderBundleBuilder* builder);
+            ~RenderBundleBase();
+
+            RenderPassBase* GetRenderPass();
+            uint32_t GetSubpass() const;
+            bool IsCompatibleWith(const RenderPassBase* renderPass, uint32_t subpass) const;
+
+            using BufferUsage = std::pair<BufferBase*, nxt::BufferUsageBit>;
+            using TextureUsage = std::pair<TextureBase*, nxt::TextureUsageBit>;
+            const std::set<BufferUsage>& GetRequiredBufferUsages() const;
+            const std::set<TextureUsage>& GetRequiredTextureUsages() const;
+
+            // The buffers the GPU writes in the bundle, and the index ranges of its draws that
+            // were checked against its vertex buffers when it was built.
+            const std::vector<BufferBase*>& GetBuffersWritten() const;
+            const std::vector<IndexRangeCheck>& GetIndexRangeChecks() const;
+
+            // Backends iterate over the commands of bundles with a BundleReplayIterator.
+            CommandIterator* GetCommands();
+
+        private:
+            Ref<RenderPassBase> renderPass;
+            uint32_t subpass;
+            std::set<BufferUsage> requiredBufferUsages;
+            std::set<TextureUsage> requiredTextureUsages;
+            std::vector<BufferBase*> buffersWritten;
+            std::vector<IndexRangeCheck> indexRangeChecks;
+            ResidencySet residency;
+            CommandIterator commands;
+    };
+
+    class RenderBundleBuilder : public Builder<RenderBundleBase> {
+        public:
+            RenderBundleBuilder(DeviceBase* device);
+            ~RenderBundleBuilder();
+
+            bool ValidateGetResult();
+
+            // NXT API
+            void DrawArrays(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+            void DrawElements(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t firstInstance);
+            void SetBindGroup(uint32_t groupIndex, BindGroupBase* group, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets);
+            void SetIndexBuffer(BufferBase* buffer, uint32_t offset, nxt::IndexFormat format);
+            void SetPipeline(PipelineBase* pipeline);
+            void SetSubpass(RenderPassBase* renderPass, uint32_t subpass);
+
+            template<typename T>
+            void SetVertexBuffers(uint32_t startSlot, uint32_t count, T* const* buffers, uint32_t const* offsets) {
+                static_assert(std::is_base_of<BufferBase, T>::value, "");
+                SetVertexBuffers(startSlot, count, reinterpret_cast<BufferBase* const*>(buffers), offsets);
+            }
+            void SetVertexBuffers(uint32_t startSlot, uint32_t count, BufferBase* const* buffers, uint32_t const* offsets);
+
+        private:
+            friend class RenderBundleBase;
+
+            RenderBundleBase* GetResultImpl() override;
+            void MoveToIterator();
+
+            std::unique_ptr<CommandBufferStateTracker> state;
+            CommandAllocator allocator;
+            CommandIterator iterator;
+            bool movedToIterator = false;
+            bool commandsAcquired = false;
+
+            Ref<RenderPassBase> renderPass;
+            uint32_t subpass = 0;
+            ResidencySet residency;
+    };
+
+}
+
+#endif // BACKEND_RENDERBUNDLE_H_
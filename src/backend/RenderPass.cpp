@@ -18,13 +18,22 @@
 #include "backend/Device.h"
 #include "backend/Texture.h"
 #include "common/Assert.h"
+#include "common/BitSetIterator.h"
+#include "common/HashUtils.h"
 
 namespace backend {
 
     // RenderPass
 
-    RenderPassBase::RenderPassBase(RenderPassBuilder* builder)
-        : attachments(std::move(builder->attachments)), subpasses(std::move(builder->subpasses)) {
+    RenderPassBase::RenderPassBase(RenderPassBuilder* builder, bool blueprint)
+        : device(builder->device), attachments(builder->attachments), subpasses(builder->subpasses), blueprint(blueprint) {
+    }
+
+    RenderPassBase::~RenderPassBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheRenderPass(this);
+        }
     }
 
     uint32_t RenderPassBase::GetAttachmentCount() const {
@@ -74,7 +83,8 @@ namespace backend {
                 return nullptr;
             }
         }
-        return device->CreateRenderPass(this);
+        RenderPassBase blueprint(this, true);
+        return device->GetOrCreateRenderPass(&blueprint, this);
     }
 
     void RenderPassBuilder::SetAttachmentCount(uint32_t attachmentCount) {
@@ -94,7 +104,7 @@ namespace backend {
             HandleError("Render pass attachment count not set yet");
             return;
         }
-        if (attachmentSlot > attachments.size()) {
+        if (attachmentSlot >= attachments.size()) {
             HandleError("Render pass attachment index out of bounds");
             return;
         }
@@ -147,4 +157,51 @@ namespace backend {
         subpasses[subpass].colorAttachments[outputAttachmentLocation] = attachmentSlot;
     }
 
+    // RenderPassCacheFuncs
+
+    size_t RenderPassCacheFuncs::operator() (const RenderPassBase* renderPass) const {
+        size_t hash = Hash(renderPass->GetAttachmentCount());
+        for (uint32_t attachment = 0; attachment < renderPass->GetAttachmentCount(); ++attachment) {
+            CombineHashes(&hash, Hash(renderPass->GetAttachmentInfo(attachment).format));
+        }
+
+        CombineHashes(&hash, Hash(renderPass->GetSubpassCount()));
+        for (uint32_t subpass = 0; subpass < renderPass->GetSubpassCount(); ++subpass) {
+            const auto& info = renderPass->GetSubpassInfo(subpass);
+            CombineHashes(&hash, Hash(info.colorAttachmentsSet));
+            for (uint32_t location : IterateBitSet(info.colorAttachmentsSet)) {
+                CombineHashes(&hash, Hash(info.colorAttachments[location]));
+            }
+        }
+
+        return hash;
+    }
+
+    bool RenderPassCacheFuncs::operator() (const RenderPassBase* a, const RenderPassBase* b) const {
+        if (a->GetAttachmentCount() != b->GetAttachmentCount() ||
+                a->GetSubpassCount() != b->GetSubpassCount()) {
+            return false;
+        }
+
+        for (uint32_t attachment = 0; attachment < a->GetAttachmentCount(); ++attachment) {
+            if (a->GetAttachmentInfo(attachment).format != b->GetAttachmentInfo(attachment).format) {
+                return false;
+            }
+        }
+
+        for (uint32_t subpass = 0; subpass < a->GetSubpassCount(); ++subpass) {
+            const auto& infoA = a->GetSubpassInfo(subpass);
+            const auto& infoB = b->GetSubpassInfo(subpass);
+            if (infoA.colorAttachmentsSet != infoB.colorAttachmentsSet) {
+                return false;
+            }
+            for (uint32_t location : IterateBitSet(infoA.colorAttachmentsSet)) {
+                if (infoA.colorAttachments[location] != infoB.colorAttachments[location]) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
 }
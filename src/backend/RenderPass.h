@@ -19,18 +19,20 @@
 #include "backend/Forward.h"
 #include "backend/RefCounted.h"
 #include "common/Constants.h"
+#include "common/StackVector.h"
+#include "common/TypedBitSet.h"
 
 #include "nxt/nxtcpp.h"
 
 #include <array>
 #include <bitset>
-#include <vector>
 
 namespace backend {
 
     class RenderPassBase : public RefCounted {
         public:
-            RenderPassBase(RenderPassBuilder* builder);
+            RenderPassBase(RenderPassBuilder* builder, bool blueprint = false);
+            ~RenderPassBase() override;
 
             struct AttachmentInfo {
                 nxt::TextureFormat format;
@@ -47,9 +49,16 @@ namespace backend {
             const SubpassInfo& GetSubpassInfo(uint32_t subpass) const;
             bool IsCompatibleWith(const RenderPassBase* other) const;
 
+            // Render passes almost always have at most one attachment per color attachment
+            // location and a single subpass, larger ones spill to the heap.
+            using Attachments = StackVector<AttachmentInfo, kMaxColorAttachments>;
+            using Subpasses = StackVector<SubpassInfo, 1>;
+
         private:
-            std::vector<AttachmentInfo> attachments;
-            std::vector<SubpassInfo> subpasses;
+            DeviceBase* device;
+            Attachments attachments;
+            Subpasses subpasses;
+            bool blueprint = false;
     };
 
     class RenderPassBuilder : public Builder<RenderPassBase> {
@@ -73,12 +82,21 @@ namespace backend {
                 ATTACHMENT_PROPERTY_COUNT
             };
 
-            std::vector<std::bitset<ATTACHMENT_PROPERTY_COUNT>> attachmentProperties;
-            std::vector<RenderPassBase::AttachmentInfo> attachments;
-            std::vector<RenderPassBase::SubpassInfo> subpasses;
+            StackVector<TypedBitSet<AttachmentProperty, ATTACHMENT_PROPERTY_COUNT>, kMaxColorAttachments> attachmentProperties;
+            RenderPassBase::Attachments attachments;
+            RenderPassBase::Subpasses subpasses;
             int propertiesSet = 0;
     };
 
+    // Implements the functors necessary for the unordered_set<RenderPass*>-based cache.
+    struct RenderPassCacheFuncs {
+        // The hash function
+        size_t operator() (const RenderPassBase* renderPass) const;
+
+        // The equality predicate
+        bool operator() (const RenderPassBase* a, const RenderPassBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_RENDERPASS_H_
@@ -0,0 +1,77 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "backend/ResidencySet.h"
+
+#include "backend/RefCounted.h"
+
+#include <utility>
+
+namespace backend {
+
+    ResidencySet::ResidencySet() {
+    }
+
+    ResidencySet::~ResidencySet() {
+        Clear();
+    }
+
+    ResidencySet::ResidencySet(ResidencySet&& other)
+        : objects(std::move(other.objects)), lastAdded(other.lastAdded) {
+        other.objects.clear();
+        other.lastAdded = nullptr;
+    }
+
+    ResidencySet& ResidencySet::operator=(ResidencySet&& other) {
+        if (&other == this) {
+            return *this;
+        }
+
+        Clear();
+        objects = std::move(other.objects);
+        lastAdded = other.lastAdded;
+        other.objects.clear();
+        other.lastAdded = nullptr;
+
+        return *this;
+    }
+
+    void ResidencySet::Add(RefCounted* object) {
+        if (object == nullptr || object == lastAdded) {
+            return;
+        }
+
+        lastAdded = object;
+        if (objects.insert(object).second) {
+            object->ReferenceInternal();
+        }
+    }
+
+    bool ResidencySet::Contains(RefCounted* object) const {
+        return objects.count(object) != 0;
+    }
+
+    size_t ResidencySet::GetSize() const {
+        return objects.size();
+    }
+
+    void ResidencySet::Clear() {
+        for (RefCounted* object : objects) {
+            object->ReleaseInternal();
+        }
+        objects.clear();
+        lastAdded = nullptr;
+    }
+
+}
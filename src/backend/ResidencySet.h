@@ -0,0 +1,57 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_RESIDENCYSET_H_
+#define BACKEND_RESIDENCYSET_H_
+
+#include <cstddef>
+#include <unordered_set>
+
+namespace backend {
+
+    class RefCounted;
+
+    // Keeps the objects used by a command stream alive. Commands store raw pointers and the
+    // builder adds each object to the set when it is recorded: the set takes a single internal
+    // reference per unique object, and all of them are released together when it is destroyed.
+    // Recording usually references the same objects over and over so the last added object is
+    // checked before looking in the hash set.
+    class ResidencySet {
+        public:
+            ResidencySet();
+            ~ResidencySet();
+
+            ResidencySet(ResidencySet&& other);
+            ResidencySet& operator=(ResidencySet&& other);
+
+            ResidencySet(const ResidencySet&) = delete;
+            ResidencySet& operator=(const ResidencySet&) = delete;
+
+            // Null objects are ignored so that invalid commands can be recorded and caught later
+            // by the validation.
+            void Add(RefCounted* object);
+            bool Contains(RefCounted* object) const;
+            size_t GetSize() const;
+
+            // Releases all the objects.
+            void Clear();
+
+        private:
+            std::unordered_set<RefCounted*> objects;
+            RefCounted* lastAdded = nullptr;
+    };
+
+}
+
+#endif // BACKEND_RESIDENCYSET_H_
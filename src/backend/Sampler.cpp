@@ -15,12 +15,34 @@
 #include "backend/Sampler.h"
 
 #include "backend/Device.h"
+#include "common/HashUtils.h"
 
 namespace backend {
 
     // SamplerBase
 
-    SamplerBase::SamplerBase(SamplerBuilder*) {
+    SamplerBase::SamplerBase(SamplerBuilder* builder, bool blueprint)
+        : device(builder->device), magFilter(builder->magFilter), minFilter(builder->minFilter),
+          mipMapFilter(builder->mipMapFilter), blueprint(blueprint) {
+    }
+
+    SamplerBase::~SamplerBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheSampler(this);
+        }
+    }
+
+    nxt::FilterMode SamplerBase::GetMagFilter() const {
+        return magFilter;
+    }
+
+    nxt::FilterMode SamplerBase::GetMinFilter() const {
+        return minFilter;
+    }
+
+    nxt::FilterMode SamplerBase::GetMipMapFilter() const {
+        return mipMapFilter;
     }
 
     // SamplerBuilder
@@ -56,7 +78,21 @@ namespace backend {
     }
 
     SamplerBase* SamplerBuilder::GetResultImpl() {
-        return device->CreateSampler(this);
+        SamplerBase blueprint(this, true);
+        return device->GetOrCreateSampler(&blueprint, this);
     }
 
+    // SamplerCacheFuncs
+
+    size_t SamplerCacheFuncs::operator() (const SamplerBase* sampler) const {
+        size_t hash = Hash(sampler->GetMagFilter());
+        CombineHashes(&hash, Hash(sampler->GetMinFilter()));
+        CombineHashes(&hash, Hash(sampler->GetMipMapFilter()));
+        return hash;
+    }
+
+    bool SamplerCacheFuncs::operator() (const SamplerBase* a, const SamplerBase* b) const {
+        return a->GetMagFilter() == b->GetMagFilter() && a->GetMinFilter() == b->GetMinFilter() &&
+            a->GetMipMapFilter() == b->GetMipMapFilter();
+    }
 }
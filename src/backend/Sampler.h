@@ -25,7 +25,19 @@ namespace backend {
 
     class SamplerBase : public RefCounted {
         public:
-            SamplerBase(SamplerBuilder* builder);
+            SamplerBase(SamplerBuilder* builder, bool blueprint = false);
+            ~SamplerBase() override;
+
+            nxt::FilterMode GetMagFilter() const;
+            nxt::FilterMode GetMinFilter() const;
+            nxt::FilterMode GetMipMapFilter() const;
+
+        private:
+            DeviceBase* device;
+            nxt::FilterMode magFilter;
+            nxt::FilterMode minFilter;
+            nxt::FilterMode mipMapFilter;
+            bool blueprint = false;
     };
 
     class SamplerBuilder : public Builder<SamplerBase> {
@@ -51,6 +63,15 @@ namespace backend {
             nxt::FilterMode mipMapFilter = nxt::FilterMode::Nearest;
     };
 
+    // Implements the functors necessary for the unordered_set<Sampler*>-based cache.
+    struct SamplerCacheFuncs {
+        // The hash function
+        size_t operator() (const SamplerBase* sampler) const;
+
+        // The equality predicate
+        bool operator() (const SamplerBase* a, const SamplerBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_SAMPLER_H_
@@ -18,16 +18,29 @@
 #include "backend/Device.h"
 #include "backend/Pipeline.h"
 #include "backend/PipelineLayout.h"
+#include "common/HashUtils.h"
+#include "common/Tracing.h"
 
 #include <spirv-cross/spirv_cross.hpp>
 
 namespace backend {
 
-    ShaderModuleBase::ShaderModuleBase(ShaderModuleBuilder* builder)
-        : device(builder->device) {
+    ShaderModuleBase::ShaderModuleBase(ShaderModuleBuilder* builder, bool blueprint)
+        : device(builder->device), spirv(builder->spirv), blueprint(blueprint) {
+        for (uint32_t word : spirv) {
+            CombineHashes(&spirvHash, Hash(word));
+        }
+    }
+
+    ShaderModuleBase::~ShaderModuleBase() {
+        // Do not register the actual cached object if we are a blueprint
+        if (!blueprint) {
+            device->UncacheShaderModule(this);
+        }
     }
 
     void ShaderModuleBase::ExtractSpirvInfo(const spirv_cross::Compiler& compiler) {
+        NXT_TRACE_EVENT("frontend", "ShaderModule::ExtractSpirvInfo");
         // TODO(cwallez@chromium.org): make errors here builder-level
         // currently errors here do not prevent the shadermodule from being used
         const auto& resources = compiler.get_shader_resources();
@@ -181,7 +194,12 @@ namespace backend {
                 continue;
             }
 
-            if (moduleInfo.type != layoutInfo.types[i]) {
+            // Shaders don't know whether the offset of a uniform buffer is dynamic.
+            nxt::BindingType layoutType = layoutInfo.types[i];
+            if (layoutType == nxt::BindingType::DynamicUniformBuffer) {
+                layoutType = nxt::BindingType::UniformBuffer;
+            }
+            if (moduleInfo.type != layoutType) {
                 return false;
             }
             if ((layoutInfo.visibilities[i] & StageBit(executionModel)) == 0) {
@@ -192,6 +210,14 @@ namespace backend {
         return true;
     }
 
+    const std::vector<uint32_t>& ShaderModuleBase::GetSpirv() const {
+        return spirv;
+    }
+
+    size_t ShaderModuleBase::GetSpirvHash() const {
+        return spirvHash;
+    }
+
     ShaderModuleBuilder::ShaderModuleBuilder(DeviceBase* device) : Builder(device) {
     }
 
@@ -200,16 +226,29 @@ namespace backend {
     }
 
     ShaderModuleBase* ShaderModuleBuilder::GetResultImpl() {
+        // Includes the SPIR-V parsing done by the backends when creating the module.
+        NXT_TRACE_EVENT("frontend", "ShaderModuleBuilder::GetResult");
         if (spirv.size() == 0) {
             HandleError("Shader module needs to have the source set");
             return nullptr;
         }
 
-        return device->CreateShaderModule(this);
+        // Identical modules are found by their SPIR-V before the backend reflects them again.
+        ShaderModuleBase blueprint(this, true);
+        return device->GetOrCreateShaderModule(&blueprint, this);
     }
 
     void ShaderModuleBuilder::SetSource(uint32_t codeSize, const uint32_t* code) {
         spirv.assign(code, code + codeSize);
     }
 
+    // ShaderModuleCacheFuncs
+
+    size_t ShaderModuleCacheFuncs::operator() (const ShaderModuleBase* module) const {
+        return module->GetSpirvHash();
+    }
+
+    bool ShaderModuleCacheFuncs::operator() (const ShaderModuleBase* a, const ShaderModuleBase* b) const {
+        return a->GetSpirvHash() == b->GetSpirvHash() && a->GetSpirv() == b->GetSpirv();
+    }
 }
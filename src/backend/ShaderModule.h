@@ -34,7 +34,8 @@ namespace backend {
 
     class ShaderModuleBase : public RefCounted {
         public:
-            ShaderModuleBase(ShaderModuleBuilder* builder);
+            ShaderModuleBase(ShaderModuleBuilder* builder, bool blueprint = false);
+            ~ShaderModuleBase() override;
 
             void ExtractSpirvInfo(const spirv_cross::Compiler& compiler);
 
@@ -62,6 +63,10 @@ namespace backend {
 
             bool IsCompatibleWithPipelineLayout(const PipelineLayoutBase* layout);
 
+            // The SPIR-V is kept to compare modules in the device cache.
+            const std::vector<uint32_t>& GetSpirv() const;
+            size_t GetSpirvHash() const;
+
         private:
             bool IsCompatibleWithBindGroupLayout(size_t group, const BindGroupLayoutBase* layout);
 
@@ -70,6 +75,9 @@ namespace backend {
             ModuleBindingInfo bindingInfo;
             std::bitset<kMaxVertexAttributes> usedVertexAttributes;
             nxt::ShaderStage executionModel;
+            std::vector<uint32_t> spirv;
+            size_t spirvHash = 0;
+            bool blueprint = false;
     };
 
     class ShaderModuleBuilder : public Builder<ShaderModuleBase> {
@@ -89,6 +97,15 @@ namespace backend {
             std::vector<uint32_t> spirv;
     };
 
+    // Implements the functors necessary for the unordered_set<ShaderModule*>-based cache.
+    struct ShaderModuleCacheFuncs {
+        // The hash function
+        size_t operator() (const ShaderModuleBase* module) const;
+
+        // The equality predicate
+        bool operator() (const ShaderModuleBase* a, const ShaderModuleBase* b) const;
+    };
+
 }
 
 #endif // BACKEND_SHADERMODULE_H_
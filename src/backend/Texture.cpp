@@ -29,11 +29,16 @@ namespace backend {
     // TextureBase
 
     TextureBase::TextureBase(TextureBuilder* builder)
-        : device(builder->device), dimension(builder->dimension), format(builder->format), width(builder->width),
+        : device(builder->device), denseIndex(device->GetTextureIndexAllocator()->Allocate()),
+        dimension(builder->dimension), format(builder->format), width(builder->width),
         height(builder->height), depth(builder->depth), numMipLevels(builder->numMipLevels),
         allowedUsage(builder->allowedUsage), currentUsage(builder->currentUsage) {
     }
 
+    TextureBase::~TextureBase() {
+        device->GetTextureIndexAllocator()->Free(denseIndex);
+    }
+
     DeviceBase* TextureBase::GetDevice() {
         return device;
     }
@@ -72,7 +77,7 @@ namespace backend {
     }
 
     bool TextureBase::HasFrozenUsage(nxt::TextureUsageBit usage) const {
-        return frozen && (usage & allowedUsage);
+        return GetUsageState().HasFrozenUsage(usage);
     }
 
     bool TextureBase::IsUsagePossible(nxt::TextureUsageBit allowedUsage, nxt::TextureUsageBit usage) {
@@ -82,10 +87,11 @@ namespace backend {
     }
 
     bool TextureBase::IsTransitionPossible(nxt::TextureUsageBit usage) const {
-        if (frozen) {
-            return false;
-        }
-        return IsUsagePossible(allowedUsage, usage);
+        return GetUsageState().IsTransitionPossible(usage);
+    }
+
+    TextureUsageState TextureBase::GetUsageState() const {
+        return {allowedUsage, frozen};
     }
 
     void TextureBase::UpdateUsageInternal(nxt::TextureUsageBit usage) {
@@ -93,6 +99,10 @@ namespace backend {
         currentUsage = usage;
     }
 
+    uint32_t TextureBase::GetDenseIndex() const {
+        return denseIndex;
+    }
+
     bool TextureBase::IsDepthFormat(nxt::TextureFormat format) {
         switch (format) {
             case nxt::TextureFormat::R8G8B8A8Unorm:
@@ -120,6 +130,19 @@ namespace backend {
         frozen = true;
     }
 
+    // TextureUsageState
+
+    bool TextureUsageState::HasFrozenUsage(nxt::TextureUsageBit usage) const {
+        return frozen && (usage & allowedUsage);
+    }
+
+    bool TextureUsageState::IsTransitionPossible(nxt::TextureUsageBit usage) const {
+        if (frozen) {
+            return false;
+        }
+        return TextureBase::IsUsagePossible(allowedUsage, usage);
+    }
+
     // TextureBuilder
 
     enum TextureSetProperties {
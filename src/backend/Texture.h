@@ -25,9 +25,20 @@ namespace backend {
 
     size_t TextureFormatPixelSize(nxt::TextureFormat format);
 
+    // The part of the state of a texture that decides the usages command buffers can give it,
+    // see BufferUsageState.
+    struct TextureUsageState {
+        nxt::TextureUsageBit allowedUsage;
+        bool frozen;
+
+        bool HasFrozenUsage(nxt::TextureUsageBit usage) const;
+        bool IsTransitionPossible(nxt::TextureUsageBit usage) const;
+    };
+
     class TextureBase : public RefCounted {
         public:
             TextureBase(TextureBuilder* builder);
+            ~TextureBase();
 
             nxt::TextureDimension GetDimension() const;
             nxt::TextureFormat GetFormat() const;
@@ -41,8 +52,12 @@ namespace backend {
             bool HasFrozenUsage(nxt::TextureUsageBit usage) const;
             static bool IsUsagePossible(nxt::TextureUsageBit allowedUsage, nxt::TextureUsageBit usage);
             bool IsTransitionPossible(nxt::TextureUsageBit usage) const;
+            TextureUsageState GetUsageState() const;
             void UpdateUsageInternal(nxt::TextureUsageBit usage);
 
+            // Unique among the live textures of the device, see DenseIndexAllocator.
+            uint32_t GetDenseIndex() const;
+
             static bool IsDepthFormat(nxt::TextureFormat format);
 
             DeviceBase* GetDevice();
@@ -56,6 +71,7 @@ namespace backend {
             virtual void TransitionUsageImpl(nxt::TextureUsageBit currentUsage, nxt::TextureUsageBit targetUsage) = 0;
 
             DeviceBase* device;
+            uint32_t denseIndex;
 
             nxt::TextureDimension dimension;
             nxt::TextureFormat format;
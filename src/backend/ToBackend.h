@@ -83,6 +83,11 @@ namespace backend {
         using BackendType = typename BackendTraits::QueueType;
     };
 
+    template<typename BackendTraits>
+    struct ToBackendTraits<RenderBundleBase, BackendTraits> {
+        using BackendType = typename BackendTraits::RenderBundleType;
+    };
+
     template<typename BackendTraits>
     struct ToBackendTraits<RenderPassBase, BackendTraits> {
         using BackendType = typename BackendTraits::RenderPassType;
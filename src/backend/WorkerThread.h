@@ -0,0 +1,49 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BACKEND_WORKERTHREAD_H_
+#define BACKEND_WORKERTHREAD_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace backend {
+
+    // A thread running the tasks posted to it in order. The destructor runs the tasks that are
+    // still queued before joining the thread.
+    class WorkerThread {
+        public:
+            WorkerThread();
+            ~WorkerThread();
+
+            void PostTask(std::function<void()> task);
+
+        private:
+            void Run();
+
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::deque<std::function<void()>> tasks;
+            bool stopping = false;
+
+            // Last so that it is started after the other members are initialized.
+            std::thread thread;
+    };
+
+}
+
+#endif // BACKEND_WORKERTHREAD_H_
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "common/Assert.h"
 #include "common/BitSetIterator.h"
 #include "backend/d3d12/BindGroupD3D12.h"
 #include "backend/d3d12/BindGroupLayoutD3D12.h"
@@ -50,6 +51,10 @@ namespace d3d12 {
                         d3d12Device->CreateConstantBufferView(&cbv, cbvUavSrvHeapStart.GetCPUHandle(*cbvUavSrvHeapOffset + bindingOffsets[binding]));
                     }
                     break;
+                case nxt::BindingType::DynamicUniformBuffer:
+                    // Bind group layouts with dynamic uniform buffers are rejected on D3D12.
+                    ASSERT(false);
+                    break;
                 case nxt::BindingType::StorageBuffer:
                     {
                         auto* view = ToBackend(GetBindingAsBufferView(binding));
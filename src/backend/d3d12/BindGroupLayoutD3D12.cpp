@@ -27,6 +27,13 @@ namespace d3d12 {
 
         for (uint32_t binding : IterateBitSet(groupInfo.mask)) {
             switch (groupInfo.types[binding]) {
+                // TODO(agent@local): Support dynamic uniform buffers, for example with root
+                // descriptors. The descriptors of bind groups are baked when they are created so
+                // they can't contain the dynamic offsets.
+                case nxt::BindingType::DynamicUniformBuffer:
+                    builder->HandleError("Dynamic uniform buffers aren't supported on D3D12");
+                    bindingOffsets[binding] = descriptorCounts[CBV]++;
+                    break;
                 case nxt::BindingType::UniformBuffer:
                     bindingOffsets[binding] = descriptorCounts[CBV]++;
                     break;
@@ -81,6 +88,7 @@ namespace d3d12 {
         for (uint32_t binding : IterateBitSet(groupInfo.mask)) {
             switch (groupInfo.types[binding]) {
                 case nxt::BindingType::UniformBuffer:
+                case nxt::BindingType::DynamicUniformBuffer:
                     bindingOffsets[binding] += descriptorOffsets[CBV];
                     break;
                 case nxt::BindingType::StorageBuffer:
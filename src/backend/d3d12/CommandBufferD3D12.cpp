@@ -27,6 +27,8 @@
 #include "backend/d3d12/SamplerD3D12.h"
 #include "backend/d3d12/TextureD3D12.h"
 #include "common/Assert.h"
+#include "common/BitSetIterator.h"
+#include "common/Tracing.h"
 
 namespace backend {
 namespace d3d12 {
@@ -131,24 +133,19 @@ namespace d3d12 {
                 Pipeline* lastPipeline = nullptr;
                 PipelineLayout* lastLayout = nullptr;
 
-                while (commands->NextCommandId(&type)) {
+                BundleReplayIterator iterator(commands);
+                while (iterator.NextCommandId(&type)) {
                     switch (type) {
                         case Command::SetPipeline:
                         {
-                            SetPipelineCmd* cmd = commands->NextCommand<SetPipelineCmd>();
-                            Pipeline* pipeline = ToBackend(cmd->pipeline).Get();
+                            SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
+                            Pipeline* pipeline = ToBackend(cmd->pipeline);
                             PipelineLayout* layout = ToBackend(pipeline->GetLayout());
 
-                            if (lastLayout) {
-                                auto mask = layout->GetBindGroupsLayoutMask();
-                                for (uint32_t i = 0; i < kMaxBindGroups; ++i) {
-                                    // matching bind groups are inherited until they differ
-                                    if (mask[i] && lastLayout->GetBindGroupLayout(i) == layout->GetBindGroupLayout(i)) {
-                                        bindingTracker->TrackSetBindInheritedGroup(i);
-                                    } else {
-                                        break;
-                                    }
-                                }
+                            // matching bind groups are inherited until they differ
+                            auto inheritedGroups = layout->InheritedGroupsMask(lastLayout) & layout->GetBindGroupsLayoutMask();
+                            for (uint32_t i : IterateBitSet(inheritedGroups)) {
+                                bindingTracker->TrackSetBindInheritedGroup(i);
                             }
 
                             lastPipeline = pipeline;
@@ -158,13 +155,14 @@ namespace d3d12 {
 
                         case Command::SetBindGroup:
                         {
-                            SetBindGroupCmd* cmd = commands->NextCommand<SetBindGroupCmd>();
-                            BindGroup* group = ToBackend(cmd->group.Get());
+                            SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                            iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                            BindGroup* group = ToBackend(cmd->group);
                             bindingTracker->TrackSetBindGroup(group, cmd->index);
                         }
                         break;
                         default:
-                            SkipCommand(commands, type);
+                            iterator.SkipCommand(type);
                     }
                 }
 
@@ -193,7 +191,7 @@ namespace d3d12 {
     
         D3D12_TEXTURE_COPY_LOCATION D3D12PlacedTextureCopyLocation(BufferCopyLocation& bufferLocation, Texture* texture, const TextureCopyLocation& textureLocation) {
             D3D12_TEXTURE_COPY_LOCATION d3d12Location;
-            d3d12Location.pResource = ToBackend(bufferLocation.buffer.Get())->GetD3D12Resource().Get();
+            d3d12Location.pResource = ToBackend(bufferLocation.buffer)->GetD3D12Resource().Get();
             d3d12Location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
             d3d12Location.PlacedFootprint.Offset = bufferLocation.offset;
             d3d12Location.PlacedFootprint.Footprint.Format = texture->GetD3D12Format();
@@ -215,7 +213,7 @@ namespace d3d12 {
 
         D3D12_TEXTURE_COPY_LOCATION D3D12TextureCopyLocation(TextureCopyLocation& textureLocation) {
             D3D12_TEXTURE_COPY_LOCATION d3d12Location;
-            d3d12Location.pResource = ToBackend(textureLocation.texture.Get())->GetD3D12Resource().Get();
+            d3d12Location.pResource = ToBackend(textureLocation.texture)->GetD3D12Resource().Get();
             d3d12Location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
             d3d12Location.SubresourceIndex = textureLocation.level;
             return d3d12Location;
@@ -231,6 +229,7 @@ namespace d3d12 {
     }
 
     void CommandBuffer::FillCommands(ComPtr<ID3D12GraphicsCommandList> commandList) {
+        NXT_TRACE_EVENT("backend", "CommandBuffer::FillCommands");
         BindGroupStateTracker bindingTracker(device);
         AllocateAndSetDescriptorHeaps(device, &bindingTracker, &commands);
         bindingTracker.Reset();
@@ -251,19 +250,20 @@ namespace d3d12 {
         RenderPass* currentRenderPass = nullptr;
         Framebuffer* currentFramebuffer = nullptr;
 
-        while(commands.NextCommandId(&type)) {
+        BundleReplayIterator iterator(&commands);
+        while(iterator.NextCommandId(&type)) {
             switch (type) {
                 case Command::BeginComputePass:
                     {
-                        commands.NextCommand<BeginComputePassCmd>();
+                        iterator.NextCommand<BeginComputePassCmd>();
                     }
                     break;
 
                 case Command::BeginRenderPass:
                     {
-                        BeginRenderPassCmd* beginRenderPassCmd = commands.NextCommand<BeginRenderPassCmd>();
-                        currentRenderPass = ToBackend(beginRenderPassCmd->renderPass.Get());
-                        currentFramebuffer = ToBackend(beginRenderPassCmd->framebuffer.Get());
+                        BeginRenderPassCmd* beginRenderPassCmd = iterator.NextCommand<BeginRenderPassCmd>();
+                        currentRenderPass = ToBackend(beginRenderPassCmd->renderPass);
+                        currentFramebuffer = ToBackend(beginRenderPassCmd->framebuffer);
 
                         uint32_t width = currentFramebuffer->GetWidth();
                         uint32_t height = currentFramebuffer->GetHeight();
@@ -277,24 +277,24 @@ namespace d3d12 {
 
                 case Command::BeginRenderSubpass:
                     {
-                        commands.NextCommand<BeginRenderSubpassCmd>();
+                        iterator.NextCommand<BeginRenderSubpassCmd>();
                     }
                     break;
 
                 case Command::CopyBufferToBuffer:
                     {
-                        CopyBufferToBufferCmd* copy = commands.NextCommand<CopyBufferToBufferCmd>();
-                        auto src = ToBackend(copy->source.buffer.Get())->GetD3D12Resource();
-                        auto dst = ToBackend(copy->destination.buffer.Get())->GetD3D12Resource();
+                        CopyBufferToBufferCmd* copy = iterator.NextCommand<CopyBufferToBufferCmd>();
+                        auto src = ToBackend(copy->source.buffer)->GetD3D12Resource();
+                        auto dst = ToBackend(copy->destination.buffer)->GetD3D12Resource();
                         commandList->CopyBufferRegion(dst.Get(), copy->destination.offset, src.Get(), copy->source.offset, copy->size);
                     }
                     break;
 
                 case Command::CopyBufferToTexture:
                     {
-                        CopyBufferToTextureCmd* copy = commands.NextCommand<CopyBufferToTextureCmd>();
-                        Buffer* buffer = ToBackend(copy->source.buffer.Get());
-                        Texture* texture = ToBackend(copy->destination.texture.Get());
+                        CopyBufferToTextureCmd* copy = iterator.NextCommand<CopyBufferToTextureCmd>();
+                        Buffer* buffer = ToBackend(copy->source.buffer);
+                        Texture* texture = ToBackend(copy->destination.texture);
 
                         D3D12_TEXTURE_COPY_LOCATION srcLocation = D3D12PlacedTextureCopyLocation(copy->source, texture, copy->destination);
                         D3D12_TEXTURE_COPY_LOCATION dstLocation = D3D12TextureCopyLocation(copy->destination);
@@ -310,9 +310,9 @@ namespace d3d12 {
 
                 case Command::CopyTextureToBuffer:
                     {
-                        CopyTextureToBufferCmd* copy = commands.NextCommand<CopyTextureToBufferCmd>();
-                        Texture* texture = ToBackend(copy->source.texture.Get());
-                        Buffer* buffer = ToBackend(copy->destination.buffer.Get());
+                        CopyTextureToBufferCmd* copy = iterator.NextCommand<CopyTextureToBufferCmd>();
+                        Texture* texture = ToBackend(copy->source.texture);
+                        Buffer* buffer = ToBackend(copy->destination.buffer);
 
                         D3D12_TEXTURE_COPY_LOCATION srcLocation = D3D12TextureCopyLocation(copy->source);
                         D3D12_TEXTURE_COPY_LOCATION dstLocation = D3D12PlacedTextureCopyLocation(copy->destination, texture, copy->source);
@@ -335,7 +335,7 @@ namespace d3d12 {
 
                 case Command::Dispatch:
                     {
-                        DispatchCmd* dispatch = commands.NextCommand<DispatchCmd>();
+                        DispatchCmd* dispatch = iterator.NextCommand<DispatchCmd>();
 
                         ASSERT(lastPipeline->IsCompute());
                         commandList->Dispatch(dispatch->x, dispatch->y, dispatch->z);
@@ -344,7 +344,7 @@ namespace d3d12 {
 
                 case Command::DrawArrays:
                     {
-                        DrawArraysCmd* draw = commands.NextCommand<DrawArraysCmd>();
+                        DrawArraysCmd* draw = iterator.NextCommand<DrawArraysCmd>();
 
                         commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
                         commandList->DrawInstanced(
@@ -358,7 +358,7 @@ namespace d3d12 {
 
                 case Command::DrawElements:
                     {
-                        DrawElementsCmd* draw = commands.NextCommand<DrawElementsCmd>();
+                        DrawElementsCmd* draw = iterator.NextCommand<DrawElementsCmd>();
 
                         commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
                         commandList->DrawIndexedInstanced(
@@ -373,27 +373,32 @@ namespace d3d12 {
 
                 case Command::EndComputePass:
                     {
-                        commands.NextCommand<EndComputePassCmd>();
+                        iterator.NextCommand<EndComputePassCmd>();
                     }
                     break;
 
                 case Command::EndRenderPass:
                     {
-                        EndRenderPassCmd* cmd = commands.NextCommand<EndRenderPassCmd>();
+                        EndRenderPassCmd* cmd = iterator.NextCommand<EndRenderPassCmd>();
                     }
                     break;
 
                 case Command::EndRenderSubpass:
                     {
-                        commands.NextCommand<EndRenderSubpassCmd>();
+                        iterator.NextCommand<EndRenderSubpassCmd>();
                     }
                     break;
 
+                case Command::ExecuteBundle:
+                    // The commands of bundles are replayed in place by the BundleReplayIterator.
+                    ASSERT(false);
+                    break;
+
                 case Command::SetPipeline:
                     {
-                        SetPipelineCmd* cmd = commands.NextCommand<SetPipelineCmd>();
+                        SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
 
-                        Pipeline* pipeline = ToBackend(cmd->pipeline).Get();
+                        Pipeline* pipeline = ToBackend(cmd->pipeline);
                         PipelineLayout* layout = ToBackend(pipeline->GetLayout());
 
                         // TODO
@@ -404,19 +409,12 @@ namespace d3d12 {
                             commandList->SetPipelineState(pipeline->GetRenderPipelineState().Get());
                         }
 
-                        if (lastLayout) {
-                            auto mask = layout->GetBindGroupsLayoutMask();
-                            for (uint32_t i = 0; i < kMaxBindGroups; ++i) {
-                                // matching bind groups are inherited until they differ
-                                if (mask[i] && lastLayout->GetBindGroupLayout(i) == layout->GetBindGroupLayout(i)) {
-                                    bindingTracker.SetInheritedBindGroup(commandList, pipeline, i);
-                                } else {
-                                    break;
-                                }
-                            }
+                        // matching bind groups are inherited until they differ
+                        auto inheritedGroups = layout->InheritedGroupsMask(lastLayout) & layout->GetBindGroupsLayoutMask();
+                        for (uint32_t i : IterateBitSet(inheritedGroups)) {
+                            bindingTracker.SetInheritedBindGroup(commandList, pipeline, i);
                         }
 
-
                         lastPipeline = pipeline;
                         lastLayout = layout;
                     }
@@ -424,29 +422,30 @@ namespace d3d12 {
 
                 case Command::SetPushConstants:
                     {
-                        SetPushConstantsCmd* cmd = commands.NextCommand<SetPushConstantsCmd>();
+                        SetPushConstantsCmd* cmd = iterator.NextCommand<SetPushConstantsCmd>();
                     }
                     break;
 
                 case Command::SetStencilReference:
                     {
-                        SetStencilReferenceCmd* cmd = commands.NextCommand<SetStencilReferenceCmd>();
+                        SetStencilReferenceCmd* cmd = iterator.NextCommand<SetStencilReferenceCmd>();
                     }
                     break;
 
                 case Command::SetBindGroup:
                     {
-                        SetBindGroupCmd* cmd = commands.NextCommand<SetBindGroupCmd>();
-                        BindGroup* group = ToBackend(cmd->group.Get());
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        BindGroup* group = ToBackend(cmd->group);
                         bindingTracker.SetBindGroup(commandList, lastPipeline, group, cmd->index);
                     }
                     break;
 
                 case Command::SetIndexBuffer:
                     {
-                        SetIndexBufferCmd* cmd = commands.NextCommand<SetIndexBufferCmd>();
+                        SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
 
-                        Buffer* buffer = ToBackend(cmd->buffer.Get());
+                        Buffer* buffer = ToBackend(cmd->buffer);
                         D3D12_INDEX_BUFFER_VIEW bufferView;
                         bufferView.BufferLocation = buffer->GetVA() + cmd->offset;
                         bufferView.SizeInBytes = buffer->GetSize() - cmd->offset;
@@ -458,16 +457,16 @@ namespace d3d12 {
 
                 case Command::SetVertexBuffers:
                     {
-                        SetVertexBuffersCmd* cmd = commands.NextCommand<SetVertexBuffersCmd>();
-                        auto buffers = commands.NextData<Ref<BufferBase>>(cmd->count);
-                        auto offsets = commands.NextData<uint32_t>(cmd->count);
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
 
                         auto inputState = ToBackend(lastPipeline->GetInputState());
 
                         std::array<D3D12_VERTEX_BUFFER_VIEW, kMaxVertexInputs> d3d12BufferViews;
                         for (uint32_t i = 0; i < cmd->count; ++i) {
                             auto input = inputState->GetInput(cmd->startSlot + i);
-                            Buffer* buffer = ToBackend(buffers[i].Get());
+                            Buffer* buffer = ToBackend(buffers[i]);
                             d3d12BufferViews[i].BufferLocation = buffer->GetVA() + offsets[i];
                             d3d12BufferViews[i].StrideInBytes = input.stride;
                             d3d12BufferViews[i].SizeInBytes = buffer->GetSize() - offsets[i];
@@ -479,9 +478,9 @@ namespace d3d12 {
 
                 case Command::TransitionBufferUsage:
                     {
-                        TransitionBufferUsageCmd* cmd = commands.NextCommand<TransitionBufferUsageCmd>();
+                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
 
-                        Buffer* buffer = ToBackend(cmd->buffer.Get());
+                        Buffer* buffer = ToBackend(cmd->buffer);
 
                         D3D12_RESOURCE_BARRIER barrier;
                         if (buffer->GetResourceTransitionBarrier(buffer->GetUsage(), cmd->usage, &barrier)) {
@@ -494,9 +493,9 @@ namespace d3d12 {
 
                 case Command::TransitionTextureUsage:
                     {
-                        TransitionTextureUsageCmd* cmd = commands.NextCommand<TransitionTextureUsageCmd>();
+                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
 
-                        Texture* texture = ToBackend(cmd->texture.Get());
+                        Texture* texture = ToBackend(cmd->texture);
 
                         D3D12_RESOURCE_BARRIER barrier;
                         if (texture->GetResourceTransitionBarrier(texture->GetUsage(), cmd->usage, &barrier)) {
@@ -105,6 +105,9 @@ namespace d3d12 {
         const uint64_t currentSerial = GetSerial();
         NextSerial();
         WaitForSerial(currentSerial);
+
+        // Destroying the objects used by the last commands needs the allocators of the device.
+        ReleaseAllKeptAliveObjects();
     }
 
     ComPtr<ID3D12Device> Device::GetD3D12Device() {
@@ -176,6 +179,10 @@ namespace d3d12 {
         NextSerial();
     }
 
+    Serial Device::GetCompletedCommandSerial() {
+        return fence->GetCompletedValue();
+    }
+
     uint64_t Device::GetSerial() const {
         return serial;
     }
@@ -240,6 +247,9 @@ namespace d3d12 {
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(this, builder);
     }
+    RenderBundleBase* Device::CreateRenderBundle(RenderBundleBuilder* builder) {
+        return new RenderBundle(builder);
+    }
     RenderPassBase* Device::CreateRenderPass(RenderPassBuilder* builder) {
         return new RenderPass(this, builder);
     }
@@ -26,6 +26,7 @@
 #include "backend/InputState.h"
 #include "backend/PipelineLayout.h"
 #include "backend/Queue.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/Sampler.h"
 #include "backend/Texture.h"
@@ -52,6 +53,7 @@ namespace d3d12 {
     class Texture;
     class TextureView;
     class Framebuffer;
+    using RenderBundle = RenderBundleBase;
     class RenderPass;
 
     class CommandAllocatorManager;
@@ -77,6 +79,7 @@ namespace d3d12 {
         using TextureType = Texture;
         using TextureViewType = TextureView;
         using FramebufferType = Framebuffer;
+        using RenderBundleType = RenderBundle;
         using RenderPassType = RenderPass;
     };
 
@@ -93,6 +96,11 @@ namespace d3d12 {
             Device(ComPtr<ID3D12Device> d3d12Device);
             ~Device();
 
+            // The descriptor-based creation of the frontend is hidden by the overrides below.
+            using DeviceBase::CreateBuffer;
+            using DeviceBase::CreateSampler;
+            using DeviceBase::CreateTexture;
+
             BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
             BindGroupLayoutBase* CreateBindGroupLayout(BindGroupLayoutBuilder* builder) override;
             BufferBase* CreateBuffer(BufferBuilder* builder) override;
@@ -104,6 +112,7 @@ namespace d3d12 {
             PipelineBase* CreatePipeline(PipelineBuilder* builder) override;
             PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
             QueueBase* CreateQueue(QueueBuilder* builder) override;
+            RenderBundleBase* CreateRenderBundle(RenderBundleBuilder* builder) override;
             RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
             SamplerBase* CreateSampler(SamplerBuilder* builder) override;
             ShaderModuleBase* CreateShaderModule(ShaderModuleBuilder* builder) override;
@@ -111,6 +120,7 @@ namespace d3d12 {
             TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
             void TickImpl() override;
+            Serial GetCompletedCommandSerial() override;
 
             ComPtr<ID3D12Device> GetD3D12Device();
             ComPtr<ID3D12CommandQueue> GetCommandQueue();
@@ -16,6 +16,7 @@
 
 #include "backend/d3d12/D3D12Backend.h"
 #include "backend/d3d12/CommandBufferD3D12.h"
+#include "common/Tracing.h"
 
 namespace backend {
 namespace d3d12 {
@@ -25,6 +26,7 @@ namespace d3d12 {
     }
 
     void Queue::Submit(uint32_t numCommands, CommandBuffer* const * commands) {
+        NXT_TRACE_EVENT("backend", "Queue::Submit");
         device->Tick();
 
         device->OpenCommandList(&commandList);
@@ -35,6 +37,9 @@ namespace d3d12 {
 
         device->ExecuteCommandLists({ commandList.Get() });
 
+        for (uint32_t i = 0; i < numCommands; ++i) {
+            device->KeepAliveUntilSerial(commands[i], device->GetSerial());
+        }
         device->NextSerial();
     }
 
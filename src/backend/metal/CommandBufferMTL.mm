@@ -23,6 +23,7 @@
 #include "backend/metal/PipelineLayoutMTL.h"
 #include "backend/metal/SamplerMTL.h"
 #include "backend/metal/TextureMTL.h"
+#include "common/Tracing.h"
 
 namespace backend {
 namespace metal {
@@ -134,6 +135,7 @@ namespace metal {
     }
 
     void CommandBuffer::FillCommands(id<MTLCommandBuffer> commandBuffer) {
+        NXT_TRACE_EVENT("backend", "CommandBuffer::FillCommands");
         Command type;
         Pipeline* lastPipeline = nullptr;
         id<MTLBuffer> indexBuffer = nil;
@@ -144,20 +146,21 @@ namespace metal {
         encoders.device = device;
 
         uint32_t currentSubpass = 0;
-        while (commands.NextCommandId(&type)) {
+        BundleReplayIterator iterator(&commands);
+        while (iterator.NextCommandId(&type)) {
             switch (type) {
                 case Command::BeginComputePass:
                     {
-                        commands.NextCommand<BeginComputePassCmd>();
+                        iterator.NextCommand<BeginComputePassCmd>();
                         encoders.BeginCompute(commandBuffer);
                     }
                     break;
 
                 case Command::BeginRenderPass:
                     {
-                        BeginRenderPassCmd* beginRenderPassCmd = commands.NextCommand<BeginRenderPassCmd>();
-                        encoders.currentRenderPass = ToBackend(beginRenderPassCmd->renderPass.Get());
-                        encoders.currentFramebuffer = ToBackend(beginRenderPassCmd->framebuffer.Get());
+                        BeginRenderPassCmd* beginRenderPassCmd = iterator.NextCommand<BeginRenderPassCmd>();
+                        encoders.currentRenderPass = ToBackend(beginRenderPassCmd->renderPass);
+                        encoders.currentFramebuffer = ToBackend(beginRenderPassCmd->framebuffer);
                         encoders.EnsureNoBlitEncoder();
                         currentSubpass = 0;
                     }
@@ -165,14 +168,14 @@ namespace metal {
 
                 case Command::BeginRenderSubpass:
                     {
-                        commands.NextCommand<BeginRenderSubpassCmd>();
+                        iterator.NextCommand<BeginRenderSubpassCmd>();
                         encoders.BeginSubpass(commandBuffer, currentSubpass);
                     }
                     break;
 
                 case Command::CopyBufferToBuffer:
                     {
-                        CopyBufferToBufferCmd* copy = commands.NextCommand<CopyBufferToBufferCmd>();
+                        CopyBufferToBufferCmd* copy = iterator.NextCommand<CopyBufferToBufferCmd>();
                         auto& src = copy->source;
                         auto& dst = copy->destination;
 
@@ -188,11 +191,11 @@ namespace metal {
 
                 case Command::CopyBufferToTexture:
                     {
-                        CopyBufferToTextureCmd* copy = commands.NextCommand<CopyBufferToTextureCmd>();
+                        CopyBufferToTextureCmd* copy = iterator.NextCommand<CopyBufferToTextureCmd>();
                         auto& src = copy->source;
                         auto& dst = copy->destination;
-                        Buffer* buffer = ToBackend(src.buffer.Get());
-                        Texture* texture = ToBackend(dst.texture.Get());
+                        Buffer* buffer = ToBackend(src.buffer);
+                        Texture* texture = ToBackend(dst.texture);
 
                         unsigned rowSize = dst.width * TextureFormatPixelSize(texture->GetFormat());
                         MTLOrigin origin;
@@ -221,11 +224,11 @@ namespace metal {
 
                 case Command::CopyTextureToBuffer:
                     {
-                        CopyTextureToBufferCmd* copy = commands.NextCommand<CopyTextureToBufferCmd>();
+                        CopyTextureToBufferCmd* copy = iterator.NextCommand<CopyTextureToBufferCmd>();
                         auto& src = copy->source;
                         auto& dst = copy->destination;
-                        Texture* texture = ToBackend(src.texture.Get());
-                        Buffer* buffer = ToBackend(dst.buffer.Get());
+                        Texture* texture = ToBackend(src.texture);
+                        Buffer* buffer = ToBackend(dst.buffer);
 
                         unsigned rowSize = src.width * TextureFormatPixelSize(texture->GetFormat());
                         MTLOrigin origin;
@@ -254,7 +257,7 @@ namespace metal {
 
                 case Command::Dispatch:
                     {
-                        DispatchCmd* dispatch = commands.NextCommand<DispatchCmd>();
+                        DispatchCmd* dispatch = iterator.NextCommand<DispatchCmd>();
                         ASSERT(encoders.compute);
                         ASSERT(lastPipeline->IsCompute());
 
@@ -265,7 +268,7 @@ namespace metal {
 
                 case Command::DrawArrays:
                     {
-                        DrawArraysCmd* draw = commands.NextCommand<DrawArraysCmd>();
+                        DrawArraysCmd* draw = iterator.NextCommand<DrawArraysCmd>();
 
                         ASSERT(encoders.render);
                         [encoders.render
@@ -279,7 +282,7 @@ namespace metal {
 
                 case Command::DrawElements:
                     {
-                        DrawElementsCmd* draw = commands.NextCommand<DrawElementsCmd>();
+                        DrawElementsCmd* draw = iterator.NextCommand<DrawElementsCmd>();
 
                         ASSERT(encoders.render);
                         [encoders.render
@@ -296,29 +299,34 @@ namespace metal {
 
                 case Command::EndComputePass:
                     {
-                        commands.NextCommand<EndComputePassCmd>();
+                        iterator.NextCommand<EndComputePassCmd>();
                         encoders.EndCompute();
                     }
                     break;
 
                 case Command::EndRenderPass:
                     {
-                        commands.NextCommand<EndRenderPassCmd>();
+                        iterator.NextCommand<EndRenderPassCmd>();
                     }
                     break;
 
                 case Command::EndRenderSubpass:
                     {
-                        commands.NextCommand<EndRenderSubpassCmd>();
+                        iterator.NextCommand<EndRenderSubpassCmd>();
                         encoders.EndSubpass();
                         currentSubpass += 1;
                     }
                     break;
 
+                case Command::ExecuteBundle:
+                    // The commands of bundles are replayed in place by the BundleReplayIterator.
+                    ASSERT(false);
+                    break;
+
                 case Command::SetPipeline:
                     {
-                        SetPipelineCmd* cmd = commands.NextCommand<SetPipelineCmd>();
-                        lastPipeline = ToBackend(cmd->pipeline).Get();
+                        SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
+                        lastPipeline = ToBackend(cmd->pipeline);
 
                         if (lastPipeline->IsCompute()) {
                             ASSERT(encoders.compute);
@@ -334,15 +342,15 @@ namespace metal {
 
                 case Command::SetPushConstants:
                     {
-                        SetPushConstantsCmd* cmd = commands.NextCommand<SetPushConstantsCmd>();
-                        commands.NextData<uint32_t>(cmd->count);
+                        SetPushConstantsCmd* cmd = iterator.NextCommand<SetPushConstantsCmd>();
+                        iterator.NextData<uint32_t>(cmd->count);
                         // TODO(kainino@chromium.org): implement SetPushConstants
                     }
                     break;
 
                 case Command::SetStencilReference:
                     {
-                        SetStencilReferenceCmd* cmd = commands.NextCommand<SetStencilReferenceCmd>();
+                        SetStencilReferenceCmd* cmd = iterator.NextCommand<SetStencilReferenceCmd>();
 
                         ASSERT(encoders.render);
 
@@ -352,9 +360,11 @@ namespace metal {
 
                 case Command::SetBindGroup:
                     {
-                        SetBindGroupCmd* cmd = commands.NextCommand<SetBindGroupCmd>();
-                        BindGroup* group = ToBackend(cmd->group.Get());
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        uint32_t* dynamicOffsets = iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        BindGroup* group = ToBackend(cmd->group);
                         uint32_t groupIndex = cmd->index;
+                        uint32_t dynamicIndex = 0;
 
                         const auto& layout = group->GetLayout()->GetBindingInfo();
 
@@ -393,12 +403,16 @@ namespace metal {
 
                             switch (layout.types[binding]) {
                                 case nxt::BindingType::UniformBuffer:
+                                case nxt::BindingType::DynamicUniformBuffer:
                                 case nxt::BindingType::StorageBuffer:
                                     {
                                         BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
                                         auto b = ToBackend(view->GetBuffer());
                                         const id<MTLBuffer> buffer = b->GetMTLBuffer();
-                                        const NSUInteger offset = view->GetOffset();
+                                        NSUInteger offset = view->GetOffset();
+                                        if (layout.types[binding] == nxt::BindingType::DynamicUniformBuffer) {
+                                            offset += dynamicOffsets[dynamicIndex++];
+                                        }
                                         if (vertStage) {
                                             [encoders.render
                                                 setVertexBuffers:&buffer
@@ -469,8 +483,8 @@ namespace metal {
 
                 case Command::SetIndexBuffer:
                     {
-                        SetIndexBufferCmd* cmd = commands.NextCommand<SetIndexBufferCmd>();
-                        auto b = ToBackend(cmd->buffer.Get());
+                        SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
+                        auto b = ToBackend(cmd->buffer);
                         indexBuffer = b->GetMTLBuffer();
                         indexBufferOffset = cmd->offset;
                         indexType = IndexFormatType(cmd->format);
@@ -479,9 +493,9 @@ namespace metal {
 
                 case Command::SetVertexBuffers:
                     {
-                        SetVertexBuffersCmd* cmd = commands.NextCommand<SetVertexBuffersCmd>();
-                        auto buffers = commands.NextData<Ref<BufferBase>>(cmd->count);
-                        auto offsets = commands.NextData<uint32_t>(cmd->count);
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
 
                         std::array<id<MTLBuffer>, kMaxVertexInputs> mtlBuffers;
                         std::array<NSUInteger, kMaxVertexInputs> mtlOffsets;
@@ -489,7 +503,7 @@ namespace metal {
                         // Perhaps an "array of vertex buffers(+offsets?)" should be
                         // a NXT API primitive to avoid reconstructing this array?
                         for (uint32_t i = 0; i < cmd->count; ++i) {
-                            Buffer* buffer = ToBackend(buffers[i].Get());
+                            Buffer* buffer = ToBackend(buffers[i]);
                             mtlBuffers[i] = buffer->GetMTLBuffer();
                             mtlOffsets[i] = offsets[i];
                         }
@@ -504,7 +518,7 @@ namespace metal {
 
                 case Command::TransitionBufferUsage:
                     {
-                        TransitionBufferUsageCmd* cmd = commands.NextCommand<TransitionBufferUsageCmd>();
+                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
 
                         cmd->buffer->UpdateUsageInternal(cmd->usage);
                     }
@@ -512,7 +526,7 @@ namespace metal {
 
                 case Command::TransitionTextureUsage:
                     {
-                        TransitionTextureUsageCmd* cmd = commands.NextCommand<TransitionTextureUsageCmd>();
+                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
 
                         cmd->texture->UpdateUsageInternal(cmd->usage);
                     }
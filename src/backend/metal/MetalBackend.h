@@ -22,6 +22,7 @@
 #include "backend/Device.h"
 #include "backend/Framebuffer.h"
 #include "backend/Queue.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/ToBackend.h"
 #include "common/Serial.h"
@@ -45,6 +46,7 @@ namespace metal {
     class Pipeline;
     class PipelineLayout;
     class Queue;
+    using RenderBundle = RenderBundleBase;
     class RenderPass;
     class Sampler;
     class ShaderModule;
@@ -64,6 +66,7 @@ namespace metal {
         using PipelineType = Pipeline;
         using PipelineLayoutType = PipelineLayout;
         using QueueType = Queue;
+        using RenderBundleType = RenderBundle;
         using RenderPassType = RenderPass;
         using SamplerType = Sampler;
         using ShaderModuleType = ShaderModule;
@@ -84,6 +87,11 @@ namespace metal {
             Device(id<MTLDevice> mtlDevice);
             ~Device();
 
+            // The descriptor-based creation of the frontend is hidden by the overrides below.
+            using DeviceBase::CreateBuffer;
+            using DeviceBase::CreateSampler;
+            using DeviceBase::CreateTexture;
+
             BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
             BindGroupLayoutBase* CreateBindGroupLayout(BindGroupLayoutBuilder* builder) override;
             BufferBase* CreateBuffer(BufferBuilder* builder) override;
@@ -95,6 +103,7 @@ namespace metal {
             PipelineBase* CreatePipeline(PipelineBuilder* builder) override;
             PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
             QueueBase* CreateQueue(QueueBuilder* builder) override;
+            RenderBundleBase* CreateRenderBundle(RenderBundleBuilder* builder) override;
             RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
             SamplerBase* CreateSampler(SamplerBuilder* builder) override;
             ShaderModuleBase* CreateShaderModule(ShaderModuleBuilder* builder) override;
@@ -102,6 +111,7 @@ namespace metal {
             TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
             void TickImpl() override;
+            Serial GetCompletedCommandSerial() override;
 
             void SetNextDrawable(id<CAMetalDrawable> drawable);
             void Present();
@@ -24,6 +24,7 @@
 #include "backend/metal/SamplerMTL.h"
 #include "backend/metal/ShaderModuleMTL.h"
 #include "backend/metal/TextureMTL.h"
+#include "common/Tracing.h"
 
 namespace backend {
 namespace metal {
@@ -112,6 +113,9 @@ namespace metal {
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
+    RenderBundleBase* Device::CreateRenderBundle(RenderBundleBuilder* builder) {
+        return new RenderBundle(builder);
+    }
     RenderPassBase* Device::CreateRenderPass(RenderPassBuilder* builder) {
         return new RenderPass(builder);
     }
@@ -137,6 +141,10 @@ namespace metal {
         SubmitPendingCommandBuffer();
     }
 
+    Serial Device::GetCompletedCommandSerial() {
+        return finishedCommandSerial;
+    }
+
     void Device::SetNextDrawable(id<CAMetalDrawable> drawable) {
         [currentDrawable release];
         currentDrawable = drawable;
@@ -280,6 +288,7 @@ namespace metal {
     }
 
     void Queue::Submit(uint32_t numCommands, CommandBuffer* const * commands) {
+        NXT_TRACE_EVENT("backend", "Queue::Submit");
         Device* device = ToBackend(GetDevice());
         id<MTLCommandBuffer> commandBuffer = device->GetPendingCommandBuffer();
 
@@ -287,6 +296,9 @@ namespace metal {
             commands[i]->FillCommands(commandBuffer);
         }
 
+        for (uint32_t i = 0; i < numCommands; ++i) {
+            device->KeepAliveUntilSerial(commands[i], device->GetPendingCommandSerial());
+        }
         device->SubmitPendingCommandBuffer();
     }
 
@@ -39,6 +39,7 @@ namespace metal {
 
                     switch (groupInfo.types[binding]) {
                         case nxt::BindingType::UniformBuffer:
+                        case nxt::BindingType::DynamicUniformBuffer:
                         case nxt::BindingType::StorageBuffer:
                             indexInfo[stage][group][binding] = bufferIndex;
                             bufferIndex++;
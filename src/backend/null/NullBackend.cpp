@@ -15,6 +15,7 @@
 #include "backend/null/NullBackend.h"
 
 #include "backend/Commands.h"
+#include "common/Tracing.h"
 
 #include <spirv-cross/spirv_cross.hpp>
 
@@ -70,6 +71,9 @@ namespace null {
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
+    RenderBundleBase* Device::CreateRenderBundle(RenderBundleBuilder* builder) {
+        return new RenderBundle(builder);
+    }
     RenderPassBase* Device::CreateRenderPass(RenderPassBuilder* builder) {
         return new RenderPass(builder);
     }
@@ -94,6 +98,14 @@ namespace null {
     void Device::TickImpl() {
     }
 
+    Serial Device::GetCompletedCommandSerial() {
+        return lastSubmittedSerial;
+    }
+
+    Serial Device::NextSubmitSerial() {
+        return ++lastSubmittedSerial;
+    }
+
     void Device::AddPendingOperation(std::unique_ptr<PendingOperation> operation) {
         pendingOperations.emplace_back(std::move(operation));
     }
@@ -162,23 +174,28 @@ namespace null {
     }
 
     void CommandBuffer::Execute() {
+        NXT_TRACE_EVENT("backend", "CommandBuffer::Execute");
+        // Command buffers can be submitted multiple times, always replay them from the start.
+        commands.Reset();
+        BundleReplayIterator iterator(&commands);
+
         Command type;
-        while (commands.NextCommandId(&type)) {
+        while (iterator.NextCommandId(&type)) {
             switch (type) {
                 case Command::TransitionBufferUsage:
                     {
-                        TransitionBufferUsageCmd* cmd = commands.NextCommand<TransitionBufferUsageCmd>();
+                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
                         cmd->buffer->UpdateUsageInternal(cmd->usage);
                     }
                     break;
                 case Command::TransitionTextureUsage:
                     {
-                        TransitionTextureUsageCmd* cmd = commands.NextCommand<TransitionTextureUsageCmd>();
+                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
                         cmd->texture->UpdateUsageInternal(cmd->usage);
                     }
                     break;
                 default:
-                    SkipCommand(&commands, type);
+                    iterator.SkipCommand(type);
                     break;
             }
         }
@@ -194,7 +211,9 @@ namespace null {
     }
 
     void Queue::Submit(uint32_t numCommands, CommandBuffer* const* commands) {
-        auto operations = ToBackend(GetDevice())->AcquirePendingOperations();
+        NXT_TRACE_EVENT("backend", "Queue::Submit");
+        Device* device = ToBackend(GetDevice());
+        auto operations = device->AcquirePendingOperations();
 
         for (auto& operation : operations) {
             operation->Execute();
@@ -204,6 +223,11 @@ namespace null {
             commands[i]->Execute();
         }
 
+        Serial serial = device->NextSubmitSerial();
+        for (uint32_t i = 0; i < numCommands; ++i) {
+            device->KeepAliveUntilSerial(commands[i], serial);
+        }
+
         operations.clear();
     }
 
@@ -28,6 +28,7 @@
 #include "backend/Pipeline.h"
 #include "backend/PipelineLayout.h"
 #include "backend/Queue.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/Sampler.h"
 #include "backend/ShaderModule.h"
@@ -49,6 +50,7 @@ namespace null {
     using Pipeline = PipelineBase;
     using PipelineLayout = PipelineLayoutBase;
     class Queue;
+    using RenderBundle = RenderBundleBase;
     using RenderPass = RenderPassBase;
     using Sampler = SamplerBase;
     using ShaderModule = ShaderModuleBase;
@@ -68,6 +70,7 @@ namespace null {
         using PipelineType = Pipeline;
         using PipelineLayoutType = PipelineLayout;
         using QueueType = Queue;
+        using RenderBundleType = RenderBundle;
         using RenderPassType = RenderPass;
         using SamplerType = Sampler;
         using ShaderModuleType = ShaderModule;
@@ -90,6 +93,11 @@ namespace null {
             Device();
             ~Device();
 
+            // The descriptor-based creation of the frontend is hidden by the overrides below.
+            using DeviceBase::CreateBuffer;
+            using DeviceBase::CreateSampler;
+            using DeviceBase::CreateTexture;
+
             BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
             BindGroupLayoutBase* CreateBindGroupLayout(BindGroupLayoutBuilder* builder) override;
             BufferBase* CreateBuffer(BufferBuilder* builder) override;
@@ -101,6 +109,7 @@ namespace null {
             PipelineBase* CreatePipeline(PipelineBuilder* builder) override;
             PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
             QueueBase* CreateQueue(QueueBuilder* builder) override;
+            RenderBundleBase* CreateRenderBundle(RenderBundleBuilder* builder) override;
             RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
             SamplerBase* CreateSampler(SamplerBuilder* builder) override;
             ShaderModuleBase* CreateShaderModule(ShaderModuleBuilder* builder) override;
@@ -109,11 +118,17 @@ namespace null {
 
             void TickImpl() override;
 
+            // Commands are executed when they are submitted so they are complete as soon as
+            // they get their serial.
+            Serial GetCompletedCommandSerial() override;
+            Serial NextSubmitSerial();
+
             void AddPendingOperation(std::unique_ptr<PendingOperation> operation);
             std::vector<std::unique_ptr<PendingOperation>> AcquirePendingOperations();
 
         private:
             std::vector<std::unique_ptr<PendingOperation>> pendingOperations;
+            Serial lastSubmittedSerial = 0;
     };
 
     class Buffer : public BufferBase {
@@ -21,7 +21,9 @@
 #include "backend/opengl/PipelineLayoutGL.h"
 #include "backend/opengl/SamplerGL.h"
 #include "backend/opengl/TextureGL.h"
+#include "common/Tracing.h"
 
+#include <array>
 #include <cstring>
 
 namespace backend {
@@ -54,40 +56,115 @@ namespace opengl {
         }
     }
 
+    static void ApplyBindGroup(Pipeline* pipeline, size_t index, BindGroup* group, const uint32_t* dynamicOffsets) {
+        const auto& indices = ToBackend(pipeline->GetLayout())->GetBindingIndexInfo()[index];
+        const auto& layout = group->GetLayout()->GetBindingInfo();
+        uint32_t dynamicIndex = 0;
+
+        // TODO(cwallez@chromium.org): iterate over the layout bitmask instead
+        for (size_t binding = 0; binding < kMaxBindingsPerGroup; ++binding) {
+            if (!layout.mask[binding]) {
+                continue;
+            }
+
+            switch (layout.types[binding]) {
+                case nxt::BindingType::UniformBuffer:
+                case nxt::BindingType::DynamicUniformBuffer:
+                    {
+                        BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
+                        GLuint buffer = ToBackend(view->GetBuffer())->GetHandle();
+                        GLuint index = indices[binding];
+
+                        GLintptr offset = view->GetOffset();
+                        if (layout.types[binding] == nxt::BindingType::DynamicUniformBuffer) {
+                            offset += dynamicOffsets[dynamicIndex++];
+                        }
+
+                        glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, view->GetSize());
+                    }
+                    break;
+
+                case nxt::BindingType::Sampler:
+                    {
+                        GLuint sampler = ToBackend(group->GetBindingAsSampler(binding))->GetHandle();
+                        GLuint index = indices[binding];
+
+                        for (auto unit : pipeline->GetTextureUnitsForSampler(index)) {
+                            glBindSampler(unit, sampler);
+                        }
+                    }
+                    break;
+
+                case nxt::BindingType::SampledTexture:
+                    {
+                        TextureView* view = ToBackend(group->GetBindingAsTextureView(binding));
+                        Texture* texture = ToBackend(view->GetTexture());
+                        GLuint handle = texture->GetHandle();
+                        GLenum target = texture->GetGLTarget();
+                        GLuint index = indices[binding];
+
+                        for (auto unit : pipeline->GetTextureUnitsForTexture(index)) {
+                            glActiveTexture(GL_TEXTURE0 + unit);
+                            glBindTexture(target, handle);
+                        }
+                    }
+                    break;
+
+                case nxt::BindingType::StorageBuffer:
+                    {
+                        BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
+                        GLuint buffer = ToBackend(view->GetBuffer())->GetHandle();
+                        GLuint index = indices[binding];
+
+                        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, buffer, view->GetOffset(), view->GetSize());
+                    }
+                    break;
+            }
+        }
+    }
+
     void CommandBuffer::Execute() {
+        NXT_TRACE_EVENT("backend", "CommandBuffer::Execute");
         Command type;
         Pipeline* lastPipeline = nullptr;
+        std::array<BindGroup*, kMaxBindGroups> bindGroups = {};
+        // Points in the commands, which outlive the execution.
+        std::array<const uint32_t*, kMaxBindGroups> bindGroupDynamicOffsets = {};
         uint32_t indexBufferOffset = 0;
         nxt::IndexFormat indexBufferFormat = nxt::IndexFormat::Uint16;
 
         PersistentPipelineState persistentPipelineState;
         persistentPipelineState.SetDefaultState();
 
-        while(commands.NextCommandId(&type)) {
+        // Command buffers can be submitted multiple times, always replay them from the start.
+        commands.Reset();
+        BundleReplayIterator iterator(&commands);
+
+        while(iterator.NextCommandId(&type)) {
             switch (type) {
                 case Command::BeginComputePass:
                     {
-                        commands.NextCommand<BeginComputePassCmd>();
+                        iterator.NextCommand<BeginComputePassCmd>();
                     }
                     break;
 
                 case Command::BeginRenderPass:
                     {
-                        commands.NextCommand<BeginRenderPassCmd>();
+                        iterator.NextCommand<BeginRenderPassCmd>();
                         // TODO(kainino@chromium.org): implement
                     }
                     break;
 
                 case Command::BeginRenderSubpass:
                     {
-                        commands.NextCommand<BeginRenderSubpassCmd>();
+                        iterator.NextCommand<BeginRenderSubpassCmd>();
                         // TODO(kainino@chromium.org): implement
                     }
                     break;
 
                 case Command::CopyBufferToBuffer:
                     {
-                        CopyBufferToBufferCmd* copy = commands.NextCommand<CopyBufferToBufferCmd>();
+                        CopyBufferToBufferCmd* copy = iterator.NextCommand<CopyBufferToBufferCmd>();
                         auto& src = copy->source;
                         auto& dst = copy->destination;
 
@@ -102,11 +179,11 @@ namespace opengl {
 
                 case Command::CopyBufferToTexture:
                     {
-                        CopyBufferToTextureCmd* copy = commands.NextCommand<CopyBufferToTextureCmd>();
+                        CopyBufferToTextureCmd* copy = iterator.NextCommand<CopyBufferToTextureCmd>();
                         auto& src = copy->source;
                         auto& dst = copy->destination;
-                        Buffer* buffer = ToBackend(src.buffer.Get());
-                        Texture* texture = ToBackend(dst.texture.Get());
+                        Buffer* buffer = ToBackend(src.buffer);
+                        Texture* texture = ToBackend(dst.texture);
                         GLenum target = texture->GetGLTarget();
                         auto format = texture->GetGLFormat();
 
@@ -123,14 +200,14 @@ namespace opengl {
 
                 case Command::CopyTextureToBuffer:
                     {
-                        commands.NextCommand<CopyTextureToBufferCmd>();
+                        iterator.NextCommand<CopyTextureToBufferCmd>();
                         // TODO(cwallez@chromium.org): implement using a temporary FBO and ReadPixels
                     }
                     break;
 
                 case Command::Dispatch:
                     {
-                        DispatchCmd* dispatch = commands.NextCommand<DispatchCmd>();
+                        DispatchCmd* dispatch = iterator.NextCommand<DispatchCmd>();
                         glDispatchCompute(dispatch->x, dispatch->y, dispatch->z);
                         // TODO(cwallez@chromium.org): add barriers to the API
                         glMemoryBarrier(GL_ALL_BARRIER_BITS);
@@ -139,7 +216,7 @@ namespace opengl {
 
                 case Command::DrawArrays:
                     {
-                        DrawArraysCmd* draw = commands.NextCommand<DrawArraysCmd>();
+                        DrawArraysCmd* draw = iterator.NextCommand<DrawArraysCmd>();
                         if (draw->firstInstance > 0) {
                             glDrawArraysInstancedBaseInstance(GL_TRIANGLES,
                                 draw->firstVertex, draw->vertexCount, draw->instanceCount, draw->firstInstance);
@@ -153,7 +230,7 @@ namespace opengl {
 
                 case Command::DrawElements:
                     {
-                        DrawElementsCmd* draw = commands.NextCommand<DrawElementsCmd>();
+                        DrawElementsCmd* draw = iterator.NextCommand<DrawElementsCmd>();
                         size_t formatSize = IndexFormatSize(indexBufferFormat);
                         GLenum formatType = IndexFormatType(indexBufferFormat);
 
@@ -174,36 +251,54 @@ namespace opengl {
 
                 case Command::EndComputePass:
                     {
-                        commands.NextCommand<EndComputePassCmd>();
+                        iterator.NextCommand<EndComputePassCmd>();
                     }
                     break;
 
                 case Command::EndRenderPass:
                     {
-                        commands.NextCommand<EndRenderPassCmd>();
+                        iterator.NextCommand<EndRenderPassCmd>();
                         // TODO(kainino@chromium.org): implement
                     }
                     break;
 
                 case Command::EndRenderSubpass:
                     {
-                        commands.NextCommand<EndRenderSubpassCmd>();
+                        iterator.NextCommand<EndRenderSubpassCmd>();
                         // TODO(kainino@chromium.org): implement
                     }
                     break;
 
+                case Command::ExecuteBundle:
+                    // The commands of bundles are replayed in place by the BundleReplayIterator.
+                    ASSERT(false);
+                    break;
+
                 case Command::SetPipeline:
                     {
-                        SetPipelineCmd* cmd = commands.NextCommand<SetPipelineCmd>();
-                        ToBackend(cmd->pipeline)->ApplyNow(persistentPipelineState);
-                        lastPipeline = ToBackend(cmd->pipeline).Get();
+                        SetPipelineCmd* cmd = iterator.NextCommand<SetPipelineCmd>();
+                        Pipeline* pipeline = ToBackend(cmd->pipeline);
+                        pipeline->ApplyNow(persistentPipelineState);
+
+                        // The bind groups compatible with the new layout aren't set again, but
+                        // the texture units they use depend on the pipeline so they are applied
+                        // again.
+                        uint32_t inheritedGroups = lastPipeline ? pipeline->GetLayout()->GroupsInheritedFrom(lastPipeline->GetLayout()) : 0;
+                        for (uint32_t i = 0; i < kMaxBindGroups; ++i) {
+                            if (i >= inheritedGroups) {
+                                bindGroups[i] = nullptr;
+                            } else if (bindGroups[i] != nullptr) {
+                                ApplyBindGroup(pipeline, i, bindGroups[i], bindGroupDynamicOffsets[i]);
+                            }
+                        }
+                        lastPipeline = pipeline;
                     }
                     break;
 
                 case Command::SetPushConstants:
                     {
-                        SetPushConstantsCmd* cmd = commands.NextCommand<SetPushConstantsCmd>();
-                        uint32_t* valuesUInt = commands.NextData<uint32_t>(cmd->count);
+                        SetPushConstantsCmd* cmd = iterator.NextCommand<SetPushConstantsCmd>();
+                        uint32_t* valuesUInt = iterator.NextData<uint32_t>(cmd->count);
                         int32_t* valuesInt = reinterpret_cast<int32_t*>(valuesUInt);
                         float* valuesFloat = reinterpret_cast<float*>(valuesUInt);
 
@@ -231,82 +326,26 @@ namespace opengl {
 
                 case Command::SetStencilReference:
                     {
-                        SetStencilReferenceCmd* cmd = commands.NextCommand<SetStencilReferenceCmd>();
+                        SetStencilReferenceCmd* cmd = iterator.NextCommand<SetStencilReferenceCmd>();
                         persistentPipelineState.SetStencilReference(cmd->reference);
                     }
                     break;
 
                 case Command::SetBindGroup:
                     {
-                        SetBindGroupCmd* cmd = commands.NextCommand<SetBindGroupCmd>();
-                        size_t index = cmd->index;
-                        BindGroup* group = ToBackend(cmd->group.Get());
-
-                        const auto& indices = ToBackend(lastPipeline->GetLayout())->GetBindingIndexInfo()[index];
-                        const auto& layout = group->GetLayout()->GetBindingInfo();
-
-                        // TODO(cwallez@chromium.org): iterate over the layout bitmask instead
-                        for (size_t binding = 0; binding < kMaxBindingsPerGroup; ++binding) {
-                            if (!layout.mask[binding]) {
-                                continue;
-                            }
-
-                            switch (layout.types[binding]) {
-                                case nxt::BindingType::UniformBuffer:
-                                    {
-                                        BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
-                                        GLuint buffer = ToBackend(view->GetBuffer())->GetHandle();
-                                        GLuint index = indices[binding];
-
-                                        glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, view->GetOffset(), view->GetSize());
-                                    }
-                                    break;
-
-                                case nxt::BindingType::Sampler:
-                                    {
-                                        GLuint sampler = ToBackend(group->GetBindingAsSampler(binding))->GetHandle();
-                                        GLuint index = indices[binding];
-
-                                        for (auto unit : lastPipeline->GetTextureUnitsForSampler(index)) {
-                                            glBindSampler(unit, sampler);
-                                        }
-                                    }
-                                    break;
-
-                                case nxt::BindingType::SampledTexture:
-                                    {
-                                        TextureView* view = ToBackend(group->GetBindingAsTextureView(binding));
-                                        Texture* texture = ToBackend(view->GetTexture());
-                                        GLuint handle = texture->GetHandle();
-                                        GLenum target = texture->GetGLTarget();
-                                        GLuint index = indices[binding];
-
-                                        for (auto unit : lastPipeline->GetTextureUnitsForTexture(index)) {
-                                            glActiveTexture(GL_TEXTURE0 + unit);
-                                            glBindTexture(target, handle);
-                                        }
-                                    }
-                                    break;
-
-                                case nxt::BindingType::StorageBuffer:
-                                    {
-                                        BufferView* view = ToBackend(group->GetBindingAsBufferView(binding));
-                                        GLuint buffer = ToBackend(view->GetBuffer())->GetHandle();
-                                        GLuint index = indices[binding];
-
-                                        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, buffer, view->GetOffset(), view->GetSize());
-                                    }
-                                    break;
-                            }
-                        }
+                        SetBindGroupCmd* cmd = iterator.NextCommand<SetBindGroupCmd>();
+                        uint32_t* dynamicOffsets = iterator.NextData<uint32_t>(cmd->dynamicOffsetCount);
+                        bindGroups[cmd->index] = ToBackend(cmd->group);
+                        bindGroupDynamicOffsets[cmd->index] = dynamicOffsets;
+                        ApplyBindGroup(lastPipeline, cmd->index, bindGroups[cmd->index], dynamicOffsets);
                     }
                     break;
 
                 case Command::SetIndexBuffer:
                     {
-                        SetIndexBufferCmd* cmd = commands.NextCommand<SetIndexBufferCmd>();
+                        SetIndexBufferCmd* cmd = iterator.NextCommand<SetIndexBufferCmd>();
 
-                        GLuint buffer = ToBackend(cmd->buffer.Get())->GetHandle();
+                        GLuint buffer = ToBackend(cmd->buffer)->GetHandle();
                         indexBufferOffset = cmd->offset;
                         indexBufferFormat = cmd->format;
                         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
@@ -315,9 +354,9 @@ namespace opengl {
 
                 case Command::SetVertexBuffers:
                     {
-                        SetVertexBuffersCmd* cmd = commands.NextCommand<SetVertexBuffersCmd>();
-                        auto buffers = commands.NextData<Ref<BufferBase>>(cmd->count);
-                        auto offsets = commands.NextData<uint32_t>(cmd->count);
+                        SetVertexBuffersCmd* cmd = iterator.NextCommand<SetVertexBuffersCmd>();
+                        auto buffers = iterator.NextData<BufferBase*>(cmd->count);
+                        auto offsets = iterator.NextData<uint32_t>(cmd->count);
 
                         auto inputState = lastPipeline->GetInputState();
 
@@ -354,7 +393,7 @@ namespace opengl {
 
                 case Command::TransitionBufferUsage:
                     {
-                        TransitionBufferUsageCmd* cmd = commands.NextCommand<TransitionBufferUsageCmd>();
+                        TransitionBufferUsageCmd* cmd = iterator.NextCommand<TransitionBufferUsageCmd>();
 
                         cmd->buffer->UpdateUsageInternal(cmd->usage);
                     }
@@ -362,7 +401,7 @@ namespace opengl {
 
                 case Command::TransitionTextureUsage:
                     {
-                        TransitionTextureUsageCmd* cmd = commands.NextCommand<TransitionTextureUsageCmd>();
+                        TransitionTextureUsageCmd* cmd = iterator.NextCommand<TransitionTextureUsageCmd>();
 
                         cmd->texture->UpdateUsageInternal(cmd->usage);
                     }
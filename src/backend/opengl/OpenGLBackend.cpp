@@ -21,6 +21,7 @@
 #include "backend/opengl/ShaderModuleGL.h"
 #include "backend/opengl/SamplerGL.h"
 #include "backend/opengl/TextureGL.h"
+#include "common/Tracing.h"
 
 namespace backend {
 namespace opengl {
@@ -81,6 +82,9 @@ namespace opengl {
     QueueBase* Device::CreateQueue(QueueBuilder* builder) {
         return new Queue(builder);
     }
+    RenderBundleBase* Device::CreateRenderBundle(RenderBundleBuilder* builder) {
+        return new RenderBundle(builder);
+    }
     RenderPassBase* Device::CreateRenderPass(RenderPassBuilder* builder) {
         return new RenderPass(builder);
     }
@@ -100,6 +104,14 @@ namespace opengl {
     void Device::TickImpl() {
     }
 
+    Serial Device::GetCompletedCommandSerial() {
+        return lastSubmittedSerial;
+    }
+
+    Serial Device::NextSubmitSerial() {
+        return ++lastSubmittedSerial;
+    }
+
     // Bind Group
 
     BindGroup::BindGroup(BindGroupBuilder* builder)
@@ -198,9 +210,17 @@ namespace opengl {
     }
 
     void Queue::Submit(uint32_t numCommands, CommandBuffer* const * commands) {
+        NXT_TRACE_EVENT("backend", "Queue::Submit");
+        Device* device = ToBackend(GetDevice());
+
         for (uint32_t i = 0; i < numCommands; ++i) {
             commands[i]->Execute();
         }
+
+        Serial serial = device->NextSubmitSerial();
+        for (uint32_t i = 0; i < numCommands; ++i) {
+            device->KeepAliveUntilSerial(commands[i], serial);
+        }
     }
 
     // RenderPass
@@ -25,6 +25,7 @@
 #include "backend/Framebuffer.h"
 #include "backend/InputState.h"
 #include "backend/Queue.h"
+#include "backend/RenderBundle.h"
 #include "backend/RenderPass.h"
 #include "backend/ToBackend.h"
 
@@ -50,6 +51,7 @@ namespace opengl {
     class Texture;
     class TextureView;
     class Framebuffer;
+    using RenderBundle = RenderBundleBase;
     class RenderPass;
 
     struct OpenGLBackendTraits {
@@ -69,6 +71,7 @@ namespace opengl {
         using TextureType = Texture;
         using TextureViewType = TextureView;
         using FramebufferType = Framebuffer;
+        using RenderBundleType = RenderBundle;
         using RenderPassType = RenderPass;
     };
 
@@ -80,6 +83,11 @@ namespace opengl {
     // Definition of backend types
     class Device : public DeviceBase {
         public:
+            // The descriptor-based creation of the frontend is hidden by the overrides below.
+            using DeviceBase::CreateBuffer;
+            using DeviceBase::CreateSampler;
+            using DeviceBase::CreateTexture;
+
             BindGroupBase* CreateBindGroup(BindGroupBuilder* builder) override;
             BindGroupLayoutBase* CreateBindGroupLayout(BindGroupLayoutBuilder* builder) override;
             BufferBase* CreateBuffer(BufferBuilder* builder) override;
@@ -91,6 +99,7 @@ namespace opengl {
             PipelineBase* CreatePipeline(PipelineBuilder* builder) override;
             PipelineLayoutBase* CreatePipelineLayout(PipelineLayoutBuilder* builder) override;
             QueueBase* CreateQueue(QueueBuilder* builder) override;
+            RenderBundleBase* CreateRenderBundle(RenderBundleBuilder* builder) override;
             RenderPassBase* CreateRenderPass(RenderPassBuilder* builder) override;
             SamplerBase* CreateSampler(SamplerBuilder* builder) override;
             ShaderModuleBase* CreateShaderModule(ShaderModuleBuilder* builder) override;
@@ -98,6 +107,14 @@ namespace opengl {
             TextureViewBase* CreateTextureView(TextureViewBuilder* builder) override;
 
             void TickImpl() override;
+
+            // The GL driver keeps its objects alive while they are used, so from the point of
+            // view of the frontend commands are complete as soon as they are submitted.
+            Serial GetCompletedCommandSerial() override;
+            Serial NextSubmitSerial();
+
+        private:
+            Serial lastSubmittedSerial = 0;
     };
 
     class BindGroup : public BindGroupBase {
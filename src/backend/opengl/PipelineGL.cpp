@@ -133,6 +133,7 @@ namespace opengl {
                 std::string name = GetBindingName(group, binding);
                 switch (groupInfo.types[binding]) {
                     case nxt::BindingType::UniformBuffer:
+                    case nxt::BindingType::DynamicUniformBuffer:
                         {
                             GLint location = glGetUniformBlockIndex(program, name.c_str());
                             glUniformBlockBinding(program, location, indices[group][binding]);
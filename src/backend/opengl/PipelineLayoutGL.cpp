@@ -36,6 +36,7 @@ namespace opengl {
 
                 switch (groupInfo.types[binding]) {
                     case nxt::BindingType::UniformBuffer:
+                    case nxt::BindingType::DynamicUniformBuffer:
                         indexInfo[group][binding] = uboIndex;
                         uboIndex ++;
                         break;
@@ -0,0 +1,222 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_FLATMAP_H_
+#define COMMON_FLATMAP_H_
+
+#include "common/Assert.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// A hash map storing its entries in a single array with open addressing and linear probing, so
+// that lookups touch contiguous memory and inserting doesn't allocate a node per entry. It has
+// the subset of std::unordered_map's interface that the frontend uses. Entries can't be erased
+// one by one, only all at once with clear(), which is what the caches of the frontend need.
+// Keys and values must be default-constructible.
+template<typename Key, typename Value, typename HashFunc = std::hash<Key>>
+class FlatMap {
+    public:
+        using value_type = std::pair<Key, Value>;
+
+        class Iterator {
+            public:
+                Iterator(FlatMap* map, size_t slot);
+                Iterator& operator++();
+
+                bool operator==(const Iterator& other) const;
+                bool operator!=(const Iterator& other) const;
+                value_type& operator*() const;
+                value_type* operator->() const;
+
+            private:
+                void SkipEmptySlots();
+
+                FlatMap* map;
+                size_t slot;
+        };
+
+        FlatMap();
+
+        size_t size() const;
+        bool empty() const;
+
+        Iterator begin();
+        Iterator end();
+        Iterator find(const Key& key);
+
+        // Returns the value for the key, inserting a default-constructed one if it wasn't there.
+        Value& operator[](const Key& key);
+
+        // Removes all the entries but keeps the memory for the next ones.
+        void clear();
+
+    private:
+        static constexpr size_t kMinCapacity = 8;
+
+        size_t FindSlot(const Key& key) const;
+        void Grow();
+
+        // The capacity is a power of two and the table is kept at most half full so that probe
+        // sequences stay short.
+        std::vector<value_type> entries;
+        std::vector<uint8_t> occupied;
+        size_t count = 0;
+};
+
+// FlatMap
+
+template<typename Key, typename Value, typename HashFunc>
+FlatMap<Key, Value, HashFunc>::FlatMap()
+    : entries(kMinCapacity), occupied(kMinCapacity, 0) {
+}
+
+template<typename Key, typename Value, typename HashFunc>
+size_t FlatMap<Key, Value, HashFunc>::size() const {
+    return count;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+bool FlatMap<Key, Value, HashFunc>::empty() const {
+    return count == 0;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::Iterator FlatMap<Key, Value, HashFunc>::begin() {
+    return {this, 0};
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::Iterator FlatMap<Key, Value, HashFunc>::end() {
+    return {this, entries.size()};
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::Iterator FlatMap<Key, Value, HashFunc>::find(const Key& key) {
+    size_t slot = FindSlot(key);
+    if (!occupied[slot]) {
+        return end();
+    }
+    return {this, slot};
+}
+
+template<typename Key, typename Value, typename HashFunc>
+Value& FlatMap<Key, Value, HashFunc>::operator[](const Key& key) {
+    size_t slot = FindSlot(key);
+    if (occupied[slot]) {
+        return entries[slot].second;
+    }
+
+    if (2 * (count + 1) > entries.size()) {
+        Grow();
+        slot = FindSlot(key);
+    }
+
+    entries[slot].first = key;
+    occupied[slot] = 1;
+    count++;
+    return entries[slot].second;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+void FlatMap<Key, Value, HashFunc>::clear() {
+    for (size_t slot = 0; slot < entries.size(); ++slot) {
+        if (occupied[slot]) {
+            entries[slot] = value_type();
+            occupied[slot] = 0;
+        }
+    }
+    count = 0;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+size_t FlatMap<Key, Value, HashFunc>::FindSlot(const Key& key) const {
+    // Returns the slot containing the key, or the empty slot where it would be inserted. There
+    // is always an empty slot because the table is at most half full.
+    // std::hash is the identity for integers on some platforms, mix the bits so that keys
+    // differing only in their high bits don't end up in the same probe sequence.
+    uint64_t hash = static_cast<uint64_t>(HashFunc()(key)) * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 32;
+
+    size_t mask = entries.size() - 1;
+    size_t slot = static_cast<size_t>(hash) & mask;
+    while (occupied[slot] && !(entries[slot].first == key)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+void FlatMap<Key, Value, HashFunc>::Grow() {
+    std::vector<value_type> oldEntries(entries.size() * 2);
+    std::vector<uint8_t> oldOccupied(entries.size() * 2, 0);
+    std::swap(oldEntries, entries);
+    std::swap(oldOccupied, occupied);
+
+    for (size_t slot = 0; slot < oldEntries.size(); ++slot) {
+        if (oldOccupied[slot]) {
+            size_t newSlot = FindSlot(oldEntries[slot].first);
+            entries[newSlot] = std::move(oldEntries[slot]);
+            occupied[newSlot] = 1;
+        }
+    }
+}
+
+// FlatMap::Iterator
+
+template<typename Key, typename Value, typename HashFunc>
+FlatMap<Key, Value, HashFunc>::Iterator::Iterator(FlatMap* map, size_t slot)
+    : map(map), slot(slot) {
+    SkipEmptySlots();
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::Iterator& FlatMap<Key, Value, HashFunc>::Iterator::operator++() {
+    slot++;
+    SkipEmptySlots();
+    return *this;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+bool FlatMap<Key, Value, HashFunc>::Iterator::operator==(const Iterator& other) const {
+    return map == other.map && slot == other.slot;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+bool FlatMap<Key, Value, HashFunc>::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::value_type& FlatMap<Key, Value, HashFunc>::Iterator::operator*() const {
+    NXT_ASSERT(slot < map->entries.size() && map->occupied[slot]);
+    return map->entries[slot];
+}
+
+template<typename Key, typename Value, typename HashFunc>
+typename FlatMap<Key, Value, HashFunc>::value_type* FlatMap<Key, Value, HashFunc>::Iterator::operator->() const {
+    return &**this;
+}
+
+template<typename Key, typename Value, typename HashFunc>
+void FlatMap<Key, Value, HashFunc>::Iterator::SkipEmptySlots() {
+    while (slot < map->entries.size() && !map->occupied[slot]) {
+        slot++;
+    }
+}
+
+#endif // COMMON_FLATMAP_H_
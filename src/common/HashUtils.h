@@ -0,0 +1,47 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_HASHUTILS_H_
+#define COMMON_HASHUTILS_H_
+
+#include <bitset>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+// TODO(cwallez@chromium.org): see if we can use boost's hash combined or some equivalent
+// this currently assumes that size_t is 64 bits
+inline void CombineHashes(size_t* h1, size_t h2) {
+    *h1 ^= (h2 << 7) + (h2 >> (64 - 7)) + 0x304975;
+}
+
+template<typename T>
+typename std::enable_if<!std::is_enum<T>::value, size_t>::type Hash(const T& value) {
+    return std::hash<T>()(value);
+}
+
+// Workaround for Chrome's stdlib having a broken std::hash for enums and bitsets
+template<typename T>
+typename std::enable_if<std::is_enum<T>::value, size_t>::type Hash(T value) {
+    using Integral = typename std::underlying_type<T>::type;
+    return std::hash<Integral>()(static_cast<Integral>(value));
+}
+
+template<size_t N>
+size_t Hash(const std::bitset<N>& value) {
+    static_assert(N <= sizeof(unsigned long long) * 8, "");
+    return std::hash<unsigned long long>()(value.to_ullong());
+}
+
+#endif // COMMON_HASHUTILS_H_
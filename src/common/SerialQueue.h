@@ -18,21 +18,29 @@
 #include "common/Assert.h"
 #include "common/Serial.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
+// A queue of values tagged with serials given in increasing order, used to defer work until the
+// GPU is done with a serial. The values are stored in a single ring buffer, and a side index
+// records where the values of each serial end, so enqueuing and clearing are amortized O(1) and
+// don't allocate once the queue has grown to its working size. Values are addressed by
+// "positions" that only ever increase: the position p is stored in the slot p & (capacity - 1).
 template<typename T>
 class SerialQueue {
     private:
-        using SerialPair = std::pair<Serial, std::vector<T>>;
-        using Storage = std::vector<SerialPair>;
-        using StorageIterator = typename Storage::iterator;
-        using ConstStorageIterator = typename Storage::const_iterator;
+        struct SerialRange {
+            Serial serial;
+            // The position after the last value of the serial
+            uint64_t end;
+        };
 
     public:
         class Iterator {
             public:
-                Iterator(StorageIterator start);
+                Iterator(T* values, uint64_t mask, uint64_t position);
                 Iterator& operator++();
 
                 bool operator==(const Iterator& other) const;
@@ -40,16 +48,14 @@ class SerialQueue {
                 T& operator*() const;
 
             private:
-                StorageIterator storageIterator;
-                // Special case the serialIterator when it should be equal to storageIterator.begin()
-                // otherwise we could ask storageIterator.begin() when storageIterator is storage.end()
-                // which is invalid. storageIterator.begin() is tagged with a nullptr.
-                T* serialIterator;
+                T* values;
+                uint64_t mask;
+                uint64_t position;
         };
 
         class ConstIterator {
             public:
-                ConstIterator(ConstStorageIterator start);
+                ConstIterator(const T* values, uint64_t mask, uint64_t position);
                 ConstIterator& operator++();
 
                 bool operator==(const ConstIterator& other) const;
@@ -57,32 +63,37 @@ class SerialQueue {
                 const T& operator*() const;
 
             private:
-                ConstStorageIterator storageIterator;
-                const T* serialIterator;
+                const T* values;
+                uint64_t mask;
+                uint64_t position;
         };
 
         class BeginEnd {
             public:
-                BeginEnd(StorageIterator start, StorageIterator end);
+                BeginEnd(T* values, uint64_t mask, uint64_t start, uint64_t end);
 
                 Iterator begin() const;
                 Iterator end() const;
 
             private:
-                StorageIterator startIt;
-                StorageIterator endIt;
+                T* values;
+                uint64_t mask;
+                uint64_t start;
+                uint64_t endPosition;
         };
 
         class ConstBeginEnd {
             public:
-                ConstBeginEnd(ConstStorageIterator start, ConstStorageIterator end);
+                ConstBeginEnd(const T* values, uint64_t mask, uint64_t start, uint64_t end);
 
                 ConstIterator begin() const;
                 ConstIterator end() const;
 
             private:
-                ConstStorageIterator startIt;
-                ConstStorageIterator endIt;
+                const T* values;
+                uint64_t mask;
+                uint64_t start;
+                uint64_t endPosition;
         };
 
         // The serial must be given in (not strictly) increasing order.
@@ -101,158 +112,200 @@ class SerialQueue {
         BeginEnd IterateAll();
         BeginEnd IterateUpTo(Serial serial);
 
+        // Clearing replaces the values by default-constructed ones so that resources they hold
+        // are released right away.
         void Clear();
         void ClearUpTo(Serial serial);
 
         Serial FirstSerial() const;
 
     private:
-        // Returns the first StorageIterator that a serial bigger than serial.
-        ConstStorageIterator FindUpTo(Serial serial) const;
-        StorageIterator FindUpTo(Serial serial);
-        Storage storage;
+        T& PrepareSlot(Serial serial);
+        void Grow();
+
+        // Returns the position after the last value associated to a serial smaller or equal to
+        // serial.
+        uint64_t FindEndUpTo(Serial serial) const;
+        void ClearPositionsUpTo(uint64_t end);
+
+        std::vector<T> storage;
+        uint64_t beginPosition = 0;
+        uint64_t endPosition = 0;
+
+        // The ranges before firstRange were cleared, they are removed from the vector once they
+        // make up half of it so that clearing stays amortized O(1).
+        std::vector<SerialRange> ranges;
+        size_t firstRange = 0;
 };
 
 // SerialQueue
 
 template<typename T>
 void SerialQueue<T>::Enqueue(const T& value, Serial serial) {
-    NXT_ASSERT(Empty() || storage.back().first <= serial);
-
-    if (Empty() || storage.back().first < serial) {
-        storage.emplace_back(SerialPair(serial, {}));
-    }
-    storage.back().second.emplace_back(value);
+    PrepareSlot(serial) = value;
 }
 
 template<typename T>
 void SerialQueue<T>::Enqueue(T&& value, Serial serial) {
-    NXT_ASSERT(Empty() || storage.back().first <= serial);
-
-    if (Empty() || storage.back().first < serial) {
-        storage.emplace_back(SerialPair(serial, {}));
-    }
-    storage.back().second.emplace_back(value);
+    PrepareSlot(serial) = std::move(value);
 }
 
 template<typename T>
 void SerialQueue<T>::Enqueue(const std::vector<T>& values, Serial serial) {
     NXT_ASSERT(values.size() > 0);
-    NXT_ASSERT(Empty() || storage.back().first <= serial);
-    storage.emplace_back(SerialPair(serial, {values}));
+    for (const T& value : values) {
+        PrepareSlot(serial) = value;
+    }
 }
 
 template<typename T>
 void SerialQueue<T>::Enqueue(std::vector<T>&& values, Serial serial) {
     NXT_ASSERT(values.size() > 0);
-    NXT_ASSERT(Empty() || storage.back().first <= serial);
-    storage.emplace_back(SerialPair(serial, {values}));
+    for (T& value : values) {
+        PrepareSlot(serial) = std::move(value);
+    }
 }
 
 template<typename T>
 bool SerialQueue<T>::Empty() const {
-    return storage.empty();
+    return beginPosition == endPosition;
 }
 
 template<typename T>
 typename SerialQueue<T>::ConstBeginEnd SerialQueue<T>::IterateAll() const {
-    return {storage.begin(), storage.end()};
+    return {storage.data(), storage.size() - 1, beginPosition, endPosition};
 }
 
 template<typename T>
 typename SerialQueue<T>::ConstBeginEnd SerialQueue<T>::IterateUpTo(Serial serial) const {
-    return {storage.begin(), FindUpTo(serial)};
+    return {storage.data(), storage.size() - 1, beginPosition, FindEndUpTo(serial)};
 }
 
 template<typename T>
 typename SerialQueue<T>::BeginEnd SerialQueue<T>::IterateAll() {
-    return {storage.begin(), storage.end()};
+    return {storage.data(), storage.size() - 1, beginPosition, endPosition};
 }
 
 template<typename T>
 typename SerialQueue<T>::BeginEnd SerialQueue<T>::IterateUpTo(Serial serial) {
-    return {storage.begin(), FindUpTo(serial)};
+    return {storage.data(), storage.size() - 1, beginPosition, FindEndUpTo(serial)};
 }
 
 template<typename T>
 void SerialQueue<T>::Clear() {
-    storage.clear();
+    ClearPositionsUpTo(endPosition);
+    ranges.clear();
+    firstRange = 0;
 }
 
 template<typename T>
 void SerialQueue<T>::ClearUpTo(Serial serial) {
-    storage.erase(storage.begin(), FindUpTo(serial));
+    auto rangesBegin = ranges.begin() + firstRange;
+    auto it = std::upper_bound(rangesBegin, ranges.end(), serial,
+                               [](Serial s, const SerialRange& range) { return s < range.serial; });
+    if (it == rangesBegin) {
+        return;
+    }
+
+    ClearPositionsUpTo((it - 1)->end);
+
+    firstRange = it - ranges.begin();
+    if (firstRange == ranges.size()) {
+        ranges.clear();
+        firstRange = 0;
+    } else if (2 * firstRange >= ranges.size()) {
+        ranges.erase(ranges.begin(), it);
+        firstRange = 0;
+    }
 }
 
 template<typename T>
 Serial SerialQueue<T>::FirstSerial() const {
     NXT_ASSERT(!Empty());
-    return storage.front().first;
+    return ranges[firstRange].serial;
+}
+
+template<typename T>
+T& SerialQueue<T>::PrepareSlot(Serial serial) {
+    NXT_ASSERT(ranges.empty() || ranges.back().serial <= serial);
+
+    if (endPosition - beginPosition == storage.size()) {
+        Grow();
+    }
+    uint64_t position = endPosition++;
+
+    if (ranges.empty() || ranges.back().serial < serial) {
+        ranges.push_back({serial, endPosition});
+    } else {
+        ranges.back().end = endPosition;
+    }
+
+    return storage[position & (storage.size() - 1)];
+}
+
+template<typename T>
+void SerialQueue<T>::Grow() {
+    // The capacity stays a power of two so that positions can be wrapped with a mask. Values keep
+    // their position, they are only moved to the slot it maps to in the larger storage.
+    size_t newCapacity = std::max(storage.size() * 2, size_t(16));
+    std::vector<T> newStorage(newCapacity);
+    for (uint64_t position = beginPosition; position < endPosition; ++position) {
+        newStorage[position & (newCapacity - 1)] = std::move(storage[position & (storage.size() - 1)]);
+    }
+    storage = std::move(newStorage);
 }
 
 template<typename T>
-typename SerialQueue<T>::ConstStorageIterator SerialQueue<T>::FindUpTo(Serial serial) const {
-    auto it = storage.begin();
-    while (it != storage.end() && it->first <= serial) {
-        it ++;
+uint64_t SerialQueue<T>::FindEndUpTo(Serial serial) const {
+    auto rangesBegin = ranges.begin() + firstRange;
+    auto it = std::upper_bound(rangesBegin, ranges.end(), serial,
+                               [](Serial s, const SerialRange& range) { return s < range.serial; });
+    if (it == rangesBegin) {
+        return beginPosition;
     }
-    return it;
+    return (it - 1)->end;
 }
 
 template<typename T>
-typename SerialQueue<T>::StorageIterator SerialQueue<T>::FindUpTo(Serial serial) {
-    auto it = storage.begin();
-    while (it != storage.end() && it->first <= serial) {
-        it ++;
+void SerialQueue<T>::ClearPositionsUpTo(uint64_t end) {
+    for (; beginPosition < end; ++beginPosition) {
+        storage[beginPosition & (storage.size() - 1)] = T();
     }
-    return it;
 }
 
 // SerialQueue::BeginEnd
 
 template<typename T>
-SerialQueue<T>::BeginEnd::BeginEnd(typename SerialQueue<T>::StorageIterator start, typename SerialQueue<T>::StorageIterator end)
-    : startIt(start), endIt(end) {
+SerialQueue<T>::BeginEnd::BeginEnd(T* values, uint64_t mask, uint64_t start, uint64_t end)
+    : values(values), mask(mask), start(start), endPosition(end) {
 }
 
 template<typename T>
 typename SerialQueue<T>::Iterator SerialQueue<T>::BeginEnd::begin() const {
-    return {startIt};
+    return {values, mask, start};
 }
 
 template<typename T>
 typename SerialQueue<T>::Iterator SerialQueue<T>::BeginEnd::end() const {
-    return {endIt};
+    return {values, mask, endPosition};
 }
 
 // SerialQueue::Iterator
 
 template<typename T>
-SerialQueue<T>::Iterator::Iterator(typename SerialQueue<T>::StorageIterator start)
-    : storageIterator(start), serialIterator(nullptr) {
+SerialQueue<T>::Iterator::Iterator(T* values, uint64_t mask, uint64_t position)
+    : values(values), mask(mask), position(position) {
 }
 
 template<typename T>
 typename SerialQueue<T>::Iterator& SerialQueue<T>::Iterator::operator++() {
-    T* vectorData = storageIterator->second.data();
-
-    if (serialIterator == nullptr) {
-        serialIterator = vectorData + 1;
-    } else {
-        serialIterator ++;
-    }
-
-    if (serialIterator >= vectorData + storageIterator->second.size()) {
-        serialIterator = nullptr;
-        storageIterator ++;
-    }
-
+    position ++;
     return *this;
 }
 
 template<typename T>
 bool SerialQueue<T>::Iterator::operator==(const typename SerialQueue<T>::Iterator& other) const {
-    return other.storageIterator == storageIterator && other.serialIterator == serialIterator;
+    return other.position == position;
 }
 
 template<typename T>
@@ -262,57 +315,42 @@ bool SerialQueue<T>::Iterator::operator!=(const typename SerialQueue<T>::Iterato
 
 template<typename T>
 T& SerialQueue<T>::Iterator::operator*() const {
-    if (serialIterator == nullptr) {
-        return *storageIterator->second.begin();
-    }
-    return *serialIterator;
+    return values[position & mask];
 }
 
 // SerialQueue::ConstBeginEnd
 
 template<typename T>
-SerialQueue<T>::ConstBeginEnd::ConstBeginEnd(typename SerialQueue<T>::ConstStorageIterator start, typename SerialQueue<T>::ConstStorageIterator end)
-    : startIt(start), endIt(end) {
+SerialQueue<T>::ConstBeginEnd::ConstBeginEnd(const T* values, uint64_t mask, uint64_t start, uint64_t end)
+    : values(values), mask(mask), start(start), endPosition(end) {
 }
 
 template<typename T>
 typename SerialQueue<T>::ConstIterator SerialQueue<T>::ConstBeginEnd::begin() const {
-    return {startIt};
+    return {values, mask, start};
 }
 
 template<typename T>
 typename SerialQueue<T>::ConstIterator SerialQueue<T>::ConstBeginEnd::end() const {
-    return {endIt};
+    return {values, mask, endPosition};
 }
 
 // SerialQueue::ConstIterator
 
 template<typename T>
-SerialQueue<T>::ConstIterator::ConstIterator(typename SerialQueue<T>::ConstStorageIterator start)
-    : storageIterator(start), serialIterator(nullptr) {
+SerialQueue<T>::ConstIterator::ConstIterator(const T* values, uint64_t mask, uint64_t position)
+    : values(values), mask(mask), position(position) {
 }
 
 template<typename T>
 typename SerialQueue<T>::ConstIterator& SerialQueue<T>::ConstIterator::operator++() {
-    const T* vectorData = storageIterator->second.data();
-
-    if (serialIterator == nullptr) {
-        serialIterator = vectorData + 1;
-    } else {
-        serialIterator ++;
-    }
-
-    if (serialIterator >= vectorData + storageIterator->second.size()) {
-        serialIterator = nullptr;
-        storageIterator ++;
-    }
-
+    position ++;
     return *this;
 }
 
 template<typename T>
 bool SerialQueue<T>::ConstIterator::operator==(const typename SerialQueue<T>::ConstIterator& other) const {
-    return other.storageIterator == storageIterator && other.serialIterator == serialIterator;
+    return other.position == position;
 }
 
 template<typename T>
@@ -322,10 +360,7 @@ bool SerialQueue<T>::ConstIterator::operator!=(const typename SerialQueue<T>::Co
 
 template<typename T>
 const T& SerialQueue<T>::ConstIterator::operator*() const {
-    if (serialIterator == nullptr) {
-        return *storageIterator->second.begin();
-    }
-    return *serialIterator;
+    return values[position & mask];
 }
 
 #endif // COMMON_SERIALQUEUE_H_
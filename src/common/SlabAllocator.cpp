@@ -0,0 +1,91 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/SlabAllocator.h"
+
+#include "common/Assert.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    size_t RoundUpBlockSize(size_t size) {
+        constexpr size_t kAlignment = alignof(std::max_align_t);
+        size = std::max(size, sizeof(void*));
+        return (size + kAlignment - 1) / kAlignment * kAlignment;
+    }
+}
+
+SlabAllocator::SlabAllocator(size_t blockSize, size_t blocksPerSlab)
+    : blockSize(RoundUpBlockSize(blockSize)), blocksPerSlab(blocksPerSlab) {
+    ASSERT(blocksPerSlab > 0);
+}
+
+SlabAllocator::~SlabAllocator() {
+    ASSERT(blocksInUse == 0);
+    for (uint8_t* slab : slabs) {
+        free(slab);
+    }
+}
+
+void* SlabAllocator::Allocate() {
+    if (freeList == nullptr) {
+        AllocateSlab();
+        if (freeList == nullptr) {
+            return nullptr;
+        }
+    }
+
+    FreeBlock* block = freeList;
+    freeList = block->next;
+    blocksInUse++;
+    return block;
+}
+
+void SlabAllocator::Deallocate(void* block) {
+    ASSERT(block != nullptr);
+    ASSERT(blocksInUse > 0);
+
+    FreeBlock* freeBlock = reinterpret_cast<FreeBlock*>(block);
+    freeBlock->next = freeList;
+    freeList = freeBlock;
+    blocksInUse--;
+}
+
+size_t SlabAllocator::GetBlockSize() const {
+    return blockSize;
+}
+
+size_t SlabAllocator::GetSlabCount() const {
+    return slabs.size();
+}
+
+size_t SlabAllocator::GetBlocksInUse() const {
+    return blocksInUse;
+}
+
+void SlabAllocator::AllocateSlab() {
+    uint8_t* slab = reinterpret_cast<uint8_t*>(malloc(blockSize * blocksPerSlab));
+    if (slab == nullptr) {
+        return;
+    }
+    slabs.push_back(slab);
+
+    // Thread the blocks of the slab in the free list so that they are handed out in order.
+    for (size_t i = blocksPerSlab; i > 0; --i) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockSize);
+        block->next = freeList;
+        freeList = block;
+    }
+}
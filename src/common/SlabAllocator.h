@@ -0,0 +1,56 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_SLABALLOCATOR_H_
+#define COMMON_SLABALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hands out blocks of a fixed size that are carved out of larger slabs of memory. Freed blocks
+// are kept in an intrusive free list and are the first to be reused, so allocating and freeing
+// objects of the same size over and over doesn't touch malloc and doesn't fragment the heap.
+// Slabs are only freed when the allocator is destroyed. This class isn't thread-safe.
+class SlabAllocator {
+    public:
+        // The block size is rounded up so that all blocks are aligned like malloc's allocations.
+        SlabAllocator(size_t blockSize, size_t blocksPerSlab);
+        ~SlabAllocator();
+
+        SlabAllocator(const SlabAllocator&) = delete;
+        SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+        void* Allocate();
+        void Deallocate(void* block);
+
+        size_t GetBlockSize() const;
+        size_t GetSlabCount() const;
+        size_t GetBlocksInUse() const;
+
+    private:
+        void AllocateSlab();
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        size_t blockSize;
+        size_t blocksPerSlab;
+        size_t blocksInUse = 0;
+        FreeBlock* freeList = nullptr;
+        std::vector<uint8_t*> slabs;
+};
+
+#endif // COMMON_SLABALLOCATOR_H_
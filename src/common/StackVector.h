@@ -0,0 +1,317 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_STACKVECTOR_H_
+#define COMMON_STACKVECTOR_H_
+
+#include "common/Assert.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A vector that stores up to N elements inline, and only allocates on the heap when it grows
+// past that. It is meant for the small arrays whose size is usually bounded by the limits in
+// Constants.h but that aren't strictly capped, like the attachments of a render pass. It has the
+// subset of std::vector's interface that the frontend uses so that it can replace it directly.
+template<typename T, size_t N>
+class StackVector {
+    static_assert(N > 0, "StackVector needs inline storage");
+
+    public:
+        StackVector();
+        explicit StackVector(size_t size);
+        StackVector(const StackVector& other);
+        StackVector(StackVector&& other);
+        StackVector& operator=(const StackVector& other);
+        StackVector& operator=(StackVector&& other);
+        ~StackVector();
+
+        size_t size() const;
+        size_t capacity() const;
+        bool empty() const;
+
+        // Whether the elements are still stored inline.
+        bool IsInline() const;
+
+        T* data();
+        const T* data() const;
+        T* begin();
+        const T* begin() const;
+        T* end();
+        const T* end() const;
+
+        T& operator[](size_t i);
+        const T& operator[](size_t i) const;
+        T& back();
+        const T& back() const;
+
+        void push_back(const T& value);
+        void push_back(T&& value);
+        void pop_back();
+
+        // New elements are value-initialized like with std::vector.
+        void resize(size_t newSize);
+        void reserve(size_t newCapacity);
+        void clear();
+
+    private:
+        T* InlineStorage();
+        void MoveFrom(StackVector&& other);
+        void Grow(size_t minimumCapacity);
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type inlineStorage[N];
+        T* elements;
+        size_t count = 0;
+        size_t allocated = N;
+};
+
+template<typename T, size_t N>
+StackVector<T, N>::StackVector() : elements(InlineStorage()) {
+}
+
+template<typename T, size_t N>
+StackVector<T, N>::StackVector(size_t size) : elements(InlineStorage()) {
+    resize(size);
+}
+
+template<typename T, size_t N>
+StackVector<T, N>::StackVector(const StackVector& other) : elements(InlineStorage()) {
+    reserve(other.count);
+    for (const T& value : other) {
+        push_back(value);
+    }
+}
+
+template<typename T, size_t N>
+StackVector<T, N>::StackVector(StackVector&& other) : elements(InlineStorage()) {
+    MoveFrom(std::move(other));
+}
+
+template<typename T, size_t N>
+StackVector<T, N>& StackVector<T, N>::operator=(const StackVector& other) {
+    if (&other != this) {
+        clear();
+        reserve(other.count);
+        for (const T& value : other) {
+            push_back(value);
+        }
+    }
+    return *this;
+}
+
+template<typename T, size_t N>
+StackVector<T, N>& StackVector<T, N>::operator=(StackVector&& other) {
+    if (&other != this) {
+        clear();
+        MoveFrom(std::move(other));
+    }
+    return *this;
+}
+
+template<typename T, size_t N>
+StackVector<T, N>::~StackVector() {
+    clear();
+    if (!IsInline()) {
+        free(elements);
+    }
+}
+
+template<typename T, size_t N>
+size_t StackVector<T, N>::size() const {
+    return count;
+}
+
+template<typename T, size_t N>
+size_t StackVector<T, N>::capacity() const {
+    return allocated;
+}
+
+template<typename T, size_t N>
+bool StackVector<T, N>::empty() const {
+    return count == 0;
+}
+
+template<typename T, size_t N>
+bool StackVector<T, N>::IsInline() const {
+    return elements == reinterpret_cast<const T*>(inlineStorage);
+}
+
+template<typename T, size_t N>
+T* StackVector<T, N>::data() {
+    return elements;
+}
+
+template<typename T, size_t N>
+const T* StackVector<T, N>::data() const {
+    return elements;
+}
+
+template<typename T, size_t N>
+T* StackVector<T, N>::begin() {
+    return elements;
+}
+
+template<typename T, size_t N>
+const T* StackVector<T, N>::begin() const {
+    return elements;
+}
+
+template<typename T, size_t N>
+T* StackVector<T, N>::end() {
+    return elements + count;
+}
+
+template<typename T, size_t N>
+const T* StackVector<T, N>::end() const {
+    return elements + count;
+}
+
+template<typename T, size_t N>
+T& StackVector<T, N>::operator[](size_t i) {
+    NXT_ASSERT(i < count);
+    return elements[i];
+}
+
+template<typename T, size_t N>
+const T& StackVector<T, N>::operator[](size_t i) const {
+    NXT_ASSERT(i < count);
+    return elements[i];
+}
+
+template<typename T, size_t N>
+T& StackVector<T, N>::back() {
+    NXT_ASSERT(count > 0);
+    return elements[count - 1];
+}
+
+template<typename T, size_t N>
+const T& StackVector<T, N>::back() const {
+    NXT_ASSERT(count > 0);
+    return elements[count - 1];
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::push_back(const T& value) {
+    if (count == allocated) {
+        // The value could be an element of this vector, copy it before growing.
+        T copy(value);
+        Grow(count + 1);
+        new (&elements[count]) T(std::move(copy));
+    } else {
+        new (&elements[count]) T(value);
+    }
+    count++;
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::push_back(T&& value) {
+    if (count == allocated) {
+        T moved(std::move(value));
+        Grow(count + 1);
+        new (&elements[count]) T(std::move(moved));
+    } else {
+        new (&elements[count]) T(std::move(value));
+    }
+    count++;
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::pop_back() {
+    NXT_ASSERT(count > 0);
+    count--;
+    elements[count].~T();
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::resize(size_t newSize) {
+    reserve(newSize);
+    while (count > newSize) {
+        pop_back();
+    }
+    for (; count < newSize; ++count) {
+        new (&elements[count]) T();
+    }
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::reserve(size_t newCapacity) {
+    if (newCapacity > allocated) {
+        Grow(newCapacity);
+    }
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::clear() {
+    while (count > 0) {
+        pop_back();
+    }
+}
+
+template<typename T, size_t N>
+T* StackVector<T, N>::InlineStorage() {
+    return reinterpret_cast<T*>(inlineStorage);
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::MoveFrom(StackVector&& other) {
+    NXT_ASSERT(count == 0);
+
+    // Heap storage can be stolen, inline elements have to be moved one by one.
+    if (!other.IsInline()) {
+        if (!IsInline()) {
+            free(elements);
+        }
+        elements = other.elements;
+        allocated = other.allocated;
+        count = other.count;
+
+        other.elements = other.InlineStorage();
+        other.allocated = N;
+        other.count = 0;
+        return;
+    }
+
+    for (T& value : other) {
+        push_back(std::move(value));
+    }
+    other.clear();
+}
+
+template<typename T, size_t N>
+void StackVector<T, N>::Grow(size_t minimumCapacity) {
+    size_t newCapacity = allocated * 2;
+    if (newCapacity < minimumCapacity) {
+        newCapacity = minimumCapacity;
+    }
+
+    T* newElements = reinterpret_cast<T*>(malloc(newCapacity * sizeof(T)));
+    if (newElements == nullptr) {
+        throw std::bad_alloc();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        new (&newElements[i]) T(std::move(elements[i]));
+        elements[i].~T();
+    }
+
+    if (!IsInline()) {
+        free(elements);
+    }
+    elements = newElements;
+    allocated = newCapacity;
+}
+
+#endif // COMMON_STACKVECTOR_H_
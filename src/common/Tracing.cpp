@@ -0,0 +1,160 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/Tracing.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace tracing {
+
+    namespace {
+
+        // The recorded events, in a ring buffer that overwrites the oldest events when full.
+        struct Recording {
+            std::mutex mutex;
+            std::vector<TraceEvent> events;
+            size_t nextEvent = 0;
+            bool wrapped = false;
+        };
+
+        Recording* GetRecording() {
+            // Never deleted so that events can be recorded during static destruction.
+            static Recording* recording = new Recording;
+            return recording;
+        }
+
+        // Chrome's viewer shows one track per thread id, small ids make the JSON more readable
+        // than hashes of std::thread::id.
+        uint32_t GetThreadId() {
+            static std::atomic<uint32_t> nextThreadId{1};
+            thread_local uint32_t threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+            return threadId;
+        }
+
+        void AppendEscaped(std::string* out, const char* string) {
+            for (const char* c = string; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    out->push_back('\\');
+                }
+                out->push_back(*c);
+            }
+        }
+
+    }
+
+    namespace detail {
+        std::atomic<bool> enabled{false};
+
+        uint64_t Now() {
+            using Clock = std::chrono::steady_clock;
+            static const Clock::time_point origin = Clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+        }
+
+        void RecordEvent(const char* category, const char* name, uint64_t begin, uint64_t end) {
+            TraceEvent event = {category, name, GetThreadId(), begin, end - begin};
+
+            Recording* recording = GetRecording();
+            std::lock_guard<std::mutex> lock(recording->mutex);
+            // Events whose scope ends after Disable are dropped.
+            if (!IsEnabled() || recording->events.empty()) {
+                return;
+            }
+
+            recording->events[recording->nextEvent] = event;
+            recording->nextEvent++;
+            if (recording->nextEvent == recording->events.size()) {
+                recording->nextEvent = 0;
+                recording->wrapped = true;
+            }
+        }
+    }
+
+    void Enable(size_t capacity) {
+        Recording* recording = GetRecording();
+        {
+            std::lock_guard<std::mutex> lock(recording->mutex);
+            recording->events.assign(capacity, TraceEvent());
+            recording->nextEvent = 0;
+            recording->wrapped = false;
+        }
+        detail::enabled.store(capacity > 0, std::memory_order_relaxed);
+    }
+
+    void Disable() {
+        detail::enabled.store(false, std::memory_order_relaxed);
+    }
+
+    std::vector<TraceEvent> GetEvents() {
+        Recording* recording = GetRecording();
+        std::lock_guard<std::mutex> lock(recording->mutex);
+
+        std::vector<TraceEvent> result;
+        if (recording->wrapped) {
+            result.insert(result.end(), recording->events.begin() + recording->nextEvent,
+                          recording->events.end());
+        }
+        result.insert(result.end(), recording->events.begin(),
+                      recording->events.begin() + recording->nextEvent);
+        return result;
+    }
+
+    std::string GetEventsAsJSON() {
+        std::string json = "{\"traceEvents\": [";
+
+        bool first = true;
+        char buffer[128];
+        for (const TraceEvent& event : GetEvents()) {
+            json += first ? "\n" : ",\n";
+            first = false;
+
+            json += "{\"cat\": \"";
+            AppendEscaped(&json, event.category);
+            json += "\", \"name\": \"";
+            AppendEscaped(&json, event.name);
+
+            // Complete events with timestamps and durations in microseconds.
+            snprintf(buffer, sizeof(buffer),
+                     "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %" PRIu32 ", \"ts\": %.3f, \"dur\": %.3f}",
+                     event.threadId, event.beginNanoseconds / 1000.0,
+                     event.durationNanoseconds / 1000.0);
+            json += buffer;
+        }
+
+        json += "\n]}\n";
+        return json;
+    }
+
+    bool WriteEventsAsJSON(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        std::string json = GetEventsAsJSON();
+        bool success = fwrite(json.data(), 1, json.size(), file) == json.size();
+        return fclose(file) == 0 && success;
+    }
+
+    void ClearEvents() {
+        Recording* recording = GetRecording();
+        std::lock_guard<std::mutex> lock(recording->mutex);
+        recording->nextEvent = 0;
+        recording->wrapped = false;
+    }
+
+}
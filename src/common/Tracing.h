@@ -0,0 +1,108 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_TRACING_H_
+#define COMMON_TRACING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped trace events that show where time goes inside NXT. Mark a scope with
+//
+//     NXT_TRACE_EVENT("backend", "CommandBuffer::Execute");
+//
+// and the time spent until the end of the scope is recorded with the thread it happened on. The
+// category and name must be string literals, or strings that outlive the recording.
+//
+// Recording is off by default. When it is off, an event costs a relaxed atomic load and a branch.
+// When NXT_ENABLE_TRACING isn't defined, the macro compiles to nothing. Once enabled, events are
+// written into a ring buffer, so a long session keeps only its most recent events. The buffer
+// can be dumped in Chrome's trace_event JSON format, which chrome://tracing loads directly.
+namespace tracing {
+
+    struct TraceEvent {
+        const char* category;
+        const char* name;
+        uint32_t threadId;
+        // Relative to an arbitrary point that is the same for all the events of the process.
+        uint64_t beginNanoseconds;
+        uint64_t durationNanoseconds;
+    };
+
+    static constexpr size_t kDefaultEventCapacity = 65536;
+
+    // Enabling starts a new recording, with room for capacity events. Events are only recorded
+    // when tracing is enabled both when their scope begins and when it ends.
+    void Enable(size_t capacity = kDefaultEventCapacity);
+    void Disable();
+
+    // The recorded events, from the oldest to the most recent one. Events are recorded when
+    // their scope ends, so an event appears after the events nested in it.
+    std::vector<TraceEvent> GetEvents();
+    std::string GetEventsAsJSON();
+    bool WriteEventsAsJSON(const char* path);
+    void ClearEvents();
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+
+        uint64_t Now();
+        void RecordEvent(const char* category, const char* name, uint64_t begin, uint64_t end);
+    }
+
+    inline bool IsEnabled() {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    class ScopedEvent {
+        public:
+            ScopedEvent(const char* category, const char* name) {
+                if (IsEnabled()) {
+                    this->category = category;
+                    this->name = name;
+                    begin = detail::Now();
+                }
+            }
+
+            ~ScopedEvent() {
+                if (name != nullptr) {
+                    detail::RecordEvent(category, name, begin, detail::Now());
+                }
+            }
+
+            ScopedEvent(const ScopedEvent&) = delete;
+            ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+        private:
+            const char* category = nullptr;
+            const char* name = nullptr;
+            uint64_t begin = 0;
+    };
+
+}
+
+#define NXT_TRACE_CONCAT_INNER(a, b) a##b
+#define NXT_TRACE_CONCAT(a, b) NXT_TRACE_CONCAT_INNER(a, b)
+
+#if defined(NXT_ENABLE_TRACING)
+    #define NXT_TRACE_EVENT(category, name) \
+        tracing::ScopedEvent NXT_TRACE_CONCAT(nxtTraceEvent, __LINE__)(category, name)
+#else
+    #define NXT_TRACE_EVENT(category, name)
+#endif
+
+#endif // COMMON_TRACING_H_
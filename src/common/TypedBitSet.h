@@ -0,0 +1,284 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMON_TYPEDBITSET_H_
+#define COMMON_TYPEDBITSET_H_
+
+#include "common/Assert.h"
+#include "common/Math.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// A bitset indexed by an enum or integer type instead of size_t, so that the bits of different
+// kinds of indices can't be mixed up. Iterating over the set bits with IterateBitSet skips whole
+// words at a time and finds each bit with a single bit scan, unlike BitSetIterator that has to
+// go through std::bitset's interface.
+template<typename Index, size_t N>
+class TypedBitSet {
+    private:
+        static constexpr size_t kBitsPerWord = 32;
+        static constexpr size_t kWordCount = (N + kBitsPerWord - 1) / kBitsPerWord;
+        using Words = std::array<uint32_t, kWordCount>;
+
+    public:
+        class Iterator {
+            public:
+                Iterator(const Words& words, size_t wordIndex);
+                Iterator& operator++();
+
+                bool operator==(const Iterator& other) const;
+                bool operator!=(const Iterator& other) const;
+                Index operator*() const;
+
+            private:
+                void SkipEmptyWords();
+
+                const Words* words;
+                size_t wordIndex;
+                // The bits of the current word that haven't been visited yet.
+                uint32_t remainingBits;
+        };
+
+        class BeginEnd {
+            public:
+                BeginEnd(const Words& words);
+
+                Iterator begin() const;
+                Iterator end() const;
+
+            private:
+                const Words& words;
+        };
+
+        TypedBitSet();
+
+        bool operator[](Index index) const;
+        bool test(Index index) const;
+        void set(Index index, bool value = true);
+        void reset(Index index);
+        void reset();
+
+        bool any() const;
+        bool none() const;
+        bool all() const;
+        size_t count() const;
+        size_t size() const;
+
+        bool operator==(const TypedBitSet& other) const;
+        bool operator!=(const TypedBitSet& other) const;
+        TypedBitSet& operator&=(const TypedBitSet& other);
+        TypedBitSet& operator|=(const TypedBitSet& other);
+
+        BeginEnd Iterate() const;
+
+    private:
+        static size_t ToBit(Index index);
+        // The bits of the last word that are part of the set
+        static constexpr uint32_t LastWordMask();
+
+        Words words;
+};
+
+template<typename Index, size_t N>
+typename TypedBitSet<Index, N>::BeginEnd IterateBitSet(const TypedBitSet<Index, N>& bitset) {
+    return bitset.Iterate();
+}
+
+// TypedBitSet
+
+template<typename Index, size_t N>
+TypedBitSet<Index, N>::TypedBitSet() {
+    words.fill(0);
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::operator[](Index index) const {
+    return test(index);
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::test(Index index) const {
+    size_t bit = ToBit(index);
+    return ((words[bit / kBitsPerWord] >> (bit % kBitsPerWord)) & 1) != 0;
+}
+
+template<typename Index, size_t N>
+void TypedBitSet<Index, N>::set(Index index, bool value) {
+    size_t bit = ToBit(index);
+    uint32_t mask = uint32_t(1) << (bit % kBitsPerWord);
+    if (value) {
+        words[bit / kBitsPerWord] |= mask;
+    } else {
+        words[bit / kBitsPerWord] &= ~mask;
+    }
+}
+
+template<typename Index, size_t N>
+void TypedBitSet<Index, N>::reset(Index index) {
+    set(index, false);
+}
+
+template<typename Index, size_t N>
+void TypedBitSet<Index, N>::reset() {
+    words.fill(0);
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::any() const {
+    for (uint32_t word : words) {
+        if (word != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::none() const {
+    return !any();
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::all() const {
+    for (size_t i = 0; i + 1 < kWordCount; ++i) {
+        if (words[i] != ~uint32_t(0)) {
+            return false;
+        }
+    }
+    return words[kWordCount - 1] == LastWordMask();
+}
+
+template<typename Index, size_t N>
+size_t TypedBitSet<Index, N>::count() const {
+    size_t result = 0;
+    for (uint32_t word : words) {
+        for (; word != 0; word &= word - 1) {
+            result++;
+        }
+    }
+    return result;
+}
+
+template<typename Index, size_t N>
+size_t TypedBitSet<Index, N>::size() const {
+    return N;
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::operator==(const TypedBitSet& other) const {
+    return words == other.words;
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::operator!=(const TypedBitSet& other) const {
+    return words != other.words;
+}
+
+template<typename Index, size_t N>
+TypedBitSet<Index, N>& TypedBitSet<Index, N>::operator&=(const TypedBitSet& other) {
+    for (size_t i = 0; i < kWordCount; ++i) {
+        words[i] &= other.words[i];
+    }
+    return *this;
+}
+
+template<typename Index, size_t N>
+TypedBitSet<Index, N>& TypedBitSet<Index, N>::operator|=(const TypedBitSet& other) {
+    for (size_t i = 0; i < kWordCount; ++i) {
+        words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+template<typename Index, size_t N>
+typename TypedBitSet<Index, N>::BeginEnd TypedBitSet<Index, N>::Iterate() const {
+    return {words};
+}
+
+template<typename Index, size_t N>
+size_t TypedBitSet<Index, N>::ToBit(Index index) {
+    size_t bit = static_cast<size_t>(index);
+    NXT_ASSERT(bit < N);
+    return bit;
+}
+
+template<typename Index, size_t N>
+constexpr uint32_t TypedBitSet<Index, N>::LastWordMask() {
+    return N % kBitsPerWord == 0 ? ~uint32_t(0) : (uint32_t(1) << (N % kBitsPerWord)) - 1;
+}
+
+// TypedBitSet::BeginEnd
+
+template<typename Index, size_t N>
+TypedBitSet<Index, N>::BeginEnd::BeginEnd(const Words& words)
+    : words(words) {
+}
+
+template<typename Index, size_t N>
+typename TypedBitSet<Index, N>::Iterator TypedBitSet<Index, N>::BeginEnd::begin() const {
+    return {words, 0};
+}
+
+template<typename Index, size_t N>
+typename TypedBitSet<Index, N>::Iterator TypedBitSet<Index, N>::BeginEnd::end() const {
+    return {words, kWordCount};
+}
+
+// TypedBitSet::Iterator
+
+template<typename Index, size_t N>
+TypedBitSet<Index, N>::Iterator::Iterator(const Words& words, size_t wordIndex)
+    : words(&words), wordIndex(wordIndex), remainingBits(0) {
+    if (wordIndex < kWordCount) {
+        remainingBits = words[wordIndex];
+        SkipEmptyWords();
+    }
+}
+
+template<typename Index, size_t N>
+typename TypedBitSet<Index, N>::Iterator& TypedBitSet<Index, N>::Iterator::operator++() {
+    NXT_ASSERT(remainingBits != 0);
+    remainingBits &= remainingBits - 1;
+    SkipEmptyWords();
+    return *this;
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::Iterator::operator==(const Iterator& other) const {
+    return wordIndex == other.wordIndex && remainingBits == other.remainingBits;
+}
+
+template<typename Index, size_t N>
+bool TypedBitSet<Index, N>::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+template<typename Index, size_t N>
+Index TypedBitSet<Index, N>::Iterator::operator*() const {
+    return static_cast<Index>(wordIndex * kBitsPerWord + ScanForward(remainingBits));
+}
+
+template<typename Index, size_t N>
+void TypedBitSet<Index, N>::Iterator::SkipEmptyWords() {
+    while (remainingBits == 0 && wordIndex < kWordCount) {
+        wordIndex++;
+        if (wordIndex < kWordCount) {
+            remainingBits = (*words)[wordIndex];
+        }
+    }
+}
+
+#endif // COMMON_TYPEDBITSET_H_
@@ -0,0 +1,76 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/perftests/PerfTest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Runs the perf tests and prints the results as JSON on stdout so they can be tracked over time.
+// Options:
+//     --filter=<substring>   Only run the tests whose name contains the substring.
+//     --min-time-ms=<ms>     Minimum time spent measuring each test, defaults to 500ms.
+//     --list                 Print the name of the tests and exit.
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    uint64_t minimumMilliseconds = 500;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--filter=", strlen("--filter=")) == 0) {
+            filter = argv[i] + strlen("--filter=");
+        } else if (strncmp(argv[i], "--min-time-ms=", strlen("--min-time-ms=")) == 0) {
+            minimumMilliseconds = strtoull(argv[i] + strlen("--min-time-ms="), nullptr, 10);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--filter=<substring>] [--min-time-ms=<ms>] [--list]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (list) {
+        for (const auto& info : GetRegisteredPerfTests()) {
+            printf("%s\n", info.name);
+        }
+        return 0;
+    }
+
+    printf("{\n");
+    printf("    \"backend\": \"null\",\n");
+    printf("    \"tests\": [");
+
+    bool first = true;
+    for (const auto& info : GetRegisteredPerfTests()) {
+        if (filter != nullptr && strstr(info.name, filter) == nullptr) {
+            continue;
+        }
+
+        PerfTestResult result = RunPerfTest(info, minimumMilliseconds * 1000000);
+        double nsPerCall = static_cast<double>(result.totalNanoseconds) / static_cast<double>(result.calls);
+
+        printf("%s\n        {\"name\": \"%s\", \"steps\": %llu, \"calls\": %llu, \"total_ns\": %llu, \"ns_per_call\": %.2f}",
+               first ? "" : ",", result.name.c_str(),
+               static_cast<unsigned long long>(result.steps),
+               static_cast<unsigned long long>(result.calls),
+               static_cast<unsigned long long>(result.totalNanoseconds), nsPerCall);
+        fflush(stdout);
+        first = false;
+    }
+
+    printf("\n    ]\n");
+    printf("}\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "tests/perftests/PerfTest.h"
+
+#include "backend/CommandAllocator.h"
+
+#include <memory>
+
+using namespace backend;
+
+namespace {
+
+    constexpr uint32_t kCommandsPerStep = 1000;
+
+    enum class Command {
+        Draw,
+        SetPipeline,
+        SetPushConstants,
+    };
+
+    struct DrawCmd {
+        uint32_t vertexCount;
+        uint32_t instanceCount;
+        uint32_t firstVertex;
+        uint32_t firstInstance;
+    };
+
+    struct SetPipelineCmd {
+        uint64_t pipeline;
+    };
+
+    struct SetPushConstantsCmd {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    // The allocators use a pool like the ones of command buffer builders so that the blocks are
+    // recycled between steps.
+    class CommandAllocatorPerfTest : public PerfTest {
+        public:
+            void SetUpStep() override {
+                allocator.reset(new CommandAllocator(&pool));
+            }
+
+            void TearDownStep() override {
+                CommandIterator commands(std::move(*allocator));
+                commands.DataWasDestroyed();
+                allocator = nullptr;
+            }
+
+        protected:
+            CommandBlockPool pool;
+            std::unique_ptr<CommandAllocator> allocator;
+    };
+
+}
+
+// Each call is the allocation of a command, alternating between commands of different sizes
+class CommandAllocatorAllocate : public CommandAllocatorPerfTest {
+    public:
+        uint32_t Step() override {
+            for (uint32_t i = 0; i < kCommandsPerStep; i += 2) {
+                SetPipelineCmd* pipeline = allocator->Allocate<SetPipelineCmd>(Command::SetPipeline);
+                pipeline->pipeline = i;
+
+                DrawCmd* draw = allocator->Allocate<DrawCmd>(Command::Draw);
+                draw->vertexCount = 3;
+                draw->instanceCount = 1;
+                draw->firstVertex = i;
+                draw->firstInstance = 0;
+            }
+            return kCommandsPerStep;
+        }
+};
+NXT_REGISTER_PERF_TEST(CommandAllocatorAllocate);
+
+// Each call is the allocation of a command followed by data of 1, 2, 4 and 8 byte alignments,
+// the mix found in the commands that carry arrays.
+class CommandAllocatorAllocateData : public CommandAllocatorPerfTest {
+    public:
+        uint32_t Step() override {
+            for (uint32_t i = 0; i < kCommandsPerStep; ++i) {
+                SetPushConstantsCmd* cmd = allocator->Allocate<SetPushConstantsCmd>(Command::SetPushConstants);
+                cmd->offset = 0;
+                cmd->count = 4;
+
+                switch (i % 4) {
+                    case 0:
+                        allocator->AllocateData<uint8_t>(3)[0] = 0;
+                        break;
+                    case 1:
+                        allocator->AllocateData<uint16_t>(5)[0] = 0;
+                        break;
+                    case 2:
+                        allocator->AllocateData<uint32_t>(4)[0] = 0;
+                        break;
+                    case 3:
+                        allocator->AllocateData<uint64_t>(2)[0] = 0;
+                        break;
+                }
+            }
+            return kCommandsPerStep;
+        }
+};
+NXT_REGISTER_PERF_TEST(CommandAllocatorAllocateData);
+
+// Each call is the decoding of a command by a CommandIterator, the commands are recorded once.
+class CommandIteratorIterate : public PerfTest {
+    public:
+        ~CommandIteratorIterate() override {
+            commands.DataWasDestroyed();
+        }
+
+        void SetUp() override {
+            CommandAllocator allocator(&pool);
+            for (uint32_t i = 0; i < kCommandsPerStep; i += 2) {
+                allocator.Allocate<SetPipelineCmd>(Command::SetPipeline)->pipeline = i;
+                allocator.Allocate<DrawCmd>(Command::Draw)->vertexCount = i;
+            }
+            commands = std::move(allocator);
+        }
+
+        uint32_t Step() override {
+            uint64_t sum = 0;
+            Command type;
+            while (commands.NextCommandId(&type)) {
+                switch (type) {
+                    case Command::Draw:
+                        sum += commands.NextCommand<DrawCmd>()->vertexCount;
+                        break;
+                    case Command::SetPipeline:
+                        sum += commands.NextCommand<SetPipelineCmd>()->pipeline;
+                        break;
+                    case Command::SetPushConstants:
+                        commands.NextCommand<SetPushConstantsCmd>();
+                        break;
+                }
+            }
+            result = sum;
+            return kCommandsPerStep;
+        }
+
+    private:
+        CommandBlockPool pool;
+        CommandIterator commands;
+        volatile uint64_t result = 0;
+};
+NXT_REGISTER_PERF_TEST(CommandIteratorIterate);
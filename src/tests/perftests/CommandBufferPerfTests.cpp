@@ -0,0 +1,197 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/perftests/PerfTest.h"
+
+#include "utils/NXTHelpers.h"
+
+#include <array>
+
+namespace {
+
+    constexpr uint32_t kDrawsPerCommandBuffer = 200;
+
+    // The data of the push constants of the Animometer sample
+    struct ShaderData {
+        float scale;
+        float time;
+        float offsetX;
+        float offsetY;
+        float scalar;
+        float scalarOffset;
+    };
+
+    // Shared setup for the command buffer tests: a render pass and a pipeline using push
+    // constants, like in the Animometer sample.
+    class AnimometerPerfTest : public PerfTest {
+        public:
+            void SetUp() override {
+                nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                    #version 450
+                    layout(push_constant) uniform ConstantsBlock {
+                        float scale;
+                        float time;
+                        float offsetX;
+                        float offsetY;
+                        float scalar;
+                        float scalarOffset;
+                    } c;
+                    void main() {
+                        gl_Position = vec4(c.offsetX, c.offsetY, c.scale * c.time, 1.0);
+                    })"
+                );
+
+                nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                    #version 450
+                    out vec4 fragColor;
+                    void main() {
+                        fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                    })"
+                );
+
+                utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+                pipeline = device.CreatePipelineBuilder()
+                    .SetSubpass(renderpass, 0)
+                    .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                    .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                    .GetResult();
+
+                for (uint32_t i = 0; i < kDrawsPerCommandBuffer; ++i) {
+                    shaderData[i] = {0.3f, 0.0f, 0.1f, -0.1f, 1.0f, static_cast<float>(i)};
+                }
+            }
+
+        protected:
+            nxt::CommandBufferBuilder BeginCommandBuffer() {
+                return device.CreateCommandBufferBuilder()
+                    .BeginRenderPass(renderpass, framebuffer)
+                    .BeginRenderSubpass()
+                    .SetPipeline(pipeline)
+                    .Clone();
+            }
+
+            void RecordDraws(const nxt::CommandBufferBuilder& builder) {
+                for (uint32_t i = 0; i < kDrawsPerCommandBuffer; ++i) {
+                    builder.SetPushConstants(nxt::ShaderStageBit::Vertex, 0, 6, reinterpret_cast<uint32_t*>(&shaderData[i]))
+                           .DrawArrays(3, 1, 0, 0);
+                }
+            }
+
+            nxt::CommandBuffer EndCommandBuffer(const nxt::CommandBufferBuilder& builder) {
+                builder.EndRenderSubpass();
+                builder.EndRenderPass();
+                return builder.GetResult();
+            }
+
+            nxt::RenderPass renderpass;
+            nxt::Framebuffer framebuffer;
+            nxt::Pipeline pipeline;
+            std::array<ShaderData, kDrawsPerCommandBuffer> shaderData;
+    };
+
+}
+
+// Cost of recording SetPushConstants + DrawArrays, each of them counts as a call.
+class CommandBufferRecording : public AnimometerPerfTest {
+    public:
+        void SetUpStep() override {
+            builder = BeginCommandBuffer();
+        }
+
+        uint32_t Step() override {
+            RecordDraws(builder);
+            return 2 * kDrawsPerCommandBuffer;
+        }
+
+        void TearDownStep() override {
+            EndCommandBuffer(builder);
+            builder = nxt::CommandBufferBuilder();
+        }
+
+    private:
+        nxt::CommandBufferBuilder builder;
+};
+NXT_REGISTER_PERF_TEST(CommandBufferRecording);
+
+// Cost of GetResult on a command buffer with kDrawsPerCommandBuffer draws, this includes the
+// validation of the commands.
+class CommandBufferGetResult : public AnimometerPerfTest {
+    public:
+        void SetUpStep() override {
+            builder = BeginCommandBuffer();
+            RecordDraws(builder);
+            builder.EndRenderSubpass();
+            builder.EndRenderPass();
+        }
+
+        uint32_t Step() override {
+            commands = builder.GetResult();
+            return 1;
+        }
+
+        void TearDownStep() override {
+            builder = nxt::CommandBufferBuilder();
+            commands = nxt::CommandBuffer();
+        }
+
+    private:
+        nxt::CommandBufferBuilder builder;
+        nxt::CommandBuffer commands;
+};
+NXT_REGISTER_PERF_TEST(CommandBufferGetResult);
+
+// Cost of the destruction of a command buffer with kDrawsPerCommandBuffer draws.
+class CommandBufferDestruction : public AnimometerPerfTest {
+    public:
+        void SetUpStep() override {
+            nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+            RecordDraws(builder);
+            commands = EndCommandBuffer(builder);
+        }
+
+        uint32_t Step() override {
+            commands = nxt::CommandBuffer();
+            return 1;
+        }
+
+    private:
+        nxt::CommandBuffer commands;
+};
+NXT_REGISTER_PERF_TEST(CommandBufferDestruction);
+
+// Cost of submitting a command buffer with kDrawsPerCommandBuffer draws.
+class QueueSubmit : public AnimometerPerfTest {
+    public:
+        void SetUpStep() override {
+            nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+            RecordDraws(builder);
+            commands = EndCommandBuffer(builder);
+        }
+
+        uint32_t Step() override {
+            queue.Submit(1, &commands);
+            return 1;
+        }
+
+        void TearDownStep() override {
+            commands = nxt::CommandBuffer();
+            // The device keeps submitted command buffers alive until the next Tick, like an
+            // application we tick once per "frame" so that they don't accumulate.
+            device.Tick();
+        }
+
+    private:
+        nxt::CommandBuffer commands;
+};
+NXT_REGISTER_PERF_TEST(QueueSubmit);
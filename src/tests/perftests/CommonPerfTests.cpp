@@ -0,0 +1,129 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "tests/perftests/PerfTest.h"
+
+#include "backend/RefCounted.h"
+#include "common/BitSetIterator.h"
+#include "nxt/EnumClassBitmasks.h"
+
+#include <bitset>
+
+namespace {
+
+    constexpr uint32_t kIterationsPerStep = 1000;
+
+    // Iterates over the set bits of the bitset, each call is the iteration over a whole bitset.
+    class BitSetIteratorPerfTest : public PerfTest {
+        public:
+            BitSetIteratorPerfTest(std::bitset<64> bits) : bits(bits) {
+            }
+
+            uint32_t Step() override {
+                uint32_t sum = 0;
+                for (uint32_t i = 0; i < kIterationsPerStep; ++i) {
+                    for (uint32_t bit : IterateBitSet(bits)) {
+                        sum += bit;
+                    }
+                }
+                result = sum;
+                return kIterationsPerStep;
+            }
+
+        private:
+            std::bitset<64> bits;
+            volatile uint32_t result = 0;
+    };
+
+    class RefTest : public backend::RefCounted {
+    };
+
+}
+
+// Like the attachments or vertex inputs actually used in a state
+class BitSetIteratorSparse : public BitSetIteratorPerfTest {
+    public:
+        BitSetIteratorSparse() : BitSetIteratorPerfTest(std::bitset<64>(0x8000010000100001ull)) {
+        }
+};
+NXT_REGISTER_PERF_TEST(BitSetIteratorSparse);
+
+class BitSetIteratorDense : public BitSetIteratorPerfTest {
+    public:
+        BitSetIteratorDense() : BitSetIteratorPerfTest(std::bitset<64>(0xFFFFFFFFFFFFFFFFull)) {
+        }
+};
+NXT_REGISTER_PERF_TEST(BitSetIteratorDense);
+
+// Each call is the copy of a Ref and its destruction, an atomic increment and decrement.
+class RefCopy : public PerfTest {
+    public:
+        RefCopy() : object(new RefTest) {
+            object->Release();
+        }
+
+        uint32_t Step() override {
+            for (uint32_t i = 0; i < kIterationsPerStep; ++i) {
+                backend::Ref<RefTest> copy(object);
+            }
+            return kIterationsPerStep;
+        }
+
+    private:
+        backend::Ref<RefTest> object;
+};
+NXT_REGISTER_PERF_TEST(RefCopy);
+
+// Each call is a Ref moved back and forth, which shouldn't touch the reference count.
+class RefMove : public PerfTest {
+    public:
+        RefMove() : object(new RefTest) {
+            object->Release();
+        }
+
+        uint32_t Step() override {
+            for (uint32_t i = 0; i < kIterationsPerStep; ++i) {
+                backend::Ref<RefTest> moved(std::move(object));
+                object = std::move(moved);
+            }
+            return kIterationsPerStep;
+        }
+
+    private:
+        backend::Ref<RefTest> object;
+};
+NXT_REGISTER_PERF_TEST(RefMove);
+
+// Each call is a mix of the operations done by the usage validation on bitmasks.
+class EnumClassBitmasks : public PerfTest {
+    public:
+        uint32_t Step() override {
+            nxt::BufferUsageBit usage = nxt::BufferUsageBit::None;
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < kIterationsPerStep; ++i) {
+                nxt::BufferUsageBit bit = static_cast<nxt::BufferUsageBit>(1u << (i % 8));
+                usage |= bit;
+                nxt::BufferUsageBit others = usage ^ bit;
+                if ((usage & nxt::BufferUsageBit::Storage) && nxt::HasZeroOrOneBits(others)) {
+                    count++;
+                }
+                usage &= ~nxt::BufferUsageBit::TransferSrc;
+            }
+            result = count + static_cast<uint32_t>(usage);
+            return kIterationsPerStep;
+        }
+
+    private:
+        volatile uint32_t result = 0;
+};
+NXT_REGISTER_PERF_TEST(EnumClassBitmasks);
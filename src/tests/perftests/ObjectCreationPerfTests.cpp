@@ -0,0 +1,318 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/perftests/PerfTest.h"
+
+#include "utils/NXTHelpers.h"
+
+#include <shaderc/shaderc.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    constexpr uint32_t kObjectsPerStep = 100;
+
+    // Each call is the creation of an object through its builder followed by its destruction.
+    class ObjectCreationPerfTest : public PerfTest {
+        public:
+            uint32_t Step() override {
+                for (uint32_t i = 0; i < kObjectsPerStep; ++i) {
+                    CreateAndDestroyObject();
+                }
+                return kObjectsPerStep;
+            }
+
+        private:
+            virtual void CreateAndDestroyObject() = 0;
+    };
+
+    const char* kVertexShader = R"(
+        #version 450
+        void main() {
+            gl_Position = vec4(0.0);
+        })";
+
+    const char* kFragmentShader = R"(
+        #version 450
+        out vec4 fragColor;
+        void main() {
+            fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+        })";
+
+}
+
+class CreateBindGroup : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            layout = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 1)
+                .GetResult();
+            nxt::Buffer buffer = device.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::Uniform)
+                .SetInitialUsage(nxt::BufferUsageBit::Uniform)
+                .SetSize(256)
+                .GetResult();
+            view = buffer.CreateBufferViewBuilder()
+                .SetExtent(0, 256)
+                .GetResult();
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateBindGroupBuilder()
+                .SetLayout(layout)
+                .SetUsage(nxt::BindGroupUsage::Frozen)
+                .SetBufferViews(0, 1, &view)
+                .GetResult();
+        }
+
+        nxt::BindGroupLayout layout;
+        nxt::BufferView view;
+};
+NXT_REGISTER_PERF_TEST(CreateBindGroup);
+
+class CreateBindGroupLayout : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 1)
+                .SetBindingsType(nxt::ShaderStageBit::Fragment, nxt::BindingType::Sampler, 1, 1)
+                .SetBindingsType(nxt::ShaderStageBit::Fragment, nxt::BindingType::SampledTexture, 2, 1)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateBindGroupLayout);
+
+class CreateBuffer : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::Vertex | nxt::BufferUsageBit::Uniform)
+                .SetInitialUsage(nxt::BufferUsageBit::Vertex)
+                .SetSize(256)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateBuffer);
+
+class CreateBufferView : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            buffer = device.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::Uniform)
+                .SetInitialUsage(nxt::BufferUsageBit::Uniform)
+                .SetSize(256)
+                .GetResult();
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            buffer.CreateBufferViewBuilder()
+                .SetExtent(0, 256)
+                .GetResult();
+        }
+
+        nxt::Buffer buffer;
+};
+NXT_REGISTER_PERF_TEST(CreateBufferView);
+
+class CreateCommandBuffer : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateCommandBufferBuilder()
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateCommandBuffer);
+
+class CreateDepthStencilState : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateDepthStencilStateBuilder()
+                .SetDepthCompareFunction(nxt::CompareFunction::Less)
+                .SetDepthWriteEnabled(true)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateDepthStencilState);
+
+class CreateFramebuffer : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            renderpass = device.CreateRenderPassBuilder()
+                .SetAttachmentCount(1)
+                .AttachmentSetFormat(0, nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetSubpassCount(1)
+                .SubpassSetColorAttachment(0, 0, 0)
+                .GetResult();
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateFramebufferBuilder()
+                .SetRenderPass(renderpass)
+                .SetDimensions(640, 480)
+                .GetResult();
+        }
+
+        nxt::RenderPass renderpass;
+};
+NXT_REGISTER_PERF_TEST(CreateFramebuffer);
+
+class CreateInputState : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateInputStateBuilder()
+                .SetInput(0, 4 * sizeof(float), nxt::InputStepMode::Vertex)
+                .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateInputState);
+
+class CreatePipeline : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, kVertexShader);
+            fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, kFragmentShader);
+            nxt::Framebuffer framebuffer;
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .GetResult();
+        }
+
+        nxt::ShaderModule vsModule;
+        nxt::ShaderModule fsModule;
+        nxt::RenderPass renderpass;
+};
+NXT_REGISTER_PERF_TEST(CreatePipeline);
+
+class CreatePipelineLayout : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            layout = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 1)
+                .GetResult();
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreatePipelineLayoutBuilder()
+                .SetBindGroupLayout(0, layout)
+                .GetResult();
+        }
+
+        nxt::BindGroupLayout layout;
+};
+NXT_REGISTER_PERF_TEST(CreatePipelineLayout);
+
+class CreateQueue : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateQueueBuilder()
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateQueue);
+
+class CreateRenderPass : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateRenderPassBuilder()
+                .SetAttachmentCount(1)
+                .AttachmentSetFormat(0, nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetSubpassCount(1)
+                .SubpassSetColorAttachment(0, 0, 0)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateRenderPass);
+
+class CreateSampler : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateSamplerBuilder()
+                .SetFilterMode(nxt::FilterMode::Linear, nxt::FilterMode::Linear, nxt::FilterMode::Linear)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateSampler);
+
+// This includes the SPIRV reflection done in the frontend, but not the GLSL to SPIRV compilation.
+class CreateShaderModule : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            shaderc::Compiler compiler;
+            shaderc::CompileOptions options;
+            auto result = compiler.CompileGlslToSpv(kVertexShader, strlen(kVertexShader), shaderc_glsl_vertex_shader, "perftest", options);
+            spirv.assign(result.cbegin(), result.cend());
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateShaderModuleBuilder()
+                .SetSource(static_cast<uint32_t>(spirv.size()), spirv.data())
+                .GetResult();
+        }
+
+        std::vector<uint32_t> spirv;
+};
+NXT_REGISTER_PERF_TEST(CreateShaderModule);
+
+class CreateTexture : public ObjectCreationPerfTest {
+    private:
+        void CreateAndDestroyObject() override {
+            device.CreateTextureBuilder()
+                .SetDimension(nxt::TextureDimension::e2D)
+                .SetExtent(640, 480, 1)
+                .SetFormat(nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetMipLevels(1)
+                .SetAllowedUsage(nxt::TextureUsageBit::OutputAttachment | nxt::TextureUsageBit::Sampled)
+                .SetInitialUsage(nxt::TextureUsageBit::OutputAttachment)
+                .GetResult();
+        }
+};
+NXT_REGISTER_PERF_TEST(CreateTexture);
+
+class CreateTextureView : public ObjectCreationPerfTest {
+    public:
+        void SetUp() override {
+            texture = device.CreateTextureBuilder()
+                .SetDimension(nxt::TextureDimension::e2D)
+                .SetExtent(640, 480, 1)
+                .SetFormat(nxt::TextureFormat::R8G8B8A8Unorm)
+                .SetMipLevels(1)
+                .SetAllowedUsage(nxt::TextureUsageBit::Sampled)
+                .SetInitialUsage(nxt::TextureUsageBit::Sampled)
+                .GetResult();
+        }
+
+    private:
+        void CreateAndDestroyObject() override {
+            texture.CreateTextureViewBuilder()
+                .GetResult();
+        }
+
+        nxt::Texture texture;
+};
+NXT_REGISTER_PERF_TEST(CreateTextureView);
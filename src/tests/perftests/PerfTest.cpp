@@ -0,0 +1,118 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/perftests/PerfTest.h"
+
+#include "nxt/nxt.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace backend {
+    namespace null {
+        void Init(nxtProcTable* procs, nxtDevice* device);
+    }
+}
+
+namespace {
+
+    void OnDeviceError(const char* message, nxtCallbackUserdata) {
+        // Errors mean the test isn't measuring what it should, the results can't be trusted.
+        fprintf(stderr, "Device error during a perf test: %s\n", message);
+        exit(1);
+    }
+
+    std::vector<PerfTestInfo>& GetRegistry() {
+        static std::vector<PerfTestInfo> registry;
+        return registry;
+    }
+
+}
+
+// PerfTest
+
+PerfTest::PerfTest() {
+    nxtProcTable procs;
+    nxtDevice cDevice;
+    backend::null::Init(&procs, &cDevice);
+
+    nxtSetProcs(&procs);
+    device = nxt::Device::Acquire(cDevice);
+    device.SetErrorCallback(OnDeviceError, 0);
+
+    queue = device.CreateQueueBuilder().GetResult();
+}
+
+PerfTest::~PerfTest() {
+    // We need to destroy NXT objects before setting the procs to null otherwise the nxt*Release
+    // will call a nullptr
+    queue = nxt::Queue();
+    device = nxt::Device();
+    nxtSetProcs(nullptr);
+}
+
+void PerfTest::SetUp() {
+}
+
+void PerfTest::SetUpStep() {
+}
+
+void PerfTest::TearDownStep() {
+}
+
+// Registration and running of the tests
+
+void RegisterPerfTest(const char* name, PerfTestFactory factory) {
+    GetRegistry().push_back({name, factory});
+}
+
+const std::vector<PerfTestInfo>& GetRegisteredPerfTests() {
+    return GetRegistry();
+}
+
+PerfTestResult RunPerfTest(const PerfTestInfo& info, uint64_t minimumNanoseconds) {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_ptr<PerfTest> test(info.factory());
+    test->SetUp();
+
+    // Do a couple steps to warm up caches and the allocators before measuring.
+    constexpr uint32_t kWarmupSteps = 10;
+    for (uint32_t i = 0; i < kWarmupSteps; ++i) {
+        test->SetUpStep();
+        test->Step();
+        test->TearDownStep();
+    }
+
+    PerfTestResult result;
+    result.name = info.name;
+
+    while (result.totalNanoseconds < minimumNanoseconds) {
+        test->SetUpStep();
+
+        auto start = Clock::now();
+        uint32_t calls = test->Step();
+        auto end = Clock::now();
+
+        test->TearDownStep();
+
+        result.steps++;
+        result.calls += calls;
+        result.totalNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+
+    return result;
+}
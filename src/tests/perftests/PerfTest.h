@@ -0,0 +1,92 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TESTS_PERFTESTS_PERFTEST_H_
+#define TESTS_PERFTESTS_PERFTEST_H_
+
+#include "nxt/nxtcpp.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Perf tests measure the CPU cost of NXT entry points on the null backend, so that only the
+// frontend (and the null backend's bookkeeping) is measured. Each test is a class deriving from
+// PerfTest that is registered with NXT_REGISTER_PERF_TEST:
+//
+//     class MyPerfTest : public PerfTest {
+//         public:
+//             void SetUp() override { /* create objects used by every step */ }
+//             uint32_t Step() override { /* do N calls */ return N; }
+//     };
+//     NXT_REGISTER_PERF_TEST(MyPerfTest);
+//
+// Steps are run until enough time has been accumulated, then the time per call is computed by
+// dividing the total time spent in Step by the total number of calls it reported. Tests of the
+// primitives used on the hot paths (CommandAllocator, SerialQueue, Ref...) use them directly and
+// ignore the device.
+class PerfTest {
+    public:
+        PerfTest();
+        virtual ~PerfTest();
+
+        // Called once before any step, to create the objects used by all steps.
+        virtual void SetUp();
+
+        // SetUpStep and TearDownStep are called before and after each step but aren't part of the
+        // measurement, they can be used to prepare and clean up state that is specific to a step.
+        virtual void SetUpStep();
+        virtual void TearDownStep();
+
+        // Does the work that is measured and returns the number of calls it made.
+        virtual uint32_t Step() = 0;
+
+    protected:
+        nxt::Device device;
+        nxt::Queue queue;
+};
+
+struct PerfTestResult {
+    std::string name;
+    uint64_t steps = 0;
+    uint64_t calls = 0;
+    uint64_t totalNanoseconds = 0;
+};
+
+using PerfTestFactory = PerfTest* (*)();
+
+struct PerfTestInfo {
+    const char* name;
+    PerfTestFactory factory;
+};
+
+void RegisterPerfTest(const char* name, PerfTestFactory factory);
+const std::vector<PerfTestInfo>& GetRegisteredPerfTests();
+
+// Runs the test until at least minimumNanoseconds were spent in its steps.
+PerfTestResult RunPerfTest(const PerfTestInfo& info, uint64_t minimumNanoseconds);
+
+namespace detail {
+    template<typename T>
+    struct PerfTestRegisterer {
+        PerfTestRegisterer(const char* name) {
+            RegisterPerfTest(name, []() -> PerfTest* { return new T; });
+        }
+    };
+}
+
+#define NXT_REGISTER_PERF_TEST(Class) \
+    static detail::PerfTestRegisterer<Class> perfTestRegisterer##Class(#Class)
+
+#endif // TESTS_PERFTESTS_PERFTEST_H_
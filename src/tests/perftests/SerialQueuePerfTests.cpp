@@ -0,0 +1,76 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/perftests/PerfTest.h"
+
+#include "common/SerialQueue.h"
+
+namespace {
+
+    constexpr uint32_t kValuesPerSerial = 64;
+    constexpr uint32_t kSerialsPerStep = 16;
+    constexpr Serial kSerialsInFlight = 3;
+
+}
+
+// Each call is a value enqueued then released a few serials later, like objects going through
+// the deferred-release paths of the backends. Uses the frontend container directly, the device
+// isn't involved.
+class SerialQueueEnqueueAndClear : public PerfTest {
+    public:
+        uint32_t Step() override {
+            for (uint32_t i = 0; i < kSerialsPerStep; ++i) {
+                for (uint32_t j = 0; j < kValuesPerSerial; ++j) {
+                    queue.Enqueue(j, serial);
+                }
+
+                if (serial >= kSerialsInFlight) {
+                    queue.ClearUpTo(serial - kSerialsInFlight);
+                }
+                serial++;
+            }
+            return kSerialsPerStep * kValuesPerSerial;
+        }
+
+    private:
+        SerialQueue<uint32_t> queue;
+        Serial serial = 0;
+};
+NXT_REGISTER_PERF_TEST(SerialQueueEnqueueAndClear);
+
+// Each call is a value visited by IterateUpTo, over values spread on many serials.
+class SerialQueueIterate : public PerfTest {
+    public:
+        void SetUp() override {
+            for (Serial serial = 0; serial < kSerialsPerStep; ++serial) {
+                for (uint32_t j = 0; j < kValuesPerSerial; ++j) {
+                    queue.Enqueue(j, serial);
+                }
+            }
+        }
+
+        uint32_t Step() override {
+            uint32_t sum = 0;
+            for (uint32_t value : queue.IterateUpTo(kSerialsPerStep)) {
+                sum += value;
+            }
+            result = sum;
+            return kSerialsPerStep * kValuesPerSerial;
+        }
+
+    private:
+        SerialQueue<uint32_t> queue;
+        volatile uint32_t result = 0;
+};
+NXT_REGISTER_PERF_TEST(SerialQueueIterate);
@@ -16,6 +16,9 @@
 
 #include "backend/CommandAllocator.h"
 
+#include <thread>
+#include <vector>
+
 using namespace backend;
 
 // Definition of the command types used in the tests
@@ -359,3 +362,247 @@ TEST(CommandAllocator, EmptyIterator) {
         iterator2.DataWasDestroyed();
     }
 }
+
+// Test that packed commands are unpacked to their values, whatever width they were packed with
+TEST(CommandAllocator, PackedCommands) {
+    CommandAllocator allocator;
+
+    // Enough commands to use several blocks, cycling between 8, 16 and 32 bit values
+    const uint32_t kCommandCount = 10000;
+    const uint32_t kValues[3] = {42, 0xBEEF, 0xDEADBEEF};
+    uint32_t myValues[3] = {6, 42, 0xFFFFFFFF};
+
+    for (uint32_t i = 0; i < kCommandCount; i++) {
+        CommandDraw draw;
+        draw.first = i;
+        draw.count = kValues[i % 3];
+        allocator.AllocatePacked(CommandType::Draw, draw);
+
+        if (i % 7 == 0) {
+            CommandPipeline* pipeline = allocator.Allocate<CommandPipeline>(CommandType::Pipeline);
+            pipeline->pipeline = i;
+            pipeline->attachmentPoint = i;
+
+            uint32_t* values = allocator.AllocateData<uint32_t>(3);
+            for (size_t j = 0; j < 3; j++) {
+                values[j] = myValues[j];
+            }
+        }
+    }
+
+    CommandIterator iterator(std::move(allocator));
+    CommandType type;
+    for (uint32_t i = 0; i < kCommandCount; i++) {
+        ASSERT_TRUE(iterator.NextCommandId(&type));
+        ASSERT_EQ(type, CommandType::Draw);
+
+        CommandDraw* draw = iterator.NextCommand<CommandDraw>();
+        ASSERT_EQ(draw->first, i);
+        ASSERT_EQ(draw->count, kValues[i % 3]);
+
+        if (i % 7 == 0) {
+            ASSERT_TRUE(iterator.NextCommandId(&type));
+            ASSERT_EQ(type, CommandType::Pipeline);
+
+            CommandPipeline* pipeline = iterator.NextCommand<CommandPipeline>();
+            ASSERT_EQ(pipeline->pipeline, i);
+            ASSERT_EQ(pipeline->attachmentPoint, i);
+
+            uint32_t* values = iterator.NextData<uint32_t>(3);
+            for (size_t j = 0; j < 3; j++) {
+                ASSERT_EQ(values[j], myValues[j]);
+            }
+        }
+    }
+    ASSERT_FALSE(iterator.NextCommandId(&type));
+
+    iterator.DataWasDestroyed();
+}
+
+// Test that packing commands with small values uses less memory
+TEST(CommandAllocator, PackedCommandsAreSmaller) {
+    const uint32_t kCommandCount = 10000;
+    CommandBlockPool pool;
+
+    CommandAllocator packedAllocator(&pool);
+    for (uint32_t i = 0; i < kCommandCount; i++) {
+        CommandDraw draw;
+        draw.first = i % 256;
+        draw.count = 3;
+        packedAllocator.AllocatePacked(CommandType::Draw, draw);
+    }
+    CommandIterator packedIterator(std::move(packedAllocator));
+    size_t packedBytes = pool.GetStats().bytesInUse;
+
+    CommandAllocator allocator(&pool);
+    for (uint32_t i = 0; i < kCommandCount; i++) {
+        CommandDraw* draw = allocator.Allocate<CommandDraw>(CommandType::Draw);
+        draw->first = i % 256;
+        draw->count = 3;
+    }
+    CommandIterator iterator(std::move(allocator));
+    size_t unpackedBytes = pool.GetStats().bytesInUse - packedBytes;
+
+    // 3 bytes per packed command, 12 bytes per unpacked command with the id and padding. Blocks
+    // sizes are rounded up so only check for a factor of 2.
+    ASSERT_LT(packedBytes * 2, unpackedBytes);
+
+    packedIterator.DataWasDestroyed();
+    iterator.DataWasDestroyed();
+}
+
+// Test that blocks given back to the pool are reused by the next allocator
+TEST(CommandBlockPool, RecyclesBlocks) {
+    CommandBlockPool pool;
+
+    for (int i = 0; i < 3; i++) {
+        CommandAllocator allocator(&pool);
+
+        CommandDraw* draw = allocator.Allocate<CommandDraw>(CommandType::Draw);
+        draw->first = i;
+        draw->count = 16;
+
+        CommandIterator iterator(std::move(allocator));
+        CommandType type;
+        ASSERT_TRUE(iterator.NextCommandId(&type));
+        ASSERT_EQ(type, CommandType::Draw);
+        ASSERT_EQ(iterator.NextCommand<CommandDraw>()->first, static_cast<uint32_t>(i));
+        iterator.DataWasDestroyed();
+    }
+
+    const CommandBlockPoolStats& stats = pool.GetStats();
+    ASSERT_EQ(stats.misses, 1u);
+    ASSERT_EQ(stats.hits, 2u);
+    ASSERT_EQ(stats.bytesInUse, 0u);
+    ASSERT_NE(stats.bytesCached, 0u);
+}
+
+// Test that blocks too large to be pooled still work and are not cached
+TEST(CommandBlockPool, OversizeBlocks) {
+    CommandBlockPool pool;
+
+    {
+        CommandAllocator allocator(&pool);
+
+        CommandBig* big = allocator.Allocate<CommandBig>(CommandType::Big);
+        big->buffer[kBigBufferSize - 1] = 42;
+
+        CommandIterator iterator(std::move(allocator));
+        CommandType type;
+        ASSERT_TRUE(iterator.NextCommandId(&type));
+        ASSERT_EQ(type, CommandType::Big);
+        ASSERT_EQ(iterator.NextCommand<CommandBig>()->buffer[kBigBufferSize - 1], 42u);
+        iterator.DataWasDestroyed();
+    }
+
+    const CommandBlockPoolStats& stats = pool.GetStats();
+    ASSERT_EQ(stats.oversizeAllocations, 1u);
+    ASSERT_EQ(stats.bytesCached, 0u);
+}
+
+// Test that Trim only keeps the blocks needed to reach the high-water mark since the last Trim
+TEST(CommandBlockPool, TrimToHighWaterMark) {
+    CommandBlockPool pool;
+
+    // Use two blocks of the smallest size class at the same time.
+    size_t size;
+    uint8_t* block1 = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+    uint8_t* block2 = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+    ASSERT_EQ(size, CommandBlockPool::kMinPooledBlockSize);
+    pool.DeallocateBlock(block1, size);
+    pool.DeallocateBlock(block2, size);
+
+    // Both blocks were used at the same time so they are kept.
+    pool.Trim();
+    ASSERT_EQ(pool.GetStats().trimmedBlocks, 0u);
+    ASSERT_EQ(pool.GetStats().bytesCached, 2 * CommandBlockPool::kMinPooledBlockSize);
+
+    // Only one block is used at the same time now, the other one is freed.
+    block1 = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+    pool.DeallocateBlock(block1, size);
+    pool.Trim();
+    ASSERT_EQ(pool.GetStats().trimmedBlocks, 1u);
+    ASSERT_EQ(pool.GetStats().bytesCached, CommandBlockPool::kMinPooledBlockSize);
+
+    // No block was used, everything is freed.
+    pool.Trim();
+    ASSERT_EQ(pool.GetStats().trimmedBlocks, 2u);
+    ASSERT_EQ(pool.GetStats().bytesCached, 0u);
+
+    ASSERT_EQ(pool.GetStats().hits, 1u);
+    ASSERT_EQ(pool.GetStats().misses, 2u);
+}
+
+// Test that the blocks cached by a thread go back to the shared pool when it exits, so Trim can
+// free them
+TEST(CommandBlockPool, ThreadExitReleasesCache) {
+    CommandBlockPool pool;
+
+    std::thread thread([&pool]() {
+        size_t size;
+        uint8_t* block = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+        pool.DeallocateBlock(block, size);
+    });
+    thread.join();
+
+    pool.Trim();
+    pool.Trim();
+    ASSERT_EQ(pool.GetStats().trimmedBlocks, 1u);
+    ASSERT_EQ(pool.GetStats().bytesCached, 0u);
+
+    // Releasing the cache of a thread that keeps using the pool is fine too.
+    size_t size;
+    uint8_t* block = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+    pool.DeallocateBlock(block, size);
+    pool.ReleaseThreadCache();
+    block = pool.AllocateBlock(CommandBlockPool::kMinPooledBlockSize, &size);
+    pool.DeallocateBlock(block, size);
+    ASSERT_EQ(pool.GetStats().hits, 1u);
+}
+
+// Test that several threads can record with the same pool and destroy their commands on another
+// thread.
+TEST(CommandBlockPool, Multithreaded) {
+    CommandBlockPool pool;
+
+    const int kThreadCount = 8;
+    const uint32_t kCommandCount = 5000;
+
+    std::vector<CommandIterator> iterators(kThreadCount);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([&pool, &iterators, i]() {
+            CommandAllocator allocator(&pool);
+            for (uint32_t j = 0; j < kCommandCount; ++j) {
+                CommandDraw* draw = allocator.Allocate<CommandDraw>(CommandType::Draw);
+                draw->first = j;
+                draw->count = i;
+            }
+            iterators[i] = std::move(allocator);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Blocks are given back to the pool from this thread.
+    for (int i = 0; i < kThreadCount; ++i) {
+        CommandIterator& iterator = iterators[i];
+
+        CommandType type;
+        uint32_t count = 0;
+        while (iterator.NextCommandId(&type)) {
+            ASSERT_EQ(type, CommandType::Draw);
+            CommandDraw* draw = iterator.NextCommand<CommandDraw>();
+            ASSERT_EQ(draw->first, count);
+            ASSERT_EQ(draw->count, static_cast<uint32_t>(i));
+            count++;
+        }
+        ASSERT_EQ(count, kCommandCount);
+
+        iterator.DataWasDestroyed();
+        iterator = CommandIterator();
+    }
+
+    ASSERT_EQ(pool.GetStats().bytesInUse, 0u);
+}
@@ -0,0 +1,65 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/DenseIndex.h"
+
+using namespace backend;
+
+// Test that indices are dense and reused after being freed.
+TEST(DenseIndexAllocator, ReusesIndices) {
+    DenseIndexAllocator allocator;
+
+    ASSERT_EQ(allocator.Allocate(), 0u);
+    ASSERT_EQ(allocator.Allocate(), 1u);
+    ASSERT_EQ(allocator.Allocate(), 2u);
+
+    allocator.Free(1);
+    ASSERT_EQ(allocator.Allocate(), 1u);
+    ASSERT_EQ(allocator.Allocate(), 3u);
+}
+
+// Test setting and getting values in the table.
+TEST(DenseSlotTable, SetAndGet) {
+    DenseSlotTable<int> table;
+
+    ASSERT_EQ(table.Get(0), nullptr);
+    ASSERT_EQ(table.Get(42), nullptr);
+
+    ASSERT_TRUE(table.Set(3, 1));
+    ASSERT_FALSE(table.Set(3, 2));
+    ASSERT_TRUE(table.Set(0, 3));
+
+    ASSERT_EQ(*table.Get(3), 2);
+    ASSERT_EQ(*table.Get(0), 3);
+    ASSERT_FALSE(table.Contains(1));
+    ASSERT_FALSE(table.Contains(4));
+}
+
+// Test that Clear removes all the values.
+TEST(DenseSlotTable, Clear) {
+    DenseSlotTable<int> table;
+
+    table.Set(0, 1);
+    table.Set(5, 2);
+    table.Clear();
+
+    ASSERT_FALSE(table.Contains(0));
+    ASSERT_FALSE(table.Contains(5));
+
+    ASSERT_TRUE(table.Set(5, 3));
+    ASSERT_EQ(*table.Get(5), 3);
+    ASSERT_FALSE(table.Contains(0));
+}
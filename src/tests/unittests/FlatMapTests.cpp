@@ -0,0 +1,87 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/FlatMap.h"
+
+#include <set>
+
+// Test inserting and finding values
+TEST(FlatMap, InsertAndFind) {
+    FlatMap<uint64_t, uint32_t> map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.end(), map.find(0));
+
+    map[1] = 10;
+    map[2] = 20;
+    ASSERT_EQ(2u, map.size());
+
+    auto it = map.find(1);
+    ASSERT_NE(map.end(), it);
+    ASSERT_EQ(1u, it->first);
+    ASSERT_EQ(10u, it->second);
+    ASSERT_EQ(map.end(), map.find(3));
+
+    // operator[] on an existing key doesn't add an entry
+    map[1] = 11;
+    ASSERT_EQ(2u, map.size());
+    ASSERT_EQ(11u, map.find(1)->second);
+}
+
+// Test that the map grows and keeps all entries, including keys that only differ in their high
+// bits like the index range keys of buffers
+TEST(FlatMap, Grow) {
+    FlatMap<uint64_t, uint32_t> map;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        map[uint64_t(i) << 32] = i;
+    }
+    ASSERT_EQ(1000u, map.size());
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        auto it = map.find(uint64_t(i) << 32);
+        ASSERT_NE(map.end(), it);
+        ASSERT_EQ(i, it->second);
+    }
+}
+
+// Test iterating over the entries
+TEST(FlatMap, Iterate) {
+    FlatMap<uint32_t, uint32_t> map;
+    for (uint32_t i = 0; i < 10; ++i) {
+        map[i * 7] = i;
+    }
+
+    std::set<uint32_t> seen;
+    for (const auto& entry : map) {
+        ASSERT_EQ(entry.first, entry.second * 7);
+        seen.insert(entry.second);
+    }
+    ASSERT_EQ(10u, seen.size());
+}
+
+// Test clearing the map
+TEST(FlatMap, Clear) {
+    FlatMap<uint32_t, uint32_t> map;
+    map[1] = 1;
+    map[2] = 2;
+
+    map.clear();
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(map.end(), map.find(1));
+    ASSERT_EQ(map.begin(), map.end());
+
+    map[2] = 3;
+    ASSERT_EQ(3u, map.find(2)->second);
+}
@@ -0,0 +1,92 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "mock/mock_nxt.h"
+
+#include "utils/ProfilingProcTable.h"
+
+#include <cstring>
+
+using namespace testing;
+
+class ProfilingProcTableTest : public Test {
+    protected:
+        void SetUp() override {
+            nxtProcTable mockProcs;
+            api.GetProcTableAndDevice(&mockProcs, &device);
+            procs = utils::GetProfilingProcs(mockProcs);
+            utils::ResetProcProfiles();
+        }
+
+        void TearDown() override {
+            utils::ResetProcProfiles();
+        }
+
+        const utils::ProcProfile* FindProfile(const std::vector<utils::ProcProfile>& profiles, const char* name) {
+            for (const utils::ProcProfile& profile : profiles) {
+                if (strcmp(profile.name, name) == 0) {
+                    return &profile;
+                }
+            }
+            return nullptr;
+        }
+
+        MockProcTable api;
+        nxtProcTable procs;
+        nxtDevice device;
+};
+
+// Test that calls are forwarded to the profiled procs and counted per entry point
+TEST_F(ProfilingProcTableTest, CountsCalls) {
+    nxtBufferBuilder apiBuilder = api.GetNewBufferBuilder();
+    EXPECT_CALL(api, DeviceCreateBufferBuilder(device)).WillOnce(Return(apiBuilder));
+    EXPECT_CALL(api, BufferBuilderSetSize(apiBuilder, 16)).Times(1);
+    EXPECT_CALL(api, DeviceTick(device)).Times(3);
+
+    nxtBufferBuilder builder = procs.deviceCreateBufferBuilder(device);
+    EXPECT_EQ(apiBuilder, builder);
+    procs.bufferBuilderSetSize(builder, 16);
+    for (int i = 0; i < 3; ++i) {
+        procs.deviceTick(device);
+    }
+
+    std::vector<utils::ProcProfile> profiles = utils::GetProcProfiles();
+    ASSERT_EQ(3u, profiles.size());
+
+    const utils::ProcProfile* tick = FindProfile(profiles, "nxtDeviceTick");
+    ASSERT_NE(nullptr, tick);
+    ASSERT_EQ(3u, tick->callCount);
+    ASSERT_EQ(1u, FindProfile(profiles, "nxtDeviceCreateBufferBuilder")->callCount);
+    ASSERT_EQ(1u, FindProfile(profiles, "nxtBufferBuilderSetSize")->callCount);
+
+    // Profiles are sorted by the time spent in the entry points.
+    for (size_t i = 1; i < profiles.size(); ++i) {
+        ASSERT_GE(profiles[i - 1].totalNanoseconds, profiles[i].totalNanoseconds);
+    }
+}
+
+// Test that resetting the profiles clears the counters
+TEST_F(ProfilingProcTableTest, Reset) {
+    EXPECT_CALL(api, DeviceTick(device)).Times(2);
+
+    procs.deviceTick(device);
+    ASSERT_EQ(1u, utils::GetProcProfiles().size());
+
+    utils::ResetProcProfiles();
+    ASSERT_TRUE(utils::GetProcProfiles().empty());
+
+    procs.deviceTick(device);
+    ASSERT_EQ(1u, utils::GetProcProfiles()[0].callCount);
+}
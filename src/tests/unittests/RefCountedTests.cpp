@@ -16,6 +16,9 @@
 
 #include "backend/RefCounted.h"
 
+#include <thread>
+#include <vector>
+
 using namespace backend;
 
 struct RCTest : public RefCounted {
@@ -60,6 +63,83 @@ TEST(RefCounted, InternalRefKeepsAlive) {
     ASSERT_TRUE(deleted);
 }
 
+// Test that TryReference revives objects only kept alive by internal refs.
+TEST(RefCounted, TryReferenceRevivesExternalRefs) {
+    bool deleted = false;
+    auto test = new RCTest(&deleted);
+
+    test->ReferenceInternal();
+    test->Release();
+    ASSERT_EQ(test->GetExternalRefs(), 0u);
+
+    ASSERT_TRUE(test->TryReference());
+    ASSERT_TRUE(test->TryReference());
+    ASSERT_EQ(test->GetExternalRefs(), 2u);
+    ASSERT_EQ(test->GetInternalRefs(), 2u);
+
+    test->ReleaseInternal();
+    test->Release();
+    test->Release();
+    ASSERT_TRUE(deleted);
+}
+
+// Test that the memory of deleted objects is reused by the next objects of the same size.
+TEST(RefCounted, MemoryIsReused) {
+    auto test = new RCTest;
+    void* memory = test;
+    test->Release();
+
+    test = new RCTest;
+    ASSERT_EQ(memory, test);
+    test->Release();
+}
+
+struct LargeRCTest : public RCTest {
+    LargeRCTest(bool* deleted): RCTest(deleted) {
+    }
+
+    char data[4096];
+};
+
+// Test that objects too large for the slabs are still allocated and deleted.
+TEST(RefCounted, LargeObject) {
+    bool deleted = false;
+    RCTest* test = new LargeRCTest(&deleted);
+
+    test->Release();
+    ASSERT_TRUE(deleted);
+}
+
+// Test that references can be added and removed from multiple threads at the same time.
+TEST(RefCounted, MultithreadedReferences) {
+    bool deleted = false;
+    auto test = new RCTest(&deleted);
+
+    const int kThreadCount = 8;
+    const int kIterations = 10000;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([test]() {
+            for (int j = 0; j < kIterations; ++j) {
+                test->Reference();
+                Ref<RCTest> ref(test);
+                test->Release();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(test->GetExternalRefs(), 1u);
+    ASSERT_EQ(test->GetInternalRefs(), 1u);
+    ASSERT_FALSE(deleted);
+
+    test->Release();
+    ASSERT_TRUE(deleted);
+}
+
 // Test Ref remove internal reference when going out of scope
 TEST(Ref, EndOfScopeRemovesInternalRef) {
     bool deleted = false;
@@ -0,0 +1,93 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "backend/RefCounted.h"
+#include "backend/ResidencySet.h"
+
+using namespace backend;
+
+struct RSTest : public RefCounted {
+    RSTest(bool* deleted): deleted(deleted) {
+    }
+
+    ~RSTest() override {
+        *deleted = true;
+    }
+
+    bool* deleted;
+};
+
+// Test that the set keeps its objects alive until it is destroyed.
+TEST(ResidencySet, KeepsObjectsAlive) {
+    bool deleted = false;
+    RSTest* test = new RSTest(&deleted);
+
+    {
+        ResidencySet set;
+        set.Add(test);
+        test->Release();
+        ASSERT_FALSE(deleted);
+    }
+    ASSERT_TRUE(deleted);
+}
+
+// Test that an object added several times is referenced only once.
+TEST(ResidencySet, Deduplicates) {
+    bool deleted1 = false;
+    bool deleted2 = false;
+    RSTest* test1 = new RSTest(&deleted1);
+    RSTest* test2 = new RSTest(&deleted2);
+
+    ResidencySet set;
+    set.Add(test1);
+    set.Add(test1);
+    set.Add(test2);
+    set.Add(test1);
+    set.Add(nullptr);
+
+    ASSERT_EQ(set.GetSize(), 2u);
+    ASSERT_TRUE(set.Contains(test1));
+    ASSERT_TRUE(set.Contains(test2));
+    ASSERT_EQ(test1->GetInternalRefs(), 2u);
+    ASSERT_EQ(test2->GetInternalRefs(), 2u);
+
+    test1->Release();
+    test2->Release();
+    set.Clear();
+    ASSERT_TRUE(deleted1);
+    ASSERT_TRUE(deleted2);
+}
+
+// Test that moving the set transfers the references.
+TEST(ResidencySet, Move) {
+    bool deleted = false;
+    RSTest* test = new RSTest(&deleted);
+
+    ResidencySet destination;
+    {
+        ResidencySet source;
+        source.Add(test);
+        test->Release();
+
+        destination = std::move(source);
+        ASSERT_EQ(source.GetSize(), 0u);
+    }
+    ASSERT_FALSE(deleted);
+    ASSERT_EQ(destination.GetSize(), 1u);
+
+    destination.Clear();
+    ASSERT_TRUE(deleted);
+}
@@ -16,6 +16,8 @@
 
 #include "common/SerialQueue.h"
 
+#include <memory>
+
 using TestSerialQueue = SerialQueue<int>;
 
 // A number of basic tests for SerialQueue that are difficult to split from one another
@@ -141,3 +143,108 @@ TEST(SerialQueue, FirstSerial) {
     queue.Enqueue(vector1, 6);
     EXPECT_EQ(queue.FirstSerial(), 6);
 }
+
+// Test that values keep their order when the queue grows while it wraps around its storage
+TEST(SerialQueue, GrowWhileWrappedAround) {
+    TestSerialQueue queue;
+
+    // Move the start of the queue in the middle of its storage.
+    for (int i = 0; i < 10; ++i) {
+        queue.Enqueue(i, 0);
+    }
+    queue.ClearUpTo(0);
+
+    for (int i = 0; i < 100; ++i) {
+        queue.Enqueue(i, i / 10 + 1);
+    }
+
+    int expectedValue = 0;
+    for (int value : queue.IterateAll()) {
+        EXPECT_EQ(expectedValue, value);
+        expectedValue++;
+    }
+    EXPECT_EQ(100, expectedValue);
+
+    expectedValue = 0;
+    for (int value : queue.IterateUpTo(5)) {
+        EXPECT_EQ(expectedValue, value);
+        expectedValue++;
+    }
+    EXPECT_EQ(50, expectedValue);
+}
+
+// Test enqueuing and clearing in a loop like the deferred-release paths do
+TEST(SerialQueue, EnqueueAndClearInterleaved) {
+    TestSerialQueue queue;
+
+    for (int serial = 0; serial < 1000; ++serial) {
+        queue.Enqueue(2 * serial, serial);
+        queue.Enqueue(2 * serial + 1, serial);
+
+        // Values stay in flight for three serials
+        if (serial >= 3) {
+            queue.ClearUpTo(serial - 3);
+            EXPECT_EQ(static_cast<Serial>(serial - 2), queue.FirstSerial());
+        }
+    }
+
+    int expectedValue = 2 * 997;
+    for (int value : queue.IterateAll()) {
+        EXPECT_EQ(expectedValue, value);
+        expectedValue++;
+    }
+    EXPECT_EQ(2 * 1000, expectedValue);
+}
+
+// Test that iterating and clearing up to a serial before the first one does nothing
+TEST(SerialQueue, UpToSerialBeforeFirst) {
+    TestSerialQueue queue;
+    queue.Enqueue(1, 5);
+
+    for (int value : queue.IterateUpTo(4)) {
+        (void) value;
+        ASSERT_TRUE(false);
+    }
+
+    queue.ClearUpTo(4);
+    ASSERT_FALSE(queue.Empty());
+    EXPECT_EQ(5u, queue.FirstSerial());
+}
+
+// Test that values can be modified while iterating
+TEST(SerialQueue, ModifyWhileIterating) {
+    TestSerialQueue queue;
+    queue.Enqueue(1, 0);
+    queue.Enqueue(2, 1);
+
+    for (int& value : queue.IterateUpTo(0)) {
+        value = 3;
+    }
+
+    std::vector<int> expectedValues = {3, 2};
+    for (int value : queue.IterateAll()) {
+        EXPECT_EQ(expectedValues.front(), value);
+        ASSERT_FALSE(expectedValues.empty());
+        expectedValues.erase(expectedValues.begin());
+    }
+    ASSERT_TRUE(expectedValues.empty());
+}
+
+// Test that clearing releases the values right away
+TEST(SerialQueue, ClearReleasesValues) {
+    SerialQueue<std::shared_ptr<int>> queue;
+    std::shared_ptr<int> value1 = std::make_shared<int>(1);
+    std::shared_ptr<int> value2 = std::make_shared<int>(2);
+
+    queue.Enqueue(value1, 0);
+    queue.Enqueue(value2, 1);
+    EXPECT_EQ(2, value1.use_count());
+    EXPECT_EQ(2, value2.use_count());
+
+    queue.ClearUpTo(0);
+    EXPECT_EQ(1, value1.use_count());
+    EXPECT_EQ(2, value2.use_count());
+
+    queue.Clear();
+    EXPECT_EQ(1, value2.use_count());
+}
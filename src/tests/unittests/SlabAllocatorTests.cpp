@@ -0,0 +1,76 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/Math.h"
+#include "common/SlabAllocator.h"
+
+#include <cstddef>
+#include <set>
+
+// Test that blocks are distinct, aligned and only allocate slabs when needed
+TEST(SlabAllocator, Basic) {
+    SlabAllocator allocator(24, 4);
+    ASSERT_EQ(0u, allocator.GetSlabCount());
+    ASSERT_EQ(0u, allocator.GetBlockSize() % alignof(std::max_align_t));
+    ASSERT_GE(allocator.GetBlockSize(), 24u);
+
+    std::set<void*> blocks;
+    for (int i = 0; i < 4; ++i) {
+        void* block = allocator.Allocate();
+        ASSERT_TRUE(IsAligned(block, alignof(std::max_align_t)));
+        blocks.insert(block);
+    }
+    ASSERT_EQ(4u, blocks.size());
+    ASSERT_EQ(1u, allocator.GetSlabCount());
+    ASSERT_EQ(4u, allocator.GetBlocksInUse());
+
+    void* block = allocator.Allocate();
+    ASSERT_EQ(0u, blocks.count(block));
+    ASSERT_EQ(2u, allocator.GetSlabCount());
+    blocks.insert(block);
+
+    for (void* b : blocks) {
+        allocator.Deallocate(b);
+    }
+    ASSERT_EQ(0u, allocator.GetBlocksInUse());
+}
+
+// Test that freed blocks are reused before allocating new slabs
+TEST(SlabAllocator, FreedBlocksAreReused) {
+    SlabAllocator allocator(16, 2);
+
+    void* first = allocator.Allocate();
+    void* second = allocator.Allocate();
+    allocator.Deallocate(first);
+
+    ASSERT_EQ(first, allocator.Allocate());
+    ASSERT_EQ(1u, allocator.GetSlabCount());
+
+    allocator.Deallocate(first);
+    allocator.Deallocate(second);
+}
+
+// Test that blocks smaller than a pointer can hold the free list
+TEST(SlabAllocator, TinyBlocks) {
+    SlabAllocator allocator(1, 8);
+    ASSERT_GE(allocator.GetBlockSize(), sizeof(void*));
+
+    void* a = allocator.Allocate();
+    void* b = allocator.Allocate();
+    ASSERT_NE(a, b);
+    allocator.Deallocate(a);
+    allocator.Deallocate(b);
+}
@@ -0,0 +1,98 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/StackVector.h"
+
+#include <memory>
+
+// Test the elements stay inline up to N elements and spill to the heap after
+TEST(StackVector, InlineThenHeap) {
+    StackVector<int, 4> vector;
+    ASSERT_TRUE(vector.empty());
+    ASSERT_TRUE(vector.IsInline());
+    ASSERT_EQ(4u, vector.capacity());
+
+    for (int i = 0; i < 4; ++i) {
+        vector.push_back(i);
+    }
+    ASSERT_TRUE(vector.IsInline());
+
+    vector.push_back(4);
+    ASSERT_FALSE(vector.IsInline());
+    ASSERT_EQ(5u, vector.size());
+
+    int expected = 0;
+    for (int value : vector) {
+        ASSERT_EQ(expected, value);
+        expected++;
+    }
+    ASSERT_EQ(5, expected);
+}
+
+// Test resize value-initializes the new elements and destroys the removed ones
+TEST(StackVector, Resize) {
+    StackVector<std::shared_ptr<int>, 2> vector(3);
+    ASSERT_EQ(3u, vector.size());
+    for (const auto& value : vector) {
+        ASSERT_EQ(nullptr, value);
+    }
+
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+    vector[2] = value;
+    ASSERT_EQ(2, value.use_count());
+
+    vector.resize(1);
+    ASSERT_EQ(1u, vector.size());
+    ASSERT_EQ(1, value.use_count());
+}
+
+// Test copying and moving, both inline and on the heap
+TEST(StackVector, CopyAndMove) {
+    for (size_t size : {2u, 5u}) {
+        StackVector<std::shared_ptr<int>, 4> vector;
+        std::shared_ptr<int> value = std::make_shared<int>(1);
+        for (size_t i = 0; i < size; ++i) {
+            vector.push_back(value);
+        }
+
+        StackVector<std::shared_ptr<int>, 4> copy(vector);
+        ASSERT_EQ(size, copy.size());
+        ASSERT_EQ(static_cast<long>(2 * size + 1), value.use_count());
+
+        StackVector<std::shared_ptr<int>, 4> moved(std::move(copy));
+        ASSERT_EQ(size, moved.size());
+        ASSERT_TRUE(copy.empty());
+        ASSERT_EQ(static_cast<long>(2 * size + 1), value.use_count());
+
+        vector = std::move(moved);
+        ASSERT_EQ(size, vector.size());
+        ASSERT_EQ(static_cast<long>(size + 1), value.use_count());
+
+        vector.clear();
+        ASSERT_EQ(1, value.use_count());
+    }
+}
+
+// Test pushing an element of the vector while it grows
+TEST(StackVector, PushBackOwnElement) {
+    StackVector<std::shared_ptr<int>, 1> vector;
+    vector.push_back(std::make_shared<int>(42));
+    vector.push_back(vector[0]);
+
+    ASSERT_EQ(2u, vector.size());
+    ASSERT_EQ(42, *vector[1]);
+    ASSERT_EQ(vector[0], vector.back());
+}
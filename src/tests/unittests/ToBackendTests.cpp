@@ -19,21 +19,27 @@
 
 #include <type_traits>
 
-// Make our own Base - Backend object pair, reusing the CommandBuffer name
-namespace backend {
-    class CommandBufferBase : public RefCounted {
-    };
-}
-
 using namespace backend;
 
-class MyCommandBuffer : public CommandBufferBase {
+// Make our own Base - Backend object pair. It must not reuse the name of one of the base classes
+// of the backend library, as the definitions would then conflict at link time.
+class MyCommandBufferBase : public RefCounted {
+};
+
+class MyCommandBuffer : public MyCommandBufferBase {
 };
 
 struct MyBackendTraits {
     using CommandBufferType = MyCommandBuffer;
 };
 
+namespace backend {
+    template<typename BackendTraits>
+    struct ToBackendTraits<MyCommandBufferBase, BackendTraits> {
+        using BackendType = typename BackendTraits::CommandBufferType;
+    };
+}
+
 // Instanciate ToBackend for our "backend"
 template<typename T>
 auto ToBackend(T&& common) -> decltype(ToBackendBase<MyBackendTraits>(common)) {
@@ -44,7 +50,7 @@ auto ToBackend(T&& common) -> decltype(ToBackendBase<MyBackendTraits>(common)) {
 TEST(ToBackend, Pointers) {
     {
         MyCommandBuffer* cmdBuf = new MyCommandBuffer;
-        const CommandBufferBase* base = cmdBuf;
+        const MyCommandBufferBase* base = cmdBuf;
 
         auto backendCmdBuf = ToBackend(base);
         static_assert(std::is_same<decltype(backendCmdBuf), const MyCommandBuffer*>::value, "");
@@ -54,7 +60,7 @@ TEST(ToBackend, Pointers) {
     }
     {
         MyCommandBuffer* cmdBuf = new MyCommandBuffer;
-        CommandBufferBase* base = cmdBuf;
+        MyCommandBufferBase* base = cmdBuf;
 
         auto backendCmdBuf = ToBackend(base);
         static_assert(std::is_same<decltype(backendCmdBuf), MyCommandBuffer*>::value, "");
@@ -68,7 +74,7 @@ TEST(ToBackend, Pointers) {
 TEST(ToBackend, Ref) {
     {
         MyCommandBuffer* cmdBuf = new MyCommandBuffer;
-        const Ref<CommandBufferBase> base(cmdBuf);
+        const Ref<MyCommandBufferBase> base(cmdBuf);
 
         const auto& backendCmdBuf = ToBackend(base);
         static_assert(std::is_same<decltype(ToBackend(base)), const Ref<MyCommandBuffer>&>::value, "");
@@ -78,7 +84,7 @@ TEST(ToBackend, Ref) {
     }
     {
         MyCommandBuffer* cmdBuf = new MyCommandBuffer;
-        Ref<CommandBufferBase> base(cmdBuf);
+        Ref<MyCommandBufferBase> base(cmdBuf);
 
         auto backendCmdBuf = ToBackend(base);
         static_assert(std::is_same<decltype(ToBackend(base)), Ref<MyCommandBuffer>&>::value, "");
@@ -0,0 +1,114 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/Tracing.h"
+
+#include <cstring>
+#include <string>
+
+class TracingTest : public testing::Test {
+    protected:
+        void TearDown() override {
+            tracing::Disable();
+            tracing::ClearEvents();
+        }
+};
+
+// Test that nothing is recorded while tracing is disabled
+TEST_F(TracingTest, DisabledRecordsNothing) {
+    ASSERT_FALSE(tracing::IsEnabled());
+    {
+        tracing::ScopedEvent event("test", "Disabled");
+    }
+    ASSERT_TRUE(tracing::GetEvents().empty());
+}
+
+// Test that events are recorded when their scope ends, with the inner events first
+TEST_F(TracingTest, NestedEvents) {
+    tracing::Enable();
+    {
+        tracing::ScopedEvent outer("test", "Outer");
+        {
+            tracing::ScopedEvent inner("test", "Inner");
+        }
+    }
+    tracing::Disable();
+
+    std::vector<tracing::TraceEvent> events = tracing::GetEvents();
+    ASSERT_EQ(2u, events.size());
+    ASSERT_STREQ("Inner", events[0].name);
+    ASSERT_STREQ("Outer", events[1].name);
+    ASSERT_STREQ("test", events[1].category);
+    ASSERT_EQ(events[0].threadId, events[1].threadId);
+
+    // The inner event is contained in the outer one.
+    ASSERT_LE(events[1].beginNanoseconds, events[0].beginNanoseconds);
+    ASSERT_GE(events[1].beginNanoseconds + events[1].durationNanoseconds,
+              events[0].beginNanoseconds + events[0].durationNanoseconds);
+}
+
+// Test that an event whose scope ends after tracing is disabled isn't recorded
+TEST_F(TracingTest, DisableDuringEvent) {
+    tracing::Enable();
+    {
+        tracing::ScopedEvent event("test", "Event");
+        tracing::Disable();
+    }
+    ASSERT_TRUE(tracing::GetEvents().empty());
+}
+
+// Test that an event whose scope begins before tracing is enabled isn't recorded
+TEST_F(TracingTest, EnableDuringEvent) {
+    {
+        tracing::ScopedEvent event("test", "Event");
+        tracing::Enable();
+    }
+    tracing::Disable();
+    ASSERT_TRUE(tracing::GetEvents().empty());
+}
+
+// Test that only the most recent events are kept when the ring buffer is full
+TEST_F(TracingTest, RingBufferWraps) {
+    const char* names[] = {"0", "1", "2", "3", "4"};
+
+    tracing::Enable(3);
+    for (const char* name : names) {
+        tracing::ScopedEvent event("test", name);
+    }
+
+    std::vector<tracing::TraceEvent> events = tracing::GetEvents();
+    ASSERT_EQ(3u, events.size());
+    ASSERT_STREQ("2", events[0].name);
+    ASSERT_STREQ("3", events[1].name);
+    ASSERT_STREQ("4", events[2].name);
+
+    tracing::ClearEvents();
+    ASSERT_TRUE(tracing::GetEvents().empty());
+}
+
+// Test the events are dumped as complete events of the trace_event format
+TEST_F(TracingTest, JSON) {
+    tracing::Enable();
+    {
+        tracing::ScopedEvent event("test", "Quoted \"name\"");
+    }
+
+    std::string json = tracing::GetEventsAsJSON();
+    ASSERT_EQ(0u, json.find("{\"traceEvents\": ["));
+    ASSERT_NE(std::string::npos, json.find("\"cat\": \"test\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"Quoted \\\"name\\\"\""));
+    ASSERT_NE(std::string::npos, json.find("\"ph\": \"X\""));
+}
@@ -0,0 +1,115 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/TypedBitSet.h"
+
+#include <vector>
+
+enum class Property {
+    A,
+    B,
+    C,
+    Count,
+};
+
+// Test setting, resetting and testing bits
+TEST(TypedBitSet, Basic) {
+    TypedBitSet<Property, static_cast<size_t>(Property::Count)> bits;
+    ASSERT_TRUE(bits.none());
+    ASSERT_EQ(3u, bits.size());
+
+    bits.set(Property::B);
+    ASSERT_TRUE(bits.any());
+    ASSERT_FALSE(bits.all());
+    ASSERT_TRUE(bits[Property::B]);
+    ASSERT_FALSE(bits.test(Property::A));
+    ASSERT_EQ(1u, bits.count());
+
+    bits.set(Property::A);
+    bits.set(Property::C);
+    ASSERT_TRUE(bits.all());
+
+    bits.reset(Property::A);
+    ASSERT_FALSE(bits[Property::A]);
+    ASSERT_EQ(2u, bits.count());
+
+    bits.reset();
+    ASSERT_TRUE(bits.none());
+}
+
+// Test comparisons and bitwise operations
+TEST(TypedBitSet, Operations) {
+    TypedBitSet<uint32_t, 40> a;
+    TypedBitSet<uint32_t, 40> b;
+    ASSERT_EQ(a, b);
+
+    a.set(3);
+    a.set(35);
+    ASSERT_NE(a, b);
+
+    b.set(35);
+    b.set(39);
+    TypedBitSet<uint32_t, 40> intersection = a;
+    intersection &= b;
+    ASSERT_EQ(1u, intersection.count());
+    ASSERT_TRUE(intersection[35]);
+
+    a |= b;
+    ASSERT_EQ(3u, a.count());
+}
+
+// Test all() when the size is a multiple of the word size
+TEST(TypedBitSet, AllWithFullWords) {
+    TypedBitSet<uint32_t, 64> bits;
+    for (uint32_t i = 0; i < 63; ++i) {
+        bits.set(i);
+    }
+    ASSERT_FALSE(bits.all());
+    bits.set(63);
+    ASSERT_TRUE(bits.all());
+}
+
+// Test iterating over the set bits, across words
+TEST(TypedBitSet, Iterate) {
+    TypedBitSet<uint32_t, 100> bits;
+    for (uint32_t value : IterateBitSet(bits)) {
+        (void) value;
+        ASSERT_TRUE(false);
+    }
+
+    std::vector<uint32_t> expected = {0, 5, 31, 32, 63, 64, 99};
+    for (uint32_t bit : expected) {
+        bits.set(bit);
+    }
+
+    std::vector<uint32_t> seen;
+    for (uint32_t bit : IterateBitSet(bits)) {
+        seen.push_back(bit);
+    }
+    ASSERT_EQ(expected, seen);
+}
+
+// Test that iteration produces values of the index type
+TEST(TypedBitSet, IterateTyped) {
+    TypedBitSet<Property, static_cast<size_t>(Property::Count)> bits;
+    bits.set(Property::C);
+
+    std::vector<Property> seen;
+    for (Property property : IterateBitSet(bits)) {
+        seen.push_back(property);
+    }
+    ASSERT_EQ(std::vector<Property>({Property::C}), seen);
+}
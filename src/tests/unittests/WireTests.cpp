@@ -197,6 +197,27 @@ TEST_F(WireTests, ValueArgument) {
     FlushClient();
 }
 
+// Test that the wire is able to send structures
+bool CheckSamplerDescriptor(const nxtSamplerDescriptor* descriptor) {
+    return descriptor->magFilter == NXT_FILTER_MODE_LINEAR &&
+        descriptor->minFilter == NXT_FILTER_MODE_LINEAR &&
+        descriptor->mipmapFilter == NXT_FILTER_MODE_NEAREST;
+}
+
+TEST_F(WireTests, StructureArgument) {
+    nxtSamplerDescriptor descriptor;
+    descriptor.magFilter = NXT_FILTER_MODE_LINEAR;
+    descriptor.minFilter = NXT_FILTER_MODE_LINEAR;
+    descriptor.mipmapFilter = NXT_FILTER_MODE_NEAREST;
+    nxtDeviceCreateSampler(device, &descriptor);
+
+    nxtSampler apiSampler = api.GetNewSampler();
+    EXPECT_CALL(api, DeviceCreateSampler(apiDevice, ResultOf(CheckSamplerDescriptor, Eq(true))))
+        .WillOnce(Return(apiSampler));
+
+    FlushClient();
+}
+
 // Test that the wire is able to send arrays of numerical values
 static constexpr uint32_t testPushConstantValues[4] = {
     0,
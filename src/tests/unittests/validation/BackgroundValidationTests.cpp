@@ -0,0 +1,112 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "backend/Device.h"
+#include "utils/NXTHelpers.h"
+
+class BackgroundValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+            reinterpret_cast<backend::DeviceBase*>(device.Get())->SetBackgroundValidationEnabled(true);
+
+            queue = device.CreateQueueBuilder().GetResult();
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+        }
+
+        nxt::Queue queue;
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+};
+
+// Test that a valid command buffer can be submitted
+TEST_F(BackgroundValidationTest, Success) {
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+    ASSERT_NE(nullptr, commands.Get());
+
+    queue.Submit(1, &commands);
+}
+
+// Test that an invalid command buffer is returned but can't be submitted
+TEST_F(BackgroundValidationTest, ErrorOnSubmit) {
+    nxt::CommandBuffer commands = AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .GetResult();
+    ASSERT_NE(nullptr, commands.Get());
+
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &commands));
+}
+
+// Test that the builder callback is called when the command buffer is destroyed before being submitted
+TEST_F(BackgroundValidationTest, ErrorOnDestruction) {
+    nxt::CommandBuffer commands = AssertWillBeError(device.CreateCommandBufferBuilder())
+        .EndRenderPass()
+        .GetResult();
+    commands = nxt::CommandBuffer();
+}
+
+// Test that the resources transitioned by the command buffer are still checked on submit
+TEST_F(BackgroundValidationTest, TransitionFrozenBuffer) {
+    nxt::Buffer buffer = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc | nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .TransitionBufferUsage(buffer, nxt::BufferUsageBit::TransferSrc)
+        .GetResult();
+
+    queue.Submit(1, &commands);
+    buffer.FreezeUsage(nxt::BufferUsageBit::TransferDst);
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &commands));
+}
+
+// Test that freezing a buffer after GetResult doesn't change what the validation thread sees and
+// is caught on submit instead
+TEST_F(BackgroundValidationTest, FreezeAfterGetResult) {
+    nxt::Buffer buffer = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc | nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .TransitionBufferUsage(buffer, nxt::BufferUsageBit::TransferSrc)
+        .GetResult();
+
+    buffer.FreezeUsage(nxt::BufferUsageBit::TransferDst);
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &commands));
+}
+
+// Test that many command buffers can be validated while others are recorded
+TEST_F(BackgroundValidationTest, ManyCommandBuffers) {
+    std::vector<nxt::CommandBuffer> commands;
+    for (int i = 0; i < 100; ++i) {
+        commands.push_back(AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+            .BeginRenderPass(renderpass, framebuffer)
+            .BeginRenderSubpass()
+            .EndRenderSubpass()
+            .EndRenderPass()
+            .GetResult());
+    }
+
+    queue.Submit(static_cast<uint32_t>(commands.size()), commands.data());
+}
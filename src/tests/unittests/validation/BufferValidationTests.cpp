@@ -83,6 +83,27 @@ TEST_F(BufferValidationTest, CreationSuccess) {
     }
 }
 
+// Test creating buffers from a descriptor
+TEST_F(BufferValidationTest, CreationFromDescriptor) {
+    nxt::BufferDescriptor descriptor;
+    descriptor.allowedUsage = nxt::BufferUsageBit::Uniform;
+    descriptor.initialUsage = nxt::BufferUsageBit::Uniform;
+    descriptor.size = 4;
+
+    nxt::Buffer buf = device.CreateBuffer(&descriptor);
+    ASSERT_TRUE(buf);
+
+    // The builder's validation errors are device errors
+    descriptor.initialUsage = nxt::BufferUsageBit::Vertex;
+    ASSERT_DEVICE_ERROR(buf = device.CreateBuffer(&descriptor));
+    ASSERT_FALSE(buf);
+
+    // Unknown usage bits are an error
+    descriptor.initialUsage = static_cast<nxt::BufferUsageBit>(0x80000000u);
+    ASSERT_DEVICE_ERROR(buf = device.CreateBuffer(&descriptor));
+    ASSERT_FALSE(buf);
+}
+
 // Test failure when specifying properties multiple times
 TEST_F(BufferValidationTest, CreationDuplicates) {
     // When size is specified multiple times
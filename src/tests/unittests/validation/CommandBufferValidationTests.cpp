@@ -14,6 +14,11 @@
 
 #include "tests/unittests/validation/ValidationTest.h"
 
+#include "utils/NXTHelpers.h"
+
+#include <thread>
+#include <vector>
+
 class CommandBufferValidationTest : public ValidationTest {
 };
 
@@ -63,3 +68,56 @@ TEST_F(CommandBufferValidationTest, RenderPass) {
         .BeginRenderPass(renderpass, framebuffer)
         .GetResult();
 }
+
+// Test that command buffers can be recorded on several threads at the same time
+TEST_F(CommandBufferValidationTest, MultithreadedRecording) {
+    nxt::RenderPass renderpass;
+    nxt::Framebuffer framebuffer;
+    utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+    nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+        #version 450
+        void main() {
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        })"
+    );
+    nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+        #version 450
+        out vec4 fragColor;
+        void main() {
+            fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+        })"
+    );
+    nxt::Pipeline pipeline = device.CreatePipelineBuilder()
+        .SetSubpass(renderpass, 0)
+        .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+        .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+        .GetResult();
+
+    // Expectations can't be added concurrently so the builders are all created upfront.
+    const int kThreadCount = 8;
+    std::vector<nxt::CommandBufferBuilder> builders;
+    for (int i = 0; i < kThreadCount; ++i) {
+        builders.push_back(AssertWillBeSuccess(device.CreateCommandBufferBuilder()));
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+        threads.emplace_back([&, i]() {
+            const nxt::CommandBufferBuilder& builder = builders[i];
+            builder.BeginRenderPass(renderpass, framebuffer)
+                   .BeginRenderSubpass();
+            for (uint32_t j = 0; j < 1000; ++j) {
+                builder.SetPipeline(pipeline)
+                       .SetPushConstants(nxt::ShaderStageBit::Vertex, 0, 1, &j)
+                       .DrawArrays(3, 1, 0, 0);
+            }
+            builder.EndRenderSubpass()
+                   .EndRenderPass()
+                   .GetResult();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "backend/Device.h"
+#include "backend/RefCounted.h"
+
+class DeferredDestructionTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+            backendDevice = reinterpret_cast<backend::DeviceBase*>(device.Get());
+            queue = device.CreateQueueBuilder().GetResult();
+        }
+
+        backend::DeviceBase* backendDevice = nullptr;
+        nxt::Queue queue;
+};
+
+struct DDTest : public backend::RefCounted {
+    DDTest(bool* deleted): deleted(deleted) {
+    }
+
+    ~DDTest() override {
+        *deleted = true;
+    }
+
+    bool* deleted;
+};
+
+// Test that the objects used by a submitted command buffer live until the next Tick
+TEST_F(DeferredDestructionTest, SubmittedCommandsLiveUntilTick) {
+    nxt::Buffer buffer = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferSrc)
+        .GetResult();
+    backend::RefCounted* backendBuffer = reinterpret_cast<backend::RefCounted*>(buffer.Get());
+    uint32_t internalRefs = backendBuffer->GetInternalRefs();
+
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .TransitionBufferUsage(buffer, nxt::BufferUsageBit::TransferSrc)
+        .GetResult();
+    ASSERT_EQ(internalRefs + 1, backendBuffer->GetInternalRefs());
+
+    queue.Submit(1, &commands);
+    commands = nxt::CommandBuffer();
+    ASSERT_EQ(internalRefs + 1, backendBuffer->GetInternalRefs());
+
+    device.Tick();
+    ASSERT_EQ(internalRefs, backendBuffer->GetInternalRefs());
+}
+
+// Test that objects are only released once their serial is completed
+TEST_F(DeferredDestructionTest, ReleasedWhenSerialCompletes) {
+    bool deleted = false;
+    DDTest* test = new DDTest(&deleted);
+
+    backendDevice->KeepAliveUntilSerial(test, backendDevice->GetCompletedCommandSerial() + 1);
+    test->Release();
+    ASSERT_FALSE(deleted);
+
+    device.Tick();
+    ASSERT_FALSE(deleted);
+
+    queue.Submit(0, nullptr);
+    ASSERT_FALSE(deleted);
+
+    device.Tick();
+    ASSERT_TRUE(deleted);
+}
+
+// Test that the objects still kept alive are released when the device is destroyed
+TEST_F(DeferredDestructionTest, ReleasedOnDeviceDestruction) {
+    bool deleted = false;
+    DDTest* test = new DDTest(&deleted);
+
+    backendDevice->KeepAliveUntilSerial(test, backendDevice->GetCompletedCommandSerial() + 1);
+    test->Release();
+
+    queue = nxt::Queue();
+    device = nxt::Device();
+    ASSERT_TRUE(deleted);
+}
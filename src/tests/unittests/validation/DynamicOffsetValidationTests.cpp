@@ -0,0 +1,118 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "backend/CommandBuffer.h"
+#include "common/Constants.h"
+
+class DynamicOffsetValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            // A static uniform buffer between two dynamic ones, to check the offsets apply to the
+            // dynamic buffers in binding order.
+            nxt::BindGroupLayout bgl = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::DynamicUniformBuffer, 0, 1)
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 1, 1)
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::DynamicUniformBuffer, 2, 1)
+                .GetResult();
+
+            nxt::Buffer buffer = device.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::Uniform)
+                .SetSize(4 * kDynamicBufferOffsetAlignment)
+                .GetResult();
+            buffer.FreezeUsage(nxt::BufferUsageBit::Uniform);
+
+            // The first dynamic view can move by up to three times the alignment, the second
+            // one by up to two times.
+            nxt::BufferView views[3] = {
+                buffer.CreateBufferViewBuilder().SetExtent(0, kDynamicBufferOffsetAlignment).GetResult(),
+                buffer.CreateBufferViewBuilder().SetExtent(0, 16).GetResult(),
+                buffer.CreateBufferViewBuilder().SetExtent(kDynamicBufferOffsetAlignment, kDynamicBufferOffsetAlignment).GetResult(),
+            };
+            bindGroup = device.CreateBindGroupBuilder()
+                .SetLayout(bgl)
+                .SetUsage(nxt::BindGroupUsage::Frozen)
+                .SetBufferViews(0, 3, views)
+                .GetResult();
+        }
+
+        nxt::BindGroup bindGroup;
+};
+
+// Test offsets that keep the dynamic views in their buffer
+TEST_F(DynamicOffsetValidationTest, OffsetsInBounds) {
+    uint32_t zeroOffsets[2] = {0, 0};
+    uint32_t maxOffsets[2] = {3 * kDynamicBufferOffsetAlignment, 2 * kDynamicBufferOffsetAlignment};
+
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 2, zeroOffsets)
+        .SetBindGroup(0, bindGroup, 2, maxOffsets)
+        .GetResult();
+}
+
+// Test that there must be exactly one offset per dynamic buffer
+TEST_F(DynamicOffsetValidationTest, WrongOffsetCount) {
+    uint32_t offsets[3] = {0, 0, 0};
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 1, offsets)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 3, offsets)
+        .GetResult();
+}
+
+// Test that offsets must be aligned
+TEST_F(DynamicOffsetValidationTest, UnalignedOffset) {
+    uint32_t offsets[2] = {0, 4};
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 2, offsets)
+        .GetResult();
+}
+
+// Test that offsets can't move the views out of their buffer, taking the view offsets into account
+TEST_F(DynamicOffsetValidationTest, OffsetsOutOfBounds) {
+    uint32_t firstOutOfBounds[2] = {4 * kDynamicBufferOffsetAlignment, 0};
+    uint32_t secondOutOfBounds[2] = {0, 3 * kDynamicBufferOffsetAlignment};
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 2, firstOutOfBounds)
+        .GetResult();
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 2, secondOutOfBounds)
+        .GetResult();
+}
+
+// Test that setting the same bind group with other offsets isn't considered redundant
+TEST_F(DynamicOffsetValidationTest, OffsetsChangeIsNotRedundant) {
+    uint32_t offsets[2] = {0, 0};
+    uint32_t otherOffsets[2] = {kDynamicBufferOffsetAlignment, 0};
+
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, bindGroup, 2, offsets)
+        // Redundant
+        .SetBindGroup(0, bindGroup, 2, offsets)
+        .SetBindGroup(0, bindGroup, 2, otherOffsets)
+        .SetBindGroup(0, bindGroup, 2, offsets)
+        .GetResult();
+
+    ASSERT_EQ(1u, reinterpret_cast<backend::CommandBufferBase*>(commands.Get())->GetRedundantStateCommandsRemoved());
+}
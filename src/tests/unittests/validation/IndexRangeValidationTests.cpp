@@ -0,0 +1,233 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "utils/NXTHelpers.h"
+
+class IndexRangeValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            queue = device.CreateQueueBuilder().GetResult();
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+            nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                #version 450
+                layout(location = 0) in vec4 pos;
+                void main() {
+                    gl_Position = pos;
+                })"
+            );
+
+            nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                #version 450
+                out vec4 fragColor;
+                void main() {
+                    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            nxt::InputState inputState = device.CreateInputStateBuilder()
+                .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+                .SetInput(0, 4 * sizeof(float), nxt::InputStepMode::Vertex)
+                .GetResult();
+
+            pipeline = device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetLayout(device.CreatePipelineLayoutBuilder().GetResult())
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .SetInputState(inputState)
+                .GetResult();
+
+            // Four vertices
+            float vertices[16] = {};
+            vertexBuffer = utils::CreateFrozenBufferFromData(device, vertices, sizeof(vertices),
+                nxt::BufferUsageBit::Vertex);
+        }
+
+        nxt::Buffer CreateIndexBuffer(const uint32_t* indices, uint32_t count) {
+            nxt::Buffer buffer = device.CreateBufferBuilder()
+                .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Index)
+                .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+                .SetSize(count * sizeof(uint32_t))
+                .GetResult();
+            buffer.SetSubData(0, count, indices);
+            buffer.TransitionUsage(nxt::BufferUsageBit::Index);
+            return buffer;
+        }
+
+        // Records a DrawElements of the given range of an index buffer in the Index usage.
+        nxt::CommandBuffer RecordDraw(nxt::CommandBufferBuilder builder, const nxt::Buffer& indexBuffer,
+                                      uint32_t indexCount, uint32_t firstIndex, uint32_t vertexOffset = 0) {
+            return builder.TransitionBufferUsage(indexBuffer, nxt::BufferUsageBit::Index)
+                .BeginRenderPass(renderpass, framebuffer)
+                .BeginRenderSubpass()
+                    .SetPipeline(pipeline)
+                    .SetVertexBuffers(0, 1, &vertexBuffer, &vertexOffset)
+                    .SetIndexBuffer(indexBuffer, 0, nxt::IndexFormat::Uint32)
+                    .DrawElements(indexCount, 1, firstIndex, 0)
+                .EndRenderSubpass()
+                .EndRenderPass()
+                .GetResult();
+        }
+
+        nxt::Queue queue;
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+        nxt::Pipeline pipeline;
+        nxt::Buffer vertexBuffer;
+};
+
+// Test that indices inside the vertex buffers are valid
+TEST_F(IndexRangeValidationTest, IndicesInBounds) {
+    uint32_t indices[4] = {0, 1, 2, 3};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    nxt::CommandBuffer commands = RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+    queue.Submit(1, &commands);
+}
+
+// Test that an index past the end of the vertex buffers is an error
+TEST_F(IndexRangeValidationTest, IndexOutOfBounds) {
+    uint32_t indices[4] = {0, 1, 2, 4};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+}
+
+// Test that only the indices used by the draw are checked
+TEST_F(IndexRangeValidationTest, OnlyDrawnIndicesAreChecked) {
+    uint32_t indices[4] = {4, 1, 2, 3};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 3, 1);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 2, 0);
+}
+
+// Test that the offset of the vertex buffer reduces the number of vertices available
+TEST_F(IndexRangeValidationTest, VertexBufferOffset) {
+    uint32_t indices[4] = {0, 1, 2, 3};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 3, 0, 16);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0, 16);
+}
+
+// Test that drawing past the end of the index buffer is an error
+TEST_F(IndexRangeValidationTest, IndexRangeOutOfIndexBuffer) {
+    uint32_t indices[4] = {0, 1, 2, 3};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 1);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 5, 0);
+}
+
+// Test that only the indices written with SetSubData are known, including when the writes are
+// merged together
+TEST_F(IndexRangeValidationTest, PartiallyWrittenContents) {
+    nxt::Buffer indexBuffer = device.CreateBufferBuilder()
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Index)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .SetSize(8 * sizeof(uint32_t))
+        .GetResult();
+    uint32_t highIndices[4] = {0, 1, 2, 4};
+    indexBuffer.SetSubData(4, 4, highIndices);
+
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 3, 4);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 4);
+
+    uint32_t lowIndices[4] = {0, 5, 2, 3};
+    indexBuffer.SetSubData(0, 4, lowIndices);
+
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 5, 2);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 6, 2);
+}
+
+// Test that the indices of disjoint writes are all known, including a small write that spans two
+// pages of the copy of the contents
+TEST_F(IndexRangeValidationTest, DisjointWrites) {
+    nxt::Buffer indexBuffer = device.CreateBufferBuilder()
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Index)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .SetSize(2048 * sizeof(uint32_t))
+        .GetResult();
+    uint32_t largeIndices[16] = {};
+    indexBuffer.SetSubData(0, 16, largeIndices);
+    uint32_t smallIndices[4] = {0, 1, 2, 4};
+    indexBuffer.SetSubData(1022, 4, smallIndices);
+
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 16, 0);
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 3, 1022);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 4, 1022);
+    RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 1, 1025);
+    // The indices in between weren't written so they aren't checked.
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 4, 1026);
+}
+
+// Test that the results cached for many different ranges are still correct
+TEST_F(IndexRangeValidationTest, ManyRanges) {
+    uint32_t indices[32] = {};
+    indices[31] = 4;
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 32);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        for (uint32_t firstIndex = 0; firstIndex < 31; ++firstIndex) {
+            RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 31 - firstIndex, firstIndex);
+            RecordDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), indexBuffer, 32 - firstIndex, firstIndex);
+        }
+    }
+}
+
+// Test that the indices of a buffer written by the GPU aren't known and aren't checked
+TEST_F(IndexRangeValidationTest, ContentsWrittenByGPUAreNotChecked) {
+    uint32_t indices[4] = {0, 1, 2, 4};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+    nxt::Buffer source = utils::CreateFrozenBufferFromData(device, indices, sizeof(indices),
+        nxt::BufferUsageBit::TransferSrc);
+
+    nxt::CommandBufferBuilder builder = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .TransitionBufferUsage(indexBuffer, nxt::BufferUsageBit::TransferDst)
+        .CopyBufferToBuffer(source, 0, indexBuffer, 0, sizeof(indices))
+        .Clone();
+    nxt::CommandBuffer commands = RecordDraw(builder.Clone(), indexBuffer, 4, 0);
+    queue.Submit(1, &commands);
+
+    // The submitted command buffer wrote the buffer so its contents aren't known anymore.
+    RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+}
+
+// Test that the indices are checked again on submit if they changed since the command buffer was
+// recorded
+TEST_F(IndexRangeValidationTest, IndicesChangedBeforeSubmit) {
+    uint32_t indices[4] = {0, 1, 2, 3};
+    nxt::Buffer indexBuffer = CreateIndexBuffer(indices, 4);
+
+    nxt::CommandBuffer commands = RecordDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), indexBuffer, 4, 0);
+    queue.Submit(1, &commands);
+
+    indexBuffer.TransitionUsage(nxt::BufferUsageBit::TransferDst);
+    indices[3] = 4;
+    indexBuffer.SetSubData(0, 4, indices);
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &commands));
+
+    indexBuffer.TransitionUsage(nxt::BufferUsageBit::TransferDst);
+    indices[3] = 3;
+    indexBuffer.SetSubData(0, 4, indices);
+    queue.Submit(1, &commands);
+}
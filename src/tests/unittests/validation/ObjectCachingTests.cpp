@@ -0,0 +1,198 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "utils/NXTHelpers.h"
+
+class ObjectCachingTest : public ValidationTest {
+    protected:
+        nxt::BindGroupLayout CreateBindGroupLayout(nxt::BindingType type) {
+            return device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, type, 0, 1)
+                .GetResult();
+        }
+};
+
+// Test that equivalent bind group layouts are the same object, and different ones aren't
+TEST_F(ObjectCachingTest, BindGroupLayout) {
+    nxt::BindGroupLayout bgl = CreateBindGroupLayout(nxt::BindingType::UniformBuffer);
+    nxt::BindGroupLayout sameBgl = CreateBindGroupLayout(nxt::BindingType::UniformBuffer);
+    nxt::BindGroupLayout otherBgl = CreateBindGroupLayout(nxt::BindingType::StorageBuffer);
+
+    EXPECT_EQ(bgl.Get(), sameBgl.Get());
+    EXPECT_NE(bgl.Get(), otherBgl.Get());
+}
+
+// Test that pipeline layouts are cached, using the identity of their bind group layouts
+TEST_F(ObjectCachingTest, PipelineLayout) {
+    nxt::BindGroupLayout bgl = CreateBindGroupLayout(nxt::BindingType::UniformBuffer);
+    nxt::BindGroupLayout otherBgl = CreateBindGroupLayout(nxt::BindingType::StorageBuffer);
+
+    nxt::PipelineLayout layout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(0, bgl)
+        .GetResult();
+    nxt::PipelineLayout sameLayout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(0, CreateBindGroupLayout(nxt::BindingType::UniformBuffer))
+        .GetResult();
+    nxt::PipelineLayout otherLayout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(0, otherBgl)
+        .GetResult();
+    nxt::PipelineLayout otherGroupLayout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(1, bgl)
+        .GetResult();
+
+    EXPECT_EQ(layout.Get(), sameLayout.Get());
+    EXPECT_NE(layout.Get(), otherLayout.Get());
+    EXPECT_NE(layout.Get(), otherGroupLayout.Get());
+}
+
+// Test that frozen bind groups with the same bindings are cached but not dynamic ones
+TEST_F(ObjectCachingTest, BindGroup) {
+    nxt::BindGroupLayout bgl = CreateBindGroupLayout(nxt::BindingType::UniformBuffer);
+    nxt::Buffer buffer = device.CreateBufferBuilder()
+        .SetAllowedUsage(nxt::BufferUsageBit::Uniform)
+        .SetSize(64)
+        .GetResult();
+    nxt::BufferView view = buffer.CreateBufferViewBuilder()
+        .SetExtent(0, 64)
+        .GetResult();
+    nxt::BufferView otherView = buffer.CreateBufferViewBuilder()
+        .SetExtent(0, 64)
+        .GetResult();
+
+    auto CreateBindGroup = [&](const nxt::BufferView& bufferView, nxt::BindGroupUsage usage) {
+        return device.CreateBindGroupBuilder()
+            .SetLayout(bgl)
+            .SetUsage(usage)
+            .SetBufferViews(0, 1, &bufferView)
+            .GetResult();
+    };
+
+    nxt::BindGroup group = CreateBindGroup(view, nxt::BindGroupUsage::Frozen);
+    EXPECT_EQ(group.Get(), CreateBindGroup(view, nxt::BindGroupUsage::Frozen).Get());
+    EXPECT_NE(group.Get(), CreateBindGroup(otherView, nxt::BindGroupUsage::Frozen).Get());
+
+    nxt::BindGroup dynamicGroup = CreateBindGroup(view, nxt::BindGroupUsage::Dynamic);
+    EXPECT_NE(group.Get(), dynamicGroup.Get());
+    EXPECT_NE(dynamicGroup.Get(), CreateBindGroup(view, nxt::BindGroupUsage::Dynamic).Get());
+}
+
+// Test that input states are cached
+TEST_F(ObjectCachingTest, InputState) {
+    auto CreateInputState = [&](uint32_t stride) {
+        return device.CreateInputStateBuilder()
+            .SetInput(0, stride, nxt::InputStepMode::Vertex)
+            .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+            .GetResult();
+    };
+
+    nxt::InputState inputState = CreateInputState(16);
+    EXPECT_EQ(inputState.Get(), CreateInputState(16).Get());
+    EXPECT_NE(inputState.Get(), CreateInputState(32).Get());
+}
+
+// Test that depth stencil states are cached
+TEST_F(ObjectCachingTest, DepthStencilState) {
+    auto CreateDepthStencilState = [&](nxt::CompareFunction compareFunction) {
+        return device.CreateDepthStencilStateBuilder()
+            .SetDepthCompareFunction(compareFunction)
+            .SetDepthWriteEnabled(true)
+            .GetResult();
+    };
+
+    nxt::DepthStencilState state = CreateDepthStencilState(nxt::CompareFunction::Less);
+    EXPECT_EQ(state.Get(), CreateDepthStencilState(nxt::CompareFunction::Less).Get());
+    EXPECT_NE(state.Get(), CreateDepthStencilState(nxt::CompareFunction::Greater).Get());
+}
+
+// Test that render passes are cached
+TEST_F(ObjectCachingTest, RenderPass) {
+    auto CreateRenderPass = [&](uint32_t attachmentCount) {
+        nxt::RenderPassBuilder builder = device.CreateRenderPassBuilder();
+        builder.SetAttachmentCount(attachmentCount);
+        for (uint32_t i = 0; i < attachmentCount; ++i) {
+            builder.AttachmentSetFormat(i, nxt::TextureFormat::R8G8B8A8Unorm);
+        }
+        return builder.SetSubpassCount(1)
+            .SubpassSetColorAttachment(0, 0, 0)
+            .GetResult();
+    };
+
+    nxt::RenderPass renderPass = CreateRenderPass(1);
+    EXPECT_EQ(renderPass.Get(), CreateRenderPass(1).Get());
+    EXPECT_NE(renderPass.Get(), CreateRenderPass(2).Get());
+}
+
+// Test that samplers are cached
+TEST_F(ObjectCachingTest, Sampler) {
+    auto CreateSampler = [&](nxt::FilterMode filter) {
+        return device.CreateSamplerBuilder()
+            .SetFilterMode(filter, filter, filter)
+            .GetResult();
+    };
+
+    nxt::Sampler sampler = CreateSampler(nxt::FilterMode::Linear);
+    EXPECT_EQ(sampler.Get(), CreateSampler(nxt::FilterMode::Linear).Get());
+    EXPECT_NE(sampler.Get(), CreateSampler(nxt::FilterMode::Nearest).Get());
+
+    // Samplers created from a descriptor share the cache
+    nxt::SamplerDescriptor descriptor;
+    descriptor.magFilter = nxt::FilterMode::Linear;
+    descriptor.minFilter = nxt::FilterMode::Linear;
+    descriptor.mipmapFilter = nxt::FilterMode::Linear;
+    EXPECT_EQ(sampler.Get(), device.CreateSampler(&descriptor).Get());
+}
+
+// Test that shader modules are cached by their SPIR-V
+TEST_F(ObjectCachingTest, ShaderModule) {
+    const char* source = R"(
+        #version 450
+        out vec4 fragColor;
+        void main() {
+            fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+        })";
+    const char* otherSource = R"(
+        #version 450
+        void main() {
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        })";
+
+    nxt::ShaderModule module = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, source);
+    EXPECT_EQ(module.Get(), utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, source).Get());
+    EXPECT_NE(module.Get(), utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, otherSource).Get());
+}
+
+// Test that an object only referenced by other objects is found in the cache
+TEST_F(ObjectCachingTest, ObjectWithOnlyInternalReferences) {
+    nxt::PipelineLayout layout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(0, CreateBindGroupLayout(nxt::BindingType::UniformBuffer))
+        .GetResult();
+
+    nxt::BindGroupLayout bgl = CreateBindGroupLayout(nxt::BindingType::UniformBuffer);
+    nxt::PipelineLayout sameLayout = device.CreatePipelineLayoutBuilder()
+        .SetBindGroupLayout(0, bgl)
+        .GetResult();
+    EXPECT_EQ(layout.Get(), sameLayout.Get());
+}
+
+// Test that an object can be created again after it is destroyed and removed from the cache
+TEST_F(ObjectCachingTest, RecreateDestroyedObject) {
+    for (int i = 0; i < 2; ++i) {
+        nxt::Sampler sampler = device.CreateSamplerBuilder()
+            .SetFilterMode(nxt::FilterMode::Linear, nxt::FilterMode::Linear, nxt::FilterMode::Linear)
+            .GetResult();
+        ASSERT_NE(nullptr, sampler.Get());
+    }
+}
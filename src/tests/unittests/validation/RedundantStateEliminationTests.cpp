@@ -0,0 +1,261 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "backend/CommandBuffer.h"
+#include "backend/Device.h"
+#include "utils/NXTHelpers.h"
+
+class RedundantStateEliminationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+            nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                #version 450
+                layout(set = 0, binding = 0) uniform Data {
+                    float scale;
+                } data;
+                layout(location = 0) in vec4 pos;
+                void main() {
+                    gl_Position = pos * data.scale;
+                })"
+            );
+
+            nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                #version 450
+                out vec4 fragColor;
+                void main() {
+                    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            nxt::BindGroupLayout bgl = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 1)
+                .GetResult();
+            nxt::PipelineLayout pl = device.CreatePipelineLayoutBuilder()
+                .SetBindGroupLayout(0, bgl)
+                .GetResult();
+            nxt::InputState inputState = device.CreateInputStateBuilder()
+                .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+                .SetInput(0, 4 * sizeof(float), nxt::InputStepMode::Vertex)
+                .GetResult();
+
+            for (auto& pipeline : pipelines) {
+                pipeline = device.CreatePipelineBuilder()
+                    .SetSubpass(renderpass, 0)
+                    .SetLayout(pl)
+                    .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                    .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                    .SetInputState(inputState)
+                    .GetResult();
+            }
+
+            float data[16] = {};
+            for (auto& buffer : buffers) {
+                buffer = utils::CreateFrozenBufferFromData(device, data, sizeof(data),
+                    nxt::BufferUsageBit::Uniform | nxt::BufferUsageBit::Vertex | nxt::BufferUsageBit::Index);
+            }
+
+            for (size_t i = 0; i < 2; ++i) {
+                nxt::BufferView view = buffers[i].CreateBufferViewBuilder()
+                    .SetExtent(0, sizeof(data))
+                    .GetResult();
+                bindGroups[i] = device.CreateBindGroupBuilder()
+                    .SetLayout(bgl)
+                    .SetUsage(nxt::BindGroupUsage::Frozen)
+                    .SetBufferViews(0, 1, &view)
+                    .GetResult();
+            }
+
+            // A pipeline with a layout that isn't compatible with the layout of the others.
+            nxt::BindGroupLayout otherBgl = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex | nxt::ShaderStageBit::Fragment, nxt::BindingType::UniformBuffer, 0, 1)
+                .GetResult();
+            otherLayoutPipeline = device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetLayout(device.CreatePipelineLayoutBuilder().SetBindGroupLayout(0, otherBgl).GetResult())
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .SetInputState(inputState)
+                .GetResult();
+
+            nxt::BufferView view = buffers[0].CreateBufferViewBuilder()
+                .SetExtent(0, sizeof(data))
+                .GetResult();
+            otherLayoutBindGroup = device.CreateBindGroupBuilder()
+                .SetLayout(otherBgl)
+                .SetUsage(nxt::BindGroupUsage::Frozen)
+                .SetBufferViews(0, 1, &view)
+                .GetResult();
+        }
+
+        nxt::CommandBufferBuilder BeginCommandBuffer() {
+            return AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+                .BeginRenderPass(renderpass, framebuffer)
+                .BeginRenderSubpass()
+                .Clone();
+        }
+
+        nxt::CommandBuffer EndCommandBuffer(const nxt::CommandBufferBuilder& builder) {
+            builder.EndRenderSubpass();
+            builder.EndRenderPass();
+            return builder.GetResult();
+        }
+
+        uint32_t GetRedundantStateCommandsRemoved(const nxt::CommandBuffer& commands) {
+            return reinterpret_cast<backend::CommandBufferBase*>(commands.Get())->GetRedundantStateCommandsRemoved();
+        }
+
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+        nxt::Pipeline pipelines[2];
+        nxt::Buffer buffers[2];
+        nxt::BindGroup bindGroups[2];
+        nxt::Pipeline otherLayoutPipeline;
+        nxt::BindGroup otherLayoutBindGroup;
+};
+
+// Test that re-setting the same pipeline and bind group is removed
+TEST_F(RedundantStateEliminationTest, PipelineAndBindGroup) {
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    for (int i = 0; i < 3; ++i) {
+        builder.SetPipeline(pipelines[0])
+               .SetBindGroup(0, bindGroups[0], 0, nullptr)
+               .DrawArrays(3, 1, 0, 0);
+    }
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(4u, GetRedundantStateCommandsRemoved(commands));
+}
+
+// Test that bind groups stay set after a change to a pipeline with a compatible layout
+TEST_F(RedundantStateEliminationTest, PipelineChangeKeepsCompatibleBindGroups) {
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    builder.SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0)
+           .SetPipeline(pipelines[1])
+           .DrawArrays(3, 1, 0, 0)
+           // Redundant
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0)
+           .SetBindGroup(0, bindGroups[1], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0);
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(1u, GetRedundantStateCommandsRemoved(commands));
+}
+
+// Test that bind groups are considered unset after a change to a pipeline with an incompatible
+// layout
+TEST_F(RedundantStateEliminationTest, PipelineChangeResetsIncompatibleBindGroups) {
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    builder.SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0)
+           .SetPipeline(otherLayoutPipeline)
+           .SetBindGroup(0, otherLayoutBindGroup, 0, nullptr)
+           .DrawArrays(3, 1, 0, 0)
+           .SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0);
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(0u, GetRedundantStateCommandsRemoved(commands));
+
+    nxt::CommandBufferBuilder errorBuilder = AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .SetPipeline(pipelines[0])
+        .SetBindGroup(0, bindGroups[0], 0, nullptr)
+        .SetPipeline(otherLayoutPipeline)
+        .DrawArrays(3, 1, 0, 0)
+        .Clone();
+    EndCommandBuffer(errorBuilder);
+}
+
+// Test that inheriting the bind groups from a pipeline doesn't consider groups that were never
+// set as set
+TEST_F(RedundantStateEliminationTest, InheritedGroupsMustHaveBeenSet) {
+    nxt::CommandBufferBuilder builder = AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .SetPipeline(pipelines[0])
+        .SetPipeline(pipelines[0])
+        .DrawArrays(3, 1, 0, 0)
+        .Clone();
+    EndCommandBuffer(builder);
+}
+
+// Test that vertex and index buffers are removed only when buffer, offset and format match
+TEST_F(RedundantStateEliminationTest, VertexAndIndexBuffers) {
+    uint32_t zeroOffset = 0;
+    uint32_t otherOffset = 16;
+
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    builder.SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .SetVertexBuffers(0, 1, &buffers[0], &zeroOffset)
+           .SetIndexBuffer(buffers[1], 0, nxt::IndexFormat::Uint16)
+           .DrawElements(3, 1, 0, 0)
+           // Redundant
+           .SetVertexBuffers(0, 1, &buffers[0], &zeroOffset)
+           .SetIndexBuffer(buffers[1], 0, nxt::IndexFormat::Uint16)
+           .DrawElements(3, 1, 0, 0)
+           // Not redundant
+           .SetVertexBuffers(0, 1, &buffers[0], &otherOffset)
+           .SetVertexBuffers(0, 1, &buffers[1], &otherOffset)
+           .SetIndexBuffer(buffers[1], 0, nxt::IndexFormat::Uint32)
+           .SetIndexBuffer(buffers[0], 0, nxt::IndexFormat::Uint32)
+           .DrawElements(3, 1, 0, 0);
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(2u, GetRedundantStateCommandsRemoved(commands));
+}
+
+// Test that the tracking is reset at subpass boundaries
+TEST_F(RedundantStateEliminationTest, ResetOnSubpassBoundaries) {
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    builder.SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0)
+           .EndRenderSubpass()
+           .EndRenderPass()
+           .BeginRenderPass(renderpass, framebuffer)
+           .BeginRenderSubpass()
+           .SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0);
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(0u, GetRedundantStateCommandsRemoved(commands));
+}
+
+// Test that the pass can be disabled on the device
+TEST_F(RedundantStateEliminationTest, Disabled) {
+    reinterpret_cast<backend::DeviceBase*>(device.Get())->SetRedundantStateEliminationEnabled(false);
+
+    nxt::CommandBufferBuilder builder = BeginCommandBuffer();
+    builder.SetPipeline(pipelines[0])
+           .SetPipeline(pipelines[0])
+           .SetBindGroup(0, bindGroups[0], 0, nullptr)
+           .DrawArrays(3, 1, 0, 0);
+    nxt::CommandBuffer commands = EndCommandBuffer(builder);
+
+    ASSERT_EQ(0u, GetRedundantStateCommandsRemoved(commands));
+}
@@ -0,0 +1,248 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "utils/NXTHelpers.h"
+
+class RenderBundleValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            queue = device.CreateQueueBuilder().GetResult();
+
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+            nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                #version 450
+                layout(set = 0, binding = 0) uniform Data {
+                    float scale;
+                } data;
+                layout(location = 0) in vec4 pos;
+                void main() {
+                    gl_Position = pos * data.scale;
+                })"
+            );
+
+            nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                #version 450
+                out vec4 fragColor;
+                void main() {
+                    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            nxt::BindGroupLayout bgl = device.CreateBindGroupLayoutBuilder()
+                .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 1)
+                .GetResult();
+            nxt::PipelineLayout pl = device.CreatePipelineLayoutBuilder()
+                .SetBindGroupLayout(0, bgl)
+                .GetResult();
+            nxt::InputState inputState = device.CreateInputStateBuilder()
+                .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+                .SetInput(0, 4 * sizeof(float), nxt::InputStepMode::Vertex)
+                .GetResult();
+
+            pipeline = device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetLayout(pl)
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .SetInputState(inputState)
+                .GetResult();
+
+            float data[16] = {};
+            frozenBuffer = utils::CreateFrozenBufferFromData(device, data, sizeof(data),
+                nxt::BufferUsageBit::Uniform | nxt::BufferUsageBit::Vertex);
+
+            nxt::BufferView view = frozenBuffer.CreateBufferViewBuilder()
+                .SetExtent(0, sizeof(data))
+                .GetResult();
+            bindGroup = device.CreateBindGroupBuilder()
+                .SetLayout(bgl)
+                .SetUsage(nxt::BindGroupUsage::Frozen)
+                .SetBufferViews(0, 1, &view)
+                .GetResult();
+        }
+
+        void BeginSubpass(const nxt::CommandBufferBuilder& builder) {
+            builder.BeginRenderPass(renderpass, framebuffer);
+            builder.BeginRenderSubpass();
+        }
+
+        nxt::CommandBuffer EndCommandBuffer(const nxt::CommandBufferBuilder& builder) {
+            builder.EndRenderSubpass();
+            builder.EndRenderPass();
+            return builder.GetResult();
+        }
+
+        nxt::Queue queue;
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+        nxt::Pipeline pipeline;
+        nxt::Buffer frozenBuffer;
+        nxt::BindGroup bindGroup;
+};
+
+// Test that a bundle can be executed in several command buffers and subpasses
+TEST_F(RenderBundleValidationTest, Success) {
+    uint32_t zeroOffset = 0;
+    nxt::RenderBundle bundle = AssertWillBeSuccess(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetPipeline(pipeline)
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .SetVertexBuffers(0, 1, &frozenBuffer, &zeroOffset)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    for (int i = 0; i < 2; ++i) {
+        nxt::CommandBufferBuilder builder = AssertWillBeSuccess(device.CreateCommandBufferBuilder());
+        BeginSubpass(builder);
+        builder.ExecuteBundle(bundle)
+               .ExecuteBundle(bundle);
+        nxt::CommandBuffer commands = EndCommandBuffer(builder);
+        queue.Submit(1, &commands);
+    }
+}
+
+// Test that the subpass of the bundle must be set, and set only once
+TEST_F(RenderBundleValidationTest, SubpassRequired) {
+    AssertWillBeError(device.CreateRenderBundleBuilder())
+        .SetPipeline(pipeline)
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    AssertWillBeError(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 1)
+        .GetResult();
+
+    AssertWillBeError(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetSubpass(renderpass, 0)
+        .GetResult();
+}
+
+// Test that the commands of the bundle are validated when it is built
+TEST_F(RenderBundleValidationTest, CommandsValidated) {
+    AssertWillBeError(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    AssertWillBeError(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetPipeline(pipeline)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+}
+
+// Test that bundles can only be executed in the subpass of compatible render passes
+TEST_F(RenderBundleValidationTest, ExecuteInCompatibleSubpass) {
+    nxt::RenderBundle bundle = AssertWillBeSuccess(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetPipeline(pipeline)
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .ExecuteBundle(bundle)
+        .GetResult();
+
+    // Identical render passes are the same object so use one with an extra attachment.
+    nxt::RenderPass otherRenderpass = device.CreateRenderPassBuilder()
+        .SetAttachmentCount(2)
+        .AttachmentSetFormat(0, nxt::TextureFormat::R8G8B8A8Unorm)
+        .AttachmentSetFormat(1, nxt::TextureFormat::R8G8B8A8Unorm)
+        .SetSubpassCount(1)
+        .SubpassSetColorAttachment(0, 0, 0)
+        .GetResult();
+    nxt::Framebuffer otherFramebuffer = device.CreateFramebufferBuilder()
+        .SetRenderPass(otherRenderpass)
+        .SetDimensions(640, 480)
+        .GetResult();
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(otherRenderpass, otherFramebuffer)
+        .BeginRenderSubpass()
+        .ExecuteBundle(bundle)
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+}
+
+// Test that the usages needed by the bundle are checked when it is executed
+TEST_F(RenderBundleValidationTest, UsagesCheckedOnExecute) {
+    nxt::Buffer vertexBuffer = device.CreateBufferBuilder()
+        .SetSize(64)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Vertex)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    uint32_t zeroOffset = 0;
+    nxt::RenderBundle bundle = AssertWillBeSuccess(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetPipeline(pipeline)
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .SetVertexBuffers(0, 1, &vertexBuffer, &zeroOffset)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    {
+        nxt::CommandBufferBuilder builder = AssertWillBeError(device.CreateCommandBufferBuilder());
+        BeginSubpass(builder);
+        builder.ExecuteBundle(bundle);
+        EndCommandBuffer(builder);
+    }
+
+    {
+        nxt::CommandBufferBuilder builder = AssertWillBeSuccess(device.CreateCommandBufferBuilder());
+        builder.TransitionBufferUsage(vertexBuffer, nxt::BufferUsageBit::Vertex);
+        BeginSubpass(builder);
+        builder.ExecuteBundle(bundle);
+        EndCommandBuffer(builder);
+    }
+}
+
+// Test that the pipeline and bind groups must be set again after executing a bundle
+TEST_F(RenderBundleValidationTest, StateResetAfterExecute) {
+    nxt::RenderBundle bundle = AssertWillBeSuccess(device.CreateRenderBundleBuilder())
+        .SetSubpass(renderpass, 0)
+        .SetPipeline(pipeline)
+        .SetBindGroup(0, bindGroup, 0, nullptr)
+        .DrawArrays(3, 1, 0, 0)
+        .GetResult();
+
+    {
+        nxt::CommandBufferBuilder builder = AssertWillBeError(device.CreateCommandBufferBuilder());
+        BeginSubpass(builder);
+        builder.SetPipeline(pipeline)
+               .SetBindGroup(0, bindGroup, 0, nullptr)
+               .ExecuteBundle(bundle)
+               .DrawArrays(3, 1, 0, 0);
+        EndCommandBuffer(builder);
+    }
+
+    {
+        nxt::CommandBufferBuilder builder = AssertWillBeSuccess(device.CreateCommandBufferBuilder());
+        BeginSubpass(builder);
+        builder.ExecuteBundle(bundle)
+               .SetPipeline(pipeline)
+               .SetBindGroup(0, bindGroup, 0, nullptr)
+               .DrawArrays(3, 1, 0, 0);
+        EndCommandBuffer(builder);
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "backend/CommandBuffer.h"
+#include "backend/Device.h"
+#include "utils/NXTHelpers.h"
+
+class StreamingValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+            reinterpret_cast<backend::DeviceBase*>(device.Get())->SetStreamingValidationEnabled(true);
+
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+            nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                #version 450
+                void main() {
+                    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                #version 450
+                out vec4 fragColor;
+                void main() {
+                    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            pipeline = device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .GetResult();
+        }
+
+        uint32_t GetRedundantStateCommandsRemoved(const nxt::CommandBuffer& commands) {
+            return reinterpret_cast<backend::CommandBufferBase*>(commands.Get())->GetRedundantStateCommandsRemoved();
+        }
+
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+        nxt::Pipeline pipeline;
+};
+
+// Test that a valid command buffer is still a success
+TEST_F(StreamingValidationTest, Success) {
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .SetPipeline(pipeline)
+        .DrawArrays(3, 1, 0, 0)
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+}
+
+// Test that an error is reported in GetResult and the builder can still be used until then
+TEST_F(StreamingValidationTest, ErrorReportedInGetResult) {
+    nxt::CommandBufferBuilder builder = AssertWillBeError(device.CreateCommandBufferBuilder());
+    builder.DrawArrays(3, 1, 0, 0);
+
+    // No device error is produced by using the builder after the error
+    builder.BeginRenderPass(renderpass, framebuffer)
+           .BeginRenderSubpass()
+           .EndRenderSubpass()
+           .EndRenderPass();
+
+    builder.GetResult();
+}
+
+// Test that the error at the end of the command buffer is reported
+TEST_F(StreamingValidationTest, UnfinishedPass) {
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .GetResult();
+}
+
+// Test that the redundant state commands are not recorded
+TEST_F(StreamingValidationTest, RedundantStateNotRecorded) {
+    nxt::CommandBuffer commands = AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .BeginRenderPass(renderpass, framebuffer)
+        .BeginRenderSubpass()
+        .SetPipeline(pipeline)
+        .DrawArrays(3, 1, 0, 0)
+        .SetPipeline(pipeline)
+        .DrawArrays(3, 1, 0, 0)
+        .EndRenderSubpass()
+        .EndRenderPass()
+        .GetResult();
+
+    ASSERT_EQ(1u, GetRedundantStateCommandsRemoved(commands));
+}
@@ -54,3 +54,110 @@ TEST_F(UsageValidationTest, UsageAfterCommandBuffer) {
 
     buf.SetSubData(0, 1, &foo);
 }
+
+// Test that a command buffer can be submitted multiple times
+TEST_F(UsageValidationTest, ResubmitCommandBuffer) {
+    nxt::Buffer buf = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Vertex)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    nxt::CommandBuffer cmdbuf = device.CreateCommandBufferBuilder()
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::Vertex)
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    uint32_t foo = 0;
+    for (int i = 0; i < 3; ++i) {
+        queue.Submit(1, &cmdbuf);
+        // The command buffer is replayed every time and leaves buf in TransferDst usage
+        buf.SetSubData(0, 1, &foo);
+    }
+}
+
+// Test that resubmitting a command buffer fails when a buffer it transitions got frozen
+TEST_F(UsageValidationTest, ResubmitCommandBufferAfterFreeze) {
+    nxt::Buffer buf = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::TransferDst | nxt::BufferUsageBit::Vertex)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+
+    nxt::CommandBuffer cmdbuf = device.CreateCommandBufferBuilder()
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::Vertex)
+        .GetResult();
+    queue.Submit(1, &cmdbuf);
+
+    buf.FreezeUsage(nxt::BufferUsageBit::Vertex);
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &cmdbuf));
+}
+
+// Test that resubmitting a command buffer fails while a buffer it transitions is mapped
+TEST_F(UsageValidationTest, ResubmitCommandBufferWhileMapped) {
+    nxt::Buffer buf = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::MapRead | nxt::BufferUsageBit::TransferDst)
+        .SetInitialUsage(nxt::BufferUsageBit::MapRead)
+        .GetResult();
+
+    nxt::CommandBuffer cmdbuf = device.CreateCommandBufferBuilder()
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::TransferDst)
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::MapRead)
+        .GetResult();
+    queue.Submit(1, &cmdbuf);
+
+    buf.MapReadAsync(0, 4, [](nxtBufferMapReadStatus, const void*, nxtCallbackUserdata) {}, 0);
+    ASSERT_DEVICE_ERROR(queue.Submit(1, &cmdbuf));
+
+    buf.Unmap();
+    queue.Submit(1, &cmdbuf);
+}
+
+// Test that the usages required by a bind group are checked whether or not they are frozen
+TEST_F(UsageValidationTest, BindGroupRequiredUsages) {
+    nxt::BindGroupLayout bgl = device.CreateBindGroupLayoutBuilder()
+        .SetBindingsType(nxt::ShaderStageBit::Vertex, nxt::BindingType::UniformBuffer, 0, 2)
+        .GetResult();
+
+    auto CreateBindGroup = [&](const nxt::Buffer& buffer) {
+        nxt::BufferView views[2];
+        for (auto& view : views) {
+            view = buffer.CreateBufferViewBuilder()
+                .SetExtent(0, 4)
+                .GetResult();
+        }
+        return device.CreateBindGroupBuilder()
+            .SetLayout(bgl)
+            .SetUsage(nxt::BindGroupUsage::Frozen)
+            .SetBufferViews(0, 2, views)
+            .GetResult();
+    };
+
+    nxt::Buffer frozenBuf = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::Uniform)
+        .GetResult();
+    frozenBuf.FreezeUsage(nxt::BufferUsageBit::Uniform);
+    nxt::BindGroup frozenGroup = CreateBindGroup(frozenBuf);
+
+    nxt::Buffer buf = device.CreateBufferBuilder()
+        .SetSize(4)
+        .SetAllowedUsage(nxt::BufferUsageBit::Uniform | nxt::BufferUsageBit::TransferDst)
+        .SetInitialUsage(nxt::BufferUsageBit::TransferDst)
+        .GetResult();
+    nxt::BindGroup group = CreateBindGroup(buf);
+
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, frozenGroup, 0, nullptr)
+        .GetResult();
+
+    AssertWillBeError(device.CreateCommandBufferBuilder())
+        .SetBindGroup(0, group, 0, nullptr)
+        .GetResult();
+
+    AssertWillBeSuccess(device.CreateCommandBufferBuilder())
+        .TransitionBufferUsage(buf, nxt::BufferUsageBit::Uniform)
+        .SetBindGroup(0, group, 0, nullptr)
+        .GetResult();
+}
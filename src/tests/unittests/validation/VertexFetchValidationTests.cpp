@@ -0,0 +1,121 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tests/unittests/validation/ValidationTest.h"
+
+#include "utils/NXTHelpers.h"
+
+class VertexFetchValidationTest : public ValidationTest {
+    protected:
+        void SetUp() override {
+            ValidationTest::SetUp();
+
+            utils::CreateDefaultRenderPass(device, &renderpass, &framebuffer);
+
+            nxt::ShaderModule vsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Vertex, R"(
+                #version 450
+                layout(location = 0) in vec4 pos;
+                layout(location = 1) in vec2 offset;
+                void main() {
+                    gl_Position = pos + vec4(offset, 0.0, 0.0);
+                })"
+            );
+
+            nxt::ShaderModule fsModule = utils::CreateShaderModule(device, nxt::ShaderStage::Fragment, R"(
+                #version 450
+                out vec4 fragColor;
+                void main() {
+                    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+                })"
+            );
+
+            // The second attribute is at the end of the instance data.
+            nxt::InputState inputState = device.CreateInputStateBuilder()
+                .SetInput(0, 4 * sizeof(float), nxt::InputStepMode::Vertex)
+                .SetAttribute(0, 0, nxt::VertexFormat::FloatR32G32B32A32, 0)
+                .SetInput(1, 4 * sizeof(float), nxt::InputStepMode::Instance)
+                .SetAttribute(1, 1, nxt::VertexFormat::FloatR32G32, 2 * sizeof(float))
+                .GetResult();
+
+            pipeline = device.CreatePipelineBuilder()
+                .SetSubpass(renderpass, 0)
+                .SetLayout(device.CreatePipelineLayoutBuilder().GetResult())
+                .SetStage(nxt::ShaderStage::Vertex, vsModule, "main")
+                .SetStage(nxt::ShaderStage::Fragment, fsModule, "main")
+                .SetInputState(inputState)
+                .GetResult();
+
+            // Four vertices and two instances
+            float data[16] = {};
+            vertexBuffer = utils::CreateFrozenBufferFromData(device, data, sizeof(data),
+                nxt::BufferUsageBit::Vertex);
+            instanceBuffer = utils::CreateFrozenBufferFromData(device, data, 8 * sizeof(float),
+                nxt::BufferUsageBit::Vertex);
+            indexBuffer = utils::CreateFrozenBufferFromData(device, data, sizeof(data),
+                nxt::BufferUsageBit::Index);
+        }
+
+        nxt::CommandBufferBuilder BeginDraw(nxt::CommandBufferBuilder builder, uint32_t vertexOffset = 0) {
+            nxt::Buffer* buffers[2] = {&vertexBuffer, &instanceBuffer};
+            uint32_t zeroOffset = 0;
+            builder.BeginRenderPass(renderpass, framebuffer)
+                .BeginRenderSubpass()
+                .SetPipeline(pipeline)
+                .SetVertexBuffers(0, 1, buffers[0], &vertexOffset)
+                .SetVertexBuffers(1, 1, buffers[1], &zeroOffset)
+                .SetIndexBuffer(indexBuffer, 0, nxt::IndexFormat::Uint32);
+            return builder;
+        }
+
+        void EndDraw(const nxt::CommandBufferBuilder& builder) {
+            builder.EndRenderSubpass()
+                .EndRenderPass()
+                .GetResult();
+        }
+
+        nxt::RenderPass renderpass;
+        nxt::Framebuffer framebuffer;
+        nxt::Pipeline pipeline;
+        nxt::Buffer vertexBuffer;
+        nxt::Buffer instanceBuffer;
+        nxt::Buffer indexBuffer;
+};
+
+// Test draws of the vertices and instances in the vertex buffers
+TEST_F(VertexFetchValidationTest, InBounds) {
+    nxt::CommandBufferBuilder builder = BeginDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()));
+    builder.DrawArrays(4, 2, 0, 0)
+           .DrawArrays(1, 1, 3, 1)
+           .DrawElements(16, 2, 0, 0);
+    EndDraw(builder);
+}
+
+// Test that drawing vertices past the end of the vertex buffers is an error
+TEST_F(VertexFetchValidationTest, VertexOutOfBounds) {
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder())).DrawArrays(5, 1, 0, 0).Clone());
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder())).DrawArrays(1, 1, 4, 0).Clone());
+}
+
+// Test that drawing instances past the end of the vertex buffers is an error
+TEST_F(VertexFetchValidationTest, InstanceOutOfBounds) {
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder())).DrawArrays(4, 3, 0, 0).Clone());
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder())).DrawArrays(4, 1, 0, 2).Clone());
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder())).DrawElements(3, 3, 0, 0).Clone());
+}
+
+// Test that the offset of the vertex buffers is taken into account
+TEST_F(VertexFetchValidationTest, VertexBufferOffset) {
+    EndDraw(BeginDraw(AssertWillBeSuccess(device.CreateCommandBufferBuilder()), 16).DrawArrays(3, 1, 0, 0).Clone());
+    EndDraw(BeginDraw(AssertWillBeError(device.CreateCommandBufferBuilder()), 16).DrawArrays(4, 1, 0, 0).Clone());
+}
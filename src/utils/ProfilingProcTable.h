@@ -0,0 +1,51 @@
+// Copyright 2017 The NXT Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UTILS_PROFILINGPROCTABLE_H_
+#define UTILS_PROFILINGPROCTABLE_H_
+
+#include <nxt/nxt.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace utils {
+
+    // The number of calls to an entry point and the time spent in them, including the time of
+    // the calls it makes to other entry points.
+    struct ProcProfile {
+        const char* name;
+        uint64_t callCount;
+        uint64_t totalNanoseconds;
+    };
+
+    // Returns a proc table that forwards to procs, counting the calls to each entry point and
+    // timing them. Any table can be profiled: the validating or non-validating procs of a
+    // backend, the procs of a wire client or the procs given to a wire server. The counters are
+    // global so only one table is profiled at a time, calling this again makes the profiling
+    // procs forward to the new table.
+    nxtProcTable GetProfilingProcs(const nxtProcTable& procs);
+
+    // Profiles of the entry points called since the last reset, the most expensive first.
+    std::vector<ProcProfile> GetProcProfiles();
+    void ResetProcProfiles();
+
+    void DumpProcProfiles(FILE* file);
+    // Dumps the profiles to stderr when the process exits.
+    void DumpProcProfilesAtExit();
+
+}
+
+#endif // UTILS_PROFILINGPROCTABLE_H_